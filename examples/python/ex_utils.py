@@ -51,10 +51,6 @@ class SimulavrAdapter(object):
     dman.addDumpVCD(vcdname, "\n".join(sigs), "ns", rstrobe, wstrobe)
     
   def getWordByName(self, dev, label):
-    addr = dev.data.GetAddressAtSymbol(label)
-    v = dev.getRWMem(addr)
-    addr += 1
-    v = (dev.getRWMem(addr) << 8) + v
-    return v
+    return dev.read_var(label, "H")
     
 # EOF
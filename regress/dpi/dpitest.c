@@ -0,0 +1,89 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2001, 2002 - 2012   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ */
+
+/* C driver for libavrdpi, like a testbench would use it: runs portcopy.elf,
+   drives port D and checks port B. Returns 0, if all checks are passed. */
+
+#include <stdio.h>
+
+#include "dpi.h"
+
+static int errors = 0;
+
+static void check(int ok, const char *what, int got, int expected) {
+    if(!ok) {
+        printf("FAIL: %s: got 0x%02x, expected 0x%02x\n", what, got, expected);
+        errors++;
+    }
+}
+
+static void checkPortB(int h, unsigned char portD) {
+    unsigned char value, oe;
+    unsigned char expected = (unsigned char)~(portD & 0x7f); /* PD7 doesn't exist */
+    avr_dpi_set_port(h, 'D', portD, 0x7f);
+    check(avr_dpi_step(h, 20) == 20, "cycles done", 0, 20);
+    avr_dpi_get_port(h, 'b', &value, &oe);
+    check(value == expected, "port B value", value, expected);
+    check(oe == 0xff, "port B output enable", oe, 0xff);
+}
+
+int main(int argc, char *argv[]) {
+    const char *elf = (argc > 1) ? argv[1] : "portcopy.elf";
+    unsigned char value, oe;
+    int h;
+
+    /* no avr_dpi_set_clock: default clock period has to be used */
+    h = avr_dpi_create("attiny2313", elf);
+    avr_dpi_reset(h);
+    avr_dpi_get_port(h, 'B', &value, &oe);
+    check(oe == 0, "port B output enable after reset", oe, 0);
+
+    checkPortB(h, 0x55);
+    checkPortB(h, 0x2a);
+    checkPortB(h, 0x00);
+    /* pins, which are released by testbench, are read as high */
+    avr_dpi_set_port(h, 'D', 0x00, 0x00);
+    avr_dpi_step(h, 20);
+    avr_dpi_get_port(h, 'B', &value, &oe);
+    check(value == 0x80, "port B with released port D", value, 0x80);
+
+    /* DDRB on data address 0x37 */
+    check(avr_dpi_read_mem(h, 0x37) == 0xff, "DDRB", avr_dpi_read_mem(h, 0x37), 0xff);
+    avr_dpi_write_mem(h, 0x37, 0x0f);
+    avr_dpi_get_port(h, 'B', &value, &oe);
+    check(oe == 0x0f, "port B output enable after write to DDRB", oe, 0x0f);
+
+    /* second device with explicit clock */
+    {
+        int h2 = avr_dpi_create("attiny2313", elf);
+        avr_dpi_set_clock(h2, 125);
+        avr_dpi_reset(h2);
+        checkPortB(h2, 0x11);
+        avr_dpi_destroy(h2);
+    }
+
+    avr_dpi_destroy(h);
+    if(errors == 0)
+        printf("dpitest: all checks passed\n");
+    return errors != 0;
+}
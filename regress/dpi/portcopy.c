@@ -0,0 +1,8 @@
+/* Copies inverted PIND to PORTB, driven by dpitest through libavrdpi. */
+#include <avr/io.h>
+
+int main() {
+    DDRB = 0xff;
+    while(1)
+        PORTB = ~PIND;
+}
@@ -0,0 +1,80 @@
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+#undef _SFR_IO8
+#define _SFR_IO8(x) (x)
+#undef _SFR_IO16
+#define _SFR_IO16(x) (x)
+
+; Register only code in alu runs as block (see BlockTier) or translated
+; module (see AotModule). Timer 0 toggles OC0 in CTC mode all the time. With
+; interrupts enabled, the compare interrupt logs TCNT0 and the return address
+; to SRAM at 0x100, so a interrupt, which is taken late, gives a other log.
+
+.global main
+main:
+    ldi r16, hi8(RAMEND)
+    out SPH, r16
+    ldi r16, lo8(RAMEND)
+    out SPL, r16
+    ldi r26, lo8(0x100)    ; X is log pointer, only used by the irq handler
+    ldi r27, hi8(0x100)
+    sbi DDRB, 3            ; OC0 is output
+    ldi r16, 99
+    out OCR0, r16
+    ldi r16, (1<<WGM01)|(1<<COM00)|(1<<CS00)
+    out TCCR0, r16
+    ldi r16, (1<<OCIE0)
+    out TIMSK, r16
+    ldi r20, 0
+    ldi r21, 1
+    ldi r22, 0
+
+    ldi r24, 50            ; interrupts disabled: blocks are used
+1:  rcall alu
+    dec r24
+    brne 1b
+
+    sei                    ; interrupts enabled: interpreter only
+2:  rcall alu
+    cpi r26, lo8(0x100+3*8)
+    brne 2b
+    cli
+
+    ldi r24, 20            ; blocks again
+3:  rcall alu
+    dec r24
+    brne 3b
+.global stopsim
+stopsim:
+    rjmp stopsim
+
+alu:
+    add r20, r21
+    eor r22, r20
+    swap r22
+    sbrc r22, 3
+    inc r21
+    lsr r22
+    adc r20, r22
+    mul r20, r21
+    mov r23, r0
+    ret
+
+.global TIMER0_COMP_vect
+TIMER0_COMP_vect:
+    push r16
+    push r28
+    push r29
+    in r28, SPL
+    in r29, SPH
+    in r16, TCNT0
+    st X+, r16
+    ldd r16, Y+4           ; return address
+    st X+, r16
+    ldd r16, Y+5
+    st X+, r16
+    pop r29
+    pop r28
+    pop r16
+    reti
@@ -0,0 +1,117 @@
+#include <iostream>
+#include <vector>
+#include <stdlib.h>
+using namespace std;
+
+#include "gtest.h"
+
+#include "avrdevice.h"
+#include "atmega16_32.h"
+#include "systemclock.h"
+#include "hwsreg.h"
+#include "blocktier.h"
+#include "aotmodule.h"
+#include "pinnotify.h"
+
+//! Records the simulation time of every change on a output pin
+class EdgeLog: public HasPinNotifyFunction {
+
+    public:
+        Pin *pin;
+        int last;
+        vector<SystemClockOffset> edges;
+
+        EdgeLog(Pin *p): pin(p), last(p->outState) { pin->RegisterCallback(this); }
+        void PinStateHasChanged(Pin *) {
+            if(pin->outState == last)
+                return;
+            last = pin->outState;
+            edges.push_back(SystemClock::Instance().GetCurrentTime());
+        }
+};
+
+//! Core state at end of alu.s
+struct RunResult {
+    unsigned char regs[32];
+    unsigned char sreg;
+    unsigned char irqLog[3*8];
+    SystemClockOffset endTime;
+    vector<SystemClockOffset> edges;
+    unsigned long long blocks;
+};
+
+//! Runs alu.s with interpreter only, with block tier or with a translated module
+static void RunAlu(bool blockTier, const char *aotModule, RunResult &r)
+{
+    SystemClock::Instance().ResetClock();
+    AvrDevice *dev1 = new AvrDevice_atmega32;
+    dev1->Load("session_blocktier/alu.atmega32.o");
+    dev1->SetClockFreq(125);
+    dev1->SetBlockTier(blockTier);
+    if(aotModule != NULL)
+        dev1->LoadAotModule(aotModule);
+    dev1->RegisterTerminationSymbol("stopsim");
+    SystemClock::Instance().Add(dev1);
+    EdgeLog oc0(dev1->GetPin("B3"));
+    SystemClock::Instance().Endless();
+
+    for(int i = 0; i < 32; i++)
+        r.regs[i] = dev1->GetCoreReg(i);
+    r.sreg = (unsigned char)*dev1->status;
+    for(int i = 0; i < 3*8; i++)
+        r.irqLog[i] = dev1->GetRWMem(0x100 + i);
+    r.endTime = SystemClock::Instance().GetCurrentTime();
+    r.edges = oc0.edges;
+    r.blocks = 0;
+    if(blockTier)
+        r.blocks += dev1->blockTier->GetBlocksExecuted();
+    if(aotModule != NULL)
+        r.blocks += dev1->aotModule->GetBlocksExecuted();
+    SystemClock::Instance().ResetClock();
+}
+
+//! Compares a run with the interpreter run
+static void CompareRuns(const RunResult &interp, const RunResult &r)
+{
+    for(int i = 0; i < 32; i++)
+        EXPECT_EQ(interp.regs[i], r.regs[i]) << "R" << i << " differs" << endl;
+    EXPECT_EQ(interp.sreg, r.sreg) << "SREG differs" << endl;
+    for(int i = 0; i < 8; i++) {
+        EXPECT_EQ(interp.irqLog[i*3], r.irqLog[i*3]) << "Interrupt " << i << " entered on other cycle" << endl;
+        EXPECT_EQ(interp.irqLog[i*3+1], r.irqLog[i*3+1]) << "Interrupt " << i << " with other return address" << endl;
+        EXPECT_EQ(interp.irqLog[i*3+2], r.irqLog[i*3+2]) << "Interrupt " << i << " with other return address" << endl;
+    }
+    EXPECT_EQ(interp.endTime, r.endTime) << "Program ends on other time" << endl;
+    ASSERT_EQ(interp.edges.size(), r.edges.size()) << "other count of OC0 edges" << endl;
+    for(size_t i = 0; i < interp.edges.size(); i++)
+        EXPECT_EQ(interp.edges[i], r.edges[i]) << "OC0 edge " << i << " on other time" << endl;
+}
+
+TEST(SESSION_BLOCKTIER, SAME_AS_INTERPRETER)
+{
+    RunResult interp, block;
+    RunAlu(false, NULL, interp);
+    RunAlu(true, NULL, block);
+
+    EXPECT_GT(block.blocks, 0u) << "no block executed" << endl;
+    EXPECT_GT(interp.edges.size(), 10u);
+    CompareRuns(interp, block);
+}
+
+TEST(SESSION_BLOCKTIER, AOT_MODULE)
+{
+    // emit and compile module like described for --aot-emit
+    SystemClock::Instance().ResetClock();
+    AvrDevice *dev1 = new AvrDevice_atmega32;
+    dev1->Load("session_blocktier/alu.atmega32.o");
+    EXPECT_GT(AotModule::Emit(dev1, "session_blocktier/alu_aot.cpp"), 0u) << "no block translated" << endl;
+    ASSERT_EQ(0, system("c++ -O2 -shared -fPIC -o session_blocktier/alu_aot.so session_blocktier/alu_aot.cpp"))
+        << "translated module not compiled" << endl;
+
+    RunResult interp, aot;
+    RunAlu(false, NULL, interp);
+    RunAlu(false, "session_blocktier/alu_aot.so", aot);
+
+    EXPECT_GT(aot.blocks, 0u) << "no translated block executed" << endl;
+    CompareRuns(interp, aot);
+}
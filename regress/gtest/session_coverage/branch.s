@@ -0,0 +1,17 @@
+; Program for lcov branch coverage, the test finds the lines by the markers
+; in the comments. Assembled with DWARF line info, not with stabs.
+
+.global main
+main:
+    ldi r24, 3
+loop:
+    subi r24, 1
+    brne loop           ; LOOP: taken and not taken
+    cpi r24, 5
+    breq dead           ; NEVER: executed, but never taken
+done:
+    rjmp done           ; DONE
+dead:
+    nop                 ; DEAD: never executed
+    brne dead           ; DEAD_BRANCH: never executed
+    rjmp done
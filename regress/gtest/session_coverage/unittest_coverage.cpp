@@ -0,0 +1,90 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+using namespace std;
+
+#include "gtest.h"
+
+#include "avrdevice.h"
+#include "atmega16_32.h"
+#include "systemclock.h"
+#include "coverage.h"
+
+//! Returns line number of the source line with marker in comment, 0 if not found
+static unsigned int FindMarker(const char *source, const char *marker) {
+   ifstream f(source);
+   string line;
+   for(unsigned int n = 1; getline(f, line); n++) {
+      size_t c = line.find(';');
+      if(c != string::npos && line.find(marker, c) != string::npos)
+         return n;
+   }
+   return 0;
+}
+
+//! Returns true, if lcov file has the given line
+static bool HasLine(const vector<string> &lcov, const char *fmt, unsigned int line, const char *rest) {
+   char buf[128];
+   snprintf(buf, sizeof(buf), fmt, line, rest);
+   for(size_t i = 0; i < lcov.size(); i++)
+      if(lcov[i] == buf)
+         return true;
+   return false;
+}
+
+TEST(SESSION_COVERAGE, LCOV_BRANCHES)
+{
+   SystemClock::Instance().ResetClock();
+   AvrDevice *dev1 = new AvrDevice_atmega32;
+   dev1->Load("session_coverage/branch.atmega32.o");
+   dev1->SetClockFreq(125);
+   SystemClock::Instance().Add(dev1);
+   CoverageRecorder *cov = new CoverageRecorder(dev1);
+
+   SystemClock::Instance().Run(100 * 125);
+
+   cov->WriteLcov("session_coverage/branch.info", "session_coverage/branch.atmega32.o");
+   ifstream f("session_coverage/branch.info");
+   vector<string> lcov;
+   string line;
+   while(getline(f, line))
+      lcov.push_back(line);
+   ASSERT_FALSE(lcov.empty()) << "no lcov file written" << endl;
+
+   unsigned int sf = 0;
+   for(size_t i = 0; i < lcov.size(); i++)
+      if(lcov[i].compare(0, 3, "SF:") == 0 && lcov[i].find("branch.s") != string::npos)
+         sf++;
+   EXPECT_EQ(1u, sf) << "source file of line table not in lcov file" << endl;
+
+   const char *source = "session_coverage/branch.s";
+   unsigned int loop = FindMarker(source, "LOOP:");
+   unsigned int never = FindMarker(source, "NEVER:");
+   unsigned int done = FindMarker(source, "DONE");
+   unsigned int dead = FindMarker(source, "DEAD:");
+   unsigned int deadBranch = FindMarker(source, "DEAD_BRANCH:");
+   ASSERT_TRUE(loop && never && done && dead && deadBranch) << "marker not found in " << source << endl;
+
+   // loop branch is taken twice and not taken once
+   EXPECT_TRUE(HasLine(lcov, "DA:%u,%s", loop, "1"));
+   EXPECT_TRUE(HasLine(lcov, "BRDA:%u,0,0,%s", loop, "1"));
+   EXPECT_TRUE(HasLine(lcov, "BRDA:%u,0,1,%s", loop, "1"));
+   // executed branch, which is never taken
+   EXPECT_TRUE(HasLine(lcov, "DA:%u,%s", never, "1"));
+   EXPECT_TRUE(HasLine(lcov, "BRDA:%u,0,0,%s", never, "0"));
+   EXPECT_TRUE(HasLine(lcov, "BRDA:%u,0,1,%s", never, "1"));
+   EXPECT_TRUE(HasLine(lcov, "DA:%u,%s", done, "1"));
+   // code, which is never reached
+   EXPECT_TRUE(HasLine(lcov, "DA:%u,%s", dead, "0"));
+   EXPECT_TRUE(HasLine(lcov, "DA:%u,%s", deadBranch, "0"));
+   EXPECT_TRUE(HasLine(lcov, "BRDA:%u,0,0,%s", deadBranch, "-"));
+   EXPECT_TRUE(HasLine(lcov, "BRDA:%u,0,1,%s", deadBranch, "-"));
+   EXPECT_TRUE(HasLine(lcov, "BRF:%u%s", 6, ""));
+   EXPECT_TRUE(HasLine(lcov, "BRH:%u%s", 3, ""));
+
+   delete cov;
+   SystemClock::Instance().ResetClock();
+}
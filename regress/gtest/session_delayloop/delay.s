@@ -0,0 +1,85 @@
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+#undef _SFR_IO8
+#define _SFR_IO8(x) (x)
+#undef _SFR_IO16
+#define _SFR_IO16(x) (x)
+
+; The three kinds of delay loops (see DelayLoopSkipper) run with interrupts
+; enabled, while timer 0 toggles OC0 in CTC mode. The compare interrupt logs
+; TCNT0 and the return address to SRAM from 0x100 on, so a interrupt, which is
+; taken on a other instruction inside a skipped loop, gives a other log. At
+; last one loop runs with interrupts disabled.
+
+.global main
+main:
+    ldi r16, hi8(RAMEND)
+    out SPH, r16
+    ldi r16, lo8(RAMEND)
+    out SPL, r16
+    ldi r26, lo8(0x100)    ; X is log pointer, only used by the irq handler
+    ldi r27, hi8(0x100)
+    sbi DDRB, 3            ; OC0 is output
+    ldi r16, 250
+    out OCR0, r16
+    ldi r16, (1<<WGM01)|(1<<COM00)|(1<<CS00)
+    out TCCR0, r16
+    ldi r16, (1<<OCIE0)
+    out TIMSK, r16
+    sei
+
+1:  ldi r24, 200
+    rcall loop1
+    ldi r24, lo8(300)
+    ldi r25, hi8(300)
+    rcall loop2
+    ldi r18, lo8(400)
+    ldi r19, hi8(400)
+    ldi r20, 0
+    rcall loop3
+    cpi r26, lo8(0x100+3*16)
+    brlo 1b
+
+    cli
+    ldi r24, lo8(2000)
+    ldi r25, hi8(2000)
+    rcall loop2
+.global stopsim
+stopsim:
+    rjmp stopsim
+
+loop1:                     ; like _delay_loop_1
+    dec r24
+    brne loop1
+    ret
+
+loop2:                     ; like _delay_loop_2
+    sbiw r24, 1
+    brne loop2
+    ret
+
+loop3:                     ; like __builtin_avr_delay_cycles
+    subi r18, 1
+    sbci r19, 0
+    sbci r20, 0
+    brne loop3
+    ret
+
+.global TIMER0_COMP_vect
+TIMER0_COMP_vect:
+    push r16
+    push r28
+    push r29
+    in r28, SPL
+    in r29, SPH
+    in r16, TCNT0
+    st X+, r16
+    ldd r16, Y+4           ; return address
+    st X+, r16
+    ldd r16, Y+5
+    st X+, r16
+    pop r29
+    pop r28
+    pop r16
+    reti
@@ -0,0 +1,85 @@
+#include <iostream>
+#include <vector>
+using namespace std;
+
+#include "gtest.h"
+
+#include "avrdevice.h"
+#include "atmega16_32.h"
+#include "systemclock.h"
+#include "hwsreg.h"
+#include "delayloop.h"
+#include "pinnotify.h"
+
+//! Records the simulation time of every change on a output pin
+class EdgeLog: public HasPinNotifyFunction {
+
+    public:
+        Pin *pin;
+        int last;
+        vector<SystemClockOffset> edges;
+
+        EdgeLog(Pin *p): pin(p), last(p->outState) { pin->RegisterCallback(this); }
+        void PinStateHasChanged(Pin *) {
+            if(pin->outState == last)
+                return;
+            last = pin->outState;
+            edges.push_back(SystemClock::Instance().GetCurrentTime());
+        }
+};
+
+//! Core state at end of delay.s
+struct RunResult {
+    unsigned char regs[32];
+    unsigned char sreg;
+    unsigned char irqLog[3*16];
+    SystemClockOffset endTime;
+    vector<SystemClockOffset> edges;
+    unsigned long long loops;
+};
+
+//! Runs delay.s with or without skipping of delay loops
+static void RunDelay(bool skip, RunResult &r)
+{
+    SystemClock::Instance().ResetClock();
+    AvrDevice *dev1 = new AvrDevice_atmega32;
+    dev1->Load("session_delayloop/delay.atmega32.o");
+    dev1->SetClockFreq(125);
+    dev1->SetDelayLoopSkip(skip);
+    dev1->RegisterTerminationSymbol("stopsim");
+    SystemClock::Instance().Add(dev1);
+    EdgeLog oc0(dev1->GetPin("B3"));
+    SystemClock::Instance().Endless();
+
+    for(int i = 0; i < 32; i++)
+        r.regs[i] = dev1->GetCoreReg(i);
+    r.sreg = (unsigned char)*dev1->status;
+    for(int i = 0; i < 3*16; i++)
+        r.irqLog[i] = dev1->GetRWMem(0x100 + i);
+    r.endTime = SystemClock::Instance().GetCurrentTime();
+    r.edges = oc0.edges;
+    r.loops = skip ? dev1->GetDelayLoopSkipper()->GetLoopsSkipped() : 0;
+    SystemClock::Instance().ResetClock();
+}
+
+TEST(SESSION_DELAYLOOP, SAME_AS_INTERPRETER)
+{
+    RunResult interp, skip;
+    RunDelay(false, interp);
+    RunDelay(true, skip);
+
+    EXPECT_GT(skip.loops, 0u) << "no loop skipped" << endl;
+    for(int i = 0; i < 32; i++)
+        EXPECT_EQ(interp.regs[i], skip.regs[i]) << "R" << i << " differs" << endl;
+    EXPECT_EQ(interp.sreg, skip.sreg) << "SREG differs" << endl;
+    for(int i = 0; i < 16; i++) {
+        EXPECT_EQ(interp.irqLog[i*3], skip.irqLog[i*3]) << "Interrupt " << i << " entered on other cycle" << endl;
+        EXPECT_EQ(interp.irqLog[i*3+1], skip.irqLog[i*3+1]) << "Interrupt " << i << " with other return address" << endl;
+        EXPECT_EQ(interp.irqLog[i*3+2], skip.irqLog[i*3+2]) << "Interrupt " << i << " with other return address" << endl;
+    }
+    EXPECT_EQ(interp.endTime, skip.endTime) << "Program ends on other time" << endl;
+    EXPECT_GT(interp.edges.size(), 10u);
+    ASSERT_EQ(interp.edges.size(), skip.edges.size()) << "other count of OC0 edges" << endl;
+    for(size_t i = 0; i < interp.edges.size(); i++)
+        EXPECT_EQ(interp.edges[i], skip.edges[i]) << "OC0 edge " << i << " on other time" << endl;
+}
@@ -0,0 +1,16 @@
+#include <avr/io.h>
+
+; a 16 bit counter in data memory, counted up from r25:r24. A variant of the
+; fork pool test sets r25:r24 and lets it run.
+
+.comm counter, 2
+
+.global main
+main:
+    clr r24
+    clr r25
+loop:
+    adiw r24, 1
+    sts counter, r24
+    sts counter+1, r25
+    rjmp loop
@@ -0,0 +1,120 @@
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+using namespace std;
+
+#include "gtest.h"
+
+#include "avrdevice.h"
+#include "memory.h"
+#include "flash.h"
+#include "atmega16_32.h"
+#include "systemclock.h"
+#include "forkpool.h"
+
+static const char *childExitFile = "session_forkpool/child_exit.txt";
+static pid_t parentPid;
+
+//! atexit handler, which marks a exit() in a child process
+static void MarkChildExit(void)
+{
+   if(getpid() != parentPid) {
+      FILE *f = fopen(childExitFile, "w");
+      if(f != NULL)
+         fclose(f);
+   }
+}
+
+//! Starts counter with 1000 * index, variant 3 runs out of flash
+class CounterVariant: public ForkVariant {
+   public:
+      AvrDevice *dev;
+      unsigned int addr;
+
+      CounterVariant(AvrDevice *d): dev(d) {
+         addr = dev->data->GetAddressAtSymbol("counter");
+      }
+
+      std::string RunVariant(unsigned int index) {
+         if(index == 3)
+            dev->PC = dev->Flash->GetSize() / 2;
+         dev->SetRWMem(24, (1000 * index) & 0xff);
+         dev->SetRWMem(25, (1000 * index) >> 8);
+         SystemClock::Instance().Run(SystemClock::Instance().GetCurrentTime() + 100 * dev->GetClockFreq());
+         char buf[16];
+         snprintf(buf, sizeof(buf), "%u", dev->GetRWMem(addr) + 256 * dev->GetRWMem(addr + 1));
+         return buf;
+      }
+};
+
+static AvrDevice *MakeDevice(void)
+{
+   SystemClock::Instance().ResetClock();
+   AvrDevice *dev1 = new AvrDevice_atmega32;
+   dev1->Load("session_forkpool/counter.atmega32.o");
+   dev1->SetClockFreq(125);
+   SystemClock::Instance().Add(dev1);
+   // run init code and some counter loops
+   SystemClock::Instance().Run(200 * dev1->GetClockFreq());
+   return dev1;
+}
+
+static void CheckPool(bool forked)
+{
+   parentPid = getpid();
+   static bool registered = false;
+   if(!registered) {
+      atexit(MarkChildExit);
+      registered = true;
+   }
+   remove(childExitFile);
+
+   AvrDevice *dev1 = MakeDevice();
+   CounterVariant v(dev1);
+   unsigned int counter = dev1->GetRWMem(v.addr) + 256 * dev1->GetRWMem(v.addr + 1);
+   SystemClockOffset time = SystemClock::Instance().GetCurrentTime();
+
+   SimulationForkPool pool(dev1, 2);
+   if(forked)
+      pool.Run(&v, 5);
+   else {
+      pool.results.assign(5, string());
+      pool.status.assign(5, 0);
+      pool.RunSequential(&v, 5);
+   }
+
+   ASSERT_EQ(5u, pool.GetCount());
+   unsigned int first = atoi(pool.GetResult(0).c_str());
+   EXPECT_GT(first, 0u) << "counter doesn't run" << endl;
+   for(unsigned int i = 0; i < 5; i++) {
+      if(i == 3) {
+         EXPECT_EQ(1, pool.GetStatus(i)) << "variant out of flash isn't a error" << endl;
+         continue;
+      }
+      EXPECT_EQ(0, pool.GetStatus(i)) << "variant " << i << endl;
+      EXPECT_EQ(first + 1000 * i, (unsigned int)atoi(pool.GetResult(i).c_str())) << "variant " << i << endl;
+   }
+
+   // branch point isn't changed by variants
+   EXPECT_EQ(counter, (unsigned int)(dev1->GetRWMem(v.addr) + 256 * dev1->GetRWMem(v.addr + 1)));
+   EXPECT_EQ(time, SystemClock::Instance().GetCurrentTime());
+   EXPECT_FALSE(access(childExitFile, F_OK) == 0) << "error in variant called exit()" << endl;
+   remove(childExitFile);
+
+   // simulation goes on after the pool
+   SystemClock::Instance().Run(time + 100 * dev1->GetClockFreq());
+   EXPECT_NE(counter, (unsigned int)(dev1->GetRWMem(v.addr) + 256 * dev1->GetRWMem(v.addr + 1)));
+
+   SystemClock::Instance().ResetClock();
+}
+
+TEST( SESSION_FORKPOOL, FORKED)
+{
+   CheckPool(true);
+}
+
+TEST( SESSION_FORKPOOL, SEQUENTIAL)
+{
+   CheckPool(false);
+}
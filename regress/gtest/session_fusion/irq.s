@@ -0,0 +1,75 @@
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+#undef _SFR_IO8
+#define _SFR_IO8(x) (x)
+#undef _SFR_IO16
+#define _SFR_IO16(x) (x)
+
+; timer 0 overflow interrupts hit the idioms, which could be executed as
+; superinstruction (see avr_op_FUSED), on different cycles. Every interrupt
+; logs TCNT0 and the return address to irqlog, so a interrupt, which is taken
+; late, gives a other log.
+
+.comm irqlog, 3*16
+
+.global main
+main:
+    ldi r26, lo8(irqlog)   ; X is log pointer, only used by the irq handler
+    ldi r27, hi8(irqlog)
+    ldi r16, (1<<CS00)     ; timer 0 without prescaler
+    out TCCR0, r16
+    ldi r16, (1<<TOIE0)
+    out TIMSK, r16
+
+    ldi r24, 100           ; interrupts disabled: overflows stay pending
+1:  rcall idioms
+    subi r24, 1
+    brne 1b
+
+    sei                    ; pending overflow is taken here
+2:  rcall idioms
+    ldi r24, 3
+3:  dec r24
+    brne 3b
+    cpi r26, lo8(irqlog+3*16)
+    brne 2b
+    cli
+.global stopsim
+stopsim:
+    rjmp stopsim
+
+idioms:
+    ldi r18, 0x12          ; LDI run
+    ldi r19, 0x34
+    ldi r20, 0x56
+    ldi r21, 0x78
+    push r18               ; PUSH run
+    push r19
+    push r20
+    pop r20                ; POP run
+    pop r19
+    pop r18
+    cp r18, r20            ; compare and branch
+    cpc r19, r21
+    brne 4f
+    nop
+4:  ret
+
+.global TIMER0_OVF_vect
+TIMER0_OVF_vect:
+    push r16
+    push r28
+    push r29
+    in r28, SPL
+    in r29, SPH
+    in r16, TCNT0
+    st X+, r16
+    ldd r16, Y+4           ; return address
+    st X+, r16
+    ldd r16, Y+5
+    st X+, r16
+    pop r29
+    pop r28
+    pop r16
+    reti
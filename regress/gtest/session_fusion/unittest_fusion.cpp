@@ -0,0 +1,47 @@
+#include <iostream>
+using namespace std;
+
+#include "gtest.h"
+
+#include "avrdevice.h"
+#include "memory.h"
+#include "atmega16_32.h"
+#include "systemclock.h"
+
+//! Runs irq.s with or without superinstructions, returns irq log, end time and PC
+static void RunIrqLog(bool fusion, unsigned char *log, SystemClockOffset &endTime, unsigned int &endPc)
+{
+   SystemClock::Instance().ResetClock();
+   AvrDevice *dev1= new AvrDevice_atmega32;
+   dev1->Load("session_fusion/irq.atmega32.o");
+   dev1->SetClockFreq(136);    // 7.3728
+   dev1->SetFusion(fusion);
+   dev1->RegisterTerminationSymbol("stopsim");
+   SystemClock::Instance().Add(dev1);
+   SystemClock::Instance().Endless();
+
+   unsigned int addr = dev1->data->GetAddressAtSymbol("irqlog");
+   for(int i = 0; i < 3*16; i++)
+      log[i] = dev1->GetRWMem(addr + i);
+   endTime = SystemClock::Instance().GetCurrentTime();
+   endPc = dev1->PC;
+   SystemClock::Instance().ResetClock();
+}
+
+TEST( SESSION_FUSION, IRQ_ENTRY)
+{
+   unsigned char log1[3*16], log2[3*16];
+   SystemClockOffset time1, time2;
+   unsigned int pc1, pc2;
+
+   RunIrqLog(false, log1, time1, pc1);
+   RunIrqLog(true, log2, time2, pc2);
+
+   for(int i = 0; i < 16; i++) {
+      EXPECT_EQ(log1[i*3], log2[i*3]) << "Interrupt " << i << " entered on other cycle" << endl;
+      EXPECT_EQ(log1[i*3+1], log2[i*3+1]) << "Interrupt " << i << " with other return address" << endl;
+      EXPECT_EQ(log1[i*3+2], log2[i*3+2]) << "Interrupt " << i << " with other return address" << endl;
+   }
+   EXPECT_EQ(time1, time2) << "Program ends on other time" << endl;
+   EXPECT_EQ(pc1, pc2) << "Program ends on other PC" << endl;
+}
@@ -0,0 +1,60 @@
+#include <avr/io.h>
+
+#undef _SFR_IO8
+#define _SFR_IO8(x) (x)
+
+; every input byte selects a action. Input is read from TWBR, which is
+; replaced by a fuzz input register (FuzzHarness::UsePipeInput), a write to
+; TWSR (replaced by RWAbort) aborts.
+
+.comm mark, 1
+
+.global main
+main:
+.global next
+next:
+    in r16, TWBR
+    cpi r16, 'I'
+    breq illegal
+    cpi r16, 'S'
+    breq recurse
+    cpi r16, 'F'
+    breq outofflash
+    cpi r16, 'A'
+    breq abort
+    cpi r16, 'T'
+    breq timeout
+    cpi r16, 'M'
+    breq setmark
+    cpi r16, 'R'
+    breq readmark
+    rjmp next
+
+illegal:                   ; illegal opcode
+    .word 0xffff
+
+recurse:                   ; stack overflow
+    rcall recurse
+
+outofflash:                ; jump behind end of flash
+    ldi r30, 0xff
+    ldi r31, 0xff
+    ijmp
+
+abort:
+    out TWSR, r16
+    rjmp next
+
+timeout:                   ; loop without reading input
+    rjmp timeout
+
+setmark:                   ; mark is kept in data memory, but not for next input
+    ldi r17, 1
+    sts mark, r17
+    rjmp next
+
+readmark:                  ; crashes, if mark was set before
+    lds r17, mark
+    tst r17
+    brne illegal
+    rjmp next
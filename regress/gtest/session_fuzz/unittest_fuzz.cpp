@@ -0,0 +1,93 @@
+#include <iostream>
+#include <string.h>
+#include <vector>
+using namespace std;
+
+#include "gtest.h"
+
+#include "avrdevice.h"
+#include "memory.h"
+#include "flash.h"
+#include "atmega16_32.h"
+#include "systemclock.h"
+#include "specialmem.h"
+#include "fuzzharness.h"
+
+class FuzzTest: public ::testing::Test {
+   protected:
+      AvrDevice *dev1;
+      FuzzHarness *harness;
+
+      void SetUp() {
+         SystemClock::Instance().ResetClock();
+         dev1 = new AvrDevice_atmega32;
+         dev1->Load("session_fuzz/crash.atmega32.o");
+         dev1->SetClockFreq(125);
+         dev1->ReplaceIoRegister(0x21, new RWAbort(dev1, "ABORT"));   // TWSR
+         SystemClock::Instance().Add(dev1);
+         harness = new FuzzHarness(dev1);
+         harness->UsePipeInput(0x20);                                 // TWBR
+         harness->SetMaxCycles(10000);
+         harness->SetStackLimit(0x800);
+      }
+
+      void TearDown() {
+         delete harness;
+         SystemClock::Instance().ResetClock();
+         sysConHandler.SetUseExit(true);
+      }
+
+      FuzzHarness::FuzzResult Run(const char *input) {
+         return harness->RunInput((const unsigned char *)input, strlen(input));
+      }
+};
+
+TEST_F(FuzzTest, RESULTS)
+{
+   EXPECT_EQ(FuzzHarness::FUZZ_OK, Run("xyz"));
+   EXPECT_EQ(FuzzHarness::FUZZ_ILLEGAL_OPCODE, Run("xI"));
+   EXPECT_EQ(FuzzHarness::FUZZ_STACK_OVERFLOW, Run("S"));
+   EXPECT_EQ(FuzzHarness::FUZZ_OUT_OF_FLASH, Run("F"));
+   EXPECT_EQ(FuzzHarness::FUZZ_ABORT, Run("A"));
+   EXPECT_EQ(FuzzHarness::FUZZ_TIMEOUT, Run("T"));
+   // harness is usable after all crashes
+   EXPECT_EQ(FuzzHarness::FUZZ_OK, Run("xyz"));
+   EXPECT_TRUE(FuzzHarness::IsCrash(FuzzHarness::FUZZ_ABORT));
+   EXPECT_FALSE(FuzzHarness::IsCrash(FuzzHarness::FUZZ_TIMEOUT));
+}
+
+TEST_F(FuzzTest, BRANCH_POINT_RESET)
+{
+   // mark in data memory crashes within the same input ...
+   EXPECT_EQ(FuzzHarness::FUZZ_ILLEGAL_OPCODE, Run("MR"));
+   // ... but not in the next one
+   EXPECT_EQ(FuzzHarness::FUZZ_OK, Run("M"));
+   EXPECT_EQ(FuzzHarness::FUZZ_OK, Run("R"));
+
+   // coverage of a input doesn't depend on inputs before
+   unsigned int size = harness->GetCoverageSize();
+   harness->ClearCoverage();
+   Run("R");
+   vector<unsigned char> first(harness->GetCoverageMap(), harness->GetCoverageMap() + size);
+   harness->ClearCoverage();
+   Run("MMxS");
+   Run("T");
+   harness->ClearCoverage();
+   Run("R");
+   vector<unsigned char> second(harness->GetCoverageMap(), harness->GetCoverageMap() + size);
+   EXPECT_TRUE(first == second) << "coverage of last run leaks into next run" << endl;
+
+   unsigned int edges = 0;
+   for(unsigned int i = 0; i < size; i++)
+      edges += (first[i] != 0);
+   EXPECT_GT(edges, 5u) << "no coverage collected" << endl;
+}
+
+TEST_F(FuzzTest, BRANCH_POINT_AT)
+{
+   unsigned int pc = dev1->Flash->GetAddressAtSymbol("next");
+   ASSERT_TRUE(harness->SetBranchPointAt(pc)) << harness->GetErrorMessage() << endl;
+   EXPECT_EQ(pc, dev1->PC);
+   EXPECT_EQ(FuzzHarness::FUZZ_ILLEGAL_OPCODE, Run("I"));
+   EXPECT_EQ(FuzzHarness::FUZZ_OK, Run("R"));
+}
@@ -0,0 +1,107 @@
+#include <iostream>
+using namespace std;
+
+#include "gtest.h"
+
+#include "pin.h"
+#include "net.h"
+
+//! Returns resolved state of net, checks it against a full recalculation
+static char NetState(Net &net) {
+   Pin::T_Pinstate incremental = net.lastState;
+   net.CalcNet();
+   EXPECT_EQ(net.lastState, incremental) << "incremental resolution differs from full one" << endl;
+   return (char)Pin(incremental);
+}
+
+TEST(SESSION_NET, MIXED_DRIVERS)
+{
+   unsigned char port = 0;
+   Pin in(&port, 1);          // port pin, which reads the net
+   Pin a, b, c, ctl;
+   OpenDrain od(&ctl);
+   Net net;
+   net.Add(&in);
+   net.Add(&a);
+   net.Add(&b);
+   net.Add(&c);
+   net.Add(&od);
+   ctl = 'L';                 // open drain doesn't drive
+
+   EXPECT_EQ('t', NetState(net));
+   a = 'h';
+   EXPECT_EQ('h', NetState(net));
+   EXPECT_EQ(1, port & 1);
+   // pull up and pull down together float, also with a second pull up
+   b = 'l';
+   EXPECT_EQ('t', NetState(net));
+   c = 'h';
+   EXPECT_EQ('t', NetState(net));
+   // open drain pulls down against the pulls
+   ctl = 'H';
+   EXPECT_EQ('L', NetState(net));
+   EXPECT_EQ(0, port & 1);
+   a = 'H';
+   EXPECT_EQ('S', NetState(net));
+   // open drain releases the net
+   ctl = 'L';
+   EXPECT_EQ('H', NetState(net));
+   EXPECT_EQ(1, port & 1);
+   a = 't';
+   b = 't';
+   EXPECT_EQ('h', NetState(net));
+   c = 't';
+   EXPECT_EQ('t', NetState(net));
+
+   // analog value is given to all pins, if no other pin drives the net
+   c = 'a';
+   c.SetAnalogValue(2.5);
+   EXPECT_EQ('a', NetState(net));
+   EXPECT_EQ(AnalogValue::ST_ANALOG, net.lastAnalog.getD());
+   EXPECT_FLOAT_EQ(2.5, net.lastAnalog.getRaw());
+   EXPECT_FLOAT_EQ(2.5, in.GetRawAnalog());
+   // also a pull is a short for a analog value
+   b = 'l';
+   EXPECT_EQ('A', NetState(net));
+   b = 't';
+   EXPECT_EQ('a', NetState(net));
+   ctl = 'H';
+   EXPECT_EQ('A', NetState(net));
+   // a digital short has precedence
+   a = 'H';
+   EXPECT_EQ('S', NetState(net));
+   a = 't';
+   ctl = 'L';
+   c.SetAnalogValue(1.0);
+   EXPECT_EQ('a', NetState(net));
+   EXPECT_FLOAT_EQ(1.0, in.GetRawAnalog());
+}
+
+TEST(SESSION_NET, ORDER_INDEPENDENT)
+{
+   // same drivers, added in different order, give the same result
+   Pin u1(Pin::PULLUP), d(Pin::PULLDOWN), u2(Pin::PULLUP);
+   Net net1;
+   net1.Add(&u1);
+   net1.Add(&u2);
+   net1.Add(&d);
+   EXPECT_EQ('t', NetState(net1));
+
+   Pin v1(Pin::PULLUP), e(Pin::PULLDOWN), v2(Pin::PULLUP);
+   Net net2;
+   net2.Add(&v1);
+   net2.Add(&e);
+   net2.Add(&v2);
+   EXPECT_EQ('t', NetState(net2));
+
+   Pin h(Pin::HIGH), l(Pin::LOW), an(2.0f);
+   Net net3;
+   net3.Add(&an);
+   net3.Add(&h);
+   net3.Add(&l);
+   EXPECT_EQ('S', NetState(net3));
+   // removed pin doesn't count anymore
+   l.UnRegisterNet(&net3);
+   h = 'L';
+   EXPECT_EQ('A', NetState(net3));
+}
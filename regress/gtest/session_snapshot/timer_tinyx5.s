@@ -0,0 +1,45 @@
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+#undef _SFR_IO8
+#define _SFR_IO8(x) (x)
+#undef _SFR_IO16
+#define _SFR_IO16(x) (x)
+
+; timer 1 runs async from pll clock with compare and overflow interrupts,
+; the main loop sums up the counter values read.
+
+.global main
+main:
+    ldi r16, (1<<PLLE)     ; start pll
+    out PLLCSR, r16
+1:  in r16, PLLCSR         ; wait for pll lock
+    sbrs r16, PLOCK
+    rjmp 1b
+    ori r16, (1<<PCKE)     ; timer 1 is clocked by pll
+    out PLLCSR, r16
+
+    ldi r16, 0x40
+    out OCR1A, r16
+    ldi r16, (1<<CS12)     ; prescaler 8
+    out TCCR1, r16
+    ldi r16, (1<<OCIE1A)|(1<<TOIE1)
+    out TIMSK, r16
+    clr r20
+    clr r21
+    clr r23
+    sei
+
+2:  in r22, TCNT1
+    add r23, r22
+    rjmp 2b
+
+.global TIMER1_COMPA_vect
+TIMER1_COMPA_vect:
+    inc r20
+    reti
+
+.global TIMER1_OVF_vect
+TIMER1_OVF_vect:
+    inc r21
+    reti
@@ -0,0 +1,66 @@
+#include <iostream>
+#include <cstdio>
+using namespace std;
+
+#include "gtest.h"
+
+#include "avrdevice.h"
+#include "attiny25_45_85.h"
+#include "systemclock.h"
+#include "snapshot.h"
+
+//! Device state, which is compared after restore of a snapshot
+struct DeviceState {
+   unsigned char regs[32];
+   unsigned char tcnt1;
+   unsigned char tifr;
+   unsigned char sreg;
+   unsigned int pc;
+   SystemClockOffset time;
+};
+
+static void GetState(AvrDevice *dev, DeviceState &s)
+{
+   for(int i = 0; i < 32; i++)
+      s.regs[i] = dev->GetRWMem(i);
+   s.tcnt1 = dev->GetRWMem(0x4f);
+   s.tifr = dev->GetRWMem(0x58);
+   s.sreg = dev->GetRWMem(0x5f);
+   s.pc = dev->PC;
+   s.time = SystemClock::Instance().GetCurrentTime();
+}
+
+TEST( SESSION_SNAPSHOT, TIMER_TINYX5)
+{
+   SystemClock::Instance().ResetClock();
+   AvrDevice *dev1= new AvrDevice_attiny85;
+   dev1->Load("session_snapshot/timer_tinyx5.attiny85.o");
+   dev1->SetClockFreq(125);    // 8MHz
+   SystemClock::Instance().Add(dev1);
+
+   // pll is locked after 100us, timer 1 runs async after that
+   SystemClock::Instance().RunTimeRange(500000);
+   const char *snapshot = "session_snapshot/timer_tinyx5.snapshot";
+   SaveSnapshot(dev1, snapshot);
+
+   DeviceState s1, s2;
+   SystemClock::Instance().RunTimeRange(300000);
+   GetState(dev1, s1);
+
+   RestoreSnapshot(dev1, snapshot);
+   remove(snapshot);
+   SystemClock::Instance().RunTimeRange(300000);
+   GetState(dev1, s2);
+
+   EXPECT_NE(0, s1.regs[20]) << "No compare interrupt" << endl;
+   EXPECT_NE(0, s1.regs[21]) << "No overflow interrupt" << endl;
+   for(int i = 0; i < 32; i++)
+      EXPECT_EQ(s1.regs[i], s2.regs[i]) << "Register " << i << " differs after restore" << endl;
+   EXPECT_EQ(s1.tcnt1, s2.tcnt1) << "TCNT1 differs after restore" << endl;
+   EXPECT_EQ(s1.tifr, s2.tifr) << "TIFR differs after restore" << endl;
+   EXPECT_EQ(s1.sreg, s2.sreg) << "SREG differs after restore" << endl;
+   EXPECT_EQ(s1.pc, s2.pc) << "PC differs after restore" << endl;
+   EXPECT_EQ(s1.time, s2.time) << "Simulation time differs after restore" << endl;
+
+   SystemClock::Instance().ResetClock();
+}
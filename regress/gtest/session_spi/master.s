@@ -0,0 +1,54 @@
+#include <avr/io.h>
+
+#undef _SFR_IO8
+#define _SFR_IO8(x) (x)
+#undef _SFR_IO16
+#define _SFR_IO16(x) (x)
+
+; SPI master sends the same 4 bytes with DORD=0 and then with DORD=1. After
+; SPIF is seen, TCNT1L and the received byte are logged to SRAM at 0x100, so
+; a SPIF, which is set on a other cycle, gives a other log.
+
+.global main
+main:
+    ldi r16, hi8(RAMEND)
+    out SPH, r16
+    ldi r16, lo8(RAMEND)
+    out SPL, r16
+    ldi r26, lo8(0x100)    ; X is log pointer
+    ldi r27, hi8(0x100)
+    ldi r16, (1<<PB7)|(1<<PB5)|(1<<PB4)  ; SCK, MOSI and /SS are outputs
+    out DDRB, r16
+    ldi r16, (1<<CS10)     ; timer 1 without prescaler
+    out TCCR1B, r16
+
+    ldi r16, (1<<SPE)|(1<<MSTR)|(1<<SPR0)
+    out SPCR, r16
+    rcall send
+    ldi r16, (1<<SPE)|(1<<MSTR)|(1<<DORD)|(1<<SPR0)
+    out SPCR, r16
+    rcall send
+.global stopsim
+stopsim:
+    rjmp stopsim
+
+send:
+    ldi r17, 0x01
+    rcall xfer
+    ldi r17, 0xa5
+    rcall xfer
+    ldi r17, 0x3c
+    rcall xfer
+    ldi r17, 0x80
+    rcall xfer
+    ret
+
+xfer:
+    out SPDR, r17
+1:  sbis SPSR, SPIF
+    rjmp 1b
+    in r18, TCNT1L
+    st X+, r18
+    in r18, SPDR
+    st X+, r18
+    ret
@@ -0,0 +1,114 @@
+#include <iostream>
+#include <vector>
+using namespace std;
+
+#include "gtest.h"
+
+#include "avrdevice.h"
+#include "atmega16_32.h"
+#include "systemclock.h"
+#include "hwspi.h"
+#include "net.h"
+
+//! Bytes sent by master.s, first with DORD=0, then with DORD=1
+static const unsigned char sent[8] = { 0x01, 0xa5, 0x3c, 0x80, 0x01, 0xa5, 0x3c, 0x80 };
+
+//! Slave, which logs the bytes given by Transfer and answers with the inverted byte
+/*! If pins are on the SCK and MOSI nets, it also shifts in MOSI on the rising
+  SCK edge, like a real slave with CPOL=0 and CPHA=0. */
+class LogSlave: public SpiSlave, public HasPinNotifyFunction {
+
+    public:
+        Pin *sck, *mosi;
+        vector<unsigned char> bytes;
+        vector<SystemClockOffset> times;
+        vector<unsigned char> sampled;
+        unsigned char shift;
+        int bits;
+
+        LogSlave(AvrDevice *dev): shift(0), bits(0) {
+            sck = dev->GetPin("B7");
+            mosi = dev->GetPin("B5");
+        }
+        bool IsSelected(void) { return true; }
+        unsigned char Transfer(unsigned char m) {
+            bytes.push_back(m);
+            times.push_back(SystemClock::Instance().GetCurrentTime());
+            return ~m;
+        }
+        void PinStateHasChanged(Pin *) {
+            if(sck->outState != Pin::HIGH)
+                return;
+            shift = (shift << 1) | (mosi->outState == Pin::HIGH ? 1 : 0);
+            if(++bits == 8) {
+                sampled.push_back(shift);
+                bits = 0;
+            }
+        }
+};
+
+//! Reverses bit order of a byte
+static unsigned char Reverse(unsigned char b) {
+    unsigned char r = 0;
+    for(int i = 0; i < 8; i++)
+        if(b & (1 << i))
+            r |= 0x80 >> i;
+    return r;
+}
+
+//! Runs master.s with a attached slave, with pins on SCK and MOSI nets, if bitLevel is set
+static void RunSpi(bool bitLevel, LogSlave *&slave, unsigned char *log) {
+    SystemClock::Instance().ResetClock();
+    AvrDevice *dev1 = new AvrDevice_atmega32;
+    dev1->Load("session_spi/master.atmega32.o");
+    dev1->SetClockFreq(125);
+    SystemClock::Instance().Add(dev1);
+    HWSpi *spi = dynamic_cast<HWSpi *>(dev1->FindScopeGroupByName("SPI"));
+    ASSERT_TRUE(spi != NULL);
+    slave = new LogSlave(dev1);
+    spi->AttachSlave(slave);
+
+    Net sckNet, mosiNet;
+    Pin sckListener, mosiListener;
+    if(bitLevel) {
+        sckNet.Add(slave->sck);
+        sckNet.Add(&sckListener);
+        mosiNet.Add(slave->mosi);
+        mosiNet.Add(&mosiListener);
+        sckListener.RegisterCallback(slave);
+    }
+
+    // a byte takes 16 SPI clock phases of 16 cycles
+    SystemClock::Instance().Run(8 * 400 * 125);
+    for(int i = 0; i < 16; i++)
+        log[i] = dev1->GetRWMem(0x100 + i);
+    spi->DetachSlave(slave);
+    SystemClock::Instance().ResetClock();
+}
+
+TEST(SESSION_SPI, BYTE_TRANSFER_DORD)
+{
+    LogSlave *byteSlave, *bitSlave;
+    unsigned char byteLog[16], bitLog[16];
+    RunSpi(false, byteSlave, byteLog);
+    RunSpi(true, bitSlave, bitLog);
+
+    ASSERT_EQ(8u, byteSlave->bytes.size());
+    ASSERT_EQ(8u, bitSlave->bytes.size());
+    ASSERT_EQ(8u, bitSlave->sampled.size()) << "pins not driven bit by bit" << endl;
+    EXPECT_EQ(0u, byteSlave->sampled.size());
+    for(int i = 0; i < 8; i++) {
+        // slave gets byte like it was shifted in bit by bit, LSB first with DORD=1
+        unsigned char expected = (i < 4) ? sent[i] : Reverse(sent[i]);
+        EXPECT_EQ(expected, byteSlave->bytes[i]) << "byte " << i << endl;
+        EXPECT_EQ(bitSlave->sampled[i], byteSlave->bytes[i]) << "byte " << i << " differs from MOSI bits" << endl;
+        EXPECT_EQ(bitSlave->bytes[i], byteSlave->bytes[i]) << "byte " << i << endl;
+        EXPECT_EQ(bitSlave->times[i], byteSlave->times[i]) << "byte " << i << " exchanged on other time" << endl;
+        // SPIF is seen on the same cycle and master gets the slave answer
+        EXPECT_EQ(bitLog[i*2], byteLog[i*2]) << "SPIF of byte " << i << " on other cycle" << endl;
+        EXPECT_EQ((unsigned char)~sent[i], byteLog[i*2+1]) << "byte " << i << endl;
+        EXPECT_EQ(bitLog[i*2+1], byteLog[i*2+1]) << "byte " << i << endl;
+    }
+    delete byteSlave;
+    delete bitSlave;
+}
@@ -0,0 +1,17 @@
+#include <avr/io.h>
+
+#undef _SFR_IO8
+#define _SFR_IO8(x) (x)
+
+; Copies input B0 to output B1, B1 follows B0 within a few cycles.
+
+.global main
+main:
+    ldi r16, (1<<PB1)
+    out DDRB, r16
+loop:
+    sbis PINB, PB0
+    cbi PORTB, PB1
+    sbic PINB, PB0
+    sbi PORTB, PB1
+    rjmp loop
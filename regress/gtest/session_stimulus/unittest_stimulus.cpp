@@ -0,0 +1,115 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+using namespace std;
+
+#include "gtest.h"
+
+#include "avrdevice.h"
+#include "atmega16_32.h"
+#include "systemclock.h"
+#include "stimulus.h"
+
+//! Waveform for B0, B1 follows it
+static const char *drive =
+   "# time,pin,value\n"
+   "0,B0,0\n"
+   "10us,B0,1\n"
+   "20us,B0,0\n"
+   "30us,B0,h\n"
+   "40us,B0,l\n"
+   "45us,B0,1\n";
+
+//! Expected output on B1 and B0, which is a input
+static const char *checks =
+   "5us,?B0,z\n"
+   "5us,?B1,0\n"
+   "15us,?B1,1\n"
+   "25us,?B1,0\n"
+   "35us,?B1,1\n"
+   "42us,?B1,0\n"
+   "48us,?B1,1\n";
+
+static void WriteFile(const char *name, const char *content) {
+   FILE *f = fopen(name, "w");
+   ASSERT_TRUE(f != NULL);
+   fputs(content, f);
+   fclose(f);
+}
+
+//! Runs copy.s for 50us with the given stimulus files, optionally records B1
+static Stimulus *RunStimulus(const vector<string> &files, const char *record = NULL) {
+   SystemClock::Instance().ResetClock();
+   AvrDevice *dev1 = new AvrDevice_atmega32;
+   dev1->Load("session_stimulus/copy.atmega32.o");
+   dev1->SetClockFreq(125);
+   SystemClock::Instance().Add(dev1);
+   Stimulus *stim = new Stimulus(dev1);
+   for(size_t i = 0; i < files.size(); i++)
+      stim->Load(files[i]);
+   if(record != NULL)
+      stim->Record(record, vector<string>(1, "B1"));
+   SystemClock::Instance().Add(stim);
+   SystemClock::Instance().Run(50000);
+   EXPECT_TRUE(stim->IsFinished()) << "not all events processed" << endl;
+   return stim;
+}
+
+TEST(SESSION_STIMULUS, CSV_CHECKS)
+{
+   WriteFile("session_stimulus/drive.csv", drive);
+   WriteFile("session_stimulus/checks.csv", checks);
+   vector<string> files;
+   files.push_back("session_stimulus/drive.csv");
+   files.push_back("session_stimulus/checks.csv");
+   Stimulus *stim = RunStimulus(files);
+   EXPECT_EQ(7u, stim->GetChecks());
+   EXPECT_EQ(0u, stim->GetErrors());
+   delete stim;
+
+   // a wrong expectation is found
+   WriteFile("session_stimulus/wrong.csv", "15us,?B1,0\n25us,?B1,0\n");
+   files[1] = "session_stimulus/wrong.csv";
+   stim = RunStimulus(files);
+   EXPECT_EQ(2u, stim->GetChecks());
+   EXPECT_EQ(1u, stim->GetErrors());
+   delete stim;
+   SystemClock::Instance().ResetClock();
+}
+
+TEST(SESSION_STIMULUS, RECORD_ROUND_TRIP)
+{
+   WriteFile("session_stimulus/drive.csv", drive);
+   vector<string> files(1, "session_stimulus/drive.csv");
+   Stimulus *stim = RunStimulus(files, "session_stimulus/record.csv");
+   EXPECT_EQ(0u, stim->GetChecks());
+   delete stim;
+
+   // initial state (input before DDRB is set) and every edge of B1 is recorded
+   unsigned int lines = 0;
+   FILE *f = fopen("session_stimulus/record.csv", "r");
+   ASSERT_TRUE(f != NULL);
+   char buf[128];
+   while(fgets(buf, sizeof(buf), f) != NULL)
+      if(strstr(buf, ",?B1,") != NULL)
+         lines++;
+   fclose(f);
+   EXPECT_EQ(7u, lines);
+
+   // recorded file checks the same run
+   files.push_back("session_stimulus/record.csv");
+   stim = RunStimulus(files);
+   EXPECT_EQ(lines, stim->GetChecks());
+   EXPECT_EQ(0u, stim->GetErrors());
+   delete stim;
+
+   // and finds a changed waveform
+   WriteFile("session_stimulus/drive.csv", "0,B0,0\n10us,B0,1\n");
+   stim = RunStimulus(files);
+   EXPECT_EQ(lines, stim->GetChecks());
+   EXPECT_GT(stim->GetErrors(), 0u);
+   delete stim;
+   SystemClock::Instance().ResetClock();
+}
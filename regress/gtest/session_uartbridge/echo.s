@@ -0,0 +1,24 @@
+#include <avr/io.h>
+
+#undef _SFR_IO8
+#define _SFR_IO8(x) (x)
+
+; Echoes every byte received by UART, incremented by one. UBRR is 0, so a
+; frame takes only 160 cycles.
+
+.global main
+main:
+    ldi r16, 0
+    out UBRRL, r16
+    ldi r16, (1<<RXEN)|(1<<TXEN)
+    out UCSRB, r16
+wait_rx:
+    sbis UCSRA, RXC
+    rjmp wait_rx
+    in r16, UDR
+    inc r16
+wait_tx:
+    sbis UCSRA, UDRE
+    rjmp wait_tx
+    out UDR, r16
+    rjmp wait_rx
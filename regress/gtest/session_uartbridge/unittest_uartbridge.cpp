@@ -0,0 +1,78 @@
+#include <iostream>
+#include <string>
+#include <stdio.h>
+#include <unistd.h>
+using namespace std;
+
+#include "gtest.h"
+
+#include "avrdevice.h"
+#include "atmega16_32.h"
+#include "systemclock.h"
+#include "hwuart.h"
+#include "ui/uartbridge.h"
+
+//! Writes a file with given content
+static void WriteFile(const char *name, const string &content) {
+   FILE *f = fopen(name, "wb");
+   ASSERT_TRUE(f != NULL);
+   fwrite(content.data(), 1, content.size(), f);
+   fclose(f);
+}
+
+//! Reads a whole file
+static string ReadFile(const char *name) {
+   string content;
+   FILE *f = fopen(name, "rb");
+   if(f == NULL)
+      return content;
+   int c;
+   while((c = fgetc(f)) != EOF)
+      content += (char)c;
+   fclose(f);
+   return content;
+}
+
+TEST(SESSION_UARTBRIDGE, FILE_STREAM)
+{
+   string input = "Hello, simulavr!\n";
+   for(int i = 0; i < 200; i++)
+      input += (char)('a' + i % 26);
+   WriteFile("session_uartbridge/in.txt", input);
+
+   SystemClock::Instance().ResetClock();
+   AvrDevice *dev1 = new AvrDevice_atmega32;
+   dev1->Load("session_uartbridge/echo.atmega32.o");
+   dev1->SetClockFreq(125);
+   SystemClock::Instance().Add(dev1);
+   HWUart *uart = dynamic_cast<HWUart *>(dev1->FindScopeGroupByName("UART0"));
+   ASSERT_TRUE(uart != NULL);
+   UartBridge *bridge = UartBridge::Create("file:session_uartbridge/in.txt,session_uartbridge/out.txt");
+   uart->SetBridge(bridge);
+
+   // a frame takes 160 cycles, echo is one frame later, give some reserve
+   SystemClock::Instance().Run((input.size() + 10) * 160 * 125);
+   uart->SetBridge(NULL);
+   delete bridge;
+
+   string expected;
+   for(size_t i = 0; i < input.size(); i++)
+      expected += (char)(input[i] + 1);
+   EXPECT_EQ(expected, ReadFile("session_uartbridge/out.txt"));
+
+   SystemClock::Instance().ResetClock();
+}
+
+TEST(SESSION_UARTBRIDGE, CLOSED_HOST)
+{
+   // creating a bridge ignores SIGPIPE, otherwise this test would be killed
+   delete UartBridge::Create("file:,");
+
+   int fds[2];
+   ASSERT_EQ(0, pipe(fds));
+   close(fds[0]);
+   FdUartBridge bridge(-1, fds[1]);
+   EXPECT_TRUE(bridge.WriteByte('x')) << "byte for a closed host isn't dropped" << endl;
+   EXPECT_EQ(-1, bridge.outFd) << "closed host isn't detected" << endl;
+   EXPECT_TRUE(bridge.WriteByte('y'));
+}
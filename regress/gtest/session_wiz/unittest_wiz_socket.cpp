@@ -0,0 +1,74 @@
+#include <iostream>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+using namespace std;
+
+#include "gtest.h"
+
+#include "wiz_socket.h"
+
+//! Listen port of the test, above 1000 and not remapped
+static const unsigned int TEST_PORT = 0x9a31;
+
+//! Polls the host and steps the socket until the status register has the expected value
+static bool WaitStatus(wiz_socket &skt, unsigned char status) {
+   for(int i = 0; i < 1000; i++) {
+      if(wiz_socket::pollHost())
+         skt.step();
+      if(skt.getRegValue(wiz_socket::SR_OFFSET) == status)
+         return true;
+      usleep(1000);
+   }
+   return false;
+}
+
+TEST(SESSION_WIZ, LOOPBACK_LISTEN_RECEIVE)
+{
+   wiz_socket skt;
+   skt.setRegValue(wiz_socket::MR_OFFSET, wiz_socket::SKT_MR_TCP);
+   skt.setRegValue(wiz_socket::PORT_OFFSET, TEST_PORT >> 8);
+   skt.setRegValue(wiz_socket::PORT_OFFSET + 1, TEST_PORT & 0xff);
+   skt.setRegValue(wiz_socket::CR_OFFSET, wiz_socket::SKT_CR_OPEN);
+   ASSERT_EQ((int)wiz_socket::SKT_SR_INIT, skt.getRegValue(wiz_socket::SR_OFFSET));
+   skt.setRegValue(wiz_socket::CR_OFFSET, wiz_socket::SKT_CR_LISTEN);
+   ASSERT_EQ((int)wiz_socket::SKT_SR_LISTEN, skt.getRegValue(wiz_socket::SR_OFFSET)) << "bind failed" << endl;
+
+   // nothing to do without a client
+   EXPECT_FALSE(wiz_socket::pollHost());
+   skt.step();
+   EXPECT_EQ((int)wiz_socket::SKT_SR_LISTEN, skt.getRegValue(wiz_socket::SR_OFFSET));
+
+   // client connects to the listening socket on 127.0.0.100
+   int client = socket(AF_INET, SOCK_STREAM, 0);
+   ASSERT_GT(client, 0);
+   struct sockaddr_in addr;
+   memset(&addr, 0, sizeof(addr));
+   addr.sin_family = AF_INET;
+   addr.sin_addr.s_addr = htonl(0x7f000064);
+   addr.sin_port = htons(TEST_PORT);
+   ASSERT_EQ(0, connect(client, (struct sockaddr *)&addr, sizeof(addr)));
+   EXPECT_TRUE(WaitStatus(skt, wiz_socket::SKT_SR_ESTABLISHED)) << "connection not accepted" << endl;
+   EXPECT_EQ(127, skt.getRegValue(wiz_socket::DIPR_OFFSET));
+
+   // data of the client is received into the rx buffer
+   const char *msg = "hello";
+   ASSERT_EQ(5, send(client, msg, 5, 0));
+   for(int i = 0; i < 1000 && !(skt.getRegValue(wiz_socket::IR_OFFSET) & wiz_socket::SKT_IR_RECV); i++) {
+      if(wiz_socket::pollHost())
+         skt.step();
+      usleep(1000);
+   }
+   EXPECT_TRUE(skt.getRegValue(wiz_socket::IR_OFFSET) & wiz_socket::SKT_IR_RECV) << "no data received" << endl;
+   EXPECT_EQ(0, skt.getRegValue(wiz_socket::RX_RSR_OFFSET));
+   EXPECT_EQ(5, skt.getRegValue(wiz_socket::RX_RSR_OFFSET + 1));
+   for(int i = 0; i < 5; i++)
+      EXPECT_EQ(msg[i], (char)skt.getRxBufferValue(i));
+   EXPECT_FALSE(wiz_socket::pollHost()) << "descriptor still ready after all data is read" << endl;
+
+   // client closes, socket is closed too
+   close(client);
+   EXPECT_TRUE(WaitStatus(skt, wiz_socket::SKT_SR_CLOSED)) << "disconnect not detected" << endl;
+}
@@ -0,0 +1,26 @@
+#include <avr/io.h>
+
+volatile unsigned char in_loop = 0;
+volatile unsigned char cmd = 0;
+volatile unsigned char buf[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+volatile unsigned short sum = 0;
+volatile long lvar = 0x12345678;
+
+int main(void) {
+    unsigned char i;
+    unsigned short s;
+
+    do {
+        in_loop = 1;
+        if(cmd == 1) {
+            // sum of buf, buf is written from python
+            s = 0;
+            for(i = 0; i < sizeof(buf); i++)
+                s += buf[i];
+            sum = s;
+            cmd = 0;
+        }
+    } while(1); // do forever
+}
+
+// EOF
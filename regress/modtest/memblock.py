@@ -0,0 +1,88 @@
+from simtestutil import SimTestCase, SimTestLoader
+import pysimulavr
+
+class TestCase(SimTestCase):
+
+  DELAY = 20000 # run 20 microseconds
+
+  def runSum(self):
+    self.dev.write_var("cmd", 1)
+    self.sim.doRun(self.sim.getCurrentTime() + self.DELAY)
+    self.assertEqual(self.dev.read_var("cmd"), 0, "sum isn't calculated")
+    return self.dev.read_var("sum", "H")
+
+  def test_00(self):
+    """read and write data space by read_block, write_block and read_var"""
+    self.assertDevice()
+    self.assertStartTime()
+    self.assertInitDone()
+    self.sim.doRun(self.sim.getCurrentTime() + self.DELAY)
+    self.assertEqual(self.dev.read_var("in_loop"), 1, "not in idle loop")
+    self.assertEqual(self.dev.read_var("lvar", "l"), 0x12345678)
+    self.assertEqual(self.dev.read_var("buf", "8B"), (1, 2, 3, 4, 5, 6, 7, 8))
+    addr = self.dev.data.GetAddressAtSymbol("buf")
+    self.assertEqual(bytearray(self.dev.read_block(addr, 8)), bytearray(range(1, 9)))
+    self.assertEqual(self.runSum(), 36)
+    # write from python, calculate in AVR
+    self.dev.write_var("buf", [10 * i for i in range(1, 9)], "8B")
+    self.assertEqual(self.runSum(), 360)
+    self.dev.write_block(addr, bytearray([0xff] * 8))
+    self.assertEqual(self.runSum(), 8 * 0xff)
+    self.assertEqual(len(self.dev.get_registers()), 32)
+    # address range is checked
+    total = self.dev.GetMemTotalSize()
+    self.assertRaises(SystemError, self.dev.read_block, total - 1, 2)
+    self.assertRaises(SystemError, self.dev.write_block, total, b"\0")
+
+  def test_01(self):
+    """read and write flash by view, read_block and write_block"""
+    self.assertDevice()
+    self.assertInitDone()
+    flash = self.dev.Flash
+    size = flash.GetSize()
+    view = flash.view()
+    self.assertEqual(len(view), size)
+    # view has words high byte first, read_block in order of elf file
+    code = bytearray(flash.read_block(0, 64))
+    words = bytearray(view[0:64])
+    for i in range(64):
+      self.assertEqual(code[i], words[i ^ 1], "flash byte %d differs" % i)
+    # flash can't be changed by view, because it has to be decoded
+    def writeView():
+      view[0:1] = b"\0"
+    self.assertRaises(TypeError, writeView)
+    # write back same code, program has to work further
+    flash.write_block(0, bytes(code))
+    self.assertEqual(bytearray(flash.read_block(0, 64)), code)
+    self.sim.doRun(self.sim.getCurrentTime() + self.DELAY)
+    self.assertEqual(self.runSum(), 36)
+    # only whole words in flash can be written
+    self.assertRaises(SystemError, flash.write_block, 1, b"\0\0")
+    self.assertRaises(SystemError, flash.write_block, 0, b"\0\0\0")
+    self.assertRaises(SystemError, flash.write_block, size - 2, b"\0\0\0\0")
+    self.assertRaises(SystemError, flash.read_block, size - 2, 4)
+
+  def test_02(self):
+    """read and write eeprom by view, read_block and write_block"""
+    self.assertDevice()
+    eeprom = self.dev.eeprom
+    size = eeprom.GetSize()
+    eeprom.write_block(1, b"\x11\x22\x33")
+    self.assertEqual(bytearray(eeprom.read_block(0, 4))[1:], bytearray(b"\x11\x22\x33"))
+    self.assertEqual(eeprom.ReadFromAddress(2), 0x22)
+    view = eeprom.view()
+    self.assertEqual(len(view), size)
+    self.assertEqual(bytearray(view[1:4]), bytearray(b"\x11\x22\x33"))
+    # eeprom view is writable
+    view[0:1] = b"\x5a"
+    self.assertEqual(eeprom.ReadFromAddress(0), 0x5a)
+    self.assertRaises(SystemError, eeprom.write_block, size - 1, b"\0\0")
+    self.assertRaises(SystemError, eeprom.read_block, size, 1)
+
+if __name__ == '__main__':
+
+  from unittest import TextTestRunner
+  tests = SimTestLoader("memblock_atmega16.elf").loadTestsFromTestCase(TestCase)
+  TextTestRunner(verbosity = 2).run(tests)
+
+# EOF
@@ -0,0 +1,43 @@
+#include <avr/io.h>
+
+volatile unsigned char in_loop = 0;
+volatile unsigned char cmd = 0;
+volatile unsigned char flag = 0;
+volatile unsigned short count = 0;
+
+void __attribute__((noinline)) marker(void) {
+    count++;
+}
+
+int main(void) {
+    unsigned char i;
+
+    DDRB = 0x01;
+    do {
+        in_loop = 1;
+        switch(cmd) {
+            case 1:
+                // wait a while, then toggle PB0
+                for(i = 0; i < 50; i++)
+                    flag = 0;
+                PORTB ^= 0x01;
+                cmd = 0;
+                break;
+            case 2:
+                // write flag with 1 to 5
+                for(i = 1; i <= 5; i++)
+                    flag = i;
+                cmd = 0;
+                break;
+            case 3:
+                // wait a while, then call marker
+                for(i = 0; i < 50; i++)
+                    flag = 0;
+                marker();
+                cmd = 0;
+                break;
+        }
+    } while(1); // do forever
+}
+
+// EOF
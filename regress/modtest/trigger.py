@@ -0,0 +1,113 @@
+from simtestutil import SimTestCase, SimTestLoader
+import pysimulavr
+
+class TestCase(SimTestCase):
+
+  DELAY = 20000 # run 20 microseconds
+  RANGE = 10000000 # run time range of 10 milliseconds
+
+  def runCommand(self, cmd):
+    """starts command in AVR and runs a long time range, returns run time"""
+    self.dev.write_var("cmd", cmd)
+    t = self.sim.getCurrentTime()
+    pysimulavr.SystemClock.Instance().RunTimeRange(self.RANGE)
+    return self.sim.getCurrentTime() - t
+
+  def initDone(self):
+    self.assertDevice()
+    self.assertStartTime()
+    self.assertInitDone()
+    self.sim.doRun(self.sim.getCurrentTime() + self.DELAY)
+    self.assertEqual(self.dev.read_var("in_loop"), 1, "not in idle loop")
+
+  def test_00(self):
+    """pin change trigger stops run time range"""
+    self.initDone()
+    pin = self.dev.GetPin("B0")
+    trigger = pysimulavr.PinChangeTrigger(pin)
+    self.assertFalse(trigger.HasFired())
+    t = self.runCommand(1)
+    self.assertTrue(trigger.HasFired(), "pin change not seen")
+    self.assertTrue(t < self.RANGE, "run time range isn't stopped")
+    self.assertEqual(pin.toChar(), "H")
+    # no other change
+    trigger.Clear()
+    pysimulavr.SystemClock.Instance().RunTimeRange(self.DELAY)
+    self.assertFalse(trigger.HasFired())
+    t = self.runCommand(1)
+    self.assertTrue(t < self.RANGE, "run time range isn't stopped")
+    self.assertEqual(pin.toChar(), "L")
+    self.assertEqual(trigger.GetHits(), 1)
+    del trigger
+
+  def test_01(self):
+    """write trigger stops run time range, also on a given value only"""
+    self.initDone()
+    addr = self.dev.data.GetAddressAtSymbol("flag")
+    trigger = pysimulavr.WriteTrigger(self.dev, addr, 3)
+    t = self.runCommand(2)
+    self.assertTrue(trigger.HasFired(), "write of value 3 not seen")
+    self.assertTrue(t < self.RANGE, "run time range isn't stopped")
+    self.assertEqual(self.dev.read_var("flag"), 3)
+    self.assertEqual(trigger.GetHits(), 1)
+    # command continues after stop
+    self.sim.doRun(self.sim.getCurrentTime() + self.DELAY)
+    self.assertEqual(self.dev.read_var("flag"), 5)
+    self.assertEqual(self.dev.read_var("cmd"), 0)
+    self.assertEqual(trigger.GetHits(), 1)
+    del trigger
+    # trigger on every value
+    trigger = pysimulavr.WriteTrigger(self.dev, addr)
+    t = self.runCommand(2)
+    self.assertTrue(t < self.RANGE, "run time range isn't stopped")
+    self.assertEqual(self.dev.read_var("flag"), 1)
+    del trigger
+
+  def test_02(self):
+    """PC trigger stops run time range"""
+    self.initDone()
+    trigger = pysimulavr.PCTrigger(self.dev, "marker")
+    self.assertEqual(self.dev.read_var("count", "H"), 0)
+    t = self.runCommand(3)
+    self.assertTrue(trigger.HasFired(), "marker not reached")
+    self.assertTrue(t < self.RANGE, "run time range isn't stopped")
+    # stopped after first instruction of marker
+    self.assertEqual(self.dev.read_var("count", "H"), 0)
+    self.sim.doRun(self.sim.getCurrentTime() + self.DELAY)
+    self.assertEqual(self.dev.read_var("count", "H"), 1)
+    del trigger
+
+  def getVCDNames(self, vcdname):
+    """gives back names of all variables in vcd file"""
+    names = list()
+    scope = ""
+    for l in open(vcdname).readlines():
+      l = l.split()
+      if len(l) > 2 and l[0] == "$scope":
+        scope = l[2]
+      elif len(l) > 4 and l[0] == "$var":
+        names.append(scope + "." + l[4])
+    return names
+
+  def test_03(self):
+    """glob selection gives the expected signals in vcd file"""
+    self.assertDevice()
+    # dumper has to be added before start of dump manager
+    self.sim.dmanStop()
+    # other devices of this python process are still registered, select
+    # only the values of this device
+    prefix = self.dev.GetTraceValuePrefix()
+    self.sim.setVCDDump("trigger_glob.vcd", [prefix + "CORE.r1?"])
+    self.sim.dmanStart()
+    self.assertInitDone()
+    self.sim.dmanStop()
+    names = self.getVCDNames("trigger_glob.vcd")
+    self.assertEqual(sorted(names), [prefix + "CORE.r1%d" % i for i in range(10)])
+
+if __name__ == '__main__':
+
+  from unittest import TextTestRunner
+  tests = SimTestLoader("trigger_atmega16.elf").loadTestsFromTestCase(TestCase)
+  TextTestRunner(verbosity = 2).run(tests)
+
+# EOF
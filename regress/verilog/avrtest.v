@@ -0,0 +1,44 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA..
+ *
+ */
+
+/*
+ Testbench with the gluecode in avr.v. It's compiled twice, with and without
+ AVR_QUANTUM, quantum-test.py compares the waveforms of B0.
+ */
+`timescale 1ns / 1ns
+
+module test;
+
+   wire clk;
+   wire [7:0] pa, pb, pd;
+   wire pb0=pb[0];
+
+   defparam  avr.progfile="toggle.elf";
+   ATtiny2313 avr(clk, pa, pb, pd);
+   avr_clock clock(clk);
+
+   initial begin
+`ifdef AVR_QUANTUM
+      $dumpfile("avrtest_quantum.vcd");
+`else
+      $dumpfile("avrtest.vcd");
+`endif
+      $dumpvars(1, test);
+      #100_000 $finish;
+   end
+endmodule // test
+
@@ -0,0 +1,53 @@
+from vcdtestutil import VCDTestCase, VCDTestLoader, getVCD, uSec
+
+class TestCase(VCDTestCase):
+
+  def setUp(self):
+    self.getVCD()
+    self.setClock(4000000)
+
+  def getPinEdges(self, vcd):
+    """gives back times of valid edges of B0, relative to first rising edge"""
+    p = vcd.getVariable("test.pb0")
+    edges = list()
+    for e in p.getEdges():
+      if e.isInit or e.hasUnknown or e.hasTristate: continue
+      if len(edges) == 0 and e.intValue != 1: continue
+      edges.append((e.internalTime, e.intValue))
+    self.assertTrue(len(edges) > 0, "B0 doesn't toggle")
+    t0 = edges[0][0]
+    return [(t - t0, v) for t, v in edges]
+
+  def test_00(self):
+    """simulation time [0..100us]"""
+    self.assertVCD()
+    self.assertTrue(self.vcd.endtime >= 100 * uSec)
+
+  def test_01(self):
+    """B0 waveform is the same as without AVR_QUANTUM"""
+    self.assertVCD()
+    ref = getVCD("avrtest.vcd")
+    self.assertTrue(ref is not None, "avrtest.vcd not loaded")
+    quantum = self.getPinEdges(self.vcd)
+    cycle = self.getPinEdges(ref)
+    # runs can start on different clock edges, compare only common time
+    end = min(quantum[-1][0], cycle[-1][0]) - 2 * self.tClock
+    cycle = [e for e in cycle if e[0] <= end]
+    self.assertTrue(len(cycle) > 100, "too less edges on B0: %d" % len(cycle))
+    self.assertTrue(len(quantum) >= len(cycle), "edges missing with AVR_QUANTUM")
+    for q, c in zip(quantum, cycle):
+      self.assertEqual(q[1], c[1])
+      self.assertTrue(abs(q[0] - c[0]) <= self.tClock,
+                      "edge at %dns, expected at %dns" % (q[0], c[0]))
+
+if __name__ == '__main__':
+
+  from unittest import TestLoader, TextTestRunner
+  tests = VCDTestLoader("avrtest_quantum.vcd").loadTestsFromTestCase(TestCase)
+  res = TextTestRunner(verbosity = 2).run(tests)
+  if res.wasSuccessful():
+    exit(0)
+  else:
+    exit(1)
+
+# EOF
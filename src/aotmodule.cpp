@@ -0,0 +1,596 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2001, 2002 - 2012   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+/* for preprocessor symbol HAVE_SYS_MINGW */
+#include "config.h"
+
+#if defined(HAVE_SYS_MINGW) || defined(_MSC_VER)
+#   include <windows.h>
+#else
+#   include <dlfcn.h>
+#endif
+
+#include "aotmodule.h"
+#include "avrdevice.h"
+#include "avrerror.h"
+#include "blocktier.h"
+#include "decoder.h"
+#include "flash.h"
+#include "hwsreg.h"
+
+using namespace std;
+
+typedef const AotModuleInfo *(*AotModuleFunc)(void);
+
+//! Put in front of every translated module, has to match aotmodule.h
+static const char aotPrologue[] =
+    "#define AOT_ABI_VERSION 1\n"
+    "#define AOT_NO_JUMP 0xffffffffU\n"
+    "\n"
+    "struct AotState {\n"
+    "    void *core;\n"
+    "    unsigned char (*getReg)(void *core, unsigned int r);\n"
+    "    void (*setReg)(void *core, unsigned int r, unsigned char v);\n"
+    "    unsigned int sreg;\n"
+    "    unsigned int pc;\n"
+    "    unsigned int jumpFrom;\n"
+    "};\n"
+    "\n"
+    "typedef int (*AotBlockFunc)(AotState *s);\n"
+    "\n"
+    "struct AotBlock {\n"
+    "    unsigned int pc;\n"
+    "    unsigned int len;\n"
+    "    AotBlockFunc func;\n"
+    "};\n"
+    "\n"
+    "struct AotModuleInfo {\n"
+    "    unsigned int abi;\n"
+    "    unsigned int checksum;\n"
+    "    unsigned int count;\n"
+    "    const AotBlock *blocks;\n"
+    "};\n"
+    "\n"
+    "#if defined(_WIN32)\n"
+    "#   define AOT_EXPORT extern \"C\" __declspec(dllexport)\n"
+    "#else\n"
+    "#   define AOT_EXPORT extern \"C\"\n"
+    "#endif\n"
+    "\n"
+    "typedef unsigned char byte;\n"
+    "\n"
+    "/* flag calculation, same as in simulavr decoder.cpp */\n"
+    "static inline int add_carry(byte res, byte rd, byte rr, int b) {\n"
+    "    byte resb = res >> b & 0x1, rdb = rd >> b & 0x1, rrb = rr >> b & 0x1;\n"
+    "    return (rdb & rrb) | (rrb & ~resb) | (~resb & rdb);\n"
+    "}\n"
+    "static inline int add_overflow(byte res, byte rd, byte rr) {\n"
+    "    byte res7 = res >> 7 & 0x1, rd7 = rd >> 7 & 0x1, rr7 = rr >> 7 & 0x1;\n"
+    "    return (rd7 & rr7 & ~res7) | (~rd7 & ~rr7 & res7);\n"
+    "}\n"
+    "static inline int sub_carry(byte res, byte rd, byte rr, int b) {\n"
+    "    byte resb = res >> b & 0x1, rdb = rd >> b & 0x1, rrb = rr >> b & 0x1;\n"
+    "    return (~rdb & rrb) | (rrb & resb) | (resb & ~rdb);\n"
+    "}\n"
+    "static inline int sub_overflow(byte res, byte rd, byte rr) {\n"
+    "    byte res7 = res >> 7 & 0x1, rd7 = rd >> 7 & 0x1, rr7 = rr >> 7 & 0x1;\n"
+    "    return (rd7 & ~rr7 & ~res7) | (~rd7 & rr7 & res7);\n"
+    "}\n"
+    "\n";
+
+//! Flag names by SREG bit
+static const char *aotFlag[8] = { "C", "Z", "N", "V", "S", "H", "T", "I" };
+
+static string Reg(unsigned int r) {
+    ostringstream os;
+    os << "r" << r;
+    return os.str();
+}
+
+static string Hex(unsigned int v) {
+    ostringstream os;
+    os << "0x" << hex << v;
+    return os.str();
+}
+
+//! Code and register usage of a block while translating
+struct AotBlockCode {
+    ostringstream body;
+    bool read[32];          //!< register is read in block
+    bool written[32];       //!< register is written in block
+    int cycles;             //!< cycles of the unconditional instructions
+    unsigned int nextPc;    //!< PC after the block, if no branch is taken
+
+    AotBlockCode(): cycles(0), nextPc(0) {
+        fill(read, read + 32, false);
+        fill(written, written + 32, false);
+    }
+    string Use(unsigned int r) { read[r] = true; return Reg(r); }
+    string Def(unsigned int r) { written[r] = true; return Reg(r); }
+};
+
+//! Flag update for N, S and Z of a 8 bit result res
+static const char aotNSZ[] = "N = (res >> 7) & 0x1; S = N ^ V; Z = res == 0;";
+
+//! Add or subtract with flags, a and b are expressions, dst is empty for compare
+static void EmitArith(AotBlockCode &b, bool add, bool carry, const string &dst,
+                      const string &a, const string &bb) {
+    const char *fn = add ? "add" : "sub";
+    b.body << "    { byte rd = " << a << ", rr = " << bb << ", res = rd "
+           << (add ? "+" : "-") << " rr" << (carry ? (add ? " + C" : " - C") : "") << ";\n"
+           << "      H = " << fn << "_carry(res, rd, rr, 3); V = " << fn << "_overflow(res, rd, rr);"
+           << " N = (res >> 7) & 0x1; S = N ^ V; C = " << fn << "_carry(res, rd, rr, 7);\n";
+    if(carry && !add)
+        b.body << "      Z = Z && res == 0;";  // previous Z remains on SBC, SBCI, CPC
+    else
+        b.body << "      Z = res == 0;";
+    if(dst.size())
+        b.body << " " << dst << " = res;";
+    b.body << " }\n";
+}
+
+//! Logic operation with flags
+static void EmitLogic(AotBlockCode &b, const char *op, const string &dst,
+                      const string &a, const string &bb) {
+    b.body << "    { byte res = " << a << " " << op << " " << bb << "; V = 0; "
+           << aotNSZ << " " << dst << " = res; }\n";
+}
+
+//! Conditional jump to target, taken costs takenCycles, not taken 1 cycle
+static void EmitCondJump(AotBlockCode &b, const string &cond, unsigned int pc,
+                         unsigned int target, int takenCycles) {
+    b.body << "    if(" << cond << ") { s->jumpFrom = " << Hex(pc) << "; pc = "
+           << Hex(target) << "; cycles += " << takenCycles << "; } else cycles += 1;\n";
+}
+
+//! Multiplication (2 cycles) into R1:R0 with C and Z, a and bb are (casted) register expressions
+static void EmitMul(AotBlockCode &b, const string &a, const string &bb, bool fractional) {
+    b.body << "    { unsigned short res = (unsigned short)(" << a << " * " << bb << ");";
+    if(fractional)
+        b.body << " C = (res >> 15) & 0x1; res = res << 1;";
+    else
+        b.body << " C = (res >> 15) & 0x1;";
+    b.body << " Z = res == 0; " << b.Def(0) << " = res & 0xff; " << b.Def(1) << " = res >> 8; }\n";
+    b.cycles += 2;
+}
+
+/*! Translates instruction on pc into b. Returns -1, if the instruction can't be
+  translated, 1 if it ends the block and 0 otherwise. */
+static int EmitInstruction(AvrDevice *core, unsigned int pc, AotBlockCode &b) {
+    unsigned int op = core->Flash->GetOpcode(pc);
+    int kind = BlockTier::Classify(op);
+    if(kind == 0)
+        return -1;
+
+    unsigned int d5 = (op >> 4) & 0x1f;
+    unsigned int r5 = (op & 0xf) | ((op >> 5) & 0x10);
+    unsigned int d4 = ((op >> 4) & 0xf) + 16;
+    string K8 = Hex(((op >> 4) & 0xf0) | (op & 0xf));
+    unsigned int bit = op & 0x7;
+    string mask = Hex(1 << bit);
+
+    b.nextPc = pc + 1;
+
+    if(op == 0x0000) {                          // NOP
+        b.cycles += 1;
+        return 0;
+    }
+    switch(op & 0xff00) {
+        case 0x0100: {                          // MOVW
+            unsigned int rd = ((op >> 4) & 0xf) << 1, rs = (op & 0xf) << 1;
+            b.body << "    " << b.Def(rd) << " = " << b.Use(rs) << "; "
+                   << b.Def(rd + 1) << " = " << b.Use(rs + 1) << ";\n";
+            b.cycles += 1;
+            return 0;
+        }
+        case 0x0200: {                          // MULS
+            if(!core->flagMULInstructions)
+                return -1;
+            unsigned int rd = ((op >> 4) & 0xf) + 16, rr = (op & 0xf) + 16;
+            EmitMul(b, "(signed char)" + b.Use(rd), "(signed char)" + b.Use(rr), false);
+            return 0;
+        }
+        case 0x0300: {                          // MULSU, FMUL, FMULS, FMULSU
+            if(!core->flagMULInstructions)
+                return -1;
+            unsigned int rd = ((op >> 4) & 0x7) + 16, rr = (op & 0x7) + 16;
+            bool signedRd = (op & 0x88) != 0x08;    // all except FMUL
+            bool signedRr = (op & 0x88) == 0x80;    // FMULS
+            EmitMul(b, (signedRd ? "(signed char)" : "") + b.Use(rd),
+                    (signedRr ? "(signed char)" : "") + b.Use(rr), (op & 0x88) != 0x00);
+            return 0;
+        }
+        case 0x9600:                            // ADIW
+        case 0x9700: {                          // SBIW
+            unsigned int rl = ((op >> 4) & 0x3) * 2 + 24;
+            string K = Hex(((op >> 2) & 0x30) | (op & 0xf));
+            bool add = (op & 0xff00) == 0x9600;
+            b.body << "    { byte rdh = " << b.Use(rl + 1) << "; unsigned short res = ((rdh << 8) + "
+                   << b.Use(rl) << ") " << (add ? "+ " : "- ") << K << ";\n";
+            if(add)
+                b.body << "      V = ~(rdh >> 7 & 0x1) & (res >> 15 & 0x1); C = ~(res >> 15 & 0x1) & (rdh >> 7 & 0x1);\n";
+            else
+                b.body << "      V = (rdh >> 7 & 0x1) & ~(res >> 15 & 0x1); C = (res >> 15 & 0x1) & ~(rdh >> 7 & 0x1);\n";
+            b.body << "      N = (res >> 15) & 0x1; S = N ^ V; Z = res == 0; "
+                   << b.Def(rl) << " = res & 0xff; " << b.Def(rl + 1) << " = res >> 8; }\n";
+            b.cycles += 2;
+            return 0;
+        }
+    }
+    switch(op & 0xfc00) {
+        case 0x0c00: EmitArith(b, true, false, b.Def(d5), b.Use(d5), b.Use(r5)); b.cycles += 1; return 0;   // ADD
+        case 0x1c00: EmitArith(b, true, true, b.Def(d5), b.Use(d5), b.Use(r5)); b.cycles += 1; return 0;    // ADC
+        case 0x1800: EmitArith(b, false, false, b.Def(d5), b.Use(d5), b.Use(r5)); b.cycles += 1; return 0;  // SUB
+        case 0x0800: EmitArith(b, false, true, b.Def(d5), b.Use(d5), b.Use(r5)); b.cycles += 1; return 0;   // SBC
+        case 0x1400: EmitArith(b, false, false, "", b.Use(d5), b.Use(r5)); b.cycles += 1; return 0;         // CP
+        case 0x0400: EmitArith(b, false, true, "", b.Use(d5), b.Use(r5)); b.cycles += 1; return 0;          // CPC
+        case 0x2000: EmitLogic(b, "&", b.Def(d5), b.Use(d5), b.Use(r5)); b.cycles += 1; return 0;           // AND
+        case 0x2800: EmitLogic(b, "|", b.Def(d5), b.Use(d5), b.Use(r5)); b.cycles += 1; return 0;           // OR
+        case 0x2400: EmitLogic(b, "^", b.Def(d5), b.Use(d5), b.Use(r5)); b.cycles += 1; return 0;           // EOR
+        case 0x2c00:                                                                                       // MOV
+            b.body << "    " << b.Def(d5) << " = " << b.Use(r5) << ";\n";
+            b.cycles += 1;
+            return 0;
+        case 0x9c00:                                                                                       // MUL
+            if(!core->flagMULInstructions)
+                return -1;
+            EmitMul(b, b.Use(d5), b.Use(r5), false);
+            return 0;
+        case 0x1000: {                                                                                     // CPSE
+            int skip = core->Flash->GetInstruction(pc + 1)->IsInstruction2Words() ? 3 : 2;
+            EmitCondJump(b, b.Use(d5) + " == " + b.Use(r5), pc, pc + skip, skip);
+            return 1;
+        }
+    }
+    switch(op & 0xf000) {
+        case 0x3000: EmitArith(b, false, false, "", b.Use(d4), K8); b.cycles += 1; return 0;                // CPI
+        case 0x4000: EmitArith(b, false, true, b.Def(d4), b.Use(d4), K8); b.cycles += 1; return 0;          // SBCI
+        case 0x5000: EmitArith(b, false, false, b.Def(d4), b.Use(d4), K8); b.cycles += 1; return 0;         // SUBI
+        case 0x6000: EmitLogic(b, "|", b.Def(d4), b.Use(d4), K8); b.cycles += 1; return 0;                  // ORI
+        case 0x7000: EmitLogic(b, "&", b.Def(d4), b.Use(d4), K8); b.cycles += 1; return 0;                  // ANDI
+        case 0xe000:                                                                                       // LDI
+            b.body << "    " << b.Def(d4) << " = " << K8 << ";\n";
+            b.cycles += 1;
+            return 0;
+        case 0xc000: {                                                                                     // RJMP
+            int k = op & 0x0fff;
+            if(k & 0x0800)
+                k -= 0x1000;
+            word target = pc;
+            target += k;
+            target &= (core->Flash->GetSize() - 1) >> 1;
+            target++;
+            b.body << "    s->jumpFrom = " << Hex(pc) << "; pc = " << Hex(target) << ";\n";
+            b.cycles += 2;
+            return 1;
+        }
+    }
+    if((op & 0xfe08) == 0x9400) {
+        string rd = b.Use(d5);
+        b.Def(d5);
+        switch(op & 0x000f) {
+            case 0x0:                           // COM
+                b.body << "    { byte res = 0xff - " << rd << "; C = 1; V = 0; " << aotNSZ << " " << rd << " = res; }\n";
+                break;
+            case 0x1:                           // NEG
+                b.body << "    { byte rd = " << rd << ", res = (0x0 - rd) & 0xff; H = ((res >> 3) | (rd >> 3)) & 0x1;"
+                       << " V = res == 0x80; " << aotNSZ << " C = res != 0x0; " << rd << " = res; }\n";
+                break;
+            case 0x2:                           // SWAP
+                b.body << "    " << rd << " = ((" << rd << " << 4) & 0xf0) | ((" << rd << " >> 4) & 0x0f);\n";
+                break;
+            case 0x3:                           // INC
+                b.body << "    { byte rd = " << rd << ", res = rd + 1; V = rd == 0x7f; " << aotNSZ << " " << rd << " = res; }\n";
+                break;
+            case 0x5:                           // ASR
+                b.body << "    { byte rd = " << rd << ", res = (rd >> 1) + (rd & 0x80); C = rd & 0x1; N = (res >> 7) & 0x1;"
+                       << " V = N ^ C; S = N ^ V; Z = res == 0; " << rd << " = res; }\n";
+                break;
+            case 0x6:                           // LSR
+                b.body << "    { byte rd = " << rd << ", res = (rd >> 1) & 0x7f; C = rd & 0x1; N = 0;"
+                       << " V = N ^ C; S = N ^ V; Z = res == 0; " << rd << " = res; }\n";
+                break;
+            case 0x7:                           // ROR
+                b.body << "    { byte rd = " << rd << ", res = (rd >> 1) | ((C << 7) & 0x80); C = rd & 0x1; N = (res >> 7) & 0x1;"
+                       << " V = N ^ C; S = N ^ V; Z = res == 0; " << rd << " = res; }\n";
+                break;
+        }
+        b.cycles += 1;
+        return 0;
+    }
+    if((op & 0xfe0f) == 0x940a) {               // DEC
+        string rd = b.Use(d5);
+        b.Def(d5);
+        b.body << "    { byte res = " << rd << " - 1; V = res == 0x7f; " << aotNSZ << " " << rd << " = res; }\n";
+        b.cycles += 1;
+        return 0;
+    }
+    if((op & 0xff0f) == 0x9408) {               // BSET, BCLR (never I flag)
+        b.body << "    " << aotFlag[(op >> 4) & 0x7] << " = " << ((op & 0x0080) ? "0" : "1") << ";\n";
+        b.cycles += 1;
+        return 0;
+    }
+    if((op & 0xfc08) == 0xf800) {
+        if(op & 0x0200)                         // BST
+            b.body << "    T = (" << b.Use(d5) << " & " << mask << ") != 0;\n";
+        else {                                  // BLD
+            string rd = b.Use(d5);
+            b.Def(d5);
+            b.body << "    " << rd << " = T ? (" << rd << " | " << mask << ") : (" << rd << " & ~" << mask << ");\n";
+        }
+        b.cycles += 1;
+        return 0;
+    }
+    if((op & 0xf800) == 0xf000) {               // BRBS, BRBC
+        int k = (op >> 3) & 0x7f;
+        if(k & 0x40)
+            k -= 0x80;
+        word target = pc;
+        target += k;
+        target++;
+        string cond = string((op & 0x0400) ? "!" : "") + aotFlag[bit];
+        EmitCondJump(b, cond, pc, target, 2);
+        return 1;
+    }
+    if((op & 0xfc08) == 0xfc00) {               // SBRC, SBRS
+        int skip = core->Flash->GetInstruction(pc + 1)->IsInstruction2Words() ? 3 : 2;
+        string cond = "(" + b.Use(d5) + " & " + mask + ") " + ((op & 0x0200) ? "!=" : "==") + " 0";
+        EmitCondJump(b, cond, pc, pc + skip, skip);
+        return 1;
+    }
+    return -1;
+}
+
+//! Writes a block on pc as function to os, returns false, if there is no block on pc
+static bool EmitBlock(AvrDevice *core, unsigned int pc, ostream &os, unsigned int &len) {
+    unsigned int words = core->Flash->GetSize() / 2;
+    AotBlockCode b;
+    len = 0;
+    while(len < BlockTier::MAX_BLOCK_LEN && pc + len + 1 < words) {
+        int res = EmitInstruction(core, pc + len, b);
+        if(res < 0)
+            break;
+        len++;
+        if(res > 0)
+            break;
+    }
+    // a single instruction isn't worth a call
+    if(len < 2)
+        return false;
+
+    os << "static int b_" << hex << pc << dec << "(AotState *s) {\n"
+       << "    void *c = s->core;\n";
+    for(unsigned int r = 0; r < 32; r++) {
+        if(b.read[r])
+            os << "    byte " << Reg(r) << " = s->getReg(c, " << r << ");\n";
+        else if(b.written[r])
+            os << "    byte " << Reg(r) << ";\n";
+    }
+    os << "    unsigned int sr = s->sreg;\n"
+       << "    bool C = sr & 0x01, Z = sr & 0x02, N = sr & 0x04, V = sr & 0x08,"
+       << " S = sr & 0x10, H = sr & 0x20, T = sr & 0x40;\n"
+       << "    int cycles = " << b.cycles << ";\n"
+       << "    unsigned int pc = " << Hex(b.nextPc) << ";\n"
+       << b.body.str();
+    for(unsigned int r = 0; r < 32; r++) {
+        if(b.written[r])
+            os << "    s->setReg(c, " << r << ", " << Reg(r) << ");\n";
+    }
+    os << "    s->sreg = (sr & 0x80) | C | (Z << 1) | (N << 2) | (V << 3) | (S << 4) | (H << 5) | (T << 6);\n"
+       << "    s->pc = pc;\n"
+       << "    return cycles;\n"
+       << "}\n\n";
+    return true;
+}
+
+//! Marks pc as start of a block, if it's in flash
+static void MarkLeader(vector<bool> &leader, unsigned int pc) {
+    if(pc < leader.size())
+        leader[pc] = true;
+}
+
+unsigned int AotModule::Emit(AvrDevice *core, const string &filename) {
+    unsigned int words = core->Flash->GetSize() / 2;
+
+    // blocks start on every jump target and behind every instruction, which
+    // isn't translated, this covers return addresses and irq vectors too
+    vector<bool> leader(words, false);
+    MarkLeader(leader, 0);
+    for(unsigned int pc = 0; pc < words; pc++) {
+        unsigned int op = core->Flash->GetOpcode(pc);
+        unsigned int size = core->Flash->GetInstruction(pc)->IsInstruction2Words() ? 2 : 1;
+        if(BlockTier::Classify(op) != 1)
+            MarkLeader(leader, pc + size);
+        if((op & 0xe000) == 0xc000) {           // RJMP, RCALL
+            int k = op & 0x0fff;
+            if(k & 0x0800)
+                k -= 0x1000;
+            MarkLeader(leader, (pc + k + 1) & (words - 1));
+        } else if((op & 0xf800) == 0xf000) {    // BRBS, BRBC
+            int k = (op >> 3) & 0x7f;
+            if(k & 0x40)
+                k -= 0x80;
+            MarkLeader(leader, pc + k + 1);
+        } else if((op & 0xfc00) == 0x1000 || (op & 0xfc08) == 0xfc00 || (op & 0xfd00) == 0x9900) {
+            // CPSE, SBRC, SBRS, SBIC, SBIS
+            MarkLeader(leader, pc + 1);
+            if(pc + 1 < words)
+                MarkLeader(leader, pc + 1 + (core->Flash->GetInstruction(pc + 1)->IsInstruction2Words() ? 2 : 1));
+        } else if((op & 0xfe0c) == 0x940c && pc + 1 < words) {  // JMP, CALL
+            unsigned int k = ((op & 0x01f0) << 13) | ((op & 0x0001) << 16) | core->Flash->GetOpcode(pc + 1);
+            MarkLeader(leader, k);
+        }
+    }
+
+    ofstream os(filename.c_str());
+    if(!os)
+        avr_error("can't write translated module to '%s'", filename.c_str());
+    unsigned int checksum = Checksum(core);
+    os << "/* simulavr ahead-of-time translated program '" << core->GetFname() << "',\n"
+       << "   checksum " << Hex(checksum) << ", generated by simulavr --aot-emit.\n"
+       << "   Compile it with: c++ -O2 -shared -fPIC -o <module>.so <this file> */\n\n"
+       << aotPrologue;
+
+    vector<unsigned int> starts, lens;
+    for(unsigned int pc = 0; pc < words; pc++) {
+        unsigned int len;
+        if(leader[pc] && EmitBlock(core, pc, os, len)) {
+            starts.push_back(pc);
+            lens.push_back(len);
+        }
+    }
+
+    os << "static const AotBlock blocks[] = {\n";
+    for(size_t i = 0; i < starts.size(); i++)
+        os << "    { " << Hex(starts[i]) << ", " << lens[i] << ", b_" << hex << starts[i] << dec << " },\n";
+    os << "    { 0, 0, 0 }\n"
+       << "};\n\n"
+       << "AOT_EXPORT const AotModuleInfo *simulavr_aot_module(void) {\n"
+       << "    static const AotModuleInfo info = { AOT_ABI_VERSION, " << Hex(checksum) << "U, "
+       << starts.size() << ", blocks };\n"
+       << "    return &info;\n"
+       << "}\n";
+    if(!os)
+        avr_error("can't write translated module to '%s'", filename.c_str());
+    return starts.size();
+}
+
+unsigned int AotModule::Checksum(AvrDevice *core) {
+    // FNV-1a over all flash words
+    unsigned int words = core->Flash->GetSize() / 2;
+    unsigned int h = 2166136261U;
+    for(unsigned int pc = 0; pc < words; pc++) {
+        unsigned int op = core->Flash->GetOpcode(pc);
+        h = (h ^ (op & 0xff)) * 16777619U;
+        h = (h ^ (op >> 8)) * 16777619U;
+    }
+    return h;
+}
+
+//! register access for translated code
+static unsigned char AotGetReg(void *core, unsigned int r) {
+    return ((AvrDevice *)core)->GetCoreReg(r);
+}
+
+static void AotSetReg(void *core, unsigned int r, unsigned char v) {
+    ((AvrDevice *)core)->SetCoreReg(r, v);
+}
+
+AotModule::AotModule(AvrDevice *_core, const string &filename):
+    core(_core),
+    handle(NULL),
+    generation(0),
+    active(true),
+    blocksExecuted(0)
+{
+    AotModuleFunc func;
+#if defined(HAVE_SYS_MINGW) || defined(_MSC_VER)
+    handle = (void *)LoadLibraryA(filename.c_str());
+    if(handle == NULL)
+        avr_error("can't load translated module '%s'", filename.c_str());
+    func = (AotModuleFunc)GetProcAddress((HMODULE)handle, "simulavr_aot_module");
+#else
+    handle = dlopen(filename.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if(handle == NULL)
+        avr_error("can't load translated module '%s': %s", filename.c_str(), dlerror());
+    func = (AotModuleFunc)dlsym(handle, "simulavr_aot_module");
+#endif
+    if(func == NULL)
+        avr_error("'%s' isn't a translated module", filename.c_str());
+
+    const AotModuleInfo *info = func();
+    if(info->abi != AOT_ABI_VERSION)
+        avr_error("translated module '%s' has interface version %u, expected %u",
+                  filename.c_str(), info->abi, AOT_ABI_VERSION);
+    if(info->checksum != Checksum(core))
+        avr_error("translated module '%s' doesn't belong to the program in flash", filename.c_str());
+
+    unsigned int words = core->Flash->GetSize() / 2;
+    blocks.assign(words, (AotBlockFunc)NULL);
+    for(unsigned int i = 0; i < info->count; i++) {
+        const AotBlock &b = info->blocks[i];
+        if(b.pc + b.len > words)
+            continue;
+        // exit points have to be checked by core
+        bool exitInside = false;
+        for(unsigned int pc = b.pc + 1; pc < b.pc + b.len; pc++) {
+            if(core->EP.end() != find(core->EP.begin(), core->EP.end(), pc))
+                exitInside = true;
+        }
+        if(!exitInside)
+            blocks[b.pc] = b.func;
+    }
+    generation = core->Flash->GetCodeGeneration();
+    avr_message("Loaded translated module '%s' with %u blocks", filename.c_str(), info->count);
+}
+
+AotModule::~AotModule() {
+#if defined(HAVE_SYS_MINGW) || defined(_MSC_VER)
+    FreeLibrary((HMODULE)handle);
+#else
+    dlclose(handle);
+#endif
+}
+
+int AotModule::Run(void) {
+    if(!active)
+        return 0;
+    if(generation != core->Flash->GetCodeGeneration()) {
+        avr_warning("flash was changed, translated module is switched off");
+        active = false;
+        return 0;
+    }
+    // a interrupt, raised inside the block, would be taken too late
+    if(core->status->I)
+        return 0;
+
+    unsigned int pc = core->PC;
+    if(pc >= blocks.size() || blocks[pc] == NULL)
+        return 0;
+
+    AotState s;
+    s.core = core;
+    s.getReg = AotGetReg;
+    s.setReg = AotSetReg;
+    s.sreg = (int)*core->status;
+    s.pc = pc;
+    s.jumpFrom = AOT_NO_JUMP;
+    int cycles = blocks[pc](&s);
+
+    *core->status = s.sreg;
+    if(s.jumpFrom != AOT_NO_JUMP) {
+        core->PC = s.jumpFrom;
+        core->DebugOnJump();
+    }
+    core->PC = s.pc;
+    blocksExecuted++;
+    return cycles;
+}
+
+// EOF
@@ -0,0 +1,118 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2001, 2002 - 2012   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#ifndef AOTMODULE
+#define AOTMODULE
+
+#include <string>
+#include <vector>
+
+class AvrDevice;
+
+//! Interface version between simulavr and a translated module
+#define AOT_ABI_VERSION 1
+
+//! State of the core, which is given to a translated block
+/*! Registers are read and written through the callbacks, because they are
+  RWMemoryMember cells (trace values!). A block reads every register once on
+  entry and writes every modified register once on exit. */
+struct AotState {
+    void *core;                                                 //!< opaque AvrDevice
+    unsigned char (*getReg)(void *core, unsigned int r);        //!< reads R0-R31
+    void (*setReg)(void *core, unsigned int r, unsigned char v); //!< writes R0-R31
+    unsigned int sreg;      //!< SREG, in and out
+    unsigned int pc;        //!< PC after the block
+    unsigned int jumpFrom;  //!< PC of a taken branch or skip, AOT_NO_JUMP otherwise
+};
+
+#define AOT_NO_JUMP 0xffffffffU
+
+//! A translated block, returns the cycles used
+typedef int (*AotBlockFunc)(AotState *s);
+
+//! Table entry for a translated block
+struct AotBlock {
+    unsigned int pc;        //!< flash word, on which the block starts
+    unsigned int len;       //!< count of instructions in block
+    AotBlockFunc func;      //!< translated code
+};
+
+//! Description of a translated module, returned by simulavr_aot_module()
+struct AotModuleInfo {
+    unsigned int abi;       //!< AOT_ABI_VERSION of the module
+    unsigned int checksum;  //!< checksum over the flash image, see AotModule::Checksum
+    unsigned int count;     //!< count of entries in blocks
+    const AotBlock *blocks;
+};
+
+//! Ahead-of-time translated code for a program image
+/*! AotModule::Emit writes a program, which is loaded in flash of a core, as
+  C++ source: every basic block, which starts on a jump target or behind a
+  instruction, which can't be translated, becomes a function. This file is
+  compiled by the host compiler to a shared object and loaded with the
+  constructor.
+
+  Translated are the same instructions as for BlockTier: blocks of register
+  and SREG only instructions (ALU, MOV, LDI, ADIW, MUL/MULS/MULSU/FMUL*, ...),
+  which may end with a relative jump, branch or register skip. IO, data memory
+  and stack accesses stay with the interpreter, so peripherals see every
+  access on the same cycle as without the module. Cycles are exact and
+  given to the hardware one by one after the block, translated blocks run
+  only with interrupts disabled, both like for BlockTier.
+
+  The module belongs to exactly one image, it's refused if the checksum of
+  flash content is different. If the program writes flash (SPM), the module
+  is switched off and the interpreter takes over. */
+class AotModule {
+
+    protected:
+        AvrDevice *core;
+        void *handle;                         //!< handle of the shared object
+        std::vector<AotBlockFunc> blocks;     //!< translated block for every flash word or NULL
+        unsigned int generation;              //!< AvrFlash code generation, the module was loaded for
+        bool active;                          //!< false, if flash was changed after loading
+        unsigned long long blocksExecuted;    //!< statistic: count of executed blocks
+
+    public:
+        //! Loads module from shared object filename for the program in flash of core
+        AotModule(AvrDevice *core, const std::string &filename);
+        ~AotModule();
+
+        //! Runs block on core->PC, if there is one
+        /*! Returns used cycles or 0, if no block was executed (always with I
+          flag set). core->PC is set to the instruction after the block. */
+        int Run(void);
+
+        //! Returns count of executed blocks
+        unsigned long long GetBlocksExecuted(void) const { return blocksExecuted; }
+
+        //! Checksum over the flash content of core, which identifies a program image
+        static unsigned int Checksum(AvrDevice *core);
+        //! Writes the program in flash of core as C++ source to filename
+        /*! Returns count of translated blocks. */
+        static unsigned int Emit(AvrDevice *core, const std::string &filename);
+};
+
+#endif
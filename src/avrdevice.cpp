@@ -26,6 +26,9 @@
 #include <limits>
 
 #include "avrdevice.h"
+#include "aotmodule.h"
+#include "blocktier.h"
+#include "delayloop.h"
 #include "traceval.h"
 #include "helper.h"
 #include "irqsystem.h"  //GetNewPc
@@ -33,7 +36,12 @@
 #include "avrerror.h"
 #include "avrmalloc.h"
 #include "avrreadelf.h"
+#include "flash.h"
+#include "hwstack.h"
+#include "hwsreg.h"
+#include "snapshot.h"
 #include <assert.h>
+#include <sstream>
 
 #include "avrdevice_impl.h"
 
@@ -72,8 +80,13 @@ SystemClockOffset AvrDevice::GetClockFreq() {
     return clockFreq;
 }
 
+Pin *AvrDevice::FindPin(const char *name) {
+    std::map<std::string, Pin*>::iterator i = allPins.find(name);
+    return (i == allPins.end()) ? NULL : i->second;
+}
+
 Pin *AvrDevice::GetPin(const char *name) {
-    Pin *ret = allPins[name];
+    Pin *ret = FindPin(name);
     if(!ret)
         avr_error("unknown Pin requested! -> %s is not available", name);
     return ret;
@@ -85,20 +98,16 @@ AvrDevice::~AvrDevice() {
         dumpManager->unregisterAvrDevice(this);
     }
 
-    // delete invalid RW memory cells on shadow store + shadow store self
-    unsigned size = totalIoSpace - registerSpaceSize - iRamSize - eRamSize;
-    for(unsigned idx = 0; idx < size; idx++)
-        delete invalidRW[idx];
+    // delete invalid RW memory cells, Ram cells and registers
     delete [] invalidRW;
-
-    // delete Ram cells and registers
-    for(unsigned idx = 0; idx < registerSpaceSize; idx++)
-        delete rw[idx];
-    size = registerSpaceSize + ioSpaceSize + iRamSize + eRamSize;
-    for(unsigned idx = (registerSpaceSize + ioSpaceSize); idx < size; idx++)
-        delete rw[idx];
+    delete registerArea;
+    delete iRamArea;
+    delete eRamArea;
 
     // delete rw and other allocated objects
+    delete aotModule;
+    delete blockTier;
+    delete delayLoops;
     delete Flash;
     delete statusRegister;
     delete status;
@@ -136,6 +145,11 @@ AvrDevice::AvrDevice(unsigned int _ioSpaceSize,
     devSignature(numeric_limits<unsigned int>::max()),
     abortOnInvalidAccess(false),
     coreTraceGroup(this),
+    pcObserver(NULL),
+    blockTier(NULL),
+    aotModule(NULL),
+    delayLoops(NULL),
+    fusion(false),
     deferIrq(false),
     newIrqPc(0xffffffff),
     v_supply(5.0),  // assume 5V supply voltage
@@ -172,7 +186,7 @@ AvrDevice::AvrDevice(unsigned int _ioSpaceSize,
     // memory space for all RW-Memory addresses + shadow store for invalid cells
     unsigned invalidSize = totalIoSpace - registerSpaceSize - IRamSize - ERamSize;
     rw = new RWMemoryMember* [totalIoSpace];
-    invalidRW = new RWMemoryMember* [invalidSize];
+    invalidRW = new InvalidMem [invalidSize];
 
     // the status register is generic to all devices
     status = new HWSreg();
@@ -194,10 +208,9 @@ AvrDevice::AvrDevice(unsigned int _ioSpaceSize,
     unsigned currentOffset = 0;
     unsigned invalidRWOffset = 0;
 
+    registerArea = new RAMArea(&coreTraceGroup, "r", registerSpaceSize);
     for(unsigned ii = 0; ii < registerSpaceSize; ii++) {
-        rw[currentOffset] = new RAM(&coreTraceGroup, "r", ii, registerSpaceSize);
-        if(rw[currentOffset] == NULL)
-            avr_error("Not enough memory for registers in AvrDevice::AvrDevice");
+        rw[currentOffset] = registerArea->GetCell(ii);
         currentOffset++;
     }
 
@@ -207,38 +220,32 @@ AvrDevice::AvrDevice(unsigned int _ioSpaceSize,
        a register will at least notify the user that there is an unimplemented
        feature or reserved register. */
     for(unsigned ii = 0; ii < ioSpaceSize; ii++) {
-        invalidRW[invalidRWOffset] = new InvalidMem(this, currentOffset);
-        if(invalidRW[invalidRWOffset] == NULL)
-            avr_error("Not enough memory for io space in AvrDevice::AvrDevice");
-        rw[currentOffset] = invalidRW[invalidRWOffset];
+        invalidRW[invalidRWOffset].SetAddress(this, currentOffset);
+        rw[currentOffset] = &invalidRW[invalidRWOffset];
         currentOffset++;
         invalidRWOffset++;
     }
 
     // create the internal ram handlers
+    iRamArea = new RAMArea(&coreTraceGroup, "IRAM", IRamSize);
     for(unsigned ii = 0; ii < IRamSize; ii++ ) {
-        rw[currentOffset] = new RAM(&coreTraceGroup, "IRAM", ii, IRamSize);
-        if(rw[currentOffset] == NULL)
-            avr_error("Not enough memory for IRAM in AvrDevice::AvrDevice");
+        rw[currentOffset] = iRamArea->GetCell(ii);
         currentOffset++;
     }
 
     // create the external ram handlers, TODO: make the configuration from
     // mcucr available here
+    eRamArea = new RAMArea(&coreTraceGroup, "ERAM", ERamSize);
     for(unsigned ii = 0; ii < ERamSize; ii++ ) {
-        rw[currentOffset] = new RAM(&coreTraceGroup, "ERAM", ii, ERamSize);
-        if(rw[currentOffset] == NULL)
-            avr_error("Not enough memory for io space in AvrDevice::AvrDevice");
+        rw[currentOffset] = eRamArea->GetCell(ii);
         currentOffset++;
     }
 
     assert(currentOffset<=totalIoSpace);
     // fill the rest of the address space with error handlers
     for(; currentOffset < totalIoSpace; currentOffset++, invalidRWOffset++) {
-        invalidRW[invalidRWOffset] = new InvalidMem(this, currentOffset);
-        if(invalidRW[invalidRWOffset] == NULL)
-            avr_error("Not enough memory for fill address space in AvrDevice::AvrDevice");
-        rw[currentOffset] = invalidRW[invalidRWOffset];
+        invalidRW[invalidRWOffset].SetAddress(this, currentOffset);
+        rw[currentOffset] = &invalidRW[invalidRWOffset];
     }
 }
 
@@ -285,6 +292,13 @@ int AvrDevice::Step(bool &untilCoreStepFinished, SystemClockOffset *nextStepIn_n
             hwWait = true;
     }
 
+    // a skipped delay loop is left, if a interrupt has to be taken inside
+    if(!hwWait && cpuCycles > 0 && delayLoops != NULL) {
+        delayLoops->Check(cpuCycles);
+        if(cpuCycles <= 0)
+            cPC = PC;
+    }
+
     if(hwWait) {
         if(trace_on)
             traceOut << "CPU-Hold by IO-Hardware ";
@@ -323,14 +337,13 @@ int AvrDevice::Step(bool &untilCoreStepFinished, SystemClockOffset *nextStepIn_n
                     traceOut << "IRQ DETECTED: VectorAddr: " << newIrqPc ;
 
                 irqSystem->IrqHandlerStarted(actualIrqVector);    //what vector we raise?
-                Funktor* fkt = new IrqFunktor(irqSystem, &HWIrqSystem::IrqHandlerFinished, actualIrqVector);
-                stack->SetReturnPoint(stack->GetStackPointer(), fkt);
+                stack->SetIrqReturnPoint(stack->GetStackPointer(), actualIrqVector);
                 stack->PushAddr(PC);
                 cpuCycles = 4; //push needs 4 cycles! (on external RAM +2, this is handled from HWExtRam!)
                 status->I = 0; //irq started so remove I-Flag from SREG
                 PC = newIrqPc - 1;   //we add a few lines later 1 so we sub here 1 :-)
 
-            } else if(status->I == 1 && !opIsCli(Flash->GetOpcode(PC))) {
+            } else if(status->I == 1 && irqSystem->IsIrqPending() && !opIsCli(Flash->GetOpcode(PC))) {
                 newIrqPc = irqSystem->GetNewPc(actualIrqVector);
 
                 if(newIrqPc != 0xffffffff) {
@@ -340,7 +353,43 @@ int AvrDevice::Step(bool &untilCoreStepFinished, SystemClockOffset *nextStepIn_n
                 }
             }
 
+            if(cpuCycles <= 0 && delayLoops != NULL && !deferIrq &&
+               !trace_on && pcObserver == NULL && BP.empty() && !dumpManager->hasDumpers()) {
+                // like a instruction with the skipped cycles, see below
+                int cycles = delayLoops->Run();
+                if(cycles > 0) {
+                    statusRegister->trigger_change();
+                    cpuCycles = cycles;
+                    PC--;   // incremented below
+                }
+            }
+
+            if(cpuCycles <= 0 && (aotModule != NULL || blockTier != NULL) && !deferIrq &&
+               !trace_on && pcObserver == NULL && BP.empty() && !dumpManager->hasDumpers()) {
+                int cycles = (aotModule != NULL) ? aotModule->Run() : 0;
+                if(cycles == 0 && blockTier != NULL)
+                    cycles = blockTier->Run();
+                if(cycles > 0) {
+                    statusRegister->trigger_change();
+                    if(hwCycleList.empty()) {
+                        // nobody sees the cycles inside the block, the core
+                        // steps again after the block
+                        if(nextStepIn_ns != NULL)
+                            *nextStepIn_ns = clockFreq * cycles;
+                        untilCoreStepFinished = true;
+                        dumpManager->cycle();
+                        return 0;
+                    }
+                    // like a instruction with the cycles of the block: hardware
+                    // gets them one by one on the next core steps, with holds
+                    cpuCycles = cycles;
+                    PC--;   // incremented below
+                }
+            }
+
             if(cpuCycles <= 0) {
+                if(pcObserver != NULL)
+                    pcObserver->OnExecute(PC);
                 if((unsigned int)(PC << 1) >= (unsigned int)Flash->GetSize() ) {
                     ostringstream os;
                     os << actualFilename << " Simulation runs out of Flash Space at " << hex << (PC << 1);
@@ -350,10 +399,13 @@ int AvrDevice::Step(bool &untilCoreStepFinished, SystemClockOffset *nextStepIn_n
                     avr_error("%s", s.c_str());
                 }
 
-                DecodedInstruction *de = (Flash->GetInstruction(PC));
                 if(trace_on) {
-                    cpuCycles = de->Trace();
+                    cpuCycles = Flash->GetInstruction(PC)->Trace();
                 } else {
+                    // superinstructions only, if nobody looks at single instructions and
+                    // no interrupt can come in between (it would be taken too late)
+                    DecodedInstruction *de = (fusion && !status->I && pcObserver == NULL && !dumpManager->hasDumpers()) ?
+                        Flash->GetFusedInstruction(PC) : Flash->GetInstruction(PC);
                     cpuCycles = (*de)();
                 }
                 // report changes on status
@@ -381,6 +433,31 @@ int AvrDevice::Step(bool &untilCoreStepFinished, SystemClockOffset *nextStepIn_n
     return (cpuCycles < 0) ? cpuCycles : 0;
 }
 
+void AvrDevice::SetBlockTier(bool on) {
+    if(on && blockTier == NULL)
+        blockTier = new BlockTier(this);
+    else if(!on && blockTier != NULL) {
+        delete blockTier;
+        blockTier = NULL;
+    }
+}
+
+void AvrDevice::SetDelayLoopSkip(bool on) {
+    if(on && delayLoops == NULL)
+        delayLoops = new DelayLoopSkipper(this);
+    else if(!on && delayLoops != NULL) {
+        delete delayLoops;
+        delayLoops = NULL;
+    }
+}
+
+void AvrDevice::LoadAotModule(const std::string &filename) {
+    delete aotModule;
+    aotModule = NULL;
+    if(filename.size())
+        aotModule = new AotModule(this, filename);
+}
+
 void AvrDevice::Reset() {
     PC_size = 2;
     PC = 0;
@@ -396,6 +473,88 @@ void AvrDevice::Reset() {
     cpuCycles = 0;
 }
 
+void AvrDevice::SaveState(SnapshotWriter &w) {
+    // memory layout, to check, that snapshot fits to device on restore
+    w.WriteDWord(ioSpaceSize);
+    w.WriteDWord(iRamSize);
+    w.WriteDWord(eRamSize);
+    w.WriteDWord(hwResetList.size());
+
+    // core
+    w.WriteDWord(PC);
+    w.WriteDWord(cPC);
+    w.WriteInt(cpuCycles);
+    w.WriteBool(deferIrq);
+    w.WriteDWord(newIrqPc);
+    w.WriteDWord(actualIrqVector);
+    w.WriteTime(clockFreq);
+    w.WriteByte((int)*status);
+
+    // registers, RAM and all IO registers, which hold the value itself
+    for(unsigned int addr = 0; addr < totalIoSpace; addr++)
+        rw[addr]->SaveCellState(w);
+
+    Flash->SaveState(w);
+    stack->SaveState(w);
+    if(irqSystem)
+        irqSystem->SaveState(w);
+
+    // hardware state, each is stored with size for checking on restore
+    for(unsigned int i = 0; i < hwResetList.size(); i++) {
+        ostringstream os;
+        SnapshotWriter hw(os);
+        hwResetList[i]->SaveState(hw);
+        w.WriteString(os.str());
+    }
+
+    // hardware, which is clocked by core
+    w.WriteDWord(hwCycleList.size());
+    for(unsigned int i = 0; i < hwCycleList.size(); i++)
+        w.WriteDWord(find(hwResetList.begin(), hwResetList.end(), hwCycleList[i]) - hwResetList.begin());
+}
+
+void AvrDevice::RestoreState(SnapshotReader &r) {
+    if(r.ReadDWord() != ioSpaceSize || r.ReadDWord() != iRamSize || r.ReadDWord() != eRamSize)
+        avr_error("snapshot: memory layout doesn't match device");
+    if(r.ReadDWord() != hwResetList.size())
+        avr_error("snapshot: hardware doesn't match device");
+
+    PC = r.ReadDWord();
+    cPC = r.ReadDWord();
+    cpuCycles = r.ReadInt();
+    deferIrq = r.ReadBool();
+    newIrqPc = r.ReadDWord();
+    actualIrqVector = r.ReadDWord();
+    clockFreq = r.ReadTime();
+    *status = r.ReadByte();
+    statusRegister->trigger_change();
+
+    for(unsigned int addr = 0; addr < totalIoSpace; addr++)
+        rw[addr]->RestoreCellState(r);
+
+    Flash->RestoreState(r);
+    stack->RestoreState(r);
+    if(irqSystem)
+        irqSystem->RestoreState(r);
+
+    for(unsigned int i = 0; i < hwResetList.size(); i++) {
+        istringstream is(r.ReadString());
+        SnapshotReader hw(is);
+        hwResetList[i]->RestoreState(hw);
+        if(!hw.AtEnd())
+            avr_error("snapshot: state of hardware #%d doesn't match device", i);
+    }
+
+    hwCycleList.clear();
+    unsigned long cnt = r.ReadDWord();
+    for(unsigned long i = 0; i < cnt; i++) {
+        unsigned int idx = r.ReadDWord();
+        if(idx >= hwResetList.size())
+            avr_error("snapshot: hardware doesn't match device");
+        hwCycleList.push_back(hwResetList[idx]);
+    }
+}
+
 void AvrDevice::DeleteAllBreakpoints() {
     BP.erase(BP.begin(), BP.end());
 }
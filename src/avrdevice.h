@@ -58,15 +58,34 @@ class HWWado;
 class Data;
 class HWIrqSystem;
 class RWMemoryMember;
+class RAMArea;
+class InvalidMem;
 class Hardware;
 class DumpManager;
 class AddressExtensionRegister;
+class SnapshotWriter;
+class SnapshotReader;
+class BlockTier;
+class AotModule;
+class DelayLoopSkipper;
+
+//! Interface to observe program flow of a core, see AvrDevice::SetPCObserver
+class PCObserver {
+
+    public:
+        virtual ~PCObserver() {}
+        //! Called before instruction on word address pc is executed
+        virtual void OnExecute(unsigned int pc) = 0;
+};
 
 //! Basic AVR device, contains the core functionality
 class AvrDevice: public SimulationMember, public TraceValueRegister {
 
     private:
-        RWMemoryMember **invalidRW; //!< hold invalid RW memory cells created by device
+        InvalidMem *invalidRW; //!< hold invalid RW memory cells created by device
+        RAMArea *registerArea; //!< cells for registers R0-R31
+        RAMArea *iRamArea; //!< cells for internal RAM
+        RAMArea *eRamArea; //!< cells for external RAM
         const unsigned int ioSpaceSize;
         static const unsigned int totalIoSpace;
         static const unsigned int registerSpaceSize;
@@ -107,6 +126,11 @@ class AvrDevice: public SimulationMember, public TraceValueRegister {
         AddressExtensionRegister *eind; //!< EIND address extension register
         bool abortOnInvalidAccess; //!< Flag, that simulation abort if an invalid access occured, default is false
         TraceValueCoreRegister coreTraceGroup;
+        PCObserver *pcObserver; //!< observer for program flow or NULL, see SetPCObserver
+        BlockTier *blockTier; //!< executes hot code blocks or NULL, see SetBlockTier
+        AotModule *aotModule; //!< ahead-of-time translated program or NULL, see LoadAotModule
+        DelayLoopSkipper *delayLoops; //!< skips busy-wait loops or NULL, see SetDelayLoopSkip
+        bool fusion; //!< execute superinstructions, see SetFusion
         bool deferIrq;  ///< Almost always false.
         unsigned int newIrqPc;
         unsigned int actualIrqVector;
@@ -165,6 +189,7 @@ class AvrDevice: public SimulationMember, public TraceValueRegister {
         void RegisterTerminationSymbol(const char *symbol);
 
         Pin *GetPin(const char *name);
+        Pin *FindPin(const char *name); //!< like GetPin, but returns NULL for a unknown pin
         /*! Steps the AVR core.
           \param untilCoreStepFinished iff true, steps a core step and not a
           single clock cycle. */
@@ -180,6 +205,39 @@ class AvrDevice: public SimulationMember, public TraceValueRegister {
         //! Clear all breakpoints in device
         void DeleteAllBreakpoints(void);
 
+        //! Set observer, which is called for every executed instruction (NULL removes it)
+        /*! Only one observer is possible, it's called before flash range check,
+          so it sees also a PC, which runs out of flash. */
+        void SetPCObserver(PCObserver *o) { pcObserver = o; }
+        //! Returns current observer or NULL, see SetPCObserver
+        PCObserver *GetPCObserver(void) { return pcObserver; }
+
+        //! Switches block execution of hot straight line code on or off, see BlockTier
+        /*! Blocks are only used, if there is no trace, dumper, PC observer
+          or breakpoint. Interrupts raised while a block runs are taken at
+          block exit. Off by default. */
+        void SetBlockTier(bool on);
+        //! Returns block tier or NULL, if it's off
+        BlockTier *GetBlockTier(void) { return blockTier; }
+        //! Switches execution of superinstructions (see avr_op_FUSED) on or off
+        /*! Off by default. They are only used, if there is no trace, dumper or
+          PC observer and interrupts are disabled: hardware runs the cycles of
+          a superinstruction after it, so a interrupt raised in between would
+          be taken later than without. A debugger has to switch them off for
+          single steps. */
+        void SetFusion(bool on) { fusion = on; }
+        //! Loads a translated module for the program in flash, see AotModule
+        /*! Call it after loading the program. An empty filename removes the module. */
+        void LoadAotModule(const std::string &filename);
+        //! Returns the loaded translated module or NULL
+        AotModule *GetAotModule(void) { return aotModule; }
+        //! Switches skipping of busy-wait delay loops on or off, see DelayLoopSkipper
+        /*! Same restrictions as for SetBlockTier, but cycles and interrupt
+          latency are the same as with the interpreter. Off by default. */
+        void SetDelayLoopSkip(bool on);
+        //! Returns delay loop skipper or NULL, if it's off
+        DelayLoopSkipper *GetDelayLoopSkipper(void) { return delayLoops; }
+
         //! Return filename from loaded program
         const std::string &GetFname(void) { return actualFilename; }
         //! Return device name
@@ -228,6 +286,11 @@ class AvrDevice: public SimulationMember, public TraceValueRegister {
         //! When a call/jump/cond-jump instruction was executed. For debugging.
         void DebugOnJump();
 
+        //! Save complete device state (core, memories, hardware) for a snapshot, see snapshot.h
+        void SaveState(SnapshotWriter &w);
+        //! Restore complete device state from a snapshot, see snapshot.h
+        void RestoreState(SnapshotReader &r);
+
         friend void ELFLoad(AvrDevice * core);
 
 };
@@ -55,6 +55,8 @@ class SystemConsoleHandler {
         
         //! Tells the handler, that exit/abort is to use instead of exceptions
         void SetUseExit(bool useExit = true);
+        //! Returns true, if exit/abort is used instead of exceptions
+        bool GetUseExit(void) const { return useExitAndAbort; }
         //! Sets the output stream, where messages are sent to
         void SetMessageStream(std::ostream *s);
         //! Sets the output stream, where warnings and errors are sent to
@@ -136,6 +136,12 @@ unsigned int ELFGetDeviceNameAndSignature(const char *filename, char *devicename
     return std::numeric_limits<unsigned int>::max();
 }
 
+
+bool ELFReadLineTable(const char *filename, ELFLineTable &table) {
+    avr_warning("reading line table from ELF file isn't supported on this platform");
+    return false;
+}
+
 #endif
 
 #ifndef _MSC_VER
@@ -463,6 +469,315 @@ unsigned int ELFGetDeviceNameAndSignature(const char *filename, char *devicename
     return signature;
 }
 
+//! Reads DWARF data from a section with bounds check
+class DwarfReader {
+
+    protected:
+        const unsigned char *data;
+        size_t size;
+        size_t pos;
+
+    public:
+        DwarfReader(const unsigned char *d, size_t s, size_t p = 0): data(d), size(s), pos(p) {}
+
+        bool AtEnd(void) const { return pos >= size; }
+        size_t GetPos(void) const { return pos; }
+        void SetPos(size_t p) { pos = p; }
+        void Skip(size_t n) { pos += n; }
+
+        unsigned long long ReadFixed(unsigned int n) {
+            unsigned long long v = 0;
+            for(unsigned int i = 0; i < n; i++, pos++) {
+                if(pos < size)
+                    v |= (unsigned long long)data[pos] << (8 * i);
+            }
+            return v;
+        }
+        unsigned long long ReadULEB(void) {
+            unsigned long long v = 0;
+            unsigned int shift = 0;
+            while(pos < size) {
+                unsigned char b = data[pos++];
+                if(shift < 64)
+                    v |= (unsigned long long)(b & 0x7f) << shift;
+                shift += 7;
+                if((b & 0x80) == 0)
+                    break;
+            }
+            return v;
+        }
+        long long ReadSLEB(void) {
+            long long v = 0;
+            unsigned int shift = 0;
+            unsigned char b = 0;
+            while(pos < size) {
+                b = data[pos++];
+                if(shift < 64)
+                    v |= (long long)(b & 0x7f) << shift;
+                shift += 7;
+                if((b & 0x80) == 0)
+                    break;
+            }
+            if(shift < 64 && (b & 0x40))
+                v |= -((long long)1 << shift);
+            return v;
+        }
+        std::string ReadString(void) {
+            std::string s;
+            while(pos < size && data[pos] != 0)
+                s += (char)data[pos++];
+            pos++;
+            return s;
+        }
+};
+
+//! Returns string from a string section (.debug_str, .debug_line_str)
+static std::string DwarfSectionString(ELFIO::section *sec, unsigned long long offset) {
+    if(sec == NULL || offset >= sec->get_size())
+        return "";
+    DwarfReader r((const unsigned char *)sec->get_data(), sec->get_size(), offset);
+    return r.ReadString();
+}
+
+//! Reads a attribute of a directory or file entry (DWARF 5), strings are returned in s
+static unsigned long long DwarfReadForm(DwarfReader &r,
+                                        unsigned long long form,
+                                        bool dwarf64,
+                                        ELFIO::section *str,
+                                        ELFIO::section *lineStr,
+                                        std::string &s) {
+    switch(form) {
+        case 0x08: // DW_FORM_string
+            s = r.ReadString();
+            return 0;
+        case 0x0e: // DW_FORM_strp
+            s = DwarfSectionString(str, r.ReadFixed(dwarf64 ? 8 : 4));
+            return 0;
+        case 0x1f: // DW_FORM_line_strp
+            s = DwarfSectionString(lineStr, r.ReadFixed(dwarf64 ? 8 : 4));
+            return 0;
+        case 0x0b: // DW_FORM_data1
+            return r.ReadFixed(1);
+        case 0x05: // DW_FORM_data2
+            return r.ReadFixed(2);
+        case 0x06: // DW_FORM_data4
+            return r.ReadFixed(4);
+        case 0x07: // DW_FORM_data8
+            return r.ReadFixed(8);
+        case 0x1e: // DW_FORM_data16
+            r.Skip(16);
+            return 0;
+        case 0x0f: // DW_FORM_udata
+            return r.ReadULEB();
+        case 0x09: // DW_FORM_block
+            r.Skip(r.ReadULEB());
+            return 0;
+        default:
+            avr_warning("unsupported DWARF form 0x%llx in line table", form);
+            r.SetPos((size_t)-1 / 2);
+            return 0;
+    }
+}
+
+//! Reads directory or file entries of a DWARF 5 line table header
+static void DwarfReadEntries(DwarfReader &r,
+                             bool dwarf64,
+                             ELFIO::section *str,
+                             ELFIO::section *lineStr,
+                             std::vector<std::string> &names,
+                             std::vector<unsigned long long> &dirs) {
+    std::vector<std::pair<unsigned long long, unsigned long long> > format;
+    unsigned int cnt = r.ReadFixed(1);
+    for(unsigned int i = 0; i < cnt; i++) {
+        unsigned long long type = r.ReadULEB();
+        format.push_back(std::make_pair(type, r.ReadULEB()));
+    }
+    unsigned long long entries = r.ReadULEB();
+    for(unsigned long long i = 0; i < entries && !r.AtEnd(); i++) {
+        std::string name;
+        unsigned long long dir = 0;
+        for(size_t j = 0; j < format.size(); j++) {
+            std::string s;
+            unsigned long long v = DwarfReadForm(r, format[j].second, dwarf64, str, lineStr, s);
+            if(format[j].first == 1) // DW_LNCT_path
+                name = s;
+            else if(format[j].first == 2) // DW_LNCT_directory_index
+                dir = v;
+        }
+        names.push_back(name);
+        dirs.push_back(dir);
+    }
+}
+
+//! Joins directory and file name
+static std::string DwarfPath(const std::string &dir, const std::string &name) {
+    if(dir.empty() || name.empty() || name[0] == '/')
+        return name;
+    return dir + "/" + name;
+}
+
+bool ELFReadLineTable(const char *filename, ELFLineTable &table) {
+    ELFIO::elfio reader;
+
+    if(!reader.load(filename))
+        avr_error("File '%s' not found or isn't a elf object", filename);
+
+    ELFIO::section *line = NULL, *str = NULL, *lineStr = NULL;
+    for(ELFIO::Elf_Half i = 0; i < reader.sections.size(); i++) {
+        ELFIO::section* psec = reader.sections[i];
+        if(psec->get_name() == ".debug_line")
+            line = psec;
+        else if(psec->get_name() == ".debug_str")
+            str = psec;
+        else if(psec->get_name() == ".debug_line_str")
+            lineStr = psec;
+    }
+    if(line == NULL || line->get_data() == NULL)
+        return false;
+
+    DwarfReader r((const unsigned char *)line->get_data(), line->get_size());
+    std::map<std::string, int> fileIndex;
+
+    // over all line tables, one for each compilation unit
+    while(!r.AtEnd()) {
+        bool dwarf64 = false;
+        unsigned long long unitLength = r.ReadFixed(4);
+        if(unitLength == 0xffffffffULL) {
+            dwarf64 = true;
+            unitLength = r.ReadFixed(8);
+        }
+        size_t unitEnd = r.GetPos() + unitLength;
+        unsigned int version = r.ReadFixed(2);
+        if(version < 2 || version > 5) {
+            avr_warning("unsupported DWARF version %d in line table", version);
+            r.SetPos(unitEnd);
+            continue;
+        }
+        if(version >= 5)
+            r.Skip(2); // address size and segment selector size
+        unsigned long long headerLength = r.ReadFixed(dwarf64 ? 8 : 4);
+        size_t programStart = r.GetPos() + headerLength;
+        unsigned int minInstLength = r.ReadFixed(1);
+        if(version >= 4)
+            r.Skip(1); // maximum operations per instruction, always 1 for AVR
+        r.Skip(1); // default is_stmt
+        int lineBase = (signed char)r.ReadFixed(1);
+        unsigned int lineRange = r.ReadFixed(1);
+        unsigned int opcodeBase = r.ReadFixed(1);
+        std::vector<unsigned int> opcodeLengths;
+        for(unsigned int i = 1; i < opcodeBase; i++)
+            opcodeLengths.push_back(r.ReadFixed(1));
+        if(lineRange == 0) {
+            r.SetPos(unitEnd);
+            continue;
+        }
+
+        // directories and files, file index in line program is mapped to index in table.files
+        std::vector<std::string> dirNames, fileNames;
+        std::vector<unsigned long long> dummy, fileDirs;
+        if(version >= 5) {
+            DwarfReadEntries(r, dwarf64, str, lineStr, dirNames, dummy);
+            DwarfReadEntries(r, dwarf64, str, lineStr, fileNames, fileDirs);
+        } else {
+            dirNames.push_back(""); // directory 0 is compilation directory
+            for(std::string d = r.ReadString(); d.size(); d = r.ReadString())
+                dirNames.push_back(d);
+            fileNames.push_back(""); // file numbers start with 1
+            fileDirs.push_back(0);
+            for(std::string f = r.ReadString(); f.size(); f = r.ReadString()) {
+                fileNames.push_back(f);
+                fileDirs.push_back(r.ReadULEB());
+                r.ReadULEB(); // modification time
+                r.ReadULEB(); // file size
+            }
+        }
+        std::vector<int> files;
+        for(size_t i = 0; i < fileNames.size(); i++) {
+            std::string dir = (fileDirs[i] < dirNames.size()) ? dirNames[fileDirs[i]] : "";
+            std::string path = DwarfPath(dir, fileNames[i]);
+            if(fileIndex.find(path) == fileIndex.end()) {
+                fileIndex[path] = table.files.size();
+                table.files.push_back(path);
+            }
+            files.push_back(fileIndex[path]);
+        }
+
+        // run line number program
+        r.SetPos(programStart);
+        unsigned long long address = 0, file = 1;
+        long long lineNo = 1;
+        while(r.GetPos() < unitEnd) {
+            unsigned int op = r.ReadFixed(1);
+            bool emit = false, endSequence = false;
+            if(op >= opcodeBase) {
+                // special opcode
+                unsigned int adj = op - opcodeBase;
+                address += (adj / lineRange) * minInstLength;
+                lineNo += lineBase + (int)(adj % lineRange);
+                emit = true;
+            } else if(op == 0) {
+                // extended opcode
+                unsigned long long len = r.ReadULEB();
+                size_t end = r.GetPos() + len;
+                unsigned int sub = (len > 0) ? r.ReadFixed(1) : 0;
+                if(sub == 1) { // DW_LNE_end_sequence
+                    emit = endSequence = true;
+                } else if(sub == 2) { // DW_LNE_set_address
+                    address = r.ReadFixed(len - 1);
+                } else if(sub == 3) { // DW_LNE_define_file
+                    std::string f = r.ReadString();
+                    unsigned long long d = r.ReadULEB();
+                    std::string path = DwarfPath((d < dirNames.size()) ? dirNames[d] : "", f);
+                    if(fileIndex.find(path) == fileIndex.end()) {
+                        fileIndex[path] = table.files.size();
+                        table.files.push_back(path);
+                    }
+                    files.push_back(fileIndex[path]);
+                }
+                r.SetPos(end);
+            } else {
+                switch(op) {
+                    case 1: // DW_LNS_copy
+                        emit = true;
+                        break;
+                    case 2: // DW_LNS_advance_pc
+                        address += r.ReadULEB() * minInstLength;
+                        break;
+                    case 3: // DW_LNS_advance_line
+                        lineNo += r.ReadSLEB();
+                        break;
+                    case 4: // DW_LNS_set_file
+                        file = r.ReadULEB();
+                        break;
+                    case 8: // DW_LNS_const_add_pc
+                        address += ((255 - opcodeBase) / lineRange) * minInstLength;
+                        break;
+                    case 9: // DW_LNS_fixed_advance_pc
+                        address += r.ReadFixed(2);
+                        break;
+                    default: // skip operands of all other opcodes
+                        for(unsigned int i = 0; i < opcodeLengths[op - 1]; i++)
+                            r.ReadULEB();
+                }
+            }
+            if(emit) {
+                ELFLineTable::Row row;
+                row.address = (unsigned int)address;
+                row.line = (unsigned int)lineNo;
+                row.file = (endSequence || file >= files.size()) ? -1 : files[file];
+                table.rows.push_back(row);
+            }
+            if(endSequence) {
+                address = 0;
+                file = 1;
+                lineNo = 1;
+            }
+        }
+        r.SetPos(unitEnd);
+    }
+    return table.rows.size() > 0;
+}
+
 #endif
 
 // EOF
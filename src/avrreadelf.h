@@ -26,9 +26,30 @@
 #ifndef AVRREADELF
 #define AVRREADELF
 
+#include <string>
+#include <vector>
+
 #include "avrdevice.h"
 
 unsigned int ELFGetDeviceNameAndSignature(const char *filename, char *devicename);
 void ELFLoad(AvrDevice * core);
 
+//! Source line table of a program, read from DWARF debug info (.debug_line)
+class ELFLineTable {
+
+    public:
+        //! One row of line table, valid till address of next row in same sequence
+        struct Row {
+            unsigned int address; //!< flash address in bytes
+            unsigned int line;    //!< source line
+            int file;             //!< index in files, -1 for end of sequence
+        };
+
+        std::vector<std::string> files; //!< source file names
+        std::vector<Row> rows;          //!< rows, ordered by sequences
+};
+
+//! Reads line table from elf file, returns false, if no line info is found
+bool ELFReadLineTable(const char *filename, ELFLineTable &table);
+
 #endif
@@ -0,0 +1,146 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2001, 2002 - 2012   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#include <algorithm>
+
+#include "blocktier.h"
+#include "avrdevice.h"
+#include "decoder.h"
+#include "flash.h"
+#include "hwsreg.h"
+
+BlockTier::BlockTier(AvrDevice *_core):
+    core(_core),
+    generation(0),
+    blocksExecuted(0),
+    insnsExecuted(0)
+{
+    Flush();
+}
+
+void BlockTier::Flush(void) {
+    unsigned int words = core->Flash->GetSize() / 2;
+    hits.assign(words, 0);
+    blockLen.assign(words, BLOCK_UNKNOWN);
+    generation = core->Flash->GetCodeGeneration();
+}
+
+int BlockTier::Classify(unsigned int opcode) {
+    if(opcode == 0x0000)                        // NOP
+        return 1;
+    switch(opcode & 0xff00) {
+        case 0x0100:                            // MOVW
+        case 0x0200:                            // MULS
+        case 0x0300:                            // MULSU, FMUL, FMULS, FMULSU
+        case 0x9600:                            // ADIW
+        case 0x9700:                            // SBIW
+            return 1;
+    }
+    switch(opcode & 0xfc00) {
+        case 0x0400: case 0x0800: case 0x0c00:  // CPC, SBC, ADD
+        case 0x1400: case 0x1800: case 0x1c00:  // CP, SUB, ADC
+        case 0x2000: case 0x2400:               // AND, EOR
+        case 0x2800: case 0x2c00:               // OR, MOV
+        case 0x9c00:                            // MUL
+            return 1;
+        case 0x1000:                            // CPSE
+            return 2;
+    }
+    switch(opcode & 0xf000) {
+        case 0x3000: case 0x4000: case 0x5000:  // CPI, SBCI, SUBI
+        case 0x6000: case 0x7000: case 0xe000:  // ORI, ANDI, LDI
+            return 1;
+        case 0xc000:                            // RJMP
+            return 2;
+    }
+    if((opcode & 0xfe08) == 0x9400) {
+        // one operand instructions, but not 0x9404 (reserved)
+        unsigned int op = opcode & 0x000f;
+        if(op == 0x0 || op == 0x1 || op == 0x2 || op == 0x3 ||  // COM, NEG, SWAP, INC
+           op == 0x5 || op == 0x6 || op == 0x7)                 // ASR, LSR, ROR
+            return 1;
+    }
+    if((opcode & 0xfe0f) == 0x940a)             // DEC
+        return 1;
+    if((opcode & 0xff0f) == 0x9408 && (opcode & 0x0070) != 0x0070)
+        return 1;                               // BSET / BCLR, but not SEI / CLI
+    if((opcode & 0xfc08) == 0xf800)             // BLD, BST
+        return 1;
+    if((opcode & 0xf800) == 0xf000)             // BRBS, BRBC
+        return 2;
+    if((opcode & 0xfc08) == 0xfc00)             // SBRC, SBRS
+        return 2;
+    return 0;
+}
+
+unsigned short BlockTier::Translate(unsigned int pc) {
+    unsigned int words = blockLen.size();
+    unsigned short len = 0;
+    while(len < MAX_BLOCK_LEN && pc + len < words) {
+        unsigned int p = pc + len;
+        // exit points have to be checked by core
+        if(len > 0 && core->EP.end() != std::find(core->EP.begin(), core->EP.end(), p))
+            break;
+        int c = Classify(core->Flash->GetOpcode(p));
+        if(c == 0)
+            break;
+        len++;
+        if(c == 2)
+            break;
+    }
+    // a single instruction isn't worth the block overhead
+    return (len < 2) ? (unsigned short)BLOCK_NONE : len;
+}
+
+int BlockTier::Run(void) {
+    if(generation != core->Flash->GetCodeGeneration())
+        Flush();
+    // a interrupt, raised inside the block, would be taken too late
+    if(core->status->I)
+        return 0;
+
+    unsigned int pc = core->PC;
+    if(pc >= blockLen.size())
+        return 0;
+    unsigned short len = blockLen[pc];
+    if(len == BLOCK_UNKNOWN) {
+        if(++hits[pc] < HOT_COUNT)
+            return 0;
+        len = blockLen[pc] = Translate(pc);
+    }
+    if(len == BLOCK_NONE)
+        return 0;
+
+    int cycles = 0;
+    for(unsigned short i = 0; i < len; i++) {
+        cycles += (*core->Flash->GetInstruction(core->PC))();
+        core->PC++;
+    }
+    blocksExecuted++;
+    insnsExecuted += len;
+    return cycles;
+}
+
+// EOF
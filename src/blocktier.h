@@ -0,0 +1,96 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2001, 2002 - 2012   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#ifndef BLOCKTIER
+#define BLOCKTIER
+
+#include <vector>
+
+class AvrDevice;
+
+//! Executes hot straight line code of a core as whole blocks
+/*! This is no JIT, no host code is generated at run time: a block runs the
+  decoded instructions (DecodedInstruction) of its run in one loop and saves
+  the scheduler, hardware and IRQ checks between them. Native host code for
+  the same blocks is made ahead of time, see AotModule.
+
+  Every instruction start is counted. If a PC was reached often enough, a
+  block is translated from there: the run of instructions, which only work on
+  registers R0-R31 and SREG (ALU, MOV, LDI, MUL, ADIW, ...), optionally ended by
+  a instruction, which only changes PC (RJMP, BRBS/BRBC, CPSE, SBRC/SBRS).
+  Instructions, which access IO, data memory, stack or I flag are never part
+  of a block, they are executed by the normal interpreter path.
+
+  A block is executed in one AvrDevice::Step like a single instruction with
+  the cycles of all its instructions: hardware on the cycle list gets them one
+  by one on the following core steps, so it sees the same simulation time as
+  on the interpreter path, holds (CpuCycle returns > 0) included. Only if no
+  hardware is on the cycle list, the next core step is scheduled after the
+  block. Blocks run only with interrupts disabled, otherwise a interrupt
+  raised inside a block would be taken too late. Blocks are dropped, if flash
+  is decoded again (program load, SPM or snapshot restore). */
+class BlockTier {
+
+    public:
+        //! values for block length of a PC
+        enum {
+            BLOCK_UNKNOWN = 0,        //!< not yet translated
+            BLOCK_NONE = 0xffff       //!< no block possible on this PC
+        };
+
+        static const unsigned int HOT_COUNT = 16;      //!< executions of a PC, before a block is translated
+        static const unsigned int MAX_BLOCK_LEN = 64;  //!< instructions per block at most
+
+    protected:
+        AvrDevice *core;
+        std::vector<unsigned short> hits;    //!< execution count for every flash word
+        std::vector<unsigned short> blockLen; //!< translated block length for every flash word
+        unsigned int generation;              //!< AvrFlash code generation, the blocks belong to
+        unsigned long long blocksExecuted;    //!< statistic: count of executed blocks
+        unsigned long long insnsExecuted;     //!< statistic: count of instructions executed in blocks
+
+        //! Translates block on pc, returns its length or BLOCK_NONE
+        unsigned short Translate(unsigned int pc);
+        //! Drops all blocks and execution counts
+        void Flush(void);
+
+    public:
+        BlockTier(AvrDevice *core);
+
+        //! Returns 0 for a instruction, which can't be in a block, 1 for a block instruction and 2, if it ends a block
+        static int Classify(unsigned int opcode);
+
+        //! Runs block on core->PC, if there is one
+        /*! Returns used cycles or 0, if no block was executed (always with I
+          flag set). core->PC is set to the instruction after the block. */
+        int Run(void);
+
+        //! Returns count of executed blocks
+        unsigned long long GetBlocksExecuted(void) const { return blocksExecuted; }
+        //! Returns count of instructions executed in blocks
+        unsigned long long GetInsnsExecuted(void) const { return insnsExecuted; }
+};
+
+#endif
@@ -0,0 +1,163 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2001, 2002 - 2012   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+/* libFuzzer target: simulavr-fuzzer, linked with -fsanitize=fuzzer
+
+   The simulator itself should not be instrumented (compile libsim without
+   -fsanitize=fuzzer), coverage of firmware is given to libFuzzer by extra
+   counters. Options for simulavr follow -ignore_remaining_args=1:
+
+   simulavr-fuzzer corpus/ -ignore_remaining_args=1 -d atmega128 -f fw.elf
+       --fuzz-pipe 0x41 [--fuzz-uart <pin>,<baud>] [--fuzz-stack <address>]
+       [--fuzz-start <label>] [-F <frequency>] [-m <nanoseconds>]
+*/
+
+#include <iostream>
+#include <string>
+#include <string.h>
+#include <stdlib.h>
+
+#include "config.h"
+
+#include "flash.h"
+#include "avrdevice.h"
+#include "avrfactory.h"
+#include "avrreadelf.h"
+#include "systemclock.h"
+#include "string2.h"
+#include "fuzzharness.h"
+
+//! firmware edge coverage, collected by libFuzzer as extra counters
+__attribute__((used, section("__libfuzzer_extra_counters")))
+static unsigned char fuzzCounters[65536];
+
+static FuzzHarness *harness = NULL;
+
+static void Usage(const char *msg) {
+    std::cerr << "simulavr-fuzzer: " << msg << std::endl
+              << "usage: simulavr-fuzzer [libFuzzer options] -ignore_remaining_args=1"
+                 " -f <elf file> [-d <device>] [-F <frequency>] [-m <nanoseconds>]"
+                 " --fuzz-pipe <offset> | --fuzz-uart <pin>,<baudrate>"
+                 " [--fuzz-stack <address>] [--fuzz-start <label>]" << std::endl;
+    exit(1);
+}
+
+extern "C" int LLVMFuzzerInitialize(int *argc, char ***argv) {
+    std::string devicename("unknown");
+    std::string filename;
+    std::string uartPin;
+    std::string startSymbol;
+    unsigned long pipeOffset = 0;
+    unsigned long uartBaud = 0;
+    unsigned long stackLimit = 0;
+    unsigned long long fcpu = 0;
+    unsigned long long maxRunTime = 0;
+
+    // our options are after -ignore_remaining_args=1, libFuzzer ignores them
+    int i = 1;
+    while(i < *argc && strcmp((*argv)[i], "-ignore_remaining_args=1") != 0)
+        i++;
+    for(i++; i < *argc; i += 2) {
+        std::string opt((*argv)[i]);
+        if(i + 1 >= *argc)
+            Usage(("option " + opt + " needs a argument").c_str());
+        const char *arg = (*argv)[i + 1];
+        if(opt == "-d" || opt == "--device")
+            devicename = arg;
+        else if(opt == "-f" || opt == "--file")
+            filename = arg;
+        else if(opt == "-F" || opt == "--cpufrequency") {
+            if(!StringToUnsignedLongLong(arg, &fcpu, NULL, 10))
+                Usage("frequency is not a number");
+        } else if(opt == "-m") {
+            if(!StringToUnsignedLongLong(arg, &maxRunTime, NULL, 10))
+                Usage("maxRunTime is not a number");
+        } else if(opt == "--fuzz-pipe") {
+            if(!StringToUnsignedLong(arg, &pipeOffset, NULL, 16))
+                Usage("fuzz-pipe offset is not a number");
+        } else if(opt == "--fuzz-uart") {
+            const char *comma = strchr(arg, ',');
+            if(comma == NULL || !StringToUnsignedLong(comma + 1, &uartBaud, NULL, 10))
+                Usage("fuzz-uart: argument has to be <pin>,<baudrate>");
+            uartPin = std::string(arg, comma - arg);
+        } else if(opt == "--fuzz-stack") {
+            if(!StringToUnsignedLong(arg, &stackLimit, NULL, 16))
+                Usage("fuzz-stack address is not a number");
+        } else if(opt == "--fuzz-start")
+            startSymbol = arg;
+        else
+            Usage(("unknown option " + opt).c_str());
+    }
+    if(filename.empty())
+        Usage("no elf file given");
+    if(pipeOffset == 0 && uartPin.empty())
+        Usage("--fuzz-pipe or --fuzz-uart is necessary");
+
+    char devname[1024];
+    strncpy(devname, devicename.c_str(), sizeof(devname) - 1);
+    devname[sizeof(devname) - 1] = 0;
+    unsigned int sig = ELFGetDeviceNameAndSignature(filename.c_str(), devname);
+    AvrDevice *dev = AvrFactory::instance().makeDevice(devname);
+    dev->SetDeviceNameAndSignature(devname, sig);
+    dev->Load(filename.c_str());
+    dev->Reset();
+    if(fcpu != 0)
+        dev->SetClockFreq((SystemClockOffset)1000000000 / fcpu);
+    if(dev->GetClockFreq() == 0)
+        dev->SetClockFreq((SystemClockOffset)1000000000 / 4000000);
+    SystemClock::Instance().Add(dev);
+
+    unsigned int startPC = 0;
+    if(startSymbol.size())
+        startPC = dev->Flash->GetAddressAtSymbol(startSymbol);
+
+    harness = new FuzzHarness(dev);
+    harness->SetCoverageMap(fuzzCounters, sizeof(fuzzCounters));
+    if(pipeOffset)
+        harness->UsePipeInput(pipeOffset);
+    else
+        harness->UseUartInput(uartPin.c_str(), uartBaud);
+    harness->SetStackLimit(stackLimit);
+    if(maxRunTime)
+        harness->SetMaxCycles(maxRunTime / dev->GetClockFreq());
+    if(startSymbol.size() && !harness->SetBranchPointAt(startPC)) {
+        std::cerr << "fuzz-start: '" << startSymbol << "' not reached "
+                  << harness->GetErrorMessage() << std::endl;
+        exit(1);
+    }
+    return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const unsigned char *data, size_t size) {
+    FuzzHarness::FuzzResult res = harness->RunInput(data, size);
+    if(FuzzHarness::IsCrash(res)) {
+        std::cerr << "simulavr-fuzzer: " << FuzzHarness::ResultName(res) << " "
+                  << harness->GetErrorMessage() << std::endl;
+        abort();
+    }
+    return 0;
+}
+
+// EOF
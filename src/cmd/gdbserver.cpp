@@ -296,6 +296,8 @@ GdbServer::GdbServer(AvrDevice *c, int _port, int debug, int _waitForGdbConnecti
     lastCoreStepFinished = true;
     connState = false;
     m_gdb_thread_id = 1;  // we start with the first thread already created
+    core->SetFusion(false);  // single steps have to stop on every instruction
+    core->stack->m_ThreadList.SetEnabled(true);  // threads are reported to gdb
 
 #if defined(HAVE_SYS_MINGW) || defined(_MSC_VER)
     server = new GdbServerSocketMingW(_port);
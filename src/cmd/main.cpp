@@ -24,6 +24,8 @@
  */
 
 #include <iostream>
+#include <fstream>
+#include <iterator>
 #include <sstream>
 #include <string>
 #include <cstring>
@@ -58,9 +60,17 @@
 #include "helper.h"
 #include "specialmem.h"
 #include "irqsystem.h"
+#include "hwspi.h"
 #include "wiz_ethernet.h"
 #include "w5500_eth.h"
 #include "cbui.h"
+#include "snapshot.h"
+#include "fuzzharness.h"
+#include "coverage.h"
+#include "hwuart.h"
+#include "ui/uartbridge.h"
+#include "stimulus.h"
+#include "aotmodule.h"
 
 #include "dumpargs.h"
 
@@ -93,6 +103,118 @@ const char *SplitOffsetFile(const char *arg,
     return end;
 }
 
+//! Runs program with one fuzz input file, returns true on a crash
+static bool RunFuzzFile(FuzzHarness &harness, const std::string &file) {
+    std::ifstream f(file.c_str(), std::ios::in | std::ios::binary);
+    if(!f.is_open())
+        avr_error("can't open fuzz input file '%s'", file.c_str());
+    std::vector<unsigned char> data((std::istreambuf_iterator<char>(f)),
+                                    std::istreambuf_iterator<char>());
+    FuzzHarness::FuzzResult res = harness.RunInput(data.size() ? &data[0] : NULL, data.size());
+    avr_message("fuzz %s: %s %s", file.c_str(), FuzzHarness::ResultName(res),
+                harness.GetErrorMessage().c_str());
+    return FuzzHarness::IsCrash(res);
+}
+
+//! Runs program once for every fuzz input file, aborts on a crash (for AFL)
+/*! If simulavr is compiled with afl-clang-fast, __AFL_LOOP is defined and
+  AFL persistent mode is used for a single input file: AFL writes a new input
+  to the same file and simulavr runs it from the branch point without a new
+  process start. */
+int RunFuzzFiles(AvrDevice *dev,
+                 const std::vector<std::string> &files,
+                 unsigned long pipeOffset,
+                 const std::string &uartPin,
+                 unsigned long uartBaud,
+                 unsigned long stackLimit,
+                 const std::string &startSymbol,
+                 unsigned long long maxRunTime)
+{
+    // resolve symbol, before harness switches error handling to exceptions
+    unsigned int startPC = 0;
+    if(startSymbol.size())
+        startPC = dev->Flash->GetAddressAtSymbol(startSymbol);
+
+    FuzzHarness harness(dev);
+    if(pipeOffset)
+        harness.UsePipeInput(pipeOffset);
+    else if(uartPin.size())
+        harness.UseUartInput(uartPin.c_str(), uartBaud);
+    else
+        avr_error("--fuzz needs --fuzz-pipe or --fuzz-uart");
+    harness.SetStackLimit(stackLimit);
+    if(maxRunTime)
+        harness.SetMaxCycles(maxRunTime / dev->GetClockFreq());
+    if(startSymbol.size()) {
+        if(!harness.SetBranchPointAt(startPC)) {
+            std::cerr << "fuzz-start: '" << startSymbol << "' not reached "
+                      << harness.GetErrorMessage() << std::endl;
+            exit(1);
+        }
+        avr_message("fuzz start at '%s'", startSymbol.c_str());
+    }
+    harness.AttachAFLSharedMemory();
+
+#ifdef __AFL_LOOP
+    if(files.size() == 1) {
+        while(__AFL_LOOP(1000)) {
+            if(RunFuzzFile(harness, files[0]))
+                abort();
+        }
+        return 0;
+    }
+#endif
+
+    bool crashed = false;
+    for(size_t i = 0; i < files.size(); i++) {
+        if(RunFuzzFile(harness, files[i]))
+            crashed = true;
+    }
+    if(crashed)
+        abort();
+    return 0;
+}
+
+//! Coverage recorder for --coverage, written on exit
+static CoverageRecorder *coverageRecorder = NULL;
+static std::string coverageFile;
+static std::string coverageElfFile;
+
+//! Writes coverage file, also if simulation is stopped by exit()
+static void WriteCoverage(void) {
+    if(coverageRecorder == NULL)
+        return;
+    avr_message("write coverage file ...");
+    coverageRecorder->Write(coverageFile, coverageElfFile);
+    delete coverageRecorder;
+    coverageRecorder = NULL;
+}
+
+//! Starts coverage recording for --coverage, program has to be loaded before
+static void StartCoverage(AvrDevice *dev, const std::string &elfFile) {
+    coverageRecorder = new CoverageRecorder(dev);
+    coverageElfFile = elfFile;
+    atexit(WriteCoverage);
+}
+
+//! Connects UARTs of device to host endpoints given by --uart-bridge
+static void StartUartBridges(AvrDevice *dev,
+                             const std::vector<std::string> &args,
+                             std::vector<UartBridge *> &bridges) {
+    for(size_t i = 0; i < args.size(); i++) {
+        size_t comma = args[i].find(',');
+        if(comma == std::string::npos)
+            avr_error("--uart-bridge: argument has to be <uart>,<bridge>");
+        std::string name = "UART" + args[i].substr(0, comma);
+        HWUart *uart = dynamic_cast<HWUart *>(dev->FindScopeGroupByName(name));
+        if(uart == NULL)
+            avr_error("--uart-bridge: device has no %s", name.c_str());
+        UartBridge *b = UartBridge::Create(args[i].substr(comma + 1));
+        uart->SetBridge(b);
+        bridges.push_back(b);
+    }
+}
+
 const char Usage[] =
     "AVR-Simulator Version " VERSION "\n"
     "-u                    run with user interface for external pin\n"
@@ -126,6 +248,52 @@ const char Usage[] =
     "                      add a special register at IO-offset\n"
     "                      which exits simulator run\n"
     "-C --core-dump <name> dump a core memory image <name> to file on exit\n"
+    "   --snapshot <name>  save complete device state to snapshot file <name> on exit\n"
+    "   --restore <name>   restore device state from snapshot file <name> before\n"
+    "                      simulation starts, -f isn't necessary then\n"
+    "   --fuzz <file>      run program once for every given input <file> from the\n"
+    "                      same start point (reset or --restore), collect edge\n"
+    "                      coverage in AFL shared memory, if available, and abort\n"
+    "                      on a crash. Input is given by --fuzz-pipe or --fuzz-uart\n"
+    "   --fuzz-pipe <offset>\n"
+    "                      add a special register at IO-offset, which reads\n"
+    "                      input for --fuzz, a read behind the end stops the run\n"
+    "   --fuzz-uart <pin>,<baudrate>\n"
+    "                      send input for --fuzz as serial data to <pin>\n"
+    "   --fuzz-stack <address>\n"
+    "                      crash, if stack pointer falls below <address>\n"
+    "   --fuzz-start <label> or <address>\n"
+    "                      run initialisation once till PC reaches <label> or\n"
+    "                      <address> and start every --fuzz run from there\n"
+    "   --uart-bridge <uart>,<bridge>\n"
+    "                      exchange whole bytes of UART <uart> (0, 1, ...) with a\n"
+    "                      host endpoint instead of simulating the pins, <bridge>\n"
+    "                      is 'pty', 'unix:<path>' or 'file:<infile>,<outfile>'\n"
+    "   --coverage <file>  record executed instructions and taken/not taken branches\n"
+    "                      and write them on exit as lcov tracefile to <file>, as\n"
+    "                      Cobertura XML, if <file> ends with .xml\n"
+    "   --stimulus <file>  drive pins and check outputs from a waveform, <file> is\n"
+    "                      a VCD file (*.vcd) or CSV with lines <time>,<pin>,<value>\n"
+    "   --record <file>,<pin>[,<pin>...]\n"
+    "                      write state changes of pins to <file> as checks for\n"
+    "                      --stimulus\n"
+    "   --block-tier       execute hot straight line code as whole blocks, only while\n"
+    "                      interrupts are disabled, not with gdb, tracers or\n"
+    "                      coverage\n"
+    "   --aot-emit <file>  write the program as C++ source to <file> and exit,\n"
+    "                      compile it with: c++ -O2 -shared -fPIC -o <module> <file>\n"
+    "   --aot-load <module>\n"
+    "                      execute translated blocks of <module> (from --aot-emit)\n"
+    "                      instead of interpreting them, same restrictions as for\n"
+    "                      --block-tier\n"
+    "   --fusion           execute frequent instruction idioms as one instruction,\n"
+    "                      only while interrupts are disabled, same restrictions as\n"
+    "                      for --block-tier\n"
+    "   --skip-delays      skip busy-wait delay loops (_delay_ms, _delay_us) like a\n"
+    "                      instruction with many cycles, peripherals get every\n"
+    "                      cycle on its own time, a interrupt sets the loop back to\n"
+    "                      the instruction, on which it's taken, same restrictions\n"
+    "                      as for --block-tier\n"
     "-v --verbose          output some hints to console\n"
     "-T --terminate <label> or <address>\n"
     "                      stops simulation if PC runs on <label> or <address>\n"
@@ -146,6 +314,19 @@ int main(int argc, char *argv[]) {
     int c;
     bool gdbserver_flag = 0;
     std::string coredumpfile("unknown");
+    std::string snapshotfile("unknown");
+    std::string restorefile("unknown");
+    std::vector<std::string> fuzzFiles;
+    unsigned long fuzzPipeOffset = 0;
+    std::string fuzzUartPin;
+    unsigned long fuzzUartBaud = 0;
+    unsigned long fuzzStackLimit = 0;
+    std::string fuzzStartSymbol;
+    std::vector<std::string> uartBridgeArgs;
+    std::vector<UartBridge *> uartBridges;
+    std::vector<std::string> stimulusFiles;
+    std::string recordArg;
+    Stimulus *stimulus = NULL;
     std::string filename("unknown");
     std::string devicename("unknown");
     std::string tracefilename("unknown");
@@ -172,6 +353,11 @@ int main(int argc, char *argv[]) {
     std::string tracer_avail_out;
 
     bool simulateEthernet = false;
+    bool blockTier = false;
+    std::string aotEmitFile;
+    std::string aotLoadFile;
+    bool skipDelays = false;
+    bool fusion = false;
     bool codeblocksSupport = false;
     wiz_ethernet * eth = 0;
     CbUI * cbui = 0;
@@ -200,6 +386,22 @@ int main(int argc, char *argv[]) {
             {"terminate", 1, 0, 'T'},
             {"breakpoint", 1, 0, 'B'},
             {"core-dump", 1, 0, 'C'},
+            {"snapshot", 1, 0, 'S'},
+            {"restore", 1, 0, 'r'},
+            {"fuzz", 1, 0, 'Z'},
+            {"fuzz-pipe", 1, 0, 'P'},
+            {"fuzz-uart", 1, 0, 'U'},
+            {"fuzz-stack", 1, 0, 'L'},
+            {"fuzz-start", 1, 0, 'H'},
+            {"coverage", 1, 0, 'O'},
+            {"uart-bridge", 1, 0, 'b'},
+            {"stimulus", 1, 0, 'I'},
+            {"record", 1, 0, 'Q'},
+            {"block-tier", 0, 0, 'J'},
+            {"aot-emit", 1, 0, 'A'},
+            {"aot-load", 1, 0, 'K'},
+            {"skip-delays", 0, 0, 'Y'},
+            {"fusion", 0, 0, 'N'},
             {"irqstatistic", 0, 0, 's'},
             {"help", 0, 0, 'h'},
             {"ethernet",0,0,'E'},
@@ -346,6 +548,82 @@ int main(int argc, char *argv[]) {
                 coredumpfile = optarg;
                 break;
 
+            case 'S':
+                snapshotfile = optarg;
+                break;
+
+            case 'r':
+                restorefile = optarg;
+                break;
+
+            case 'Z':
+                fuzzFiles.push_back(optarg);
+                break;
+
+            case 'P':
+                if(!StringToUnsignedLong(optarg, &fuzzPipeOffset, NULL, 16)) {
+                    std::cerr << "fuzz-pipe offset is not a number" << std::endl;
+                    exit(1);
+                }
+                break;
+
+            case 'U': {
+                const char *comma = strchr(optarg, ',');
+                if(comma == NULL || !StringToUnsignedLong(comma + 1, &fuzzUartBaud, NULL, 10)) {
+                    std::cerr << "fuzz-uart: argument has to be <pin>,<baudrate>" << std::endl;
+                    exit(1);
+                }
+                fuzzUartPin = std::string(optarg, comma - optarg);
+                break;
+            }
+
+            case 'L':
+                if(!StringToUnsignedLong(optarg, &fuzzStackLimit, NULL, 16)) {
+                    std::cerr << "fuzz-stack address is not a number" << std::endl;
+                    exit(1);
+                }
+                break;
+
+            case 'H':
+                fuzzStartSymbol = optarg;
+                break;
+
+            case 'O':
+                coverageFile = optarg;
+                break;
+
+            case 'b':
+                uartBridgeArgs.push_back(optarg);
+                break;
+
+            case 'I':
+                stimulusFiles.push_back(optarg);
+                break;
+
+            case 'Q':
+                recordArg = optarg;
+                break;
+
+            case 'J':
+                blockTier = true;
+                break;
+
+            case 'A':
+                aotEmitFile = optarg;
+                break;
+
+            case 'K':
+                aotLoadFile = optarg;
+                break;
+
+            case 'Y':
+                skipDelays = true;
+                break;
+
+            case 'N':
+                fusion = true;
+                break;
+
             case 'E':
                 simulateEthernet = true;
                 break;
@@ -400,6 +678,14 @@ std::cout << "Simulating ethernet controller" << std::endl;
         misonet.Add(dev1->GetPin("MISO"));
         ssnet.Add(dev1->GetPin("SS"));
         sclknet.Add(dev1->GetPin("SCLK"));
+
+        // exchange whole bytes with the SPI master, pins are only
+        // simulated bit by bit, if a tracer could record them
+        HWSpi *spi = dynamic_cast<HWSpi *>(dev1->FindScopeGroupByName("SPI"));
+        if (spi) {
+            eth->attachSpi(spi);
+            spi->SetPinLevel(tracer_opts.size() != 0);
+        }
     }
 
     if ((gdbserver_flag)&&(codeblocksSupport)) {
@@ -417,8 +703,8 @@ std::cout << "Simulating ethernet controller" << std::endl;
     /* handle DumpTrace option */
     SetDumpTraceArgs(tracer_opts, dev1);
 
-    if(!gdbserver_flag && filename == "unknown") {
-        std::cerr << "Specify either --file <executable> or --gdbserver (or --gdb-stdin)" << std::endl;
+    if(!gdbserver_flag && filename == "unknown" && restorefile == "unknown") {
+        std::cerr << "Specify either --file <executable>, --restore <snapshot> or --gdbserver (or --gdb-stdin)" << std::endl;
         exit(1);
     }
 
@@ -452,6 +738,14 @@ std::cout << "Simulating ethernet controller" << std::endl;
         dev1->Reset(); // reset after load data from file to activate fuses and lockbits
     }
 
+    if(aotEmitFile.size()) {
+        if(filename == "unknown")
+            avr_error("--aot-emit needs a program, use --file");
+        unsigned int count = AotModule::Emit(dev1, aotEmitFile);
+        avr_message("Wrote %u translated blocks to %s", count, aotEmitFile.c_str());
+        exit(0);
+    }
+
     //if we have a file we can check out for termination lines.
     std::vector<std::string>::iterator ii;
     for(ii = terminationArgs.begin(); ii != terminationArgs.end(); ii++) {
@@ -481,10 +775,45 @@ std::cout << "Simulating ethernet controller" << std::endl;
 
     dman->start(); // start dump session
 
+    StartUartBridges(dev1, uartBridgeArgs, uartBridges);
+
+    if(stimulusFiles.size() || recordArg.size()) {
+        stimulus = new Stimulus(dev1);
+        for(size_t i = 0; i < stimulusFiles.size(); i++)
+            stimulus->Load(stimulusFiles[i]);
+        if(recordArg.size()) {
+            std::vector<std::string> pins = split(recordArg, ",");
+            if(pins.size() < 2)
+                avr_error("--record: argument has to be <file>,<pin>[,<pin>...]");
+            std::string recordFile = pins[0];
+            pins.erase(pins.begin());
+            stimulus->Record(recordFile, pins);
+        }
+        SystemClock::Instance().Add(stimulus);
+    }
+
     long steps = 0;
     if(gdbserver_flag == 0) { // no gdb
         SystemClock::Instance().Add(dev1);
+        dev1->SetBlockTier(blockTier);
+        if(aotLoadFile.size())
+            dev1->LoadAotModule(aotLoadFile);
+        dev1->SetDelayLoopSkip(skipDelays);
+        dev1->SetFusion(fusion);
         if (eth) SystemClock::Instance().Add(eth);
+        if(restorefile != "unknown") {
+            avr_message("restore snapshot file ...");
+            RestoreSnapshot(dev1, restorefile);
+        }
+        if(coverageFile.size()) {
+            if(fuzzFiles.size())
+                avr_error("--coverage can't be used together with --fuzz");
+            StartCoverage(dev1, filename);
+        }
+        if(fuzzFiles.size())
+            exit(RunFuzzFiles(dev1, fuzzFiles, fuzzPipeOffset, fuzzUartPin,
+                              fuzzUartBaud, fuzzStackLimit, fuzzStartSymbol,
+                              maxRunTime));
         if(maxRunTime == 0) {
             steps = SystemClock::Instance().Endless();
             std::cout << "SystemClock::Endless stopped" << std::endl
@@ -498,6 +827,12 @@ std::cout << "Simulating ethernet controller" << std::endl;
     } else { // gdb should be activated
         avr_message("Waiting for gdb connection ...");
         GdbServer gdb1(dev1, global_gdbserver_port, global_gdb_debug, globalWaitForGdbConnection);
+        if(restorefile != "unknown") {
+            avr_message("restore snapshot file ...");
+            RestoreSnapshot(dev1, restorefile);
+        }
+        if(coverageFile.size())
+            StartCoverage(dev1, filename);
         SystemClock::Instance().Add(&gdb1);
         if (eth) SystemClock::Instance().Add(eth);
         if (cbui) SystemClock::Instance().Add(cbui);
@@ -516,12 +851,32 @@ std::cout << "Simulating ethernet controller" << std::endl;
         WriteCoreDump(coredumpfile, dev1);
     }
 
+    if(snapshotfile != "unknown") {
+        avr_message("write snapshot file ...");
+        SaveSnapshot(dev1, snapshotfile);
+    }
+
+    WriteCoverage();
+
+    int exitCode = 0;
+    if(stimulus != NULL) {
+        if(stimulus->GetChecks()) {
+            std::cout << "Stimulus: " << stimulus->GetChecks() << " checks, "
+                 << stimulus->GetErrors() << " errors" << std::endl;
+            if(stimulus->GetErrors())
+                exitCode = 1;
+        }
+        delete stimulus;
+    }
+
     // delete ui, device and ethernet
     delete ui;
     delete dev1;
+    for(size_t i = 0; i < uartBridges.size(); i++)
+        delete uartBridges[i];
     if (eth) delete eth;
     if (cbui) delete cbui;
 
-    return 0;
+    return exitCode;
 }
 
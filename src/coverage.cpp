@@ -0,0 +1,272 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2001, 2002 - 2012   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <time.h>
+
+#include "coverage.h"
+#include "flash.h"
+#include "avrreadelf.h"
+#include "avrerror.h"
+
+using namespace std;
+
+//! Coverage of one source line
+struct LineCoverage {
+    bool executed;                      //!< one of the instructions of this line was executed
+    vector<unsigned int> conditionals;  //!< conditional instructions of this line
+    LineCoverage(): executed(false) {}
+};
+
+typedef map<unsigned int, LineCoverage> FileCoverage;
+typedef map<string, FileCoverage> ProgramCoverage;
+
+CoverageRecorder::CoverageRecorder(AvrDevice *_core):
+    core(_core),
+    lastPc(0),
+    lastConditional(false)
+{
+    Analyze();
+    next = core->GetPCObserver();
+    core->SetPCObserver(this);
+}
+
+CoverageRecorder::~CoverageRecorder() {
+    if(core->GetPCObserver() == this)
+        core->SetPCObserver(next);
+}
+
+bool CoverageRecorder::IsTwoWordOpcode(unsigned int opcode) const {
+    return (opcode & 0xfe0e) == 0x940c ||  // JMP
+           (opcode & 0xfe0e) == 0x940e ||  // CALL
+           (opcode & 0xfe0f) == 0x9000 ||  // LDS
+           (opcode & 0xfe0f) == 0x9200;    // STS
+}
+
+void CoverageRecorder::Analyze(void) {
+    unsigned int words = core->Flash->GetSize() / 2;
+    flags.assign(words, 0);
+    takenPc.assign(words, 0);
+    lastConditional = false;
+
+    for(unsigned int pc = 0; pc < words; pc++) {
+        unsigned int opcode = core->Flash->GetOpcode(pc);
+        if((opcode & 0xf800) == 0xf000) {
+            // BRBS / BRBC: 7 bit signed offset
+            int k = (opcode >> 3) & 0x7f;
+            if(k & 0x40)
+                k -= 0x80;
+            flags[pc] = COV_CONDITIONAL;
+            takenPc[pc] = (pc + 1 + k + words) % words;
+        } else if((opcode & 0xfc00) == 0x1000 ||  // CPSE
+                  (opcode & 0xfc08) == 0xfc00 ||  // SBRC / SBRS
+                  (opcode & 0xfd00) == 0x9900) {  // SBIC / SBIS
+            flags[pc] = COV_CONDITIONAL;
+            unsigned int next = (pc + 1) % words;
+            takenPc[pc] = (next + (IsTwoWordOpcode(core->Flash->GetOpcode(next)) ? 2 : 1)) % words;
+        }
+    }
+}
+
+void CoverageRecorder::Clear(void) {
+    for(unsigned int pc = 0; pc < flags.size(); pc++)
+        flags[pc] &= COV_CONDITIONAL;
+    lastConditional = false;
+}
+
+void CoverageRecorder::OnExecute(unsigned int pc) {
+    if(next != NULL)
+        next->OnExecute(pc);
+    if(pc >= flags.size())
+        return; // core will stop with error
+    if(lastConditional) {
+        // a other PC comes from a interrupt, this is ignored
+        if(pc == takenPc[lastPc])
+            flags[lastPc] |= COV_TAKEN;
+        else if(pc == lastPc + 1)
+            flags[lastPc] |= COV_NOT_TAKEN;
+    }
+    unsigned char f = flags[pc];
+    flags[pc] = f | COV_EXECUTED;
+    lastConditional = (f & COV_CONDITIONAL) != 0;
+    lastPc = pc;
+}
+
+//! Maps recorded flags to source lines by line table from elf file
+static void CollectLines(const string &elfFile,
+                         const vector<unsigned char> &flags,
+                         ProgramCoverage &prog) {
+    ELFLineTable table;
+    if(elfFile.empty() || !ELFReadLineTable(elfFile.c_str(), table)) {
+        avr_warning("no line info found in '%s', coverage is empty", elfFile.c_str());
+        return;
+    }
+
+    for(size_t i = 0; i + 1 < table.rows.size(); i++) {
+        const ELFLineTable::Row &row = table.rows[i];
+        unsigned int end = table.rows[i + 1].address;
+        if(row.file < 0 || end <= row.address)
+            continue;
+        LineCoverage &lc = prog[table.files[row.file]][row.line];
+        for(unsigned int pc = row.address / 2; pc < end / 2 && pc < flags.size(); pc++) {
+            if(flags[pc] & CoverageRecorder::COV_EXECUTED)
+                lc.executed = true;
+            if(flags[pc] & CoverageRecorder::COV_CONDITIONAL)
+                lc.conditionals.push_back(pc);
+        }
+    }
+}
+
+void CoverageRecorder::WriteLcov(const string &filename, const string &elfFile) {
+    ProgramCoverage prog;
+    CollectLines(elfFile, flags, prog);
+
+    ofstream f(filename.c_str());
+    if(!f.is_open())
+        avr_error("can't open coverage file '%s' for writing", filename.c_str());
+
+    for(ProgramCoverage::iterator i = prog.begin(); i != prog.end(); i++) {
+        unsigned int lf = 0, lh = 0, brf = 0, brh = 0;
+        f << "TN:" << endl << "SF:" << i->first << endl;
+        for(FileCoverage::iterator l = i->second.begin(); l != i->second.end(); l++) {
+            const LineCoverage &lc = l->second;
+            f << "DA:" << l->first << "," << (lc.executed ? 1 : 0) << endl;
+            lf++;
+            if(lc.executed)
+                lh++;
+            for(size_t c = 0; c < lc.conditionals.size(); c++) {
+                unsigned char fl = flags[lc.conditionals[c]];
+                for(unsigned int b = 0; b < 2; b++) {
+                    bool hit = (fl & ((b == 0) ? COV_TAKEN : COV_NOT_TAKEN)) != 0;
+                    f << "BRDA:" << l->first << "," << c << "," << b << ",";
+                    if(fl & COV_EXECUTED)
+                        f << (hit ? 1 : 0) << endl;
+                    else
+                        f << "-" << endl;
+                    brf++;
+                    if(hit)
+                        brh++;
+                }
+            }
+        }
+        f << "BRF:" << brf << endl << "BRH:" << brh << endl
+          << "LF:" << lf << endl << "LH:" << lh << endl
+          << "end_of_record" << endl;
+    }
+}
+
+//! Replaces special characters for XML attributes
+static string XmlEscape(const string &s) {
+    string r;
+    for(size_t i = 0; i < s.size(); i++) {
+        switch(s[i]) {
+            case '&':  r += "&amp;"; break;
+            case '<':  r += "&lt;"; break;
+            case '>':  r += "&gt;"; break;
+            case '"':  r += "&quot;"; break;
+            default:   r += s[i];
+        }
+    }
+    return r;
+}
+
+//! Returns rate as string for Cobertura
+static string Rate(unsigned int hit, unsigned int total) {
+    ostringstream os;
+    os << ((total == 0) ? 1.0 : (double)hit / total);
+    return os.str();
+}
+
+void CoverageRecorder::WriteCobertura(const string &filename, const string &elfFile) {
+    ProgramCoverage prog;
+    CollectLines(elfFile, flags, prog);
+
+    ostringstream classes;
+    unsigned int linesValid = 0, linesCovered = 0, branchesValid = 0, branchesCovered = 0;
+    for(ProgramCoverage::iterator i = prog.begin(); i != prog.end(); i++) {
+        ostringstream lines;
+        unsigned int lf = 0, lh = 0, brf = 0, brh = 0;
+        for(FileCoverage::iterator l = i->second.begin(); l != i->second.end(); l++) {
+            const LineCoverage &lc = l->second;
+            lf++;
+            if(lc.executed)
+                lh++;
+            lines << "          <line number=\"" << l->first << "\" hits=\"" << (lc.executed ? 1 : 0) << "\"";
+            if(lc.conditionals.size()) {
+                unsigned int total = lc.conditionals.size() * 2, hit = 0;
+                for(size_t c = 0; c < lc.conditionals.size(); c++) {
+                    unsigned char fl = flags[lc.conditionals[c]];
+                    hit += ((fl & COV_TAKEN) ? 1 : 0) + ((fl & COV_NOT_TAKEN) ? 1 : 0);
+                }
+                lines << " branch=\"true\" condition-coverage=\"" << (hit * 100 / total)
+                      << "% (" << hit << "/" << total << ")\"";
+                brf += total;
+                brh += hit;
+            } else
+                lines << " branch=\"false\"";
+            lines << "/>" << endl;
+        }
+        classes << "        <class name=\"" << XmlEscape(i->first) << "\" filename=\"" << XmlEscape(i->first)
+                << "\" line-rate=\"" << Rate(lh, lf) << "\" branch-rate=\"" << Rate(brh, brf)
+                << "\" complexity=\"0\">" << endl
+                << "          <methods/>" << endl << "          <lines>" << endl
+                << lines.str()
+                << "          </lines>" << endl << "        </class>" << endl;
+        linesValid += lf;
+        linesCovered += lh;
+        branchesValid += brf;
+        branchesCovered += brh;
+    }
+
+    ofstream f(filename.c_str());
+    if(!f.is_open())
+        avr_error("can't open coverage file '%s' for writing", filename.c_str());
+    f << "<?xml version=\"1.0\" ?>" << endl
+      << "<!DOCTYPE coverage SYSTEM \"http://cobertura.sourceforge.net/xml/coverage-04.dtd\">" << endl
+      << "<coverage line-rate=\"" << Rate(linesCovered, linesValid)
+      << "\" branch-rate=\"" << Rate(branchesCovered, branchesValid)
+      << "\" lines-covered=\"" << linesCovered << "\" lines-valid=\"" << linesValid
+      << "\" branches-covered=\"" << branchesCovered << "\" branches-valid=\"" << branchesValid
+      << "\" complexity=\"0\" version=\"simulavr\" timestamp=\"" << (unsigned long)time(NULL) << "\">" << endl
+      << "  <sources>" << endl << "    <source>.</source>" << endl << "  </sources>" << endl
+      << "  <packages>" << endl
+      << "    <package name=\"" << XmlEscape(elfFile) << "\" line-rate=\"" << Rate(linesCovered, linesValid)
+      << "\" branch-rate=\"" << Rate(branchesCovered, branchesValid) << "\" complexity=\"0\">" << endl
+      << "      <classes>" << endl
+      << classes.str()
+      << "      </classes>" << endl << "    </package>" << endl
+      << "  </packages>" << endl << "</coverage>" << endl;
+}
+
+void CoverageRecorder::Write(const string &filename, const string &elfFile) {
+    if(filename.size() > 4 && filename.substr(filename.size() - 4) == ".xml")
+        WriteCobertura(filename, elfFile);
+    else
+        WriteLcov(filename, elfFile);
+}
+
+// EOF
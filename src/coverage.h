@@ -0,0 +1,87 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2001, 2002 - 2012   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#ifndef COVERAGE
+#define COVERAGE
+
+#include <string>
+#include <vector>
+
+#include "avrdevice.h"
+
+//! Records code coverage of the simulated program
+/*! For every flash word a flag is set, if the instruction on it was executed.
+  For conditional instructions (BRBS/BRBC and the skip instructions CPSE, SBRC,
+  SBRS, SBIC, SBIS) it's recorded additionally, if the branch / skip was taken
+  or not taken.
+
+  Coverage can be written as lcov tracefile or Cobertura XML, source lines
+  are taken from DWARF line table in elf file. Recording costs only a few
+  operations per instruction, so it can stay enabled for whole runs. A other
+  PC observer is kept and called before, like in PCTrigger. */
+class CoverageRecorder: public PCObserver {
+
+    public:
+        //! flags for every flash word
+        enum {
+            COV_EXECUTED = 1,    //!< instruction was executed
+            COV_TAKEN = 2,       //!< branch or skip was taken
+            COV_NOT_TAKEN = 4,   //!< branch or skip was not taken
+            COV_CONDITIONAL = 8  //!< instruction is a conditional branch or skip
+        };
+
+    protected:
+        AvrDevice *core;
+        PCObserver *next;                     //!< replaced observer or NULL
+        std::vector<unsigned char> flags;     //!< coverage flags for every flash word
+        std::vector<unsigned int> takenPc;    //!< PC after a taken branch or skip
+        unsigned int lastPc;                  //!< last executed conditional instruction
+        bool lastConditional;                 //!< last executed instruction was conditional
+
+        bool IsTwoWordOpcode(unsigned int opcode) const;
+
+    public:
+        //! Creates a recorder and attaches it to core, program has to be loaded before
+        CoverageRecorder(AvrDevice *core);
+        virtual ~CoverageRecorder();
+
+        //! Finds conditional instructions in flash, call it after loading a new program
+        void Analyze(void);
+        //! Clears all recorded coverage
+        void Clear(void);
+        //! Returns coverage flags for a flash word
+        unsigned char GetFlags(unsigned int pc) const { return (pc < flags.size()) ? flags[pc] : 0; }
+
+        //! Writes coverage as lcov tracefile, source lines are taken from elfFile
+        void WriteLcov(const std::string &filename, const std::string &elfFile);
+        //! Writes coverage as Cobertura XML, source lines are taken from elfFile
+        void WriteCobertura(const std::string &filename, const std::string &elfFile);
+        //! Writes Cobertura XML, if filename ends with ".xml", otherwise lcov
+        void Write(const std::string &filename, const std::string &elfFile);
+
+        void OnExecute(unsigned int pc);
+};
+
+#endif
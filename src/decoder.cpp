@@ -23,6 +23,8 @@
  *  $Id$
  */
 
+#include <algorithm>
+
 #include "decoder.h"
 #include "hwstack.h"
 #include "flash.h"
@@ -341,13 +343,13 @@ int avr_op_BST::operator()() {
 
 avr_op_CALL::avr_op_CALL(word opcode, AvrDevice *c):
     DecodedInstruction(c, true),
-    KH(get_k_22(opcode)) {}
+    KH(get_k_22(opcode)),
+    clkadd(c->flagXMega ? 1 : 2) {}
 
 int avr_op_CALL::operator()() 
 {
     word K_lsb = core->Flash->ReadMemWord((core->PC + 1) * 2);
     int k = (KH << 16) + K_lsb;
-    int clkadd = core->flagXMega ? 1 : 2;
     
     core->stack->m_ThreadList.OnCall();
     core->stack->PushAddr(core->PC + 2);
@@ -360,11 +362,10 @@ int avr_op_CALL::operator()()
 avr_op_CBI::avr_op_CBI(word opcode, AvrDevice *c):
     DecodedInstruction(c),
     ioreg(get_A_5(opcode)),
-    Kbit(get_reg_bit(opcode)) {}
+    Kbit(get_reg_bit(opcode)),
+    clks((c->flagXMega || c->flagTiny10) ? 1 : 2) {}
 
 int avr_op_CBI::operator()() {
-    int clks = (core->flagXMega || core->flagTiny10) ? 1 : 2;
-    
     core->SetIORegBit(ioreg, Kbit, false);
     
     return clks;
@@ -469,7 +470,7 @@ int avr_op_CPSE::operator()() {
     byte rr = core->GetCoreReg(R2);
     int clks;
 
-    if(core->Flash->DecodedMem[core->PC + 1]->IsInstruction2Words())
+    if(core->Flash->Decoded(core->PC + 1)->IsInstruction2Words())
         skip = 3;
     else
         skip = 2;
@@ -503,7 +504,8 @@ int avr_op_DEC::operator()() {
 }
 
 avr_op_EICALL::avr_op_EICALL(word opcode, AvrDevice *c):
-    DecodedInstruction(c) {}
+    DecodedInstruction(c),
+    clks(c->flagXMega ? 3 : 4) {}
 
 int avr_op_EICALL::operator()() {
     unsigned new_PC = core->GetRegZ() + (core->eind->GetRegVal() << 16);
@@ -514,7 +516,7 @@ int avr_op_EICALL::operator()() {
     core->DebugOnJump();
     core->PC = new_PC;
 
-    return core->flagXMega ? 3 : 4;
+    return clks;
 }
 
 avr_op_EIJMP::avr_op_EIJMP(word opcode, AvrDevice *c):
@@ -697,7 +699,8 @@ int avr_op_FMULSU::operator()() {
 }
 
 avr_op_ICALL::avr_op_ICALL(word opcode, AvrDevice *c):
-    DecodedInstruction(c) {}
+    DecodedInstruction(c),
+    clkadd(c->flagXMega ? 0 : 1) {}
 
 int avr_op_ICALL::operator()() {
     unsigned int pc = core->PC;
@@ -710,7 +713,7 @@ int avr_op_ICALL::operator()() {
     core->DebugOnJump();
     core->PC = new_pc - 1;
 
-    return core->PC_size + (core->flagXMega ? 0 : 1);
+    return core->PC_size + clkadd;
 }
 
 avr_op_IJMP::avr_op_IJMP(word opcode, AvrDevice *c):
@@ -769,7 +772,8 @@ int avr_op_JMP::operator()() {
 avr_op_LDD_Y::avr_op_LDD_Y(word opcode, AvrDevice *c):
     DecodedInstruction(c),
     Rd(get_rd_5(opcode)),
-    K(get_q(opcode)) {}
+    K(get_q(opcode)),
+    clks(((c->flagXMega || c->flagTiny10) && K == 0) ? 1 : 2) {}
 
 int avr_op_LDD_Y::operator()() {
     /* Y is R29:R28 */
@@ -777,13 +781,14 @@ int avr_op_LDD_Y::operator()() {
 
     core->SetCoreReg(Rd, core->GetRWMem(Y + K));
     
-    return ((core->flagXMega || core->flagTiny10) && K == 0) ? 1 : 2;
+    return clks;
 }
 
 avr_op_LDD_Z::avr_op_LDD_Z(word opcode, AvrDevice *c):
     DecodedInstruction(c),
     Rd(get_rd_5(opcode)),
-    K(get_q(opcode)) {}
+    K(get_q(opcode)),
+    clks(((c->flagXMega || c->flagTiny10) && K == 0) ? 1 : 2) {}
 
 int avr_op_LDD_Z::operator()() {
     /* Z is R31:R30 */
@@ -791,7 +796,7 @@ int avr_op_LDD_Z::operator()() {
 
     core->SetCoreReg(Rd, core->GetRWMem(Z + K));
 
-    return ((core->flagXMega || core->flagTiny10) && K == 0) ? 1 : 2;
+    return clks;
 }
 
 avr_op_LDI::avr_op_LDI(word opcode, AvrDevice *c):
@@ -824,7 +829,8 @@ int avr_op_LDS::operator()() {
 
 avr_op_LD_X::avr_op_LD_X(word opcode, AvrDevice *c):
     DecodedInstruction(c),
-    Rd(get_rd_5(opcode)) {}
+    Rd(get_rd_5(opcode)),
+    clks((c->flagXMega || c->flagTiny10) ? 1 : 2) {}
 
 int avr_op_LD_X::operator()() {
     /* X is R27:R26 */
@@ -832,12 +838,13 @@ int avr_op_LD_X::operator()() {
 
     core->SetCoreReg(Rd, core->GetRWMem(X));
     
-    return (core->flagXMega || core->flagTiny10) ? 1 : 2;
+    return clks;
 }
 
 avr_op_LD_X_decr::avr_op_LD_X_decr(word opcode, AvrDevice *c):
     DecodedInstruction(c),
-    Rd(get_rd_5(opcode)) {}
+    Rd(get_rd_5(opcode)),
+    clks(c->flagTiny10 ? 3 : 2) {}
 
 int avr_op_LD_X_decr::operator()() {
     /* X is R27:R26 */
@@ -851,12 +858,13 @@ int avr_op_LD_X_decr::operator()() {
     core->SetCoreReg(26, X & 0xff);
     core->SetCoreReg(27, (X >> 8) & 0xff);
 
-    return core->flagTiny10 ? 3 : 2;
+    return clks;
 }
 
 avr_op_LD_X_incr::avr_op_LD_X_incr(word opcode, AvrDevice *c):
     DecodedInstruction(c),
-    Rd(get_rd_5(opcode)) {}
+    Rd(get_rd_5(opcode)),
+    clks(c->flagXMega ? 1 : 2) {}
 
 int avr_op_LD_X_incr::operator()() {
     /* X is R27:R26 */
@@ -870,12 +878,13 @@ int avr_op_LD_X_incr::operator()() {
     core->SetCoreReg(26, X & 0xff);
     core->SetCoreReg(27, (X >> 8) & 0xff);
 
-    return core->flagXMega ? 1 : 2;
+    return clks;
 }
 
 avr_op_LD_Y_decr::avr_op_LD_Y_decr(word opcode, AvrDevice *c):
     DecodedInstruction(c),
-    Rd(get_rd_5(opcode)) {}
+    Rd(get_rd_5(opcode)),
+    clks(c->flagTiny10 ? 3 : 2) {}
 
 int avr_op_LD_Y_decr::operator()() {
     /* Y is R29:R28 */
@@ -889,12 +898,13 @@ int avr_op_LD_Y_decr::operator()() {
     core->SetCoreReg(28, Y & 0xff);
     core->SetCoreReg(29, (Y >> 8) & 0xff);
 
-    return core->flagTiny10 ? 3 : 2;
+    return clks;
 }
 
 avr_op_LD_Y_incr::avr_op_LD_Y_incr(word opcode, AvrDevice *c):
     DecodedInstruction(c),
-    Rd(get_rd_5(opcode)) {}
+    Rd(get_rd_5(opcode)),
+    clks(c->flagXMega ? 1 : 2) {}
 
 int avr_op_LD_Y_incr::operator()() {
     /* Y is R29:R28 */
@@ -908,12 +918,13 @@ int avr_op_LD_Y_incr::operator()() {
     core->SetCoreReg(28, Y & 0xff);
     core->SetCoreReg(29, (Y >> 8) & 0xff);
 
-    return core->flagXMega ? 1 : 2;
+    return clks;
 }
 
 avr_op_LD_Z_incr::avr_op_LD_Z_incr(word opcode, AvrDevice *c):
     DecodedInstruction(c),
-    Rd(get_rd_5(opcode)) {}
+    Rd(get_rd_5(opcode)),
+    clks(c->flagXMega ? 1 : 2) {}
 
 int avr_op_LD_Z_incr::operator()() {
     /* Z is R31:R30 */
@@ -927,12 +938,13 @@ int avr_op_LD_Z_incr::operator()() {
     core->SetCoreReg(30, Z & 0xff);
     core->SetCoreReg(31, (Z >> 8) & 0xff);
 
-    return core->flagXMega ? 1 : 2;
+    return clks;
 }
 
 avr_op_LD_Z_decr::avr_op_LD_Z_decr(word opcode, AvrDevice *c):
     DecodedInstruction(c),
-    Rd(get_rd_5(opcode)) {}
+    Rd(get_rd_5(opcode)),
+    clks(c->flagTiny10 ? 3 : 2) {}
 
 int avr_op_LD_Z_decr::operator()() {
     /* Z is R31:R30 */
@@ -946,7 +958,7 @@ int avr_op_LD_Z_decr::operator()() {
     core->SetCoreReg(30, Z & 0xff);
     core->SetCoreReg(31, (Z >> 8) & 0xff);
 
-    return core->flagTiny10 ? 3 : 2;
+    return clks;
 }
 
 avr_op_LPM_Z::avr_op_LPM_Z(word opcode, AvrDevice *c):
@@ -1192,17 +1204,19 @@ int avr_op_POP::operator()() {
 
 avr_op_PUSH::avr_op_PUSH(word opcode, AvrDevice *c):
     DecodedInstruction(c),
-    R1(get_rd_5(opcode)) {}
+    R1(get_rd_5(opcode)),
+    clks(c->flagXMega ? 1 : 2) {}
 
 int avr_op_PUSH::operator()() {
     core->stack->Push(core->GetCoreReg(R1));
 
-    return core->flagXMega ? 1 : 2;
+    return clks;
 }
 
 avr_op_RCALL::avr_op_RCALL(word opcode, AvrDevice *c):
     DecodedInstruction(c),
-    K(n_bit_unsigned_to_signed(get_k_12(opcode), 12)) {}
+    K(n_bit_unsigned_to_signed(get_k_12(opcode), 12)),
+    clkadd(c->flagTiny10 ? 2 : (c->flagXMega ? 0 : 1)) {}
 
 int avr_op_RCALL::operator()() {
     core->stack->PushAddr(core->PC + 1);
@@ -1211,10 +1225,7 @@ int avr_op_RCALL::operator()() {
     core->PC += K;
     core->PC &= (core->Flash->GetSize() - 1) >> 1;
 
-    if(core->flagTiny10)
-        return 4;
-    return core->PC_size + (core->flagXMega ? 0 : 1);
-    
+    return core->PC_size + clkadd;
 }
 
 avr_op_RET::avr_op_RET(word opcode, AvrDevice *c):
@@ -1331,11 +1342,10 @@ int avr_op_SBCI::operator()() {
 avr_op_SBI::avr_op_SBI(word opcode, AvrDevice *c):
     DecodedInstruction(c),
     ioreg(get_A_5(opcode)),
-    Kbit(get_reg_bit(opcode)) {}
+    Kbit(get_reg_bit(opcode)),
+    clks((c->flagXMega || c->flagTiny10) ? 1 : 2) {}
 
 int avr_op_SBI::operator()() {
-    int clks = (core->flagXMega || core->flagTiny10) ? 1 : 2;
-    
     core->SetIORegBit(ioreg, Kbit, true);
     
     return clks;
@@ -1344,12 +1354,13 @@ int avr_op_SBI::operator()() {
 avr_op_SBIC::avr_op_SBIC(word opcode, AvrDevice *c):
     DecodedInstruction(c),
     ioreg(get_A_5(opcode)),
-    Kbit(get_reg_bit(opcode)) {}
+    Kbit(get_reg_bit(opcode)),
+    clkadd(c->flagXMega ? 1 : 0) {}
 
 int avr_op_SBIC::operator()() {
     int skip, clks;
 
-    if(core->Flash->DecodedMem[core->PC + 1]->IsInstruction2Words())
+    if(core->Flash->Decoded(core->PC + 1)->IsInstruction2Words())
         skip = 3;
     else
         skip = 2;
@@ -1361,21 +1372,19 @@ int avr_op_SBIC::operator()() {
     } else
         clks = 1;
 
-    if(core->flagXMega)
-        clks++;
-    
-    return clks;
+    return clks + clkadd;
 }
 
 avr_op_SBIS::avr_op_SBIS(word opcode, AvrDevice *c):
     DecodedInstruction(c),
     ioreg(get_A_5(opcode)),
-    Kbit(get_reg_bit(opcode)) {}
+    Kbit(get_reg_bit(opcode)),
+    clkadd(c->flagXMega ? 1 : 0) {}
 
 int avr_op_SBIS::operator()() {
     int skip, clks;
 
-    if(core->Flash->DecodedMem[core->PC + 1]->IsInstruction2Words())
+    if(core->Flash->Decoded(core->PC + 1)->IsInstruction2Words())
         skip = 3;
     else
         skip = 2;
@@ -1387,10 +1396,7 @@ int avr_op_SBIS::operator()() {
     } else
         clks = 1;
 
-    if(core->flagXMega)
-        clks++;
-    
-    return clks;
+    return clks + clkadd;
 }
 
 
@@ -1433,7 +1439,7 @@ avr_op_SBRC::avr_op_SBRC(word opcode, AvrDevice *c):
 int avr_op_SBRC::operator()() {
     int skip, clks;
 
-    if(core->Flash->DecodedMem[core->PC + 1]->IsInstruction2Words())
+    if(core->Flash->Decoded(core->PC + 1)->IsInstruction2Words())
         skip = 3;
     else
         skip = 2;
@@ -1456,7 +1462,7 @@ avr_op_SBRS::avr_op_SBRS(word opcode, AvrDevice *c):
 int avr_op_SBRS::operator()() {
     int skip, clks;
 
-    if(core->Flash->DecodedMem[core->PC + 1]->IsInstruction2Words())
+    if(core->Flash->Decoded(core->PC + 1)->IsInstruction2Words())
         skip = 3;
     else
         skip = 2;
@@ -1518,7 +1524,8 @@ int avr_op_SPM::operator()() {
 avr_op_STD_Y::avr_op_STD_Y(word opcode, AvrDevice *c):
     DecodedInstruction(c),
     R1(get_rd_5(opcode)),
-    K(get_q(opcode)) {}
+    K(get_q(opcode)),
+    clks((K == 0 && (c->flagXMega || c->flagTiny10)) ? 1 : 2) {}
 
 int avr_op_STD_Y::operator()() {
     /* Y is R29:R28 */
@@ -1526,13 +1533,14 @@ int avr_op_STD_Y::operator()() {
 
     core->SetRWMem(Y + K, core->GetCoreReg(R1));
 
-    return (K == 0 && (core->flagXMega || core->flagTiny10)) ? 1 : 2;
+    return clks;
 }
 
 avr_op_STD_Z::avr_op_STD_Z(word opcode, AvrDevice *c):
     DecodedInstruction(c),
     R1(get_rd_5(opcode)),
-    K(get_q(opcode)) {}
+    K(get_q(opcode)),
+    clks((K == 0 && (c->flagXMega || c->flagTiny10)) ? 1 : 2) {}
 
 int avr_op_STD_Z::operator()() {
     /* Z is R31:R30 */
@@ -1540,7 +1548,7 @@ int avr_op_STD_Z::operator()() {
 
     core->SetRWMem(Z + K, core->GetCoreReg(R1));
 
-    return (K == 0 && (core->flagXMega || core->flagTiny10)) ? 1 : 2;
+    return clks;
 }
 
 avr_op_STS::avr_op_STS(word opcode, AvrDevice *c):
@@ -1559,7 +1567,8 @@ int avr_op_STS::operator()() {
 
 avr_op_ST_X::avr_op_ST_X(word opcode, AvrDevice *c):
     DecodedInstruction(c),
-    R1(get_rd_5(opcode)) {}
+    R1(get_rd_5(opcode)),
+    clks((c->flagXMega || c->flagTiny10) ? 1 : 2) {}
 
 int avr_op_ST_X::operator()() {
     /* X is R27:R26 */
@@ -1567,7 +1576,7 @@ int avr_op_ST_X::operator()() {
     
     core->SetRWMem(X, core->GetCoreReg(R1));
 
-    return (core->flagXMega || core->flagTiny10) ? 1 : 2;
+    return clks;
 }
 
 avr_op_ST_X_decr::avr_op_ST_X_decr(word opcode, AvrDevice *c):
@@ -1591,7 +1600,8 @@ int avr_op_ST_X_decr::operator()() {
 
 avr_op_ST_X_incr::avr_op_ST_X_incr(word opcode, AvrDevice *c):
     DecodedInstruction(c),
-    R1(get_rd_5(opcode)) {}
+    R1(get_rd_5(opcode)),
+    clks((c->flagXMega || c->flagTiny10) ? 1 : 2) {}
 
 int avr_op_ST_X_incr::operator()() {
     /* X is R27:R26 */
@@ -1606,7 +1616,7 @@ int avr_op_ST_X_incr::operator()() {
     core->SetCoreReg(26, X & 0xff);
     core->SetCoreReg(27, (X >> 8) & 0xff);
 
-    return (core->flagXMega || core->flagTiny10) ? 1 : 2;
+    return clks;
 }
 
 avr_op_ST_Y_decr::avr_op_ST_Y_decr(word opcode, AvrDevice *c):
@@ -1630,7 +1640,8 @@ int avr_op_ST_Y_decr::operator()() {
 
 avr_op_ST_Y_incr::avr_op_ST_Y_incr(word opcode, AvrDevice *c):
     DecodedInstruction(c),
-    R1(get_rd_5(opcode)) {}
+    R1(get_rd_5(opcode)),
+    clks((c->flagXMega || c->flagTiny10) ? 1 : 2) {}
 
 int avr_op_ST_Y_incr::operator()() {
     /* Y is R29:R28 */
@@ -1645,7 +1656,7 @@ int avr_op_ST_Y_incr::operator()() {
     core->SetCoreReg(28, Y & 0xff);
     core->SetCoreReg(29, (Y >> 8) & 0xff);
 
-    return (core->flagXMega || core->flagTiny10) ? 1 : 2;
+    return clks;
 }
 
 avr_op_ST_Z_decr::avr_op_ST_Z_decr(word opcode, AvrDevice *c):
@@ -1669,7 +1680,8 @@ int avr_op_ST_Z_decr::operator()() {
 
 avr_op_ST_Z_incr::avr_op_ST_Z_incr(word opcode, AvrDevice *c):
     DecodedInstruction(c),
-    R1(get_rd_5(opcode)) {}
+    R1(get_rd_5(opcode)),
+    clks((c->flagXMega || c->flagTiny10) ? 1 : 2) {}
 
 int avr_op_ST_Z_incr::operator()() {
     /* Z is R31:R30 */
@@ -1684,7 +1696,7 @@ int avr_op_ST_Z_incr::operator()() {
     core->SetCoreReg(30, Z & 0xff);
     core->SetCoreReg(31, (Z >> 8) & 0xff);
 
-    return (core->flagXMega || core->flagTiny10) ? 1 : 2;
+    return clks;
 }
 
 avr_op_SUB::avr_op_SUB(word opcode, AvrDevice *c):
@@ -1778,6 +1790,38 @@ int avr_op_ILLEGAL::operator()() {
     return 0;
 }
 
+avr_op_FUSED::avr_op_FUSED(AvrDevice *c, DecodedInstruction **p, unsigned int n, int ld, int st):
+    DecodedInstruction(c),
+    count(n),
+    ldPtr(ld),
+    stPtr(st) {
+    for(unsigned int i = 0; i < n; i++)
+        parts[i] = p[i];
+}
+
+bool avr_op_FUSED::PointsToRam(int ptr) {
+    unsigned int addr = core->GetCoreReg(ptr) + (core->GetCoreReg(ptr + 1) << 8);
+    return addr >= core->GetMemRegisterSize() + core->GetMemIOSize();
+}
+
+int avr_op_FUSED::operator()() {
+    /* registers and IO have to be accessed on the right cycle, the core
+     * executes the instructions one by one then */
+    if((ldPtr >= 0 && !PointsToRam(ldPtr)) || (stPtr >= 0 && !PointsToRam(stPtr)))
+        return (*parts[0])();
+
+    int clks = (*parts[0])();
+    for(unsigned int i = 1; i < count; i++) {
+        word next = core->PC + 1;
+        if(core->BP.end() != std::find(core->BP.begin(), core->BP.end(), next) ||
+           core->EP.end() != std::find(core->EP.begin(), core->EP.end(), next))
+            break;
+        core->PC = next;
+        clks += (*parts[i])();
+    }
+    return clks;
+}
+
 static int get_add_carry( byte res, byte rd, byte rr, int b )
 {
     byte resb = res >> b & 0x1;
@@ -1946,7 +1990,102 @@ static int get_A_6( word opcode )
 
 
 
-DecodedInstruction* lookup_opcode( word opcode, AvrDevice *core )
+// all instructions, which lookup_opcode constructs in a slot
+DECODED_SLOT_CHECK(avr_op_ADC);
+DECODED_SLOT_CHECK(avr_op_ADD);
+DECODED_SLOT_CHECK(avr_op_ADIW);
+DECODED_SLOT_CHECK(avr_op_AND);
+DECODED_SLOT_CHECK(avr_op_ANDI);
+DECODED_SLOT_CHECK(avr_op_ASR);
+DECODED_SLOT_CHECK(avr_op_BCLR);
+DECODED_SLOT_CHECK(avr_op_BLD);
+DECODED_SLOT_CHECK(avr_op_BRBC);
+DECODED_SLOT_CHECK(avr_op_BRBS);
+DECODED_SLOT_CHECK(avr_op_BSET);
+DECODED_SLOT_CHECK(avr_op_BST);
+DECODED_SLOT_CHECK(avr_op_CALL);
+DECODED_SLOT_CHECK(avr_op_CBI);
+DECODED_SLOT_CHECK(avr_op_COM);
+DECODED_SLOT_CHECK(avr_op_CP);
+DECODED_SLOT_CHECK(avr_op_CPC);
+DECODED_SLOT_CHECK(avr_op_CPI);
+DECODED_SLOT_CHECK(avr_op_CPSE);
+DECODED_SLOT_CHECK(avr_op_DEC);
+DECODED_SLOT_CHECK(avr_op_EICALL);
+DECODED_SLOT_CHECK(avr_op_EIJMP);
+DECODED_SLOT_CHECK(avr_op_ELPM_Z);
+DECODED_SLOT_CHECK(avr_op_ELPM_Z_incr);
+DECODED_SLOT_CHECK(avr_op_ELPM);
+DECODED_SLOT_CHECK(avr_op_EOR);
+DECODED_SLOT_CHECK(avr_op_ESPM);
+DECODED_SLOT_CHECK(avr_op_FMUL);
+DECODED_SLOT_CHECK(avr_op_FMULS);
+DECODED_SLOT_CHECK(avr_op_FMULSU);
+DECODED_SLOT_CHECK(avr_op_ICALL);
+DECODED_SLOT_CHECK(avr_op_IJMP);
+DECODED_SLOT_CHECK(avr_op_IN);
+DECODED_SLOT_CHECK(avr_op_INC);
+DECODED_SLOT_CHECK(avr_op_JMP);
+DECODED_SLOT_CHECK(avr_op_LDD_Y);
+DECODED_SLOT_CHECK(avr_op_LDD_Z);
+DECODED_SLOT_CHECK(avr_op_LDI);
+DECODED_SLOT_CHECK(avr_op_LDS);
+DECODED_SLOT_CHECK(avr_op_LD_X);
+DECODED_SLOT_CHECK(avr_op_LD_X_decr);
+DECODED_SLOT_CHECK(avr_op_LD_X_incr);
+DECODED_SLOT_CHECK(avr_op_LD_Y_decr);
+DECODED_SLOT_CHECK(avr_op_LD_Y_incr);
+DECODED_SLOT_CHECK(avr_op_LD_Z_incr);
+DECODED_SLOT_CHECK(avr_op_LD_Z_decr);
+DECODED_SLOT_CHECK(avr_op_LPM_Z);
+DECODED_SLOT_CHECK(avr_op_LPM);
+DECODED_SLOT_CHECK(avr_op_LPM_Z_incr);
+DECODED_SLOT_CHECK(avr_op_LSR);
+DECODED_SLOT_CHECK(avr_op_MOV);
+DECODED_SLOT_CHECK(avr_op_MOVW);
+DECODED_SLOT_CHECK(avr_op_MUL);
+DECODED_SLOT_CHECK(avr_op_MULS);
+DECODED_SLOT_CHECK(avr_op_MULSU);
+DECODED_SLOT_CHECK(avr_op_NEG);
+DECODED_SLOT_CHECK(avr_op_NOP);
+DECODED_SLOT_CHECK(avr_op_OR);
+DECODED_SLOT_CHECK(avr_op_ORI);
+DECODED_SLOT_CHECK(avr_op_OUT);
+DECODED_SLOT_CHECK(avr_op_POP);
+DECODED_SLOT_CHECK(avr_op_PUSH);
+DECODED_SLOT_CHECK(avr_op_RCALL);
+DECODED_SLOT_CHECK(avr_op_RET);
+DECODED_SLOT_CHECK(avr_op_RETI);
+DECODED_SLOT_CHECK(avr_op_RJMP);
+DECODED_SLOT_CHECK(avr_op_ROR);
+DECODED_SLOT_CHECK(avr_op_SBC);
+DECODED_SLOT_CHECK(avr_op_SBCI);
+DECODED_SLOT_CHECK(avr_op_SBI);
+DECODED_SLOT_CHECK(avr_op_SBIC);
+DECODED_SLOT_CHECK(avr_op_SBIS);
+DECODED_SLOT_CHECK(avr_op_SBIW);
+DECODED_SLOT_CHECK(avr_op_SBRC);
+DECODED_SLOT_CHECK(avr_op_SBRS);
+DECODED_SLOT_CHECK(avr_op_SLEEP);
+DECODED_SLOT_CHECK(avr_op_SPM);
+DECODED_SLOT_CHECK(avr_op_STD_Y);
+DECODED_SLOT_CHECK(avr_op_STD_Z);
+DECODED_SLOT_CHECK(avr_op_STS);
+DECODED_SLOT_CHECK(avr_op_ST_X);
+DECODED_SLOT_CHECK(avr_op_ST_X_decr);
+DECODED_SLOT_CHECK(avr_op_ST_X_incr);
+DECODED_SLOT_CHECK(avr_op_ST_Y_decr);
+DECODED_SLOT_CHECK(avr_op_ST_Y_incr);
+DECODED_SLOT_CHECK(avr_op_ST_Z_decr);
+DECODED_SLOT_CHECK(avr_op_ST_Z_incr);
+DECODED_SLOT_CHECK(avr_op_SUB);
+DECODED_SLOT_CHECK(avr_op_SUBI);
+DECODED_SLOT_CHECK(avr_op_SWAP);
+DECODED_SLOT_CHECK(avr_op_WDR);
+DECODED_SLOT_CHECK(avr_op_BREAK);
+DECODED_SLOT_CHECK(avr_op_ILLEGAL);
+
+DecodedInstruction* lookup_opcode( word opcode, AvrDevice *core, void *slot )
 {
     int decode;
 
@@ -1954,234 +2093,234 @@ DecodedInstruction* lookup_opcode( word opcode, AvrDevice *core )
         /* opcodes with no operands */
         case 0x9519:
             if(core->flagEIJMPInstructions)
-                return new avr_op_EICALL(opcode, core);                    /* 1001 0101 0001 1001 | EICALL */
+                return new(slot) avr_op_EICALL(opcode, core);              /* 1001 0101 0001 1001 | EICALL */
             else
-                return new avr_op_ILLEGAL(opcode, core);
+                return new(slot) avr_op_ILLEGAL(opcode, core);
         case 0x9419:
             if(core->flagEIJMPInstructions)
-                return new avr_op_EIJMP(opcode, core);                     /* 1001 0100 0001 1001 | EIJMP */
+                return new(slot) avr_op_EIJMP(opcode, core);               /* 1001 0100 0001 1001 | EIJMP */
             else
-                return new avr_op_ILLEGAL(opcode, core);
+                return new(slot) avr_op_ILLEGAL(opcode, core);
         case 0x95D8:
             if(core->flagELPMInstructions)
-                return new avr_op_ELPM(opcode, core);                      /* 1001 0101 1101 1000 | ELPM */
+                return new(slot) avr_op_ELPM(opcode, core);                /* 1001 0101 1101 1000 | ELPM */
             else
-                return new avr_op_ILLEGAL(opcode, core);
+                return new(slot) avr_op_ILLEGAL(opcode, core);
         case 0x95F8:
             if(core->flagLPMInstructions)
-                return new avr_op_ESPM(opcode, core);                      /* 1001 0101 1111 1000 | ESPM */
+                return new(slot) avr_op_ESPM(opcode, core);                /* 1001 0101 1111 1000 | ESPM */
             else
-                return new avr_op_ILLEGAL(opcode, core);
+                return new(slot) avr_op_ILLEGAL(opcode, core);
         case 0x9509:
             if(core->flagIJMPInstructions)
-                return new avr_op_ICALL(opcode, core);                     /* 1001 0101 0000 1001 | ICALL */
+                return new(slot) avr_op_ICALL(opcode, core);               /* 1001 0101 0000 1001 | ICALL */
             else
-                return new avr_op_ILLEGAL(opcode, core);
+                return new(slot) avr_op_ILLEGAL(opcode, core);
         case 0x9409:
             if(core->flagIJMPInstructions)
-                return new avr_op_IJMP(opcode, core);                      /* 1001 0100 0000 1001 | IJMP */
+                return new(slot) avr_op_IJMP(opcode, core);                /* 1001 0100 0000 1001 | IJMP */
             else
-                return new avr_op_ILLEGAL(opcode, core);
+                return new(slot) avr_op_ILLEGAL(opcode, core);
         case 0x95C8:
             if(!core->flagTiny10)
                 /* except tiny10, all devices provide LPM instruction! */
-                return new avr_op_LPM(opcode, core);                       /* 1001 0101 1100 1000 | LPM */
+                return new(slot) avr_op_LPM(opcode, core);                 /* 1001 0101 1100 1000 | LPM */
             else
-                return new avr_op_ILLEGAL(opcode, core);
-        case 0x0000: return new  avr_op_NOP(opcode, core);                 /* 0000 0000 0000 0000 | NOP */
-        case 0x9508: return new  avr_op_RET(opcode, core);                 /* 1001 0101 0000 1000 | RET */
-        case 0x9518: return new  avr_op_RETI(opcode, core);                /* 1001 0101 0001 1000 | RETI */
-        case 0x9588: return new  avr_op_SLEEP(opcode, core);               /* 1001 0101 1000 1000 | SLEEP */
+                return new(slot) avr_op_ILLEGAL(opcode, core);
+        case 0x0000: return new(slot) avr_op_NOP(opcode, core);            /* 0000 0000 0000 0000 | NOP */
+        case 0x9508: return new(slot) avr_op_RET(opcode, core);            /* 1001 0101 0000 1000 | RET */
+        case 0x9518: return new(slot) avr_op_RETI(opcode, core);           /* 1001 0101 0001 1000 | RETI */
+        case 0x9588: return new(slot) avr_op_SLEEP(opcode, core);          /* 1001 0101 1000 1000 | SLEEP */
         case 0x95E8:
             if(core->flagLPMInstructions)
-                return new avr_op_SPM(opcode, core);                       /* 1001 0101 1110 1000 | SPM */
+                return new(slot) avr_op_SPM(opcode, core);                 /* 1001 0101 1110 1000 | SPM */
             else
-                return new avr_op_ILLEGAL(opcode, core);
-        case 0x95A8: return new  avr_op_WDR(opcode, core);                 /* 1001 0101 1010 1000 | WDR */
-        case 0x9598: return new  avr_op_BREAK(opcode, core);               /* 1001 0101 1001 1000 | BREAK */
+                return new(slot) avr_op_ILLEGAL(opcode, core);
+        case 0x95A8: return new(slot) avr_op_WDR(opcode, core);            /* 1001 0101 1010 1000 | WDR */
+        case 0x9598: return new(slot) avr_op_BREAK(opcode, core);          /* 1001 0101 1001 1000 | BREAK */
         default:
                      {
                          /* opcodes with two 5-bit register (Rd and Rr) operands */
                          decode = opcode & ~(mask_Rd_5 | mask_Rr_5);
                          switch ( decode ) {
-                             case 0x1C00: return new  avr_op_ADC(opcode, core);         /* 0001 11rd dddd rrrr | ADC or ROL */
-                             case 0x0C00: return new  avr_op_ADD(opcode, core);         /* 0000 11rd dddd rrrr | ADD or LSL */
-                             case 0x2000: return new  avr_op_AND(opcode, core);         /* 0010 00rd dddd rrrr | AND or TST */
-                             case 0x1400: return new  avr_op_CP(opcode, core);          /* 0001 01rd dddd rrrr | CP */
-                             case 0x0400: return new  avr_op_CPC(opcode, core);         /* 0000 01rd dddd rrrr | CPC */
-                             case 0x1000: return new  avr_op_CPSE(opcode, core);        /* 0001 00rd dddd rrrr | CPSE */
-                             case 0x2400: return new  avr_op_EOR(opcode, core);         /* 0010 01rd dddd rrrr | EOR or CLR */
-                             case 0x2C00: return new  avr_op_MOV(opcode, core);         /* 0010 11rd dddd rrrr | MOV */
+                             case 0x1C00: return new(slot) avr_op_ADC(opcode, core);    /* 0001 11rd dddd rrrr | ADC or ROL */
+                             case 0x0C00: return new(slot) avr_op_ADD(opcode, core);    /* 0000 11rd dddd rrrr | ADD or LSL */
+                             case 0x2000: return new(slot) avr_op_AND(opcode, core);    /* 0010 00rd dddd rrrr | AND or TST */
+                             case 0x1400: return new(slot) avr_op_CP(opcode, core);     /* 0001 01rd dddd rrrr | CP */
+                             case 0x0400: return new(slot) avr_op_CPC(opcode, core);    /* 0000 01rd dddd rrrr | CPC */
+                             case 0x1000: return new(slot) avr_op_CPSE(opcode, core);   /* 0001 00rd dddd rrrr | CPSE */
+                             case 0x2400: return new(slot) avr_op_EOR(opcode, core);    /* 0010 01rd dddd rrrr | EOR or CLR */
+                             case 0x2C00: return new(slot) avr_op_MOV(opcode, core);    /* 0010 11rd dddd rrrr | MOV */
                              case 0x9C00:
                                  if(core->flagMULInstructions)
-                                     return new avr_op_MUL(opcode, core);               /* 1001 11rd dddd rrrr | MUL */
+                                     return new(slot) avr_op_MUL(opcode, core);         /* 1001 11rd dddd rrrr | MUL */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
-                             case 0x2800: return new  avr_op_OR(opcode, core);          /* 0010 10rd dddd rrrr | OR */
-                             case 0x0800: return new  avr_op_SBC(opcode, core);         /* 0000 10rd dddd rrrr | SBC */
-                             case 0x1800: return new  avr_op_SUB(opcode, core);         /* 0001 10rd dddd rrrr | SUB */
+                                     return new(slot) avr_op_ILLEGAL(opcode, core);
+                             case 0x2800: return new(slot) avr_op_OR(opcode, core);     /* 0010 10rd dddd rrrr | OR */
+                             case 0x0800: return new(slot) avr_op_SBC(opcode, core);    /* 0000 10rd dddd rrrr | SBC */
+                             case 0x1800: return new(slot) avr_op_SUB(opcode, core);    /* 0001 10rd dddd rrrr | SUB */
                          }
 
                          /* opcode with a single register (Rd) as operand */
                          decode = opcode & ~(mask_Rd_5);
                          switch (decode) {
-                             case 0x9405: return new  avr_op_ASR(opcode, core);         /* 1001 010d dddd 0101 | ASR */
-                             case 0x9400: return new  avr_op_COM(opcode, core);         /* 1001 010d dddd 0000 | COM */
-                             case 0x940A: return new  avr_op_DEC(opcode, core);         /* 1001 010d dddd 1010 | DEC */
+                             case 0x9405: return new(slot) avr_op_ASR(opcode, core);    /* 1001 010d dddd 0101 | ASR */
+                             case 0x9400: return new(slot) avr_op_COM(opcode, core);    /* 1001 010d dddd 0000 | COM */
+                             case 0x940A: return new(slot) avr_op_DEC(opcode, core);    /* 1001 010d dddd 1010 | DEC */
                              case 0x9006:
                                  if(core->flagELPMInstructions)
-                                     return new avr_op_ELPM_Z(opcode, core);            /* 1001 000d dddd 0110 | ELPM */
+                                     return new(slot) avr_op_ELPM_Z(opcode, core);      /* 1001 000d dddd 0110 | ELPM */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new(slot) avr_op_ILLEGAL(opcode, core);
                              case 0x9007:
                                  if(core->flagELPMInstructions)
-                                     return new avr_op_ELPM_Z_incr(opcode, core);       /* 1001 000d dddd 0111 | ELPM */
+                                     return new(slot) avr_op_ELPM_Z_incr(opcode, core); /* 1001 000d dddd 0111 | ELPM */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
-                             case 0x9403: return new  avr_op_INC(opcode, core);         /* 1001 010d dddd 0011 | INC */
-                             case 0x9000: return new  avr_op_LDS(opcode, core);         /* 1001 000d dddd 0000 | LDS */
+                                     return new(slot) avr_op_ILLEGAL(opcode, core);
+                             case 0x9403: return new(slot) avr_op_INC(opcode, core);    /* 1001 010d dddd 0011 | INC */
+                             case 0x9000: return new(slot) avr_op_LDS(opcode, core);    /* 1001 000d dddd 0000 | LDS */
                              case 0x900C:
                                  if(!core->flagTiny1x)
-                                     return new avr_op_LD_X(opcode, core);              /* 1001 000d dddd 1100 | LD */
+                                     return new(slot) avr_op_LD_X(opcode, core);        /* 1001 000d dddd 1100 | LD */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new(slot) avr_op_ILLEGAL(opcode, core);
                              case 0x900E:
                                  if(!core->flagTiny1x)
-                                     return new avr_op_LD_X_decr(opcode, core);         /* 1001 000d dddd 1110 | LD */
+                                     return new(slot) avr_op_LD_X_decr(opcode, core);   /* 1001 000d dddd 1110 | LD */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new(slot) avr_op_ILLEGAL(opcode, core);
                              case 0x900D:
                                  if(!core->flagTiny1x)
-                                     return new avr_op_LD_X_incr(opcode, core);         /* 1001 000d dddd 1101 | LD */
+                                     return new(slot) avr_op_LD_X_incr(opcode, core);   /* 1001 000d dddd 1101 | LD */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new(slot) avr_op_ILLEGAL(opcode, core);
                              case 0x8008:
                                  if(!core->flagTiny1x)
-                                     return new avr_op_LDD_Y(opcode, core);             /* 1000 000d dddd 1000 | LD */
+                                     return new(slot) avr_op_LDD_Y(opcode, core);       /* 1000 000d dddd 1000 | LD */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new(slot) avr_op_ILLEGAL(opcode, core);
                              case 0x900A:
                                  if(!core->flagTiny1x)
-                                     return new avr_op_LD_Y_decr(opcode, core);         /* 1001 000d dddd 1010 | LD */
+                                     return new(slot) avr_op_LD_Y_decr(opcode, core);   /* 1001 000d dddd 1010 | LD */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new(slot) avr_op_ILLEGAL(opcode, core);
                              case 0x9009:
                                  if(!core->flagTiny1x)
-                                     return new avr_op_LD_Y_incr(opcode, core);         /* 1001 000d dddd 1001 | LD */
+                                     return new(slot) avr_op_LD_Y_incr(opcode, core);   /* 1001 000d dddd 1001 | LD */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
-                             case 0x8000: return new avr_op_LDD_Z(opcode, core);        /* 1000 000d dddd 0000 | LD */
+                                     return new(slot) avr_op_ILLEGAL(opcode, core);
+                             case 0x8000: return new(slot) avr_op_LDD_Z(opcode, core);  /* 1000 000d dddd 0000 | LD */
                              case 0x9002:
                                  if(!core->flagTiny1x)
-                                     return new avr_op_LD_Z_decr(opcode, core);         /* 1001 000d dddd 0010 | LD */
+                                     return new(slot) avr_op_LD_Z_decr(opcode, core);   /* 1001 000d dddd 0010 | LD */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new(slot) avr_op_ILLEGAL(opcode, core);
                              case 0x9001:
                                  if(!core->flagTiny1x)
-                                     return new avr_op_LD_Z_incr(opcode, core);         /* 1001 000d dddd 0001 | LD */
+                                     return new(slot) avr_op_LD_Z_incr(opcode, core);   /* 1001 000d dddd 0001 | LD */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new(slot) avr_op_ILLEGAL(opcode, core);
                              case 0x9004:
                                  if(core->flagLPMInstructions)
-                                     return new avr_op_LPM_Z(opcode, core);             /* 1001 000d dddd 0100 | LPM */
+                                     return new(slot) avr_op_LPM_Z(opcode, core);       /* 1001 000d dddd 0100 | LPM */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new(slot) avr_op_ILLEGAL(opcode, core);
                              case 0x9005:
                                  if(core->flagLPMInstructions)
-                                     return new avr_op_LPM_Z_incr(opcode, core);        /* 1001 000d dddd 0101 | LPM */
+                                     return new(slot) avr_op_LPM_Z_incr(opcode, core);  /* 1001 000d dddd 0101 | LPM */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
-                             case 0x9406: return new  avr_op_LSR(opcode, core);         /* 1001 010d dddd 0110 | LSR */
-                             case 0x9401: return new  avr_op_NEG(opcode, core);         /* 1001 010d dddd 0001 | NEG */
+                                     return new(slot) avr_op_ILLEGAL(opcode, core);
+                             case 0x9406: return new(slot) avr_op_LSR(opcode, core);    /* 1001 010d dddd 0110 | LSR */
+                             case 0x9401: return new(slot) avr_op_NEG(opcode, core);    /* 1001 010d dddd 0001 | NEG */
                              case 0x900F:
                                  if(!core->flagTiny1x)
-                                     return new avr_op_POP(opcode, core);               /* 1001 000d dddd 1111 | POP */
+                                     return new(slot) avr_op_POP(opcode, core);         /* 1001 000d dddd 1111 | POP */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new(slot) avr_op_ILLEGAL(opcode, core);
                              case 0x920F:
                                  if(!core->flagTiny1x)
-                                     return new avr_op_PUSH(opcode, core);              /* 1001 001d dddd 1111 | PUSH */
+                                     return new(slot) avr_op_PUSH(opcode, core);        /* 1001 001d dddd 1111 | PUSH */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
-                             case 0x9407: return new  avr_op_ROR(opcode, core);         /* 1001 010d dddd 0111 | ROR */
-                             case 0x9200: return new  avr_op_STS(opcode, core);         /* 1001 001d dddd 0000 | STS */
+                                     return new(slot) avr_op_ILLEGAL(opcode, core);
+                             case 0x9407: return new(slot) avr_op_ROR(opcode, core);    /* 1001 010d dddd 0111 | ROR */
+                             case 0x9200: return new(slot) avr_op_STS(opcode, core);    /* 1001 001d dddd 0000 | STS */
                              case 0x920C:
                                  if(!core->flagTiny1x)
-                                     return new avr_op_ST_X(opcode, core);              /* 1001 001d dddd 1100 | ST */
+                                     return new(slot) avr_op_ST_X(opcode, core);        /* 1001 001d dddd 1100 | ST */
                              case 0x920E:
                                  if(!core->flagTiny1x)
-                                     return new avr_op_ST_X_decr(opcode, core);         /* 1001 001d dddd 1110 | ST */
+                                     return new(slot) avr_op_ST_X_decr(opcode, core);   /* 1001 001d dddd 1110 | ST */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new(slot) avr_op_ILLEGAL(opcode, core);
                              case 0x920D:
                                  if(!core->flagTiny1x)
-                                     return new avr_op_ST_X_incr(opcode, core);         /* 1001 001d dddd 1101 | ST */
+                                     return new(slot) avr_op_ST_X_incr(opcode, core);   /* 1001 001d dddd 1101 | ST */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new(slot) avr_op_ILLEGAL(opcode, core);
                              case 0x8208:
                                  if(!core->flagTiny1x)
-                                     return new avr_op_STD_Y(opcode, core);             /* 1000 001d dddd 1000 | ST */
+                                     return new(slot) avr_op_STD_Y(opcode, core);       /* 1000 001d dddd 1000 | ST */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new(slot) avr_op_ILLEGAL(opcode, core);
                              case 0x920A:
                                  if(!core->flagTiny1x)
-                                     return new avr_op_ST_Y_decr(opcode, core);         /* 1001 001d dddd 1010 | ST */
+                                     return new(slot) avr_op_ST_Y_decr(opcode, core);   /* 1001 001d dddd 1010 | ST */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new(slot) avr_op_ILLEGAL(opcode, core);
                              case 0x9209:
                                  if(!core->flagTiny1x)
-                                     return new avr_op_ST_Y_incr(opcode, core);         /* 1001 001d dddd 1001 | ST */
+                                     return new(slot) avr_op_ST_Y_incr(opcode, core);   /* 1001 001d dddd 1001 | ST */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
-                             case 0x8200: return new  avr_op_STD_Z(opcode, core);       /* 1000 001d dddd 0000 | ST */
+                                     return new(slot) avr_op_ILLEGAL(opcode, core);
+                             case 0x8200: return new(slot) avr_op_STD_Z(opcode, core);  /* 1000 001d dddd 0000 | ST */
                              case 0x9202:
                                  if(!core->flagTiny1x)
-                                     return new avr_op_ST_Z_decr(opcode, core);         /* 1001 001d dddd 0010 | ST */
+                                     return new(slot) avr_op_ST_Z_decr(opcode, core);   /* 1001 001d dddd 0010 | ST */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new(slot) avr_op_ILLEGAL(opcode, core);
                              case 0x9201:
                                  if(!core->flagTiny1x)
-                                     return new avr_op_ST_Z_incr(opcode, core);         /* 1001 001d dddd 0001 | ST */
+                                     return new(slot) avr_op_ST_Z_incr(opcode, core);   /* 1001 001d dddd 0001 | ST */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
-                             case 0x9402: return new  avr_op_SWAP(opcode, core);        /* 1001 010d dddd 0010 | SWAP */
+                                     return new(slot) avr_op_ILLEGAL(opcode, core);
+                             case 0x9402: return new(slot) avr_op_SWAP(opcode, core);   /* 1001 010d dddd 0010 | SWAP */
                          }
 
                          /* opcodes with a register (Rd) and a constant data (K) as operands */
                          decode = opcode & ~(mask_Rd_4 | mask_K_8);
                          switch ( decode ) {
-                             case 0x7000: return new  avr_op_ANDI(opcode, core);        /* 0111 KKKK dddd KKKK | CBR or ANDI */
-                             case 0x3000: return new  avr_op_CPI(opcode, core);         /* 0011 KKKK dddd KKKK | CPI */
-                             case 0xE000: return new  avr_op_LDI(opcode, core);         /* 1110 KKKK dddd KKKK | LDI or SER */
-                             case 0x6000: return new  avr_op_ORI(opcode, core);         /* 0110 KKKK dddd KKKK | SBR or ORI */
-                             case 0x4000: return new  avr_op_SBCI(opcode, core);        /* 0100 KKKK dddd KKKK | SBCI */
-                             case 0x5000: return new  avr_op_SUBI(opcode, core);        /* 0101 KKKK dddd KKKK | SUBI */
+                             case 0x7000: return new(slot) avr_op_ANDI(opcode, core);   /* 0111 KKKK dddd KKKK | CBR or ANDI */
+                             case 0x3000: return new(slot) avr_op_CPI(opcode, core);    /* 0011 KKKK dddd KKKK | CPI */
+                             case 0xE000: return new(slot) avr_op_LDI(opcode, core);    /* 1110 KKKK dddd KKKK | LDI or SER */
+                             case 0x6000: return new(slot) avr_op_ORI(opcode, core);    /* 0110 KKKK dddd KKKK | SBR or ORI */
+                             case 0x4000: return new(slot) avr_op_SBCI(opcode, core);   /* 0100 KKKK dddd KKKK | SBCI */
+                             case 0x5000: return new(slot) avr_op_SUBI(opcode, core);   /* 0101 KKKK dddd KKKK | SUBI */
                          }
 
                          /* opcodes with a register (Rd) and a register bit number (b) as operands */
                          decode = opcode & ~(mask_Rd_5 | mask_reg_bit);
                          switch ( decode ) {
-                             case 0xF800: return new  avr_op_BLD(opcode, core);         /* 1111 100d dddd 0bbb | BLD */
-                             case 0xFA00: return new  avr_op_BST(opcode, core);         /* 1111 101d dddd 0bbb | BST */
-                             case 0xFC00: return new  avr_op_SBRC(opcode, core);        /* 1111 110d dddd 0bbb | SBRC */
-                             case 0xFE00: return new  avr_op_SBRS(opcode, core);        /* 1111 111d dddd 0bbb | SBRS */
+                             case 0xF800: return new(slot) avr_op_BLD(opcode, core);    /* 1111 100d dddd 0bbb | BLD */
+                             case 0xFA00: return new(slot) avr_op_BST(opcode, core);    /* 1111 101d dddd 0bbb | BST */
+                             case 0xFC00: return new(slot) avr_op_SBRC(opcode, core);   /* 1111 110d dddd 0bbb | SBRC */
+                             case 0xFE00: return new(slot) avr_op_SBRS(opcode, core);   /* 1111 111d dddd 0bbb | SBRS */
                          }
 
                          /* opcodes with a relative 7-bit address (k) and a register bit number (b) as operands */
                          decode = opcode & ~(mask_k_7 | mask_reg_bit);
                          switch ( decode ) {
-                             case 0xF400: return new  avr_op_BRBC(opcode, core);        /* 1111 01kk kkkk kbbb | BRBC */
-                             case 0xF000: return new  avr_op_BRBS(opcode, core);        /* 1111 00kk kkkk kbbb | BRBS */
+                             case 0xF400: return new(slot) avr_op_BRBC(opcode, core);   /* 1111 01kk kkkk kbbb | BRBC */
+                             case 0xF000: return new(slot) avr_op_BRBS(opcode, core);   /* 1111 00kk kkkk kbbb | BRBS */
                          }
 
                          /* opcodes with a 6-bit address displacement (q) and a register (Rd) as operands */
                          if(!core->flagTiny10 && !core->flagTiny1x) {
                              decode = opcode & ~(mask_Rd_5 | mask_q_displ);
                              switch ( decode ) {
-                                 case 0x8008: return new  avr_op_LDD_Y(opcode, core);   /* 10q0 qq0d dddd 1qqq | LDD */
-                                 case 0x8000: return new  avr_op_LDD_Z(opcode, core);   /* 10q0 qq0d dddd 0qqq | LDD */
-                                 case 0x8208: return new  avr_op_STD_Y(opcode, core);   /* 10q0 qq1d dddd 1qqq | STD */
-                                 case 0x8200: return new  avr_op_STD_Z(opcode, core);   /* 10q0 qq1d dddd 0qqq | STD */
+                                 case 0x8008: return new(slot) avr_op_LDD_Y(opcode, core); /* 10q0 qq0d dddd 1qqq | LDD */
+                                 case 0x8000: return new(slot) avr_op_LDD_Z(opcode, core); /* 10q0 qq0d dddd 0qqq | LDD */
+                                 case 0x8208: return new(slot) avr_op_STD_Y(opcode, core); /* 10q0 qq1d dddd 1qqq | STD */
+                                 case 0x8200: return new(slot) avr_op_STD_Z(opcode, core); /* 10q0 qq1d dddd 0qqq | STD */
                              }
                          }
                          
@@ -2190,14 +2329,14 @@ DecodedInstruction* lookup_opcode( word opcode, AvrDevice *core )
                          switch ( decode ) {
                              case 0x940E:
                                  if(core->flagJMPInstructions)
-                                     return new avr_op_CALL(opcode, core);              /* 1001 010k kkkk 111k | CALL */
+                                     return new(slot) avr_op_CALL(opcode, core);        /* 1001 010k kkkk 111k | CALL */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new(slot) avr_op_ILLEGAL(opcode, core);
                              case 0x940C:
                                  if(core->flagJMPInstructions)
-                                     return new avr_op_JMP(opcode, core);               /* 1001 010k kkkk 110k | JMP */
+                                     return new(slot) avr_op_JMP(opcode, core);         /* 1001 010k kkkk 110k | JMP */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new(slot) avr_op_ILLEGAL(opcode, core);
                          }
 
                          /* opcode with a sreg bit select (s) operand */
@@ -2205,8 +2344,8 @@ DecodedInstruction* lookup_opcode( word opcode, AvrDevice *core )
                          switch ( decode ) {
                              /* BCLR takes place of CL{C,Z,N,V,S,H,T,I} */
                              /* BSET takes place of SE{C,Z,N,V,S,H,T,I} */
-                             case 0x9488: return new  avr_op_BCLR(opcode, core);        /* 1001 0100 1sss 1000 | BCLR */
-                             case 0x9408: return new  avr_op_BSET(opcode, core);        /* 1001 0100 0sss 1000 | BSET */
+                             case 0x9488: return new(slot) avr_op_BCLR(opcode, core);   /* 1001 0100 1sss 1000 | BCLR */
+                             case 0x9408: return new(slot) avr_op_BSET(opcode, core);   /* 1001 0100 0sss 1000 | BSET */
                          }
 
                          /* opcodes with a 6-bit constant (K) and a register (Rd) as operands */
@@ -2214,37 +2353,37 @@ DecodedInstruction* lookup_opcode( word opcode, AvrDevice *core )
                          switch ( decode ) {
                              case 0x9600:
                                  if(core->flagIWInstructions)
-                                     return new avr_op_ADIW(opcode, core);              /* 1001 0110 KKdd KKKK | ADIW */
+                                     return new(slot) avr_op_ADIW(opcode, core);        /* 1001 0110 KKdd KKKK | ADIW */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new(slot) avr_op_ILLEGAL(opcode, core);
                              case 0x9700:
                                  if(core->flagIWInstructions)
-                                     return new avr_op_SBIW(opcode, core);              /* 1001 0111 KKdd KKKK | SBIW */
+                                     return new(slot) avr_op_SBIW(opcode, core);        /* 1001 0111 KKdd KKKK | SBIW */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new(slot) avr_op_ILLEGAL(opcode, core);
                          }
 
                          /* opcodes with a 5-bit IO Addr (A) and register bit number (b) as operands */
                          decode = opcode & ~(mask_A_5 | mask_reg_bit);
                          switch ( decode ) {
-                             case 0x9800: return new  avr_op_CBI(opcode, core);         /* 1001 1000 AAAA Abbb | CBI */
-                             case 0x9A00: return new  avr_op_SBI(opcode, core);         /* 1001 1010 AAAA Abbb | SBI */
-                             case 0x9900: return new  avr_op_SBIC(opcode, core);        /* 1001 1001 AAAA Abbb | SBIC */
-                             case 0x9B00: return new  avr_op_SBIS(opcode, core);        /* 1001 1011 AAAA Abbb | SBIS */
+                             case 0x9800: return new(slot) avr_op_CBI(opcode, core);    /* 1001 1000 AAAA Abbb | CBI */
+                             case 0x9A00: return new(slot) avr_op_SBI(opcode, core);    /* 1001 1010 AAAA Abbb | SBI */
+                             case 0x9900: return new(slot) avr_op_SBIC(opcode, core);   /* 1001 1001 AAAA Abbb | SBIC */
+                             case 0x9B00: return new(slot) avr_op_SBIS(opcode, core);   /* 1001 1011 AAAA Abbb | SBIS */
                          }
 
                          /* opcodes with a 6-bit IO Addr (A) and register (Rd) as operands */
                          decode = opcode & ~(mask_A_6 | mask_Rd_5);
                          switch ( decode ) {
-                             case 0xB000: return new  avr_op_IN(opcode, core);          /* 1011 0AAd dddd AAAA | IN */
-                             case 0xB800: return new  avr_op_OUT(opcode, core);         /* 1011 1AAd dddd AAAA | OUT */
+                             case 0xB000: return new(slot) avr_op_IN(opcode, core);     /* 1011 0AAd dddd AAAA | IN */
+                             case 0xB800: return new(slot) avr_op_OUT(opcode, core);    /* 1011 1AAd dddd AAAA | OUT */
                          }
 
                          /* opcodes with a relative 12-bit address (k) operand */
                          decode = opcode & ~(mask_k_12);
                          switch ( decode ) {
-                             case 0xD000: return new  avr_op_RCALL(opcode, core);       /* 1101 kkkk kkkk kkkk | RCALL */
-                             case 0xC000: return new  avr_op_RJMP(opcode, core);        /* 1100 kkkk kkkk kkkk | RJMP */
+                             case 0xD000: return new(slot) avr_op_RCALL(opcode, core);  /* 1101 kkkk kkkk kkkk | RCALL */
+                             case 0xC000: return new(slot) avr_op_RJMP(opcode, core);   /* 1100 kkkk kkkk kkkk | RJMP */
                          }
 
                          /* opcodes with two 4-bit register (Rd and Rr) operands */
@@ -2252,14 +2391,14 @@ DecodedInstruction* lookup_opcode( word opcode, AvrDevice *core )
                          switch ( decode ) {
                              case 0x0100:
                                  if(core->flagMOVWInstruction)
-                                     return new avr_op_MOVW(opcode, core);              /* 0000 0001 dddd rrrr | MOVW */
+                                     return new(slot) avr_op_MOVW(opcode, core);        /* 0000 0001 dddd rrrr | MOVW */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new(slot) avr_op_ILLEGAL(opcode, core);
                              case 0x0200:
                                  if(core->flagMULInstructions)
-                                     return new avr_op_MULS(opcode, core);              /* 0000 0010 dddd rrrr | MULS */
+                                     return new(slot) avr_op_MULS(opcode, core);        /* 0000 0010 dddd rrrr | MULS */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new(slot) avr_op_ILLEGAL(opcode, core);
                          }
 
                          /* opcodes with two 3-bit register (Rd and Rr) operands */
@@ -2267,31 +2406,99 @@ DecodedInstruction* lookup_opcode( word opcode, AvrDevice *core )
                          switch ( decode ) {
                              case 0x0300:
                                  if(core->flagMULInstructions)
-                                     return new avr_op_MULSU(opcode, core);             /* 0000 0011 0ddd 0rrr | MULSU */
+                                     return new(slot) avr_op_MULSU(opcode, core);       /* 0000 0011 0ddd 0rrr | MULSU */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new(slot) avr_op_ILLEGAL(opcode, core);
                              case 0x0308:
                                  if(core->flagMULInstructions)
-                                     return new avr_op_FMUL(opcode, core);              /* 0000 0011 0ddd 1rrr | FMUL */
+                                     return new(slot) avr_op_FMUL(opcode, core);        /* 0000 0011 0ddd 1rrr | FMUL */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new(slot) avr_op_ILLEGAL(opcode, core);
                              case 0x0380:
                                  if(core->flagMULInstructions)
-                                     return new avr_op_FMULS(opcode, core);             /* 0000 0011 1ddd 0rrr | FMULS */
+                                     return new(slot) avr_op_FMULS(opcode, core);       /* 0000 0011 1ddd 0rrr | FMULS */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new(slot) avr_op_ILLEGAL(opcode, core);
                              case 0x0388:
                                  if(core->flagMULInstructions)
-                                     return new avr_op_FMULSU(opcode, core);            /* 0000 0011 1ddd 1rrr | FMULSU */
+                                     return new(slot) avr_op_FMULSU(opcode, core);      /* 0000 0011 1ddd 1rrr | FMULSU */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new(slot) avr_op_ILLEGAL(opcode, core);
                          }
 
                      } /* default */
     } /* first switch */
 
     //return NULL;
-    return new avr_op_ILLEGAL(opcode, core);
+    return new(slot) avr_op_ILLEGAL(opcode, core);
 
 } /* decode opcode function */
 
+//! Returns pointer register for LD / ST with post increment or -1
+static int get_ptr_incr( word opcode )
+{
+    switch(opcode & 0x000f) {
+        case 0xd: return 26;    /* X+ */
+        case 0x9: return 28;    /* Y+ */
+        case 0x1: return 30;    /* Z+ */
+    }
+    return -1;
+}
+
+DecodedInstruction* lookup_fused( const word *opcodes, DecodedInstruction **decoded, unsigned int count, AvrDevice *core )
+{
+    const word *op = opcodes;
+    unsigned int n = 0;
+    int ld = -1, st = -1;
+
+    if(count < 2)
+        return NULL;
+
+    if((op[0] & 0xf000) == 0xe000) {
+        /* LDI, LDI, ...: constants */
+        for(n = 1; n < count && n < 4 && (op[n] & 0xf000) == 0xe000; n++)
+            ;
+    } else if((op[0] & 0xfe0f) == 0x920f || (op[0] & 0xfe0f) == 0x900f) {
+        /* PUSH, PUSH, ... or POP, POP, ...: prologue / epilogue */
+        for(n = 1; n < count && (op[n] & 0xfe0f) == (op[0] & 0xfe0f); n++)
+            ;
+    } else if((op[0] & 0xfc00) == 0x1400 || (op[0] & 0xf000) == 0x3000) {
+        /* CP/CPI, CPC, ..., BRBS/BRBC: compare of multi byte values, a LDI
+         * may load the constant for CPC */
+        for(n = 1; n < count - 1 && ((op[n] & 0xfc00) == 0x0400 || (op[n] & 0xf000) == 0xe000); n++)
+            ;
+        if((op[n] & 0xf800) != 0xf000)
+            return NULL;
+        n++;
+    } else if((op[0] & 0xff00) == 0x9700 || (op[0] & 0xfe0f) == 0x940a || (op[0] & 0xf000) == 0x5000) {
+        /* SBIW/DEC/SUBI, SBCI, ..., BRBS/BRBC: loop counter */
+        for(n = 1; n < count - 1 && (op[n] & 0xf000) == 0x4000; n++)
+            ;
+        if((op[n] & 0xf800) != 0xf000)
+            return NULL;
+        n++;
+    } else if((op[0] & 0xfe00) == 0x9000 && (op[1] & 0xfe00) == 0x9200) {
+        /* LD Rd, P+ / LPM Rd, Z+ and ST Q+, Rd: copy loop */
+        int rd = (op[0] >> 4) & 0x1f;
+        if(((op[1] >> 4) & 0x1f) != rd)
+            return NULL;
+        if((op[0] & 0x000f) != 0x5) {
+            ld = get_ptr_incr(op[0]);
+            if(ld < 0)
+                return NULL;
+        }
+        st = get_ptr_incr(op[1]);
+        int src = (ld < 0) ? 30 : ld;
+        if(st < 0 || st == src || (rd >= src && rd <= src + 1) || (rd >= st && rd <= st + 1))
+            return NULL;
+        n = 2;
+    }
+
+    if(n < 2)
+        return NULL;
+    for(unsigned int i = 0; i < n; i++) {
+        if(decoded[i] == NULL || dynamic_cast<avr_op_ILLEGAL *>(decoded[i]) != NULL)
+            return NULL;
+    }
+    return new avr_op_FUSED(core, decoded, n, ld, st);
+}
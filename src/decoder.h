@@ -27,6 +27,7 @@
 #define DECODER
 
 #include <iostream>
+#include <cstddef>
 
 #include "rwmem.h"
 #include "types.h"
@@ -34,6 +35,14 @@
 
 class AvrFlash;
 
+//! Size of memory for one instruction, see lookup_opcode and AvrFlash::Slot
+#define DECODED_SLOT_SIZE (6 * sizeof(void *))
+
+/*! Breaks compile, if a instance of cls doesn't fit into a slot of
+  DECODED_SLOT_SIZE bytes (array with negative size) */
+#define DECODED_SLOT_CHECK(cls) \
+    typedef char cls##_fits_in_slot[(sizeof(cls) <= DECODED_SLOT_SIZE) ? 1 : -1]
+
 //! Base class of core instruction
 /*! All instruction are derived from this class */
 class DecodedInstruction {
@@ -46,6 +55,13 @@ class DecodedInstruction {
         DecodedInstruction(AvrDevice *c, bool s2w = false): core(c), size2Word(s2w) {}
         virtual ~DecodedInstruction() {}
 
+        //! Allocates on heap (superinstructions, see lookup_fused)
+        static void *operator new(size_t size) { return ::operator new(size); }
+        //! Constructs in a slot of DECODED_SLOT_SIZE bytes, see lookup_opcode and DECODED_SLOT_CHECK
+        static void *operator new(size_t size, void *slot) { return slot; }
+        static void operator delete(void *p) { ::operator delete(p); }
+        static void operator delete(void *p, void *slot) {}
+
         //! Returns true, if instruction need 2 words (4byte)
         bool IsInstruction2Words() { return size2Word; } 
 
@@ -59,8 +75,18 @@ class DecodedInstruction {
 		virtual unsigned char GetModifiedRHi() const {return -1;}
 };
 
-//! Translates an opcode to a instance of DecodedInstruction
-DecodedInstruction* lookup_opcode(word opcode, AvrDevice *core);
+/*! Translates an opcode to a instance of DecodedInstruction, which is
+  constructed in slot (DECODED_SLOT_SIZE bytes). Release it by calling the
+  destructor, not with delete. */
+DecodedInstruction* lookup_opcode(word opcode, AvrDevice *core, void *slot);
+
+//! Max. count of instructions in a superinstruction, see avr_op_FUSED
+#define FUSED_MAX_PARTS 8
+
+/*! Looks for a frequent instruction idiom (see avr_op_FUSED) in count
+  instructions, given by opcodes and decoded, which follow one after the
+  other in flash. Returns a new superinstruction or NULL. */
+DecodedInstruction* lookup_fused(const word *opcodes, DecodedInstruction **decoded, unsigned int count, AvrDevice *core);
 
 class avr_op_ADC: public DecodedInstruction {
     /*
@@ -364,6 +390,7 @@ class avr_op_CALL: public DecodedInstruction
 
     protected:
         unsigned char KH;
+        const int clkadd; //!< additional cycles, resolved for core variant on decoding
 
     public:
         avr_op_CALL(word opcode, AvrDevice *c);
@@ -387,6 +414,7 @@ class avr_op_CBI: public DecodedInstruction
         unsigned char ioreg;
         unsigned char Kbit;
         HWSreg *status;
+        const int clks; //!< cycles, resolved for core variant on decoding
 
     public:
         avr_op_CBI(word opcode, AvrDevice *c);
@@ -543,6 +571,9 @@ class avr_op_EICALL: public DecodedInstruction
      * Num Clocks : 4
      */
 
+    protected:
+        const int clks; //!< cycles, resolved for core variant on decoding
+
     public:
         avr_op_EICALL(word opcode, AvrDevice *c);
         int operator()();
@@ -751,6 +782,9 @@ class avr_op_ICALL: public DecodedInstruction
      * Num Clocks : 3 / 4
      */
 
+    protected:
+        const int clkadd; //!< additional cycles, resolved for core variant on decoding
+
     public:
         avr_op_ICALL(word opcode, AvrDevice *c);
         int operator()();
@@ -855,6 +889,7 @@ class avr_op_LDD_Y: public DecodedInstruction
     protected:
         unsigned char Rd;
         unsigned char K;
+        const int clks; //!< cycles, resolved for core variant on decoding
 
     public:
         avr_op_LDD_Y(word opcode, AvrDevice *c);
@@ -877,6 +912,7 @@ class avr_op_LDD_Z: public DecodedInstruction
     protected:
         unsigned char Rd;
         unsigned char K;
+        const int clks; //!< cycles, resolved for core variant on decoding
 
     public:
         avr_op_LDD_Z(word opcode, AvrDevice *c);
@@ -942,6 +978,7 @@ class avr_op_LD_X: public DecodedInstruction
 
     protected:
         unsigned char Rd;
+        const int clks; //!< cycles, resolved for core variant on decoding
 
     public:
         avr_op_LD_X(word opcode, AvrDevice *c);
@@ -963,6 +1000,7 @@ class avr_op_LD_X_decr: public DecodedInstruction
 
     protected:
         unsigned char Rd;
+        const int clks; //!< cycles, resolved for core variant on decoding
 
     public:
         avr_op_LD_X_decr(word opcode, AvrDevice *c);
@@ -984,6 +1022,7 @@ class avr_op_LD_X_incr: public DecodedInstruction
 
     protected:
         unsigned char Rd;
+        const int clks; //!< cycles, resolved for core variant on decoding
 
     public:
         avr_op_LD_X_incr(word opcode, AvrDevice *c);
@@ -1006,6 +1045,7 @@ class avr_op_LD_Y_decr: public DecodedInstruction
 
     protected:
         unsigned char Rd;
+        const int clks; //!< cycles, resolved for core variant on decoding
 
     public:
         avr_op_LD_Y_decr(word opcode, AvrDevice *c);
@@ -1027,6 +1067,7 @@ class avr_op_LD_Y_incr: public DecodedInstruction
 
     protected:
         unsigned char Rd;
+        const int clks; //!< cycles, resolved for core variant on decoding
 
     public:
         avr_op_LD_Y_incr(word opcode, AvrDevice *c);
@@ -1048,6 +1089,7 @@ class avr_op_LD_Z_incr: public DecodedInstruction
 
     protected:
         unsigned char Rd;
+        const int clks; //!< cycles, resolved for core variant on decoding
 
     public:
         avr_op_LD_Z_incr(word opcode, AvrDevice *c);
@@ -1069,6 +1111,7 @@ class avr_op_LD_Z_decr: public DecodedInstruction
 
     protected:
         unsigned char Rd;
+        const int clks; //!< cycles, resolved for core variant on decoding
 
     public:
         avr_op_LD_Z_decr(word opcode, AvrDevice *c);
@@ -1421,6 +1464,7 @@ class avr_op_PUSH: public DecodedInstruction
 
     protected:
         unsigned char R1;
+        const int clks; //!< cycles, resolved for core variant on decoding
 
     public:
         avr_op_PUSH(word opcode, AvrDevice *c);
@@ -1442,6 +1486,7 @@ class avr_op_RCALL: public DecodedInstruction
 
     protected:
         signed int K;
+        const int clkadd; //!< additional cycles, resolved for core variant on decoding
 
     public:
         avr_op_RCALL(word opcode, AvrDevice *c);
@@ -1594,6 +1639,7 @@ class avr_op_SBI: public DecodedInstruction
     protected:
         unsigned char ioreg;
         unsigned char Kbit;
+        const int clks; //!< cycles, resolved for core variant on decoding
 
     public:
         avr_op_SBI(word opcode, AvrDevice *c);
@@ -1616,6 +1662,7 @@ class avr_op_SBIC: public DecodedInstruction
     protected:
         unsigned char ioreg;
         unsigned char Kbit;
+        const int clkadd; //!< additional cycles, resolved for core variant on decoding
 
     public:
         avr_op_SBIC(word opcode, AvrDevice *c);
@@ -1638,6 +1685,7 @@ class avr_op_SBIS: public DecodedInstruction
     protected:
         unsigned char ioreg;
         unsigned char Kbit;
+        const int clkadd; //!< additional cycles, resolved for core variant on decoding
 
     public:
         avr_op_SBIS(word opcode, AvrDevice *c);
@@ -1769,6 +1817,7 @@ class avr_op_STD_Y: public DecodedInstruction
     protected:
         unsigned char R1;
         unsigned char K;
+        const int clks; //!< cycles, resolved for core variant on decoding
 
     public:
         avr_op_STD_Y(word opcode, AvrDevice *c);
@@ -1791,6 +1840,7 @@ class avr_op_STD_Z: public DecodedInstruction
     protected:
         unsigned char R1;
         unsigned char K;
+        const int clks; //!< cycles, resolved for core variant on decoding
 
     public:
         avr_op_STD_Z(word opcode, AvrDevice *c);
@@ -1833,6 +1883,7 @@ class avr_op_ST_X: public DecodedInstruction
 
     protected:
         unsigned char R1;
+        const int clks; //!< cycles, resolved for core variant on decoding
 
     public:
         avr_op_ST_X(word opcode, AvrDevice *c);
@@ -1875,6 +1926,7 @@ class avr_op_ST_X_incr: public DecodedInstruction
 
     protected:
         unsigned char R1;
+        const int clks; //!< cycles, resolved for core variant on decoding
 
     public:
         avr_op_ST_X_incr(word opcode, AvrDevice *c);
@@ -1917,6 +1969,7 @@ class avr_op_ST_Y_incr: public DecodedInstruction
 
     protected:
         unsigned char R1;
+        const int clks; //!< cycles, resolved for core variant on decoding
 
     public:
         avr_op_ST_Y_incr(word opcode, AvrDevice *c);
@@ -1959,6 +2012,7 @@ class avr_op_ST_Z_incr: public DecodedInstruction
 
     protected:
         unsigned char R1;
+        const int clks; //!< cycles, resolved for core variant on decoding
 
     public:
         avr_op_ST_Z_incr(word opcode, AvrDevice *c);
@@ -2085,5 +2139,41 @@ class avr_op_ILLEGAL: public DecodedInstruction
         int Trace();
 };
 
+class avr_op_FUSED: public DecodedInstruction
+{
+    /*
+     * Superinstruction: a idiom of avr-gcc output, executed with one dispatch
+     *
+     * Idioms     : LDI, LDI, ...
+     *              PUSH, PUSH, ... / POP, POP, ...
+     *              CP/CPI, [CPC/LDI, ...], BRBS/BRBC
+     *              SBIW/DEC/SUBI [SBCI, ...], BRBS/BRBC
+     *              LD/LPM Rd, P+, ST Q+, Rd
+     * Num Clocks : sum of the instructions
+     *
+     * The original instructions are executed one after the other, PC is
+     * moved between them, only the last one may jump. Execution stops
+     * before a instruction with a breakpoint or exit point and before a
+     * LD/ST, which would access registers or IO, so the core executes it
+     * in a own step. Only used while interrupts are disabled, see
+     * AvrDevice::SetFusion.
+     */
+    protected:
+        DecodedInstruction *parts[FUSED_MAX_PARTS]; //!< original instructions, owned by AvrFlash
+        unsigned int count;  //!< count of instructions in parts
+        int ldPtr;           //!< pointer register (26, 28, 30) of a LD in idiom or -1
+        int stPtr;           //!< pointer register of a ST in idiom or -1
+
+        //! Checks, if pointer register ptr addresses internal or external RAM
+        bool PointsToRam(int ptr);
+
+    public:
+        avr_op_FUSED(AvrDevice *c, DecodedInstruction **p, unsigned int n, int ld = -1, int st = -1);
+        int operator()();
+        int Trace();
+        //! Returns count of instructions executed together
+        unsigned int GetCount() const { return count; }
+};
+
 #endif
 
@@ -756,4 +756,9 @@ int avr_op_ILLEGAL::Trace() {
     return ret;
 }
 
+int avr_op_FUSED::Trace() {
+    // a trace shows every single instruction
+    return parts[0]->Trace();
+}
+
 /* EOF */
@@ -0,0 +1,209 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2001, 2002 - 2012   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#include <algorithm>
+#include <assert.h>
+
+#include "delayloop.h"
+#include "avrdevice.h"
+#include "decoder.h"
+#include "flash.h"
+#include "hwsreg.h"
+#include "irqsystem.h"
+
+DelayLoopSkipper::DelayLoopSkipper(AvrDevice *_core):
+    core(_core),
+    generation(0),
+    active(LOOP_NONE),
+    activeVal(0),
+    activeCycles(0),
+    loopsSkipped(0),
+    cyclesSkipped(0)
+{
+    Flush();
+}
+
+void DelayLoopSkipper::Flush(void) {
+    loopAt.assign(core->Flash->GetSize() / 2, LOOP_UNKNOWN);
+    loops.clear();
+    active = LOOP_NONE;
+    generation = core->Flash->GetCodeGeneration();
+}
+
+int DelayLoopSkipper::Recognize(unsigned int pc) {
+    unsigned int words = loopAt.size();
+    Loop l;
+    l.pc = pc;
+    l.len = 0;
+    l.counterBytes = 0;
+
+    unsigned int opcode = core->Flash->GetOpcode(pc);
+    if((opcode & 0xfe0f) == 0x940a) {                 // DEC Rd
+        l.counter[l.counterBytes++] = (opcode >> 4) & 0x1f;
+        l.cycles[l.len++] = 1;
+    } else if((opcode & 0xffcf) == 0x9701) {          // SBIW Rd, 1
+        unsigned char d = 24 + ((opcode >> 4) & 0x3) * 2;
+        l.counter[l.counterBytes++] = d;
+        l.counter[l.counterBytes++] = d + 1;
+        l.cycles[l.len++] = 2;
+    } else if((opcode & 0xff0f) == 0x5001) {          // SUBI Rd, 1
+        l.counter[l.counterBytes++] = 16 + ((opcode >> 4) & 0xf);
+        l.cycles[l.len++] = 1;
+        while(l.counterBytes < MAX_COUNTER && pc + l.len < words) {
+            opcode = core->Flash->GetOpcode(pc + l.len);
+            if((opcode & 0xff0f) != 0x4000)           // SBCI Rd, 0
+                break;
+            unsigned char d = 16 + ((opcode >> 4) & 0xf);
+            if(std::find(l.counter, l.counter + l.counterBytes, d) != l.counter + l.counterBytes)
+                return LOOP_NONE;
+            l.counter[l.counterBytes++] = d;
+            l.cycles[l.len++] = 1;
+        }
+    } else
+        return LOOP_NONE;
+
+    // BRNE back to loop start
+    unsigned int brne = pc + l.len;
+    if(brne >= words)
+        return LOOP_NONE;
+    opcode = core->Flash->GetOpcode(brne);
+    if((opcode & 0xfc07) != 0xf401)
+        return LOOP_NONE;
+    int k = (opcode >> 3) & 0x7f;
+    if(k & 0x40)
+        k -= 0x80;
+    if((int)brne + 1 + k != (int)pc)
+        return LOOP_NONE;
+    l.cycles[l.len++] = 2;
+
+    // exit points have to be checked by core on every pass
+    for(unsigned int i = 0; i < l.len; i++)
+        if(core->EP.end() != std::find(core->EP.begin(), core->EP.end(), pc + i))
+            return LOOP_NONE;
+
+    l.passCycles = 0;
+    for(unsigned int i = 0; i < l.len; i++) {
+        l.offset[i] = l.passCycles;
+        l.passCycles += l.cycles[i];
+    }
+    loops.push_back(l);
+    return loops.size() - 1;
+}
+
+unsigned long long DelayLoopSkipper::GetCounter(const Loop &l) {
+    unsigned long long val = 0;
+    for(unsigned int i = l.counterBytes; i > 0; i--)
+        val = (val << 8) | core->GetCoreReg(l.counter[i - 1]);
+    return val;
+}
+
+void DelayLoopSkipper::SetCounter(const Loop &l, unsigned long long val) {
+    for(unsigned int i = 0; i < l.counterBytes; i++, val >>= 8)
+        core->SetCoreReg(l.counter[i], val & 0xff);
+}
+
+void DelayLoopSkipper::Execute(unsigned int count) {
+    for(unsigned int i = 0; i < count; i++) {
+        (*core->Flash->GetInstruction(core->PC))();
+        core->PC++;
+    }
+}
+
+unsigned int DelayLoopSkipper::Restore(const Loop &l, unsigned long long val, unsigned long long at) {
+    unsigned long long pass = at / l.passCycles;
+    unsigned int offset = at % l.passCycles;
+    unsigned int insn = std::find(l.offset, l.offset + l.len, offset) - l.offset;
+    assert(insn < l.len);
+
+    core->PC = l.pc;
+    if(pass > 0) {
+        // run the pass before, so that SREG is exact too
+        SetCounter(l, val - (pass - 1));
+        Execute(l.len);
+    }
+    Execute(insn);
+    return insn;
+}
+
+int DelayLoopSkipper::Run(void) {
+    if(generation != core->Flash->GetCodeGeneration())
+        Flush();
+
+    unsigned int pc = core->PC;
+    if(pc >= loopAt.size())
+        return 0;
+    int index = loopAt[pc];
+    if(index == LOOP_UNKNOWN)
+        index = loopAt[pc] = Recognize(pc);
+    if(index == LOOP_NONE)
+        return 0;
+    const Loop &l = loops[index];
+
+    if(core->status->I == 1 && core->irqSystem->IsIrqPending())
+        return 0;
+
+    // the last pass is left to the interpreter
+    unsigned long long val = GetCounter(l);
+    unsigned long long passes = (val == 0) ? (1ULL << (8 * l.counterBytes)) : val;
+    unsigned long long skip = std::min(passes - 1, (unsigned long long)(MAX_SKIP_CYCLES / l.passCycles));
+    if(skip == 0)
+        return 0;
+    unsigned long long cycles = skip * l.passCycles;
+
+    Restore(l, val, cycles);
+    active = index;
+    activeVal = val;
+    activeCycles = cycles;
+    loopsSkipped++;
+    cyclesSkipped += cycles;
+    return cycles;
+}
+
+void DelayLoopSkipper::Check(int &cpuCycles) {
+    if(active < 0)
+        return;
+    const Loop &l = loops[active];
+    if(cpuCycles <= 0 || cpuCycles >= activeCycles || core->PC != l.pc) {
+        // core isn't inside skipped cycles anymore (reset, snapshot, ...)
+        active = LOOP_NONE;
+        return;
+    }
+    unsigned long long at = activeCycles - cpuCycles;
+    if(cpuCycles == 1)
+        active = LOOP_NONE;  // last skipped cycle
+
+    // interpreter would see the interrupt, if this is a instruction start
+    if(core->status->I == 0 || !core->irqSystem->IsIrqPending())
+        return;
+    unsigned int offset = at % l.passCycles;
+    if(std::find(l.offset, l.offset + l.len, offset) == l.offset + l.len)
+        return;
+    Restore(l, activeVal, at);
+    cpuCycles = 0;
+    active = LOOP_NONE;
+    cyclesSkipped -= activeCycles - at;
+}
+
+// EOF
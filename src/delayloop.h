@@ -0,0 +1,129 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2001, 2002 - 2012   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#ifndef DELAYLOOP
+#define DELAYLOOP
+
+#include <vector>
+
+class AvrDevice;
+
+//! Skips counted busy-wait loops of a core in closed form
+/*! Recognized are the delay loops of avr-libc (<util/delay.h>,
+  <util/delay_basic.h> and __builtin_avr_delay_cycles):
+
+  - DEC Rd, BRNE back (_delay_loop_1, 3 cycles per pass)
+  - SBIW Rd, 1, BRNE back (_delay_loop_2, 4 cycles per pass)
+  - SUBI Rd, 1, SBCI Rd+n, 0 (1 to 3 times), BRNE back (5 to 7 cycles per pass)
+
+  Such a loop changes only its counter and SREG. If the core comes to the
+  loop start with more than one pass left, passes are skipped in one core
+  step (all but the last one, at most MAX_SKIP_CYCLES): the counter is set
+  to the value after these passes. The last pass is executed by the normal
+  interpreter, so SREG and the end of the loop are exact.
+
+  The skipped cycles are handled like one instruction with that many cycles:
+  hardware on the cycle list gets them one by one on the following core
+  steps, so timers, UART and other simulation members keep the same
+  simulation time, holds included. Only decoding and execution of the loop
+  instructions is saved.
+
+  If interrupts are enabled, every of these core steps checks for a raised
+  interrupt (see Check). On the instruction start, on which the interpreter
+  would see it, the core is set back to the loop state of this cycle and the
+  interpreter goes on from there. */
+class DelayLoopSkipper {
+
+    public:
+        //! values for loop index of a PC
+        enum {
+            LOOP_UNKNOWN = -2,        //!< not yet checked
+            LOOP_NONE = -1            //!< no delay loop starts on this PC
+        };
+
+        static const unsigned int MAX_LOOP_LEN = 5;  //!< instructions of the longest loop
+        static const unsigned int MAX_COUNTER = 4;   //!< bytes of the widest counter
+        static const unsigned int MAX_SKIP_CYCLES = 4096; //!< cycles skipped in one core step at most
+
+    protected:
+        //! a recognized delay loop
+        struct Loop {
+            unsigned int pc;                      //!< loop start
+            unsigned int len;                     //!< instructions, including BRNE
+            unsigned int cycles[MAX_LOOP_LEN];    //!< cycles of every instruction, BRNE taken
+            unsigned int offset[MAX_LOOP_LEN];    //!< cycle offset of every instruction in a pass
+            unsigned int passCycles;              //!< cycles of a whole pass
+            unsigned int counterBytes;            //!< counter size in bytes
+            unsigned char counter[MAX_COUNTER];   //!< counter registers, LSB first
+        };
+
+        AvrDevice *core;
+        std::vector<int> loopAt;          //!< index in loops for every flash word or LOOP_UNKNOWN / LOOP_NONE
+        std::vector<Loop> loops;          //!< recognized loops
+        unsigned int generation;          //!< AvrFlash code generation, the loops belong to
+        int active;                       //!< index of loop, which core is skipping, or LOOP_NONE
+        unsigned long long activeVal;     //!< counter of active loop before skipping
+        int activeCycles;                 //!< cycles skipped on active loop
+        unsigned long long loopsSkipped;  //!< statistic: count of skipped loops
+        unsigned long long cyclesSkipped; //!< statistic: count of skipped cycles
+
+        //! Checks for a delay loop on pc, returns its index or LOOP_NONE
+        int Recognize(unsigned int pc);
+        //! Drops all recognized loops
+        void Flush(void);
+        //! Reads counter of loop from core registers
+        unsigned long long GetCounter(const Loop &l);
+        //! Writes counter of loop to core registers
+        void SetCounter(const Loop &l, unsigned long long val);
+        //! Sets core to the state on cycle offset at of a loop, which started with counter val
+        /*! at has to be a instruction start. Returns index of instruction in
+          the pass, which starts on at. */
+        unsigned int Restore(const Loop &l, unsigned long long val, unsigned long long at);
+        //! Executes count instructions of loop from core->PC
+        void Execute(unsigned int count);
+
+    public:
+        DelayLoopSkipper(AvrDevice *core);
+
+        //! Skips delay loop on core->PC, if there is one
+        /*! Has to be called on a instruction start after interrupt check.
+          Returns count of skipped cycles or 0, if nothing was skipped. The
+          core is set to the state after the skipped cycles, the caller has to
+          wait this count of cycles like for a instruction. */
+        int Run(void);
+        //! Checks for a interrupt inside the skipped cycles
+        /*! Has to be called on every core step, which waits for skipped cycles,
+          after hardware got the cycle (not on a hold). If the interpreter would
+          see a raised interrupt on this instruction start, the core is set back
+          to the state on this cycle and cpuCycles is set to 0. */
+        void Check(int &cpuCycles);
+
+        //! Returns count of skipped loops
+        unsigned long long GetLoopsSkipped(void) const { return loopsSkipped; }
+        //! Returns count of skipped cycles
+        unsigned long long GetCyclesSkipped(void) const { return cyclesSkipped; }
+};
+
+#endif
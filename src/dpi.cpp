@@ -0,0 +1,200 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2001, 2002 - 2012   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+
+#include <vector>
+
+#include "dpi.h"
+#include "avrdevice.h"
+#include "avrfactory.h"
+#include "avrerror.h"
+#include "pin.h"
+#include "net.h"
+#include "systemclock.h"
+
+//! External side of a AVR port, pins are connected by a net to the AVR pins
+struct DpiPort {
+    Pin *avrPin[8];       //!< AVR pins or NULL, if not available
+    Pin extPin[8];        //!< pins driven by testbench
+    Net *net[8];          //!< nets between AVR pin and external pin
+    unsigned char value;  //!< last value set by avr_dpi_set_port
+    unsigned char oe;     //!< last output enable set by avr_dpi_set_port
+};
+
+//! AVR device created by DPI interface
+struct DpiDevice {
+    AvrDevice *dev;
+    SystemClockOffset time;  //!< simulation time of next clock cycle
+    DpiPort *ports[26];      //!< ports by letter, created on first access
+};
+
+static std::vector<DpiDevice*> dpiDevices;
+
+static DpiDevice *GetDevice(int handle) {
+    if(handle < 0 || handle >= (int)dpiDevices.size() || dpiDevices[handle] == NULL)
+        avr_error("DPI: invalid AVR handle %d", handle);
+    return dpiDevices[handle];
+}
+
+static DpiPort *GetPort(DpiDevice *d, char port) {
+    if(port >= 'a' && port <= 'z')
+        port -= 'a' - 'A';
+    if(port < 'A' || port > 'Z')
+        avr_error("DPI: invalid port '%c'", port);
+    DpiPort *p = d->ports[port - 'A'];
+    if(p == NULL) {
+        p = new DpiPort;
+        p->value = 0;
+        p->oe = 0;
+        bool found = false;
+        for(int i = 0; i < 8; i++) {
+            char name[3] = { port, (char)('0' + i), 0 };
+            p->avrPin[i] = d->dev->FindPin(name);
+            p->net[i] = NULL;
+            if(p->avrPin[i] != NULL) {
+                found = true;
+                p->net[i] = new Net;
+                p->net[i]->Add(p->avrPin[i]);
+                p->net[i]->Add(&p->extPin[i]);
+            }
+        }
+        if(!found) {
+            delete p;
+            avr_error("DPI: port '%c' isn't available on this device", port);
+        }
+        d->ports[port - 'A'] = p;
+    }
+    return p;
+}
+
+int avr_dpi_create(const char *device, const char *progname) {
+    DpiDevice *d = new DpiDevice;
+    d->dev = AvrFactory::instance().makeDevice(device);
+    d->dev->Load(progname);
+    // default 4MHz, if program doesn't give a frequency
+    if(d->dev->GetClockFreq() == 0)
+        d->dev->SetClockFreq((SystemClockOffset)1000000000 / 4000000);
+    d->time = 0;
+    for(int i = 0; i < 26; i++)
+        d->ports[i] = NULL;
+    dpiDevices.push_back(d);
+    return dpiDevices.size() - 1;
+}
+
+void avr_dpi_destroy(int handle) {
+    DpiDevice *d = GetDevice(handle);
+    for(int i = 0; i < 26; i++) {
+        DpiPort *p = d->ports[i];
+        if(p == NULL)
+            continue;
+        for(int b = 0; b < 8; b++)
+            delete p->net[b];
+    }
+    delete d->dev;
+    for(int i = 0; i < 26; i++)
+        delete d->ports[i];
+    delete d;
+    dpiDevices[handle] = NULL;
+}
+
+void avr_dpi_reset(int handle) {
+    GetDevice(handle)->dev->Reset();
+}
+
+void avr_dpi_set_clock(int handle, long long period) {
+    if(period <= 0)
+        avr_error("DPI: clock period has to be greater than 0");
+    GetDevice(handle)->dev->SetClockFreq(period);
+}
+
+int avr_dpi_step(int handle, int cycles) {
+    DpiDevice *d = GetDevice(handle);
+    AvrDevice *dev = d->dev;
+    SystemClock &clock = SystemClock::Instance();
+    SystemClockOffset period = dev->GetClockFreq();
+    int i;
+    for(i = 0; i < cycles; i++) {
+        clock.SetCurrentTime(d->time);
+        bool untilCoreStepFinished = false;
+        if(dev->Step(untilCoreStepFinished) != 0)
+            break; // stopped on breakpoint
+        d->time += period;
+    }
+    return i;
+}
+
+void avr_dpi_get_port(int handle, char port, unsigned char *value, unsigned char *oe) {
+    DpiPort *p = GetPort(GetDevice(handle), port);
+    unsigned char v = 0, e = 0;
+    for(int i = 0; i < 8; i++) {
+        if(p->avrPin[i] == NULL)
+            continue;
+        switch(p->avrPin[i]->outState) {
+            case Pin::HIGH:
+                e |= 1 << i;
+                // fall through
+            case Pin::PULLUP:
+                v |= 1 << i;
+                break;
+            case Pin::LOW:
+            case Pin::SHORTED:
+                e |= 1 << i;
+                break;
+            default:
+                break;
+        }
+    }
+    *value = v;
+    *oe = e;
+}
+
+void avr_dpi_set_port(int handle, char port, unsigned char value, unsigned char oe) {
+    DpiPort *p = GetPort(GetDevice(handle), port);
+    unsigned char changed = (p->oe ^ oe) | ((p->value ^ value) & oe);
+    p->value = value;
+    p->oe = oe;
+    for(int i = 0; changed != 0; i++, changed >>= 1) {
+        if(!(changed & 1) || p->avrPin[i] == NULL)
+            continue;
+        if(oe & (1 << i))
+            p->extPin[i] = (value & (1 << i)) ? 'H' : 'L';
+        else
+            p->extPin[i] = 't';
+    }
+}
+
+int avr_dpi_read_mem(int handle, int address) {
+    return GetDevice(handle)->dev->GetRWMem(address);
+}
+
+void avr_dpi_write_mem(int handle, int address, int value) {
+    GetDevice(handle)->dev->SetRWMem(address, value);
+}
+
+int avr_dpi_get_pc(int handle) {
+    return GetDevice(handle)->dev->cPC;
+}
+
+// EOF
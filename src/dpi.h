@@ -0,0 +1,74 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2001, 2002 - 2012   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+
+#ifndef DPI_H_INCLUDED
+#define DPI_H_INCLUDED
+
+/*! \file dpi.h
+  DPI-C interface to simulavr, e.g. for Verilator testbenches
+
+  All functions have C linkage and use only types, which can be mapped
+  directly to SystemVerilog (see src/verilog/avr_dpi.sv for the import
+  declarations). Ports are exchanged as whole bytes, port is given by its
+  letter ('A', 'B', ...). An AVR is identified by a handle as returned by
+  avr_dpi_create. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! Creates an AVR device and loads program, returns handle
+int avr_dpi_create(const char *device, const char *progname);
+//! Destroys an AVR device
+void avr_dpi_destroy(int handle);
+//! Resets an AVR device
+void avr_dpi_reset(int handle);
+//! Sets clock period in ns, used for simulation time inside of simulavr (trace, dumps)
+/*! Default is the frequency given in program (see SIMINFO_CPUFREQUENCY)
+  or 250ns (4MHz), if program hasn't a frequency. */
+void avr_dpi_set_clock(int handle, long long period);
+//! Runs AVR for the given count of clock cycles, returns count of cycles done
+int avr_dpi_step(int handle, int cycles);
+//! Returns output states of port pins
+/*! value has a bit set, if pin drives high or has pull up, oe has a bit
+  set, if pin drives actively high or low. */
+void avr_dpi_get_port(int handle, char port, unsigned char *value, unsigned char *oe);
+//! Sets external drivers for port pins
+/*! Pins with a bit set in oe are driven to the level given by value, other
+  pins are not driven from outside. Only changed pins are updated. */
+void avr_dpi_set_port(int handle, char port, unsigned char value, unsigned char oe);
+//! Reads a byte from data address space (registers, IO, SRAM)
+int avr_dpi_read_mem(int handle, int address);
+//! Writes a byte to data address space (registers, IO, SRAM)
+void avr_dpi_write_mem(int handle, int address, int value);
+//! Returns word address of current instruction
+int avr_dpi_get_pc(int handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -25,6 +25,7 @@
 
 #include "externalirq.h"
 #include "avrerror.h"
+#include "snapshot.h"
 
 ExternalIRQHandler::ExternalIRQHandler(AvrDevice* c,
                                        HWIrqSystem* irqsys,
@@ -107,6 +108,20 @@ void ExternalIRQHandler::Reset(void) {
         extirqs[idx]->ResetMode();
 }
 
+void ExternalIRQHandler::SaveState(SnapshotWriter &w) {
+    w.WriteByte(irq_mask);
+    w.WriteByte(irq_flag);
+    for(unsigned int idx = 0; idx < extirqs.size(); idx++)
+        extirqs[idx]->SaveState(w);
+}
+
+void ExternalIRQHandler::RestoreState(SnapshotReader &r) {
+    irq_mask = r.ReadByte();
+    irq_flag = r.ReadByte();
+    for(unsigned int idx = 0; idx < extirqs.size(); idx++)
+        extirqs[idx]->RestoreState(r);
+}
+
 unsigned char ExternalIRQHandler::set_from_reg(const IOSpecialReg* reg, unsigned char nv) {
     if(reg == mask_reg) {
         // mask register: trigger interrupt, if mask bit is new set and flag is true or fireAgain()
@@ -156,6 +171,14 @@ unsigned char ExternalIRQ::get_from_client(const IOSpecialReg* reg, unsigned cha
     return (v & ~mask) | (mode << bitshift);
 }
 
+void ExternalIRQ::SaveState(SnapshotWriter &w) {
+    w.WriteByte(mode);
+}
+
+void ExternalIRQ::RestoreState(SnapshotReader &r) {
+    mode = r.ReadByte();
+}
+
 ExternalIRQSingle::ExternalIRQSingle(IOSpecialReg *ctrl, int ctrlOffset, int ctrlBits, Pin *pin, bool _8515mode):
     ExternalIRQ(ctrl, ctrlOffset, ctrlBits)
 {
@@ -217,6 +240,16 @@ bool ExternalIRQSingle::mustSetFlagOnFire(void) {
     return mode != MODE_LEVEL_LOW;
 }
 
+void ExternalIRQSingle::SaveState(SnapshotWriter &w) {
+    ExternalIRQ::SaveState(w);
+    w.WriteBool(state);
+}
+
+void ExternalIRQSingle::RestoreState(SnapshotReader &r) {
+    ExternalIRQ::RestoreState(r);
+    state = r.ReadBool();
+}
+
 ExternalIRQPort::ExternalIRQPort(IOSpecialReg *ctrl, HWPort *port):
     ExternalIRQ(ctrl, 0, port->GetPortSize())
 {
@@ -235,6 +268,18 @@ ExternalIRQPort::ExternalIRQPort(IOSpecialReg *ctrl, HWPort *port):
     ResetMode();
 }
 
+void ExternalIRQPort::SaveState(SnapshotWriter &w) {
+    ExternalIRQ::SaveState(w);
+    for(unsigned int idx = 0; idx < 8; idx++)
+        w.WriteBool(state[idx]);
+}
+
+void ExternalIRQPort::RestoreState(SnapshotReader &r) {
+    ExternalIRQ::RestoreState(r);
+    for(unsigned int idx = 0; idx < 8; idx++)
+        state[idx] = r.ReadBool();
+}
+
 void ExternalIRQPort::PinStateHasChanged(Pin *pin) {
     // new state
     bool s = (bool)*pin;
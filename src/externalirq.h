@@ -66,6 +66,8 @@ class ExternalIRQHandler: public Hardware, public IOSpecialRegClient {
         virtual void Reset(void);
         virtual bool IsLevelInterrupt(unsigned int vector);
         virtual bool LevelInterruptPending(unsigned int vector);
+        virtual void SaveState(SnapshotWriter &w);
+        virtual void RestoreState(SnapshotReader &r);
         
         // from IOSpecialRegClient
         virtual unsigned char set_from_reg(const IOSpecialReg* reg, unsigned char nv);
@@ -95,6 +97,10 @@ class ExternalIRQ: public IOSpecialRegClient {
         virtual bool fireAgain(void) { return false; }
         //! does fire interrupt set the interrupt flag? (level interrupt does this not!)
         virtual bool mustSetFlagOnFire(void) { return true; }
+        //! Save mode and pin states for a snapshot
+        virtual void SaveState(SnapshotWriter &w);
+        //! Restore mode and pin states from a snapshot
+        virtual void RestoreState(SnapshotReader &r);
         
         friend class ExternalIRQHandler;
         
@@ -128,6 +134,8 @@ class ExternalIRQSingle: public ExternalIRQ, public HasPinNotifyFunction {
         void ChangeMode(unsigned char m);
         bool fireAgain(void);
         bool mustSetFlagOnFire(void);
+        void SaveState(SnapshotWriter &w);
+        void RestoreState(SnapshotReader &r);
         
         // from HasPinNotifyFunction
         void PinStateHasChanged(Pin *pin);
@@ -144,6 +152,10 @@ class ExternalIRQPort: public ExternalIRQ, public HasPinNotifyFunction {
     public:
         ExternalIRQPort(IOSpecialReg *ctrl, HWPort *port);
         
+        // from ExternalIRQ
+        void SaveState(SnapshotWriter &w);
+        void RestoreState(SnapshotReader &r);
+        
         // from HasPinNotifyFunction
         void PinStateHasChanged(Pin *pin);
 };
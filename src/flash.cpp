@@ -27,6 +27,8 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <algorithm>
+#include <string.h>
 
 
 
@@ -34,6 +36,7 @@
 #include "helper.h"
 #include "memory.h"
 #include "avrerror.h"
+#include "snapshot.h"
 
 void AvrFlash::Decode(){
     for(unsigned int addr = 0; addr < size ; addr += 2)
@@ -44,19 +47,24 @@ AvrFlash::AvrFlash(AvrDevice *c, int _size):
     Memory(_size),
     core(c),
     DecodedMem(_size),
-    flashLoaded(false) {
+    FusedMem(_size / 2),
+    fusedValid(_size / 2, false),
+    slotPages((_size / 2 + FLASH_SLOT_PAGE_WORDS - 1) / FLASH_SLOT_PAGE_WORDS),
+    flashLoaded(false),
+    codeGeneration(0) {
     for(unsigned int tt = 0; tt < size; tt++)
         myMemory[tt] = 0xff;  // Safeguard, will be decoded as avr_op_ILLEGAL
     rww_lock = 0;
-    // initialize DecodedMem
-    Decode();
+    // DecodedMem is filled on first fetch of an instruction
 }
 
 AvrFlash::~AvrFlash() {
-    for(unsigned int i = 0; i < size; i++) {
-       if(DecodedMem[i] != NULL)
-          delete DecodedMem[i]; // delete Instruction
-    }
+    for(unsigned int i = 0; i < size / 2; i++)
+        delete FusedMem[i];
+    for(unsigned int i = 0; i < size / 2; i++)
+        DropDecoded(i);
+    for(unsigned int i = 0; i < slotPages.size(); i++)
+        delete [] slotPages[i];
 }
 
 void AvrFlash::WriteMem(const unsigned char *src, unsigned int offset, unsigned int secSize) {
@@ -71,6 +79,35 @@ void AvrFlash::WriteMem(const unsigned char *src, unsigned int offset, unsigned
     flashLoaded = true;
 }
 
+void AvrFlash::SaveState(SnapshotWriter &w) {
+    w.WriteDWord(size);
+    w.WriteBlock(myMemory, size);
+    w.WriteDWord(rww_lock);
+    w.WriteBool(flashLoaded);
+}
+
+void AvrFlash::RestoreState(SnapshotReader &r) {
+    if(r.ReadDWord() != size)
+        avr_error("snapshot: flash size doesn't match");
+    // decode only changed instructions, flash is mostly the same
+    unsigned char mem[1024];
+    for(unsigned int offset = 0; offset < size; offset += sizeof(mem)) {
+        unsigned int len = std::min((unsigned int)sizeof(mem), size - offset);
+        r.ReadBlock(mem, len);
+        if(memcmp(myMemory + offset, mem, len) == 0)
+            continue;
+        for(unsigned int addr = 0; addr < len; addr += 2) {
+            if(myMemory[offset + addr] != mem[addr] || myMemory[offset + addr + 1] != mem[addr + 1]) {
+                myMemory[offset + addr] = mem[addr];
+                myMemory[offset + addr + 1] = mem[addr + 1];
+                Decode(offset + addr);
+            }
+        }
+    }
+    rww_lock = r.ReadDWord();
+    flashLoaded = r.ReadBool();
+}
+
 void AvrFlash::WriteMemByte(unsigned char val, unsigned int offset) {
     assert(offset < size);  // in bytes
     *(myMemory + offset) = val;
@@ -80,7 +117,16 @@ void AvrFlash::WriteMemByte(unsigned char val, unsigned int offset) {
 DecodedInstruction* AvrFlash::GetInstruction(unsigned int pc) {
     if(IsRWWLock(pc * 2))
         avr_error("flash is locked (RWW lock)");
-    return DecodedMem[pc];
+    return Decoded(pc);
+}
+
+DecodedInstruction* AvrFlash::GetFusedInstruction(unsigned int pc) {
+    if(IsRWWLock(pc * 2))
+        avr_error("flash is locked (RWW lock)");
+    if(!fusedValid[pc])
+        Fuse(pc);
+    DecodedInstruction *fused = FusedMem[pc];
+    return (fused != NULL) ? fused : Decoded(pc);
 }
 
 unsigned int AvrFlash::GetOpcode(unsigned int pc) {
@@ -116,11 +162,51 @@ void AvrFlash::Decode(unsigned int offset, int secSize) {
 void AvrFlash::Decode(unsigned int addr) {
     assert((unsigned)addr < size);
     assert((addr % 2) == 0);
-    word opcode = (myMemory[addr] << 8) + myMemory[addr + 1];
     unsigned int index = addr / 2;
-    if(DecodedMem[index] != NULL)
-        delete DecodedMem[index];                     //delete old Instruction here 
-    DecodedMem[index] = lookup_opcode(opcode, core);  //and set new one
+    DropDecoded(index);  // new instruction is created on next fetch
+    codeGeneration++;
+
+    // superinstructions, which contain this instruction, are built again on next fetch
+    unsigned int first = (index >= FUSED_MAX_PARTS - 1) ? index - (FUSED_MAX_PARTS - 1) : 0;
+    for(unsigned int i = first; i <= index; i++) {
+        delete FusedMem[i];
+        FusedMem[i] = NULL;
+        fusedValid[i] = false;
+    }
+}
+
+DecodedInstruction* AvrFlash::DecodeWord(unsigned int index) {
+    unsigned int addr = index * 2;
+    assert(addr < size);
+    word opcode = (myMemory[addr] << 8) + myMemory[addr + 1];
+    return DecodedMem[index] = lookup_opcode(opcode, core, Slot(index));
+}
+
+void *AvrFlash::Slot(unsigned int index) {
+    unsigned char *&page = slotPages[index / FLASH_SLOT_PAGE_WORDS];
+    if(page == NULL)
+        page = new unsigned char[FLASH_SLOT_PAGE_WORDS * DECODED_SLOT_SIZE];
+    return page + (index % FLASH_SLOT_PAGE_WORDS) * DECODED_SLOT_SIZE;
+}
+
+void AvrFlash::DropDecoded(unsigned int index) {
+    if(DecodedMem[index] != NULL) {
+        DecodedMem[index]->~DecodedInstruction();  // memory stays in slotPages
+        DecodedMem[index] = NULL;
+    }
+}
+
+void AvrFlash::Fuse(unsigned int index) {
+    word opcodes[FUSED_MAX_PARTS];
+    unsigned int count = 0;
+    for(; count < FUSED_MAX_PARTS && (index + count) * 2 < size; count++) {
+        unsigned int addr = (index + count) * 2;
+        opcodes[count] = (myMemory[addr] << 8) + myMemory[addr + 1];
+        Decoded(index + count);
+    }
+    delete FusedMem[index];
+    FusedMem[index] = lookup_fused(opcodes, &DecodedMem[index], count, core);
+    fusedValid[index] = true;
 }
 
 /** Returns true if insn at address index*2 looks like switching thread stacks (heuristics).
@@ -135,11 +221,11 @@ void AvrFlash::Decode(unsigned int addr) {
 * We analyze few preceding instructions in hope to rule out these cases.
 * (GDB's weak prologue analysis is doctored elsewhere.)
 */
-bool AvrFlash::LooksLikeContextSwitch(unsigned int addr) const
+bool AvrFlash::LooksLikeContextSwitch(unsigned int addr)
 {
     assert(addr < size);
     word index = addr/2;
-    DecodedInstruction * instr = DecodedMem[index];
+    DecodedInstruction * instr = Decoded(index);
     avr_op_OUT * out_instr = dynamic_cast<avr_op_OUT*>(instr);
     if(out_instr == NULL)
         return false;
@@ -151,7 +237,7 @@ bool AvrFlash::LooksLikeContextSwitch(unsigned int addr) const
     unsigned char out_R = out_instr->R1;  // We have "OUT SP, R"
 
     for(int i = 1; i < 8 && i <= index; i++) {
-        instr = DecodedMem[index - i];
+        instr = Decoded(index - i);
         byte Rlo = instr->GetModifiedR();  // "sbiw r28:r29, 42" returns 28
         byte Rhi = instr->GetModifiedRHi();  // "sbiw r28:r29, 42" returns 29
         if(out_R == Rlo || (is_SPH && out_R == Rhi)) {
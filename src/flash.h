@@ -33,15 +33,24 @@
 #include "memory.h"
 
 class DecodedInstruction;
+class SnapshotWriter;
+class SnapshotReader;
+
+//! Count of instruction slots in one page of AvrFlash::slotPages
+#define FLASH_SLOT_PAGE_WORDS 256
 
 //! Holds AVR flash content and symbol informations.
 class AvrFlash: public Memory {
   
     protected:
         AvrDevice *core;
-        std::vector <DecodedInstruction*> DecodedMem;
+        std::vector <DecodedInstruction*> DecodedMem; //!< instruction on a word or NULL, if it isn't decoded yet
+        std::vector <DecodedInstruction*> FusedMem; //!< superinstruction starting on a word or NULL, see avr_op_FUSED
+        std::vector <bool> fusedValid; //!< FusedMem entry is built for current flash content
+        std::vector <unsigned char*> slotPages; //!< memory for DecodedMem instructions, a page is allocated on first use
         unsigned int rww_lock; //!< When Flash write is in progress then addresses below this are inaccesible, otherwise 0.
         bool flashLoaded; //!< Flag, true if there was a write to Flash after constructor call (program load)
+        unsigned int codeGeneration; //!< Incremented with every decoded instruction
         
         friend int avr_op_CPSE::operator()();
         friend int avr_op_SBIC::operator()();
@@ -49,14 +58,30 @@ class AvrFlash: public Memory {
         friend int avr_op_SBRC::operator()();
         friend int avr_op_SBRS::operator()();
 
+        //! Returns instruction on word index, decodes it on first use
+        DecodedInstruction* Decoded(unsigned int index) {
+            DecodedInstruction *instr = DecodedMem[index];
+            return (instr != NULL) ? instr : DecodeWord(index);
+        }
+        //! Creates instruction on word index from flash content
+        DecodedInstruction* DecodeWord(unsigned int index);
+        //! Returns memory for the instruction on word index, see lookup_opcode
+        void *Slot(unsigned int index);
+        //! Destroys instruction on word index, it's decoded again on next fetch
+        void DropDecoded(unsigned int index);
+        /*! Build superinstruction starting on word 'index', see lookup_fused */
+        void Fuse(unsigned int index);
+
     public:
       
         AvrFlash(AvrDevice *c, int size);
         ~AvrFlash();
         
-        void Decode(); /*!< Decode/create all instructions */
+        void Decode(); /*!< Decode all instructions again (on next fetch) */
         
-        /*! Decode/create instruction at address 'addr'. */
+        /*! Decode instruction at address 'addr' again.
+          Instructions are decoded on first fetch, this drops the instruction
+          and the superinstructions, which contain it. */
         void Decode(unsigned int addr);
         
         /*! Decode memory block with offset and size
@@ -72,6 +97,10 @@ class AvrFlash: public Memory {
         /*! Write byte `val' at `address' (in bytes). Caller must call Decode() later. */
         void WriteMemByte(unsigned char val, unsigned int address);
         
+        /*! Returns a counter, which changes with every decoded instruction, caches
+          of decoded code (see BlockTier) are invalid, if it has changed */
+        unsigned int GetCodeGeneration(void) const { return codeGeneration; }
+
         /*! True if flash was written, i.e. a program was loaded */
         bool IsProgramLoaded(void) { return flashLoaded; }
         
@@ -85,6 +114,10 @@ class AvrFlash: public Memory {
         /*! Returns instruction at pointer PC. Aborts if Flash write is in progress. */
         DecodedInstruction* GetInstruction(unsigned int pc);
 
+        /*! Returns superinstruction at PC, if there is one, otherwise the
+          same as GetInstruction. Aborts if Flash write is in progress. */
+        DecodedInstruction* GetFusedInstruction(unsigned int pc);
+
         /*! Returns opcode at PC. Aborts if Flash write is in progress. */
         unsigned int GetOpcode(unsigned int pc);
         
@@ -100,7 +133,12 @@ class AvrFlash: public Memory {
         /*! Returns 16bits at flash address. Aborts if Flash write is in progress. */
         unsigned int ReadMemWord(unsigned int addr);
 
-        bool LooksLikeContextSwitch(unsigned int addr) const;
+        bool LooksLikeContextSwitch(unsigned int addr);
+
+        /*! Save flash content and RWW lock state for a snapshot */
+        void SaveState(SnapshotWriter &w);
+        /*! Restore flash content and RWW lock state from a snapshot, changed instructions are decoded again */
+        void RestoreState(SnapshotReader &r);
 };
 
 #endif
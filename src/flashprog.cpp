@@ -28,6 +28,7 @@
 #include "systemclock.h"
 #include "avrmalloc.h"
 #include "flash.h"
+#include "snapshot.h"
 
 //#include <iostream>
 //using namespace std;
@@ -111,6 +112,24 @@ void FlashProgramming::Reset() {
     timeout = 0;
 }
 
+void FlashProgramming::SaveState(SnapshotWriter &w) {
+    w.WriteByte(spmcr_val);
+    w.WriteInt(opr_enable_count);
+    w.WriteInt(action);
+    w.WriteInt(spm_opr);
+    w.WriteTime(timeout);
+    w.WriteBlock(tempBuffer, pageSize * 2);
+}
+
+void FlashProgramming::RestoreState(SnapshotReader &r) {
+    spmcr_val = r.ReadByte();
+    opr_enable_count = r.ReadInt();
+    action = (SPM_ACTIONtype)r.ReadInt();
+    spm_opr = (SPM_OPStype)r.ReadInt();
+    timeout = r.ReadTime();
+    r.ReadBlock(tempBuffer, pageSize * 2);
+}
+
 unsigned char FlashProgramming::LPM_action(unsigned int xaddr, unsigned int addr) {
     return 0;
 }
@@ -86,6 +86,8 @@ class FlashProgramming: public Hardware {
         
         unsigned int CpuCycle();
         void Reset();
+        void SaveState(SnapshotWriter &w);
+        void RestoreState(SnapshotReader &r);
         
         unsigned char LPM_action(unsigned int xaddr, unsigned int addr);
         int SPM_action(unsigned int data, unsigned int xaddr, unsigned int addr);
@@ -0,0 +1,217 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2001, 2002 - 2012   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#include <iostream>
+#include <sstream>
+#include <map>
+#include <stdio.h>
+
+/* for preprocessor symbol HAVE_SYS_MINGW */
+#include "config.h"
+
+#if !(defined(HAVE_SYS_MINGW) || defined(_MSC_VER))
+#   include <unistd.h>
+#   include <errno.h>
+#   include <sys/types.h>
+#   include <sys/wait.h>
+#   include <sys/select.h>
+#endif
+
+#include "forkpool.h"
+#include "avrdevice.h"
+#include "snapshot.h"
+#include "systemclock.h"
+#include "avrerror.h"
+
+using namespace std;
+
+SimulationForkPool::SimulationForkPool(AvrDevice *_core, unsigned int _maxParallel):
+    core(_core),
+    maxParallel(_maxParallel)
+{
+    if(maxParallel == 0) {
+#if defined(HAVE_SYS_MINGW) || defined(_MSC_VER)
+        maxParallel = 1;
+#else
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        maxParallel = (n > 0) ? (unsigned int)n : 1;
+#endif
+    }
+}
+
+void SimulationForkPool::Run(ForkVariant *v, unsigned int count) {
+    results.assign(count, string());
+    status.assign(count, 0);
+#if defined(HAVE_SYS_MINGW) || defined(_MSC_VER)
+    RunSequential(v, count);
+#else
+    RunForked(v, count);
+#endif
+}
+
+void SimulationForkPool::RunSequential(ForkVariant *v, unsigned int count) {
+    SystemClock &clk = SystemClock::Instance();
+    ostringstream branchPoint;
+    SaveSnapshot(core, branchPoint);
+    string state = branchPoint.str();
+
+    // errors in a variant must not end the application
+    bool useExit = sysConHandler.GetUseExit();
+    sysConHandler.SetUseExit(false);
+    for(unsigned int i = 0; i < count; i++) {
+        try {
+            results[i] = v->RunVariant(i);
+        } catch(char const *s) {
+            // s is in message buffer of sysConHandler, which is used by avr_warning too
+            string msg(s);
+            avr_warning("fork pool: variant %u: %s", i, msg.c_str());
+            status[i] = 1;
+        } catch(int code) {
+            status[i] = (code < 0) ? -code : code;
+        }
+        // a error throws out of SystemClock::Step, before core is inserted
+        // again into time table
+        if(clk.GetNextTime(core) < 0)
+            clk.Add(core);
+        istringstream is(state);
+        RestoreSnapshot(core, is);
+    }
+    sysConHandler.SetUseExit(useExit);
+}
+
+#if !(defined(HAVE_SYS_MINGW) || defined(_MSC_VER))
+
+//! Writes all data to a pipe, used in child process
+static void WriteAll(int fd, const string &data) {
+    size_t pos = 0;
+    while(pos < data.size()) {
+        ssize_t res = write(fd, data.data() + pos, data.size() - pos);
+        if(res < 0) {
+            if(errno == EINTR)
+                continue;
+            return;
+        }
+        pos += res;
+    }
+}
+
+void SimulationForkPool::RunForked(ForkVariant *v, unsigned int count) {
+    map<int, unsigned int> running; // pipe fd -> variant index
+    map<int, pid_t> pids;           // pipe fd -> child process
+    unsigned int next = 0;
+
+    // buffered output would be written twice otherwise, by parent and child
+    cout.flush();
+    cerr.flush();
+    fflush(NULL);
+
+    while(next < count || running.size()) {
+        // start new variants up to max. parallel count
+        while(next < count && running.size() < maxParallel) {
+            int fds[2];
+            if(pipe(fds) != 0)
+                avr_error("fork pool: can't create pipe");
+            pid_t pid = fork();
+            if(pid < 0)
+                avr_error("fork pool: can't fork variant %u", next);
+            if(pid == 0) {
+                // child: run variant on copy on write image of parent. Errors
+                // have to throw, exit() would run atexit handlers of parent
+                // (for instance writing the coverage file)
+                close(fds[0]);
+                sysConHandler.SetUseExit(false);
+                int code = 0;
+                string res;
+                try {
+                    res = v->RunVariant(next);
+                } catch(char const *s) {
+                    string msg(s);
+                    avr_warning("fork pool: variant %u: %s", next, msg.c_str());
+                    code = 1;
+                } catch(int c) {
+                    code = (c < 0) ? -c : c;
+                }
+                WriteAll(fds[1], res);
+                close(fds[1]);
+                cout.flush();
+                cerr.flush();
+                fflush(NULL);
+                _exit(code);
+            }
+            close(fds[1]);
+            running[fds[0]] = next;
+            pids[fds[0]] = pid;
+            next++;
+        }
+
+        // collect result data from running variants
+        fd_set rfds;
+        int maxfd = -1;
+        FD_ZERO(&rfds);
+        for(map<int, unsigned int>::iterator i = running.begin(); i != running.end(); i++) {
+            FD_SET(i->first, &rfds);
+            if(i->first > maxfd)
+                maxfd = i->first;
+        }
+        if(select(maxfd + 1, &rfds, NULL, NULL, NULL) < 0) {
+            if(errno == EINTR)
+                continue;
+            avr_error("fork pool: select failed");
+        }
+        for(map<int, unsigned int>::iterator i = running.begin(); i != running.end(); ) {
+            int fd = i->first;
+            if(!FD_ISSET(fd, &rfds)) {
+                i++;
+                continue;
+            }
+            char buf[4096];
+            ssize_t res = read(fd, buf, sizeof(buf));
+            if(res < 0 && errno == EINTR) {
+                i++;
+                continue;
+            }
+            if(res > 0) {
+                results[i->second].append(buf, res);
+                i++;
+                continue;
+            }
+            // end of data: variant is finished
+            int st = 0;
+            close(fd);
+            while(waitpid(pids[fd], &st, 0) < 0 && errno == EINTR)
+                ;
+            if(WIFEXITED(st))
+                status[i->second] = WEXITSTATUS(st);
+            else if(WIFSIGNALED(st))
+                status[i->second] = -WTERMSIG(st);
+            pids.erase(fd);
+            running.erase(i++);
+        }
+    }
+}
+
+#endif
+
+// EOF
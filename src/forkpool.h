@@ -0,0 +1,87 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2001, 2002 - 2012   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#ifndef FORKPOOL
+#define FORKPOOL
+
+#include <string>
+#include <vector>
+
+class AvrDevice;
+
+//! A what-if variant, which starts from a common simulation state
+/*! Derive from this class and implement RunVariant to change simulation
+  state (for instance inject a fault or a different input) and to run the
+  simulation. */
+class ForkVariant {
+
+    public:
+        virtual ~ForkVariant() {}
+
+        //! Runs variant with number index and returns result data
+        /*! Is called in a copy of the simulation, so it can change device state
+          and simulation time as it likes, the branch point isn't affected. */
+        virtual std::string RunVariant(unsigned int index) = 0;
+};
+
+//! Runs variants of a simulation, branched from the current simulation state
+/*! On systems with fork() every variant runs in its own child process. This
+  process shares all memory pages (RAM, eeprom, flash and decoded instructions,
+  internal state of peripherals) copy on write with the calling process, so
+  memory needed for a variant is only proportional to the pages touched by it.
+  Up to maxParallel variants run at the same time, result data is sent back by
+  a pipe.
+
+  On systems without fork() variants run one after the other in the calling
+  process. Device state and simulation time are stored by a snapshot on branch
+  point and restored after each variant. */
+class SimulationForkPool {
+
+    protected:
+        AvrDevice *core;                  //!< device, from which variants are branched
+        unsigned int maxParallel;         //!< max. count of variants running at the same time
+        std::vector<std::string> results; //!< result data for each variant
+        std::vector<int> status;          //!< exit status for each variant
+
+        void RunSequential(ForkVariant *v, unsigned int count);
+        void RunForked(ForkVariant *v, unsigned int count);
+
+    public:
+        //! Creates a pool, maxParallel = 0 means: use count of online processors
+        SimulationForkPool(AvrDevice *core, unsigned int maxParallel = 0);
+
+        //! Runs count variants and waits, until all variants are finished
+        void Run(ForkVariant *v, unsigned int count);
+        //! Returns count of variants, which was run by last call of Run
+        unsigned int GetCount(void) const { return results.size(); }
+        //! Returns result data of a variant
+        const std::string &GetResult(unsigned int index) const { return results[index]; }
+        //! Returns 0, if variant finished normally, otherwise a exit code or -signal number
+        int GetStatus(unsigned int index) const { return status[index]; }
+        //! Returns max. count of variants running at the same time
+        unsigned int GetMaxParallel(void) const { return maxParallel; }
+};
+
+#endif
@@ -0,0 +1,306 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2001, 2002 - 2012   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#include <sstream>
+#include <algorithm>
+#include <string.h>
+#include <stdlib.h>
+
+/* for preprocessor symbol HAVE_SYS_MINGW */
+#include "config.h"
+
+#if !(defined(HAVE_SYS_MINGW) || defined(_MSC_VER))
+#   include <sys/types.h>
+#   include <sys/ipc.h>
+#   include <sys/shm.h>
+#endif
+
+#include "fuzzharness.h"
+#include "flash.h"
+#include "hwstack.h"
+#include "decoder.h"
+#include "systemclock.h"
+#include "snapshot.h"
+#include "avrerror.h"
+
+using namespace std;
+
+RWFuzzInput::RWFuzzInput(TraceValueRegister *registry,
+                         const string &tracename,
+                         FuzzHarness *_harness):
+    RWMemoryMember(registry, tracename),
+    harness(_harness) {}
+
+unsigned char RWFuzzInput::get() const {
+    return harness->NextInputByte();
+}
+
+void FuzzSerialSource::Clear(void) {
+    inputBuffer.clear();
+    txState = TX_DISABLED;
+    tx = 'H';
+    SystemClock::Instance().Remove(this);
+}
+
+FuzzHarness::FuzzHarness(AvrDevice *_core, unsigned int coverageSize):
+    core(_core),
+    prevLocation(0),
+    stackLimit(0),
+    maxCycles(10000000),
+    idleCycles(10000),
+    serial(NULL),
+    serialNet(NULL),
+    input(NULL),
+    inputSize(0),
+    inputPos(0),
+    inputConsumed(false),
+    stopReason(FUZZ_OK)
+{
+    if(coverageSize == 0 || (coverageSize & (coverageSize - 1)) != 0)
+        avr_error("fuzz: coverage map size %u isn't a power of 2", coverageSize);
+    ownCoverage.resize(coverageSize, 0);
+    coverage = &ownCoverage[0];
+    coverageMask = coverageSize - 1;
+
+    // crashes have to be reported by exceptions and not by exit()
+    sysConHandler.SetUseExit(false);
+    next = core->GetPCObserver();
+    core->SetPCObserver(this);
+}
+
+FuzzHarness::~FuzzHarness() {
+    if(core->GetPCObserver() == this)
+        core->SetPCObserver(next);
+    if(serial != NULL) {
+        serial->Clear();
+        delete serialNet;
+        delete serial;
+    }
+}
+
+void FuzzHarness::UsePipeInput(unsigned int ioOffset) {
+    core->ReplaceIoRegister(ioOffset, new RWFuzzInput(core, "FUZZIN", this));
+}
+
+void FuzzHarness::UseUartInput(const char *pinName, unsigned long long baudrate) {
+    Pin *pin = core->GetPin(pinName);
+    if(pin == NULL)
+        avr_error("fuzz: pin '%s' not found", pinName);
+    serial = new FuzzSerialSource;
+    serial->SetBaudRate(baudrate);
+    serialNet = new Net;
+    serialNet->Add(pin);
+    serialNet->Add(serial->GetPin("tx"));
+}
+
+void FuzzHarness::SetCoverageMap(unsigned char *map, unsigned int size) {
+    if(size == 0 || (size & (size - 1)) != 0)
+        avr_error("fuzz: coverage map size %u isn't a power of 2", size);
+    coverage = map;
+    coverageMask = size - 1;
+}
+
+bool FuzzHarness::AttachAFLSharedMemory(void) {
+#if defined(HAVE_SYS_MINGW) || defined(_MSC_VER)
+    return false;
+#else
+    const char *id = getenv("__AFL_SHM_ID");
+    if(id == NULL)
+        return false;
+    void *map = shmat(atoi(id), NULL, 0);
+    if(map == (void *)-1)
+        avr_error("fuzz: can't attach AFL shared memory %s", id);
+    // AFL default map size, unless AFL++ tells us a other size
+    unsigned int size = 65536;
+    const char *s = getenv("AFL_MAP_SIZE");
+    if(s != NULL && atoi(s) > 0) {
+        size = 1;
+        while(size * 2 <= (unsigned int)atoi(s))
+            size *= 2;
+    }
+    SetCoverageMap((unsigned char *)map, size);
+    return true;
+#endif
+}
+
+void FuzzHarness::SetBranchPoint(void) {
+    ostringstream os;
+    SaveSnapshot(core, os);
+    branchPoint = os.str();
+
+    // flash content is part of branch point, so we can mark illegal opcodes now
+    unsigned int words = core->Flash->GetSize() / 2;
+    illegalOpcode.assign(words, false);
+    for(unsigned int i = 0; i < words; i++)
+        illegalOpcode[i] = dynamic_cast<avr_op_ILLEGAL *>(core->Flash->GetInstruction(i)) != NULL;
+}
+
+bool FuzzHarness::SetBranchPointAt(unsigned int pc) {
+    SystemClock &clk = SystemClock::Instance();
+
+    if(clk.GetNextTime(core) < 0)
+        clk.Add(core);
+    input = NULL;
+    inputSize = 0;
+    inputPos = 0;
+    inputConsumed = false;
+    errorMessage = "";
+
+    // a breakpoint stops RunTimeRange before the instruction on pc is executed
+    core->BP.push_back(pc);
+    try {
+        clk.RunTimeRange((SystemClockOffset)maxCycles * core->GetClockFreq());
+    } catch(char const *s) {
+        errorMessage = s;
+    } catch(int) {
+        errorMessage = "firmware stopped before branch point";
+    }
+    core->BP.erase(find(core->BP.begin(), core->BP.end(), pc));
+    if(inputConsumed)
+        errorMessage = "firmware reads input before branch point";
+
+    // illegal opcode table isn't set up till now, so forget, what we have seen
+    stopReason = FUZZ_OK;
+    prevLocation = 0;
+    if(core->PC != pc || inputConsumed || errorMessage.size())
+        return false;
+    SetBranchPoint();
+    ClearCoverage();
+    return true;
+}
+
+void FuzzHarness::ClearCoverage(void) {
+    memset(coverage, 0, coverageMask + 1);
+}
+
+void FuzzHarness::Stop(FuzzResult reason) {
+    if(stopReason == FUZZ_OK)
+        stopReason = reason;
+    SystemClock::Instance().Stop();
+}
+
+unsigned char FuzzHarness::NextInputByte(void) {
+    if(inputPos < inputSize)
+        return input[inputPos++];
+    inputConsumed = true;
+    Stop(FUZZ_OK);
+    return 0;
+}
+
+void FuzzHarness::OnExecute(unsigned int pc) {
+    if(next != NULL)
+        next->OnExecute(pc);
+    // AFL style edge coverage: hash of previous and current location
+    unsigned int location = (pc * 0x9e3779b1U) >> 15;
+    coverage[(location ^ prevLocation) & coverageMask]++;
+    prevLocation = location >> 1;
+
+    if(pc >= illegalOpcode.size()) {
+        // avr_error is raised by core after this
+        stopReason = FUZZ_OUT_OF_FLASH;
+    } else if(illegalOpcode[pc]) {
+        // avr_error is raised by instruction
+        stopReason = FUZZ_ILLEGAL_OPCODE;
+    } else {
+        // stack pointer 0 means: not initialized after reset (on older devices)
+        unsigned long sp = core->stack->GetStackPointer();
+        if(sp < stackLimit && sp != 0)
+            Stop(FUZZ_STACK_OVERFLOW);
+    }
+}
+
+FuzzHarness::FuzzResult FuzzHarness::RunInput(const unsigned char *data, size_t size) {
+    SystemClock &clk = SystemClock::Instance();
+
+    if(branchPoint.empty())
+        SetBranchPoint();
+    if(serial != NULL)
+        serial->Clear();
+    // a crash in last run throws out of SystemClock::Step, before core is
+    // inserted again into time table
+    if(clk.GetNextTime(core) < 0)
+        clk.Add(core);
+    istringstream is(branchPoint);
+    RestoreSnapshot(core, is);
+
+    input = data;
+    inputSize = size;
+    inputPos = 0;
+    inputConsumed = false;
+    prevLocation = 0;
+    stopReason = FUZZ_OK;
+    errorMessage = "";
+
+    SystemClockOffset endTime = clk.GetCurrentTime() + (SystemClockOffset)maxCycles * core->GetClockFreq();
+    SystemClockOffset t = clk.GetCurrentTime();
+    try {
+        if(serial != NULL) {
+            for(size_t i = 0; i < size; i++)
+                serial->Send(data[i]);
+            // run, till all data is sent, then give firmware some time to process it
+            while(serial->Sending() && t < endTime) {
+                t = min(t + 1000 * core->GetClockFreq(), endTime);
+                clk.Run(t);
+                if(clk.GetCurrentTime() < t)
+                    break;
+            }
+            if(!serial->Sending() && clk.GetCurrentTime() >= t) {
+                t = min(clk.GetCurrentTime() + (SystemClockOffset)idleCycles * core->GetClockFreq(), endTime);
+                clk.Run(t);
+                if(clk.GetCurrentTime() >= t && t < endTime)
+                    return FUZZ_OK;
+            }
+        } else {
+            t = endTime;
+            clk.Run(t);
+        }
+    } catch(char const *s) {
+        errorMessage = s;
+        return (stopReason != FUZZ_OK) ? stopReason : FUZZ_ERROR;
+    } catch(int code) {
+        return (code < 0) ? FUZZ_ABORT : FUZZ_EXIT;
+    }
+
+    if(stopReason != FUZZ_OK)
+        return stopReason;
+    if(clk.GetCurrentTime() < t)
+        return inputConsumed ? FUZZ_OK : FUZZ_EXIT; // else stopped by exit point
+    return FUZZ_TIMEOUT;
+}
+
+const char *FuzzHarness::ResultName(FuzzResult r) {
+    switch(r) {
+        case FUZZ_OK:             return "ok";
+        case FUZZ_TIMEOUT:        return "timeout";
+        case FUZZ_EXIT:           return "exit";
+        case FUZZ_ILLEGAL_OPCODE: return "illegal opcode";
+        case FUZZ_STACK_OVERFLOW: return "stack overflow";
+        case FUZZ_OUT_OF_FLASH:   return "out of flash";
+        case FUZZ_ABORT:          return "abort";
+        default:                  return "error";
+    }
+}
+
+// EOF
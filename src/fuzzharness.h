@@ -0,0 +1,164 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2001, 2002 - 2012   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#ifndef FUZZHARNESS
+#define FUZZHARNESS
+
+#include <string>
+#include <vector>
+
+#include "avrdevice.h"
+#include "rwmem.h"
+#include "ui/serialtx.h"
+
+class FuzzHarness;
+
+//! Read register, which delivers the bytes of current fuzz input
+/*! Works like RWReadFromFile, but reads from FuzzHarness. A read behind the
+  end of input stops the run. Writes are ignored. */
+class RWFuzzInput: public RWMemoryMember {
+
+    public:
+        RWFuzzInput(TraceValueRegister *registry,
+                    const std::string &tracename,
+                    FuzzHarness *harness);
+
+    protected:
+        FuzzHarness *harness;
+
+        unsigned char get() const;
+        void set(unsigned char) {}
+};
+
+//! Sends fuzz input as serial data to a UART rx pin
+class FuzzSerialSource: public SerialTxBuffered {
+
+    public:
+        //! Drops pending data and removes it from simulation time table
+        void Clear(void);
+};
+
+//! Runs firmware with fuzz input, collects edge coverage and detects crashes
+/*! Every input starts from the same branch point (a in memory snapshot, see
+  SetBranchPoint and SetBranchPointAt) and is fed to firmware by a read register (UsePipeInput) or
+  as serial data to a UART rx pin (UseUartInput).
+
+  Coverage is collected AFL style from the stream of executed PCs: for every
+  pair of previous and current PC a byte in the coverage map is incremented.
+  A other PC observer is kept and called before, like in PCTrigger.
+  The map can be a AFL shared memory map (AttachAFLSharedMemory), a map given by
+  application (for instance libFuzzer extra counters) or a own map.
+
+  Crashes are illegal opcodes, a stack pointer below the stack limit, a PC
+  outside of flash, RWAbort and any other simulation error. The harness switches
+  error handling to exceptions (see SystemConsoleHandler::SetUseExit). */
+class FuzzHarness: public PCObserver {
+
+    public:
+        //! result of a run with one input
+        enum FuzzResult {
+            FUZZ_OK = 0,         //!< input consumed or firmware idle after serial input
+            FUZZ_TIMEOUT,        //!< max. cycles for one input reached
+            FUZZ_EXIT,           //!< firmware stopped by RWExit or exit point
+            FUZZ_ILLEGAL_OPCODE, //!< illegal opcode executed
+            FUZZ_STACK_OVERFLOW, //!< stack pointer below stack limit
+            FUZZ_OUT_OF_FLASH,   //!< PC runs out of flash
+            FUZZ_ABORT,          //!< firmware aborted by RWAbort
+            FUZZ_ERROR           //!< other simulation error
+        };
+
+    protected:
+        AvrDevice *core;                       //!< device under test
+        PCObserver *next;                      //!< replaced observer or NULL
+        std::string branchPoint;               //!< snapshot, on which every run starts
+        unsigned char *coverage;               //!< coverage map
+        unsigned int coverageMask;             //!< size of coverage map - 1
+        std::vector<unsigned char> ownCoverage; //!< own coverage map, if not given from outside
+        unsigned int prevLocation;             //!< hashed previous PC, shifted by 1
+        std::vector<bool> illegalOpcode;       //!< flag for every flash word, true if illegal opcode
+        unsigned long stackLimit;              //!< lowest valid stack pointer value, 0 = no check
+        unsigned long long maxCycles;          //!< max. count of cycles for one run
+        unsigned long long idleCycles;         //!< cycles to run after serial input is sent
+        FuzzSerialSource *serial;              //!< serial source or NULL, if input by register
+        Net *serialNet;                        //!< connects serial source with device pin
+        const unsigned char *input;            //!< current input data
+        size_t inputSize;                      //!< size of current input data
+        size_t inputPos;                       //!< position of next input byte
+        bool inputConsumed;                    //!< firmware has read behind end of input
+        FuzzResult stopReason;                 //!< reason for stop, detected by harness
+        std::string errorMessage;              //!< last simulation error message
+
+        void Stop(FuzzResult reason);
+
+    public:
+        //! Creates a harness for a device, coverageSize must be a power of 2
+        FuzzHarness(AvrDevice *core, unsigned int coverageSize = 65536);
+        virtual ~FuzzHarness();
+
+        //! Replaces register on ioOffset (like option -R) by a RWFuzzInput register
+        void UsePipeInput(unsigned int ioOffset);
+        //! Feeds input as serial data with baudrate to pin of device
+        void UseUartInput(const char *pinName, unsigned long long baudrate);
+        //! Sets max. count of CPU cycles for one run
+        void SetMaxCycles(unsigned long long cycles) { maxCycles = cycles; }
+        //! Sets count of CPU cycles to run after all serial input is sent
+        void SetIdleCycles(unsigned long long cycles) { idleCycles = cycles; }
+        //! Sets lowest valid stack pointer value, 0 disables the check
+        void SetStackLimit(unsigned long limit) { stackLimit = limit; }
+        //! Uses a coverage map from application, size must be a power of 2
+        void SetCoverageMap(unsigned char *map, unsigned int size);
+        //! Uses AFL shared memory map from environment __AFL_SHM_ID, returns true if found
+        bool AttachAFLSharedMemory(void);
+        //! Stores current simulation state as start point for every run
+        void SetBranchPoint(void);
+        //! Runs firmware till PC reaches pc (word address), then sets branch point there
+        /*! So the firmware initialisation runs only once and not for every
+          input. Returns false, if pc isn't reached within max. cycles, the
+          firmware crashed or reads input before. */
+        bool SetBranchPointAt(unsigned int pc);
+
+        //! Runs firmware with input data from branch point, returns result
+        FuzzResult RunInput(const unsigned char *data, size_t size);
+        //! Returns error message of last run, if result was a crash
+        const std::string &GetErrorMessage(void) const { return errorMessage; }
+        //! Returns true, if result is a crash
+        static bool IsCrash(FuzzResult r) { return r >= FUZZ_ILLEGAL_OPCODE; }
+        //! Returns a readable name for a result
+        static const char *ResultName(FuzzResult r);
+
+        //! Returns coverage map
+        unsigned char *GetCoverageMap(void) { return coverage; }
+        //! Returns size of coverage map
+        unsigned int GetCoverageSize(void) const { return coverageMask + 1; }
+        //! Clears coverage map
+        void ClearCoverage(void);
+
+        //! Next input byte for RWFuzzInput, stops run, if input is consumed
+        unsigned char NextInputByte(void);
+
+        void OnExecute(unsigned int pc);
+};
+
+#endif
@@ -27,6 +27,8 @@
 #define HARDWARE
 
 class AvrDevice;
+class SnapshotWriter;
+class SnapshotReader;
 
 /*! Hardware objects are the subsystems of an AVR device. They have a clock and
   reset input and in addition will define various memory registers through
@@ -58,6 +60,14 @@ class Hardware {
         
         /*! Check a level interrupt on the time, where interrupt routine will be called */
         virtual bool LevelInterruptPending(unsigned int vector) { return false; }
+
+        /*! Save internal state of hardware for a snapshot. The default is to
+          save nothing, which is right for hardware without own state. */
+        virtual void SaveState(SnapshotWriter &w) {}
+
+        /*! Restore internal state of hardware from a snapshot, must read
+          exactly the data, which was written by SaveState. */
+        virtual void RestoreState(SnapshotReader &r) {}
         
 };
 
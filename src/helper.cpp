@@ -97,3 +97,26 @@ vector<std::string> split(const std::string &inp, std::string splitc) {
 	out.push_back(cur);
     return out;
 }
+
+bool globmatch(const std::string &pattern, const std::string &str) {
+    size_t p = 0, s = 0;
+    size_t starp = std::string::npos, stars = 0;
+    while(s < str.size()) {
+        if(p < pattern.size() && (pattern[p] == '?' || pattern[p] == str[s])) {
+            p++;
+            s++;
+        } else if(p < pattern.size() && pattern[p] == '*') {
+            // remember position, first try to match nothing
+            starp = p++;
+            stars = s;
+        } else if(starp != std::string::npos) {
+            // let last '*' match one character more
+            p = starp + 1;
+            s = ++stars;
+        } else
+            return false;
+    }
+    while(p < pattern.size() && pattern[p] == '*')
+        p++;
+    return p == pattern.size();
+}
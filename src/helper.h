@@ -62,4 +62,7 @@ std::string readline(std::istream &is);
 
 //! Splits a string into a vector of strings at delimiters splitc
 std::vector<std::string> split(const std::string &inp, std::string splitc="\t\n\r\b ");
+
+//! Matches a string against a glob pattern with '*' and '?' wildcards
+bool globmatch(const std::string &pattern, const std::string &str);
 #endif	
@@ -28,6 +28,7 @@
 #include "irqsystem.h"
 #include "hwad.h"
 #include "hwtimer.h"
+#include "snapshot.h"
 
 HWAcomp::HWAcomp(AvrDevice *core,
                  HWIrqSystem *irqsys,
@@ -90,6 +91,18 @@ void HWAcomp::Reset() {
         acsr |= ACO;
 }
 
+void HWAcomp::SaveState(SnapshotWriter &w) {
+    w.WriteByte(acsr);
+    w.WriteBool(enabled);
+    w.WriteBool(acme_sfior);
+}
+
+void HWAcomp::RestoreState(SnapshotReader &r) {
+    acsr = r.ReadByte();
+    enabled = r.ReadBool();
+    acme_sfior = r.ReadBool();
+}
+
 void HWAcomp::SetAcsr(unsigned char val) {
     unsigned char old = acsr & (ACO|ACI);
     bool old_acic = (acsr & ACIC) == ACIC;
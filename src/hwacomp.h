@@ -100,6 +100,8 @@ class HWAcomp: public Hardware,
         void SetAcsr(unsigned char val);
         //! Reset the unit
         void Reset();
+        void SaveState(SnapshotWriter &w);
+        void RestoreState(SnapshotReader &r);
         //! Reflect irq processing, reset interrupt source
         void ClearIrqFlag(unsigned int vec);
         //! Get informed about input pin change
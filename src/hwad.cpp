@@ -26,6 +26,7 @@
 #include "hwad.h"
 #include "irqsystem.h"
 #include "avrerror.h"
+#include "snapshot.h"
 
 HWARefPin::HWARefPin(AvrDevice *_core):
     HWARef(_core),
@@ -335,6 +336,39 @@ void HWAd::Reset(void) {
     adchLocked = false;
 }
 
+void HWAd::SaveState(SnapshotWriter &w) {
+    w.WriteByte(adch);
+    w.WriteByte(adcl);
+    w.WriteByte(adcsra);
+    w.WriteByte(adcsrb);
+    w.WriteByte(admux);
+    w.WriteBool(adchLocked);
+    w.WriteInt(adSample);
+    w.WriteInt(adMuxConfig);
+    w.WriteInt(prescaler);
+    w.WriteInt(prescalerSelect);
+    w.WriteInt(conversionState);
+    w.WriteBool(firstConversion);
+    w.WriteInt(state);
+}
+
+void HWAd::RestoreState(SnapshotReader &r) {
+    adch = r.ReadByte();
+    adcl = r.ReadByte();
+    adcsra = r.ReadByte();
+    adcsrb = r.ReadByte();
+    admux = r.ReadByte();
+    adchLocked = r.ReadBool();
+    adSample = r.ReadInt();
+    adMuxConfig = r.ReadInt();
+    prescaler = r.ReadInt();
+    prescalerSelect = r.ReadInt();
+    conversionState = r.ReadInt();
+    firstConversion = r.ReadBool();
+    state = (T_State)r.ReadInt();
+    mux->SetMuxSelect((int)admux);
+}
+
 void HWAd::NotifySignalChanged(void) {
     if((notifyClient != NULL) && !IsADEnabled())
         notifyClient->NotifySignalChanged();
@@ -604,4 +638,14 @@ unsigned char HWAd_SFIOR::set_from_reg(const IOSpecialReg* reg, unsigned char nv
     return nv;
 }
 
+void HWAd_SFIOR::SaveState(SnapshotWriter &w) {
+    HWAd::SaveState(w);
+    w.WriteInt(adts);
+}
+
+void HWAd_SFIOR::RestoreState(SnapshotReader &r) {
+    HWAd::RestoreState(r);
+    adts = r.ReadInt();
+}
+
 // EOF
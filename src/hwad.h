@@ -261,6 +261,8 @@ class HWAd: public Hardware, public TraceValueRegister, public AnalogSignalChang
         void SetAdmux(unsigned char val);
         void Reset(void);
         void ClearIrqFlag(unsigned int vec);
+        virtual void SaveState(SnapshotWriter &w);
+        virtual void RestoreState(SnapshotReader &r);
 
         // interface for notify signal change in multiplexer
         void NotifySignalChanged(void);
@@ -289,6 +291,8 @@ class HWAd_SFIOR: public HWAd, public IOSpecialRegClient {
         HWAd_SFIOR(AvrDevice *c, int _typ, HWIrqSystem *i, unsigned int iv, HWAdmux *a, HWARef *r, IOSpecialReg *s);
 
         void Reset(void) { HWAd::Reset(); adts = 0; }
+        void SaveState(SnapshotWriter &w);
+        void RestoreState(SnapshotReader &r);
 
         unsigned char set_from_reg(const IOSpecialReg* reg, unsigned char nv);
         unsigned char get_from_client(const IOSpecialReg* reg, unsigned char v) { return v; }
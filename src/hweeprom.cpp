@@ -28,6 +28,7 @@
 #include "systemclock.h"
 #include "irqsystem.h"
 #include "avrerror.h"
+#include "snapshot.h"
 #include <assert.h>
 
 using namespace std;
@@ -284,6 +285,35 @@ void HWEeprom::ClearIrqFlag(unsigned int vector) {
         irqSystem->ClearIrqFlag(irqVectorNo);
 }
 
+void HWEeprom::SaveState(SnapshotWriter &w) {
+    w.WriteDWord(size);
+    w.WriteBlock(myMemory, size);
+    w.WriteDWord(eear);
+    w.WriteByte(eecr);
+    w.WriteByte(eedr);
+    w.WriteInt(opEnableCycles);
+    w.WriteInt(cpuHoldCycles);
+    w.WriteInt(opState);
+    w.WriteInt(opMode);
+    w.WriteDWord(opAddr);
+    w.WriteTime(writeDoneTime);
+}
+
+void HWEeprom::RestoreState(SnapshotReader &r) {
+    if(r.ReadDWord() != size)
+        avr_error("snapshot: eeprom size doesn't match");
+    r.ReadBlock(myMemory, size);
+    eear = r.ReadDWord();
+    eecr = r.ReadByte();
+    eedr = r.ReadByte();
+    opEnableCycles = r.ReadInt();
+    cpuHoldCycles = r.ReadInt();
+    opState = r.ReadInt();
+    opMode = r.ReadInt();
+    opAddr = r.ReadDWord();
+    writeDoneTime = r.ReadTime();
+}
+
 void HWEeprom::WriteAtAddress(unsigned int addr, unsigned char val) {
     myMemory[addr] = val;
 }
@@ -82,6 +82,8 @@ class HWEeprom: public Hardware, public Memory, public TraceValueRegister {
         virtual unsigned int CpuCycle();
         void Reset();
         void ClearIrqFlag(unsigned int vector);
+        void SaveState(SnapshotWriter &w);
+        void RestoreState(SnapshotReader &r);
 
         void WriteMem(const unsigned char *, unsigned int offset, unsigned int size);
         void WriteAtAddress(unsigned int, unsigned char);
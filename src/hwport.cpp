@@ -29,6 +29,7 @@ using namespace std;
 #include "hwport.h"
 #include "avrdevice.h"
 #include "avrerror.h"
+#include "snapshot.h"
 #include <assert.h>
 
 HWPort::HWPort(AvrDevice *core, const string &name, bool portToggle, int size):
@@ -84,7 +85,31 @@ void HWPort::Reset(void) {
     useAlternatePort = 0;
 
     useAlternatePortIfDdrSet = 0;
-    
+
+    outputsValid = false;
+    CalcOutputs();
+}
+
+void HWPort::SaveState(SnapshotWriter &w) {
+    w.WriteByte(port);
+    w.WriteByte(ddr);
+    w.WriteByte(alternateDdr);
+    w.WriteByte(useAlternateDdr);
+    w.WriteByte(alternatePort);
+    w.WriteByte(useAlternatePort);
+    w.WriteByte(useAlternatePortIfDdrSet);
+}
+
+void HWPort::RestoreState(SnapshotReader &r) {
+    port = r.ReadByte();
+    ddr = r.ReadByte();
+    alternateDdr = r.ReadByte();
+    useAlternateDdr = r.ReadByte();
+    alternatePort = r.ReadByte();
+    useAlternatePort = r.ReadByte();
+    useAlternatePortIfDdrSet = r.ReadByte();
+    // pin register is calculated from output and external pin states
+    outputsValid = false;
     CalcOutputs();
 }
 
@@ -101,49 +126,52 @@ void HWPort::CalcPin(void) {
 }
 
 void HWPort::CalcOutputs(void) { // Calculate the new output value to be transmitted to the environment
-    for(unsigned int actualBitNo = 0; actualBitNo < portSize; actualBitNo++) {
-        unsigned char actualBit = 1 << actualBitNo;
-        unsigned char workingPort = 0;
-        unsigned char workingDdr = 0;
-
-        if(useAlternatePortIfDdrSet & actualBit) {
-            if(ddr & actualBit) {
-                workingPort |= alternatePort & actualBit;
-                workingDdr |= actualBit;
-            } else
-                workingPort |= port & actualBit;
-        } else {
-            if(useAlternateDdr & actualBit)
-                workingDdr |= alternateDdr & actualBit;
-            else
-                workingDdr |= ddr & actualBit;
+    // all 8 bits at once: OCR outputs (useAlternatePortIfDdrSet) use alternate port only, if ddr is set,
+    // all other bits take alternate ddr / port, if selected by useAlternateDdr / useAlternatePort
+    unsigned char ifDdr = useAlternatePortIfDdrSet;
+    unsigned char workingDdr = (ifDdr & ddr) |
+                               (~ifDdr & ((useAlternateDdr & alternateDdr) | (~useAlternateDdr & ddr)));
+    unsigned char selectAlternate = (ifDdr & ddr) | (~ifDdr & useAlternatePort);
+    unsigned char workingPort = (selectAlternate & alternatePort) | (~selectAlternate & port);
+
+    if(!outputsValid) {
+        // first calculation after reset or restore: set all pins
+        outputsValid = true;
+        outDdr = workingDdr;
+        outPort = workingPort;
+        for(unsigned int tt = 0; tt < portSize; tt++)
+            SetOutState(tt);
+        CalcPin(); // now transfer the result also to all HWPort::pin instances
+        return;
+    }
 
-            if(useAlternatePort & actualBit)
-                workingPort |= alternatePort & actualBit;
+    // only pins with changed output stage are updated
+    unsigned char changed = ((workingDdr ^ outDdr) | (workingPort ^ outPort)) & portMask;
+    if(changed == 0)
+        return;
+    outDdr = workingDdr;
+    outPort = workingPort;
+    for(unsigned int tt = 0; changed != 0; tt++, changed >>= 1) {
+        if(changed & 1) {
+            SetOutState(tt);
+            // input value of not changed pins is set by Pin::SetInState, if necessary
+            if(p[tt].CalcPin())
+                pin |= (1 << tt);
             else
-                workingPort |= port & actualBit;
-        }
-
-        if(workingDdr & actualBit) { // DDR is set to output (1)
-            if(workingPort & actualBit) { // Port is High
-                p[actualBitNo].outState = Pin::HIGH;
-                pintrace[actualBitNo]->change(Pin::HIGH);
-            } else {
-                p[actualBitNo].outState = Pin::LOW;
-                pintrace[actualBitNo]->change(Pin::LOW);
-            }
-        } else { // DDR is input (0)
-            if(workingPort & actualBit) {
-                p[actualBitNo].outState = Pin::PULLUP;
-                pintrace[actualBitNo]->change(Pin::PULLUP);
-            } else {
-                p[actualBitNo].outState = Pin::TRISTATE;
-                pintrace[actualBitNo]->change(Pin::TRISTATE);
-            }
+                pin &= ~(1 << tt);
         }
     }
-    
-    CalcPin(); // now transfer the result also to all HWPort::pin instances
+}
+
+void HWPort::SetOutState(unsigned int bitNo) {
+    unsigned char bit = 1 << bitNo;
+    Pin::T_Pinstate state;
+    if(outDdr & bit) // DDR is set to output (1)
+        state = (outPort & bit) ? Pin::HIGH : Pin::LOW;
+    else // DDR is input (0)
+        state = (outPort & bit) ? Pin::PULLUP : Pin::TRISTATE;
+    p[bitNo].outState = state;
+    pintrace[bitNo]->change(state);
 }
 
 string HWPort::GetPortString(void) {
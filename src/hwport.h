@@ -44,6 +44,7 @@ class HWPort: public Hardware, public TraceValueRegister {
     
     private:
         void CalcPin(void); //!< calculating the value for register "pin" from the Pin p[] array
+        void SetOutState(unsigned int bitNo); //!< set output stage of a pin from outDdr and outPort
         
     protected:
         std::string myName; //!< the "name" of the port
@@ -61,6 +62,10 @@ class HWPort: public Hardware, public TraceValueRegister {
         /*! special case for the ocr1a&b is selected on pin, which only be send
           to pin if ddr is set to output */
         unsigned char useAlternatePortIfDdrSet; 
+
+        unsigned char outDdr;  //!< resulting data direction of pins on last CalcOutputs
+        unsigned char outPort; //!< resulting output value of pins on last CalcOutputs
+        bool outputsValid;     //!< false, if all pins have to be set on next CalcOutputs
         
         Pin p[8]; //!< the port pins, e.g. the final IO stages
         TraceValue* pintrace[8]; //!< trace channel to trace output driver state
@@ -72,9 +77,14 @@ class HWPort: public Hardware, public TraceValueRegister {
         HWPort(AvrDevice *core, const std::string &name, bool portToggle = false, int size = 8);
         ~HWPort();
         
-        void CalcOutputs(void);  //!< Calculate the new output value to be transmitted to the environment
+        //! Calculate the new output value to be transmitted to the environment
+        /*! Working ddr and port are calculated for all bits at once, only pins with
+          a changed output stage are set and propagated to their net. */
+        void CalcOutputs(void);
         std::string GetPortString(void); //!< returns a string representation of output states
         void Reset(void);
+        void SaveState(SnapshotWriter &w);
+        void RestoreState(SnapshotReader &r);
         std::string GetName(void) { return myName; } //!< returns the port name as given in constructor
         Pin& GetPin(unsigned char pinNo); //!< returns a pin reference of pin with pin number
         int GetPortSize(void) { return portSize; } //!< returns, how much bits this port controls
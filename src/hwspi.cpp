@@ -32,6 +32,7 @@
 #include "traceval.h"
 #include "irqsystem.h"
 #include "avrerror.h"
+#include "snapshot.h"
 
 //configuration
 #define SPIE 0x80
@@ -88,6 +89,7 @@ void HWSpi::SetSPDR(unsigned char val) {
             bitcnt=0;
             finished=false;
             clkcnt=0;
+            byteTransfer=(!pinLevel && slaves.size() && !hasPinListeners());
         }
     }
 }
@@ -150,6 +152,7 @@ void HWSpi::SetSPCR(unsigned char val) {
        the switch on/off behaviour of the SPI interface! */
         bitcnt=8;
         finished=false;
+        byteTransfer=false;
         core->RemoveFromCycleList(this);
         MOSI.SetUseAlternatePortIfDdrSet(0);
         MISO.SetUseAlternatePortIfDdrSet(0);
@@ -182,6 +185,8 @@ HWSpi::HWSpi(AvrDevice *_c,
     irq->DebugVerifyInterruptVector(ivec, this);
     bitcnt=8;
     finished=false;
+    pinLevel=false;
+    byteTransfer=false;
 
     // register pins
     core->RegisterPin("MOSI",&MOSI.GetPin());
@@ -202,6 +207,93 @@ void HWSpi::Reset() {
     data_write=data_read=shift_in=0;
 }
 
+void HWSpi::SaveState(SnapshotWriter &w) {
+    w.WriteByte(shift_in);
+    w.WriteByte(data_read);
+    w.WriteByte(data_write);
+    w.WriteByte(spsr);
+    w.WriteByte(spcr);
+    w.WriteInt(clkdiv);
+    w.WriteBool(spsr_read);
+    w.WriteBool(oldsck);
+    w.WriteInt(bitcnt);
+    w.WriteDWord(clkcnt);
+    w.WriteInt(spi_cycles);
+    w.WriteBool(finished);
+    w.WriteBool(byteTransfer);
+}
+
+void HWSpi::RestoreState(SnapshotReader &r) {
+    shift_in = r.ReadByte();
+    data_read = r.ReadByte();
+    data_write = r.ReadByte();
+    spsr = r.ReadByte();
+    spcr = r.ReadByte();
+    clkdiv = r.ReadInt();
+    spsr_read = r.ReadBool();
+    oldsck = r.ReadBool();
+    bitcnt = r.ReadInt();
+    clkcnt = r.ReadDWord();
+    spi_cycles = r.ReadInt();
+    finished = r.ReadBool();
+    byteTransfer = r.ReadBool();
+}
+
+void HWSpi::AttachSlave(SpiSlave *s) {
+    slaves.push_back(s);
+}
+
+void HWSpi::DetachSlave(SpiSlave *s) {
+    for(std::vector<SpiSlave *>::iterator i = slaves.begin(); i != slaves.end(); i++) {
+        if(*i == s) {
+            slaves.erase(i);
+            break;
+        }
+    }
+    if(slaves.size() == 0)
+        byteTransfer = false;
+}
+
+//! Reverses bit order of a byte for DORD=1
+static unsigned char reverseBits(unsigned char b) {
+    b = ((b & 0xf0) >> 4) | ((b & 0x0f) << 4);
+    b = ((b & 0xcc) >> 2) | ((b & 0x33) << 2);
+    return ((b & 0xaa) >> 1) | ((b & 0x55) << 1);
+}
+
+void HWSpi::byteExchange() {
+    bool lsbFirst = (spcr & DORD) != 0;
+    unsigned char out = lsbFirst ? reverseBits(data_write) : data_write;
+    for(size_t i = 0; i < slaves.size(); i++) {
+        if(slaves[i]->IsSelected()) {
+            unsigned char in = slaves[i]->Transfer(out);
+            shift_in = lsbFirst ? reverseBits(in) : in;
+        }
+    }
+}
+
+bool HWSpi::hasPinListeners() {
+    Pin *pins[2] = { &MOSI.GetPin(), &SCK.GetPin() };
+    for(int i = 0; i < 2; i++) {
+        Net *net = pins[i]->GetNet();
+        if(net == NULL)
+            continue;
+        for(size_t j = 0; j < net->size(); j++) {
+            Pin *p = (*net)[j];
+            if(p == pins[i])
+                continue;
+            bool own = false;
+            for(size_t k = 0; k < slaves.size(); k++) {
+                if(slaves[k]->OwnsPin(p))
+                    own = true;
+            }
+            if(!own)
+                return true;
+        }
+    }
+    return false;
+}
+
 void HWSpi::ClearIrqFlag(unsigned int vector) {
     if (vector==irq_vector) {
         spsr&=~SPIF;
@@ -265,6 +357,22 @@ unsigned int HWSpi::CpuCycle() {
             bitcnt = 8; // slave and idle
             finished=false;
                 clkcnt=0;
+            byteTransfer=false;
+        }
+        if (byteTransfer) {
+            // byte wise transfer with slaves, pins stay idle, the byte
+            // is exchanged after the same 16 SPI clock phases
+            if (clkcnt == (unsigned)(16*clkdiv)) {
+                // without a selected slave, the level on MISO is shifted in
+                shift_in = MISO ? 0xff : 0x00;
+                byteExchange();
+                bitcnt=8;
+                finished=true;
+                byteTransfer=false;
+                trxend();
+            }
+            clkcnt++;
+            return 0;
         }
         if ((clkcnt%clkdiv) == 0){ // TRX bits
             if (bitcnt < 8) {
@@ -299,6 +407,10 @@ unsigned int HWSpi::CpuCycle() {
                 if (spcr&CPHA) {
                     rxbit(bitpos_prec);
                 }
+                // pins are driven for other listeners, attached slaves get
+                // the byte nevertheless
+                if (slaves.size())
+                    byteExchange();
                 trxend();
                 // set idle clock
                 SCK.SetAlternatePort(spcr&CPOL);
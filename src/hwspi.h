@@ -30,6 +30,9 @@
 #include "pinatport.h"
 #include "rwmem.h"
 #include "traceval.h"
+#include "spislave.h"
+
+#include <vector>
 
 class AvrDevice;
 class HWIrqSystem;
@@ -87,6 +90,19 @@ class HWSpi: public Hardware, public TraceValueRegister {
     
         //! finished transmission?
         bool finished;
+
+        //! slaves, which get whole bytes in master mode
+        std::vector<SpiSlave *> slaves;
+        //! simulate SCK and MOSI bit by bit, even if slaves are attached
+        bool pinLevel;
+        //! current master transfer is done byte wise with slaves
+        bool byteTransfer;
+
+        //! Exchanges data_write with the selected slave at end of a byte transfer
+        /*! shift_in is only changed, if a slave is selected. */
+        void byteExchange();
+        //! Returns true, if a pin, which isn't from device or a slave, is on SCK or MOSI net
+        bool hasPinListeners();
         
         //! Send/receive one bit 
         void txbit(const int bitpos);
@@ -110,6 +126,8 @@ class HWSpi: public Hardware, public TraceValueRegister {
         
         unsigned int CpuCycle();
         void Reset();
+        void SaveState(SnapshotWriter &w);
+        void RestoreState(SnapshotReader &r);
     
         void SetSPDR(unsigned char val);
         void SetSPSR(unsigned char val); // it is read only! but we need it for rwmem-> only tell that we have an error 
@@ -120,6 +138,20 @@ class HWSpi: public Hardware, public TraceValueRegister {
         unsigned char GetSPCR();
     
         void ClearIrqFlag(unsigned int);
+
+        //! Attaches a slave, which exchanges whole bytes in master mode
+        /*! After the transfer time of a byte, the selected slave gets the byte
+          by SpiSlave::Transfer. If there are no other pins on SCK and MOSI nets
+          (see SpiSlave::OwnsPin) and SetPinLevel isn't set, master transfers
+          don't change SCK and MOSI pins and, if no slave is selected, the MISO
+          level is read in. Otherwise the pins are driven bit by bit as
+          without a slave. Pin change interrupts of the device on SCK or MOSI
+          don't count, they aren't raised for byte transfers. */
+        void AttachSlave(SpiSlave *s);
+        //! Detaches a slave
+        void DetachSlave(SpiSlave *s);
+        //! Forces bit by bit transfers on pins, for instance to see them in a trace
+        void SetPinLevel(bool on) { pinLevel = on; }
     
         IOReg<HWSpi> spdr_reg,
                      spsr_reg,
@@ -27,6 +27,8 @@
 #include "avrerror.h"
 #include "avrmalloc.h"
 #include "flash.h"
+#include "irqsystem.h"
+#include "snapshot.h"
 #include <assert.h>
 #include <cstdio>  // NULL
 
@@ -34,6 +36,7 @@ using namespace std;
 
 HWStack::HWStack(AvrDevice *c):
     core(c),
+    irqReturnCount(0),
     m_ThreadList(*c)
 {
     Reset();
@@ -41,11 +44,24 @@ HWStack::HWStack(AvrDevice *c):
 
 void HWStack::Reset(void) {
     returnPointList.clear();
+    InitIrqReturnPoints(irqReturnPoints.size());
     stackPointer = 0;
     lowestStackPointer = 0;
 }
 
-void HWStack::CheckReturnPoints() {
+void HWStack::InitIrqReturnPoints(unsigned long size) {
+    irqReturnPoints.assign(size, 0);
+    irqReturnCount = 0;
+}
+
+void HWStack::RunReturnPoints() {
+    if(irqReturnCount != 0 && stackPointer < irqReturnPoints.size() && irqReturnPoints[stackPointer] != 0) {
+        unsigned int vector = irqReturnPoints[stackPointer] - 1;
+        irqReturnPoints[stackPointer] = 0;
+        irqReturnCount--;
+        core->irqSystem->IrqHandlerFinished(vector);
+    }
+
     typedef multimap<unsigned long, Funktor *>::iterator I;
     pair<I,I> l = returnPointList.equal_range(stackPointer);
     
@@ -60,6 +76,58 @@ void HWStack::SetReturnPoint(unsigned long stackPointer, Funktor *f) {
     returnPointList.insert(make_pair(stackPointer, f));
 }
 
+void HWStack::SetIrqReturnPoint(unsigned long stackPointer, unsigned int vector) {
+    if(stackPointer < irqReturnPoints.size() && irqReturnPoints[stackPointer] == 0) {
+        irqReturnPoints[stackPointer] = vector + 1;
+        irqReturnCount++;
+    } else // address is used already (by a other stack), needs a listener
+        SetReturnPoint(stackPointer, new IrqFunktor(core->irqSystem, &HWIrqSystem::IrqHandlerFinished, vector));
+}
+
+void HWStack::SaveState(SnapshotWriter &w) {
+    w.WriteDWord(stackPointer);
+    w.WriteDWord(lowestStackPointer);
+
+    // only interrupt return points can be restored, other listeners
+    // belong to the application, which has to set them again
+    typedef multimap<unsigned long, Funktor *>::iterator I;
+    unsigned long cnt = irqReturnCount;
+    for(I i = returnPointList.begin(); i != returnPointList.end(); i++)
+        if(dynamic_cast<IrqFunktor *>(i->second) != NULL)
+            cnt++;
+    w.WriteDWord(cnt);
+    for(unsigned long sp = 0; sp < irqReturnPoints.size(); sp++) {
+        if(irqReturnPoints[sp] != 0) {
+            w.WriteDWord(sp);
+            w.WriteDWord(irqReturnPoints[sp] - 1);
+        }
+    }
+    for(I i = returnPointList.begin(); i != returnPointList.end(); i++) {
+        IrqFunktor *f = dynamic_cast<IrqFunktor *>(i->second);
+        if(f != NULL) {
+            w.WriteDWord(i->first);
+            w.WriteDWord(f->GetVector());
+        }
+    }
+}
+
+void HWStack::RestoreState(SnapshotReader &r) {
+    stackPointer = r.ReadDWord();
+    lowestStackPointer = r.ReadDWord();
+
+    typedef multimap<unsigned long, Funktor *>::iterator I;
+    for(I i = returnPointList.begin(); i != returnPointList.end(); i++)
+        delete i->second;
+    returnPointList.clear();
+    InitIrqReturnPoints(irqReturnPoints.size());
+    unsigned long cnt = r.ReadDWord();
+    for(unsigned long i = 0; i < cnt; i++) {
+        unsigned long sp = r.ReadDWord();
+        unsigned int vector = r.ReadDWord();
+        SetIrqReturnPoint(sp, vector);
+    }
+}
+
 HWStackSram::HWStackSram(AvrDevice *c, int bs, bool initRE):
     HWStack(c),
     TraceValueRegister(c, "STACK"),
@@ -70,11 +138,13 @@ HWStackSram::HWStackSram(AvrDevice *c, int bs, bool initRE):
             this, &HWStackSram::GetSpl, &HWStackSram::SetSpl)
 {
     stackCeil = 1 << bs;  // TODO: The number of bits is unable to acurately represent 0x460 ceiling of ATmega8: has 1024 B RAM (0x400) and 32+64 (0x60) registers.
+    InitIrqReturnPoints(stackCeil);
     Reset();
 }
 
 void HWStackSram::Reset() {
     returnPointList.clear();
+    InitIrqReturnPoints(irqReturnPoints.size());
     if(initRAMEND)
         stackPointer = core->GetMemIRamSize() +
                        core->GetMemIOSize() +
@@ -84,6 +154,12 @@ void HWStackSram::Reset() {
     lowestStackPointer = stackPointer;
 }
 
+void HWStackSram::RestoreState(SnapshotReader &r) {
+    HWStack::RestoreState(r);
+    spl_reg.hardwareChange(stackPointer & 0x0000ff);
+    sph_reg.hardwareChange((stackPointer & 0x00ff00)>>8);
+}
+
 void HWStackSram::Push(unsigned char val) {
     core->SetRWMem(stackPointer, val);
     stackPointer--;
@@ -189,6 +265,7 @@ ThreeLevelStack::ThreeLevelStack(AvrDevice *c):
     TraceValueRegister(c, "STACK") {
     stackArea = avr_new(unsigned long, 3);
     trace_direct(this, "PTR", &stackPointer);
+    InitIrqReturnPoints(4);
     Reset();
 }
 
@@ -198,10 +275,23 @@ ThreeLevelStack::~ThreeLevelStack() {
 
 void ThreeLevelStack::Reset(void) {
     returnPointList.clear();
+    InitIrqReturnPoints(irqReturnPoints.size());
     stackPointer = 3;
     lowestStackPointer = stackPointer;
 }
 
+void ThreeLevelStack::SaveState(SnapshotWriter &w) {
+    HWStack::SaveState(w);
+    for(int i = 0; i < 3; i++)
+        w.WriteDWord(stackArea[i]);
+}
+
+void ThreeLevelStack::RestoreState(SnapshotReader &r) {
+    HWStack::RestoreState(r);
+    for(int i = 0; i < 3; i++)
+        stackArea[i] = r.ReadDWord();
+}
+
 void ThreeLevelStack::Push(unsigned char val) {
     avr_error("Push method isn't available on TreeLevelStack");
 }
@@ -236,7 +326,8 @@ unsigned long ThreeLevelStack::PopAddr() {
 }
 
 ThreadList::ThreadList(AvrDevice & core)
-	: m_core(core)
+	: m_core(core),
+	  m_enabled(false)
 {
 	m_phase_of_switch = eNormal;
 	m_last_SP_read = 0x0000;
@@ -262,7 +353,7 @@ void ThreadList::OnReset()
 	m_threads.resize(0);
 }
 
-void ThreadList::OnCall()
+void ThreadList::TrackCall()
 {
 	m_on_call_sp = m_core.stack->GetStackPointer();
 	assert(m_on_call_sp != 0x0000);
@@ -273,7 +364,7 @@ void ThreadList::OnCall()
 	}
 }
 
-void ThreadList::OnSPRead(int SP_value)
+void ThreadList::TrackSPRead(int SP_value)
 {
 	assert(0 <= SP_value && SP_value <= 0xFFFF);
 	assert(0 != SP_value);  // SP must not point to register area
@@ -281,7 +372,7 @@ void ThreadList::OnSPRead(int SP_value)
 	m_last_SP_read = SP_value;
 }
 
-void ThreadList::OnSPWrite( int new_SP )
+void ThreadList::TrackSPWrite( int new_SP )
 {
 	if( ! m_core.Flash->LooksLikeContextSwitch(m_core.PC*2))
 		return;
@@ -289,14 +380,14 @@ void ThreadList::OnSPWrite( int new_SP )
 	m_last_SP_writen = new_SP;
 }
 
-void ThreadList::OnPush()
+void ThreadList::TrackPush()
 {
 	m_phase_of_switch = eNormal;
 	m_last_SP_read = 0x0000;
 	m_last_SP_writen = 0x0000;
 }
 
-void ThreadList::OnPop()
+void ThreadList::TrackPop()
 {
 	if(m_phase_of_switch != eWritten2)
 	{
@@ -32,6 +32,7 @@
 #include "traceval.h"
 
 #include <map>
+#include <vector>
 
 /** A thread automatically detected in simulated program.
 * We keep track of them in core->stack.m_ThreadList.m_threads[] and
@@ -65,18 +66,27 @@ class ThreadList
     /// Currently running thread. (Thread index used for querying by GDB is in GdbServer.)
     int m_cur_thread;
     AvrDevice & m_core;
+    bool m_enabled;  ///< thread detection is done, see SetEnabled
 
     ThreadList& operator=(const ThreadList&);  // not assignable
+    void TrackCall();
+    void TrackSPRead(int SP_value);
+    void TrackSPWrite(int new_SP);
+    void TrackPush();
+    void TrackPop();
 public:
 
     ThreadList(AvrDevice & core);
     ~ThreadList();
     void OnReset();
-    void OnCall();
-    void OnSPRead(int SP_value);
-    void OnSPWrite(int new_SP);
-    void OnPush();
-    void OnPop();
+    /// Switches thread detection on or off. Off by default, a debugger has to switch it on.
+    void SetEnabled(bool on) { m_enabled = on; }
+    bool IsEnabled() const { return m_enabled; }
+    void OnCall() { if(m_enabled) TrackCall(); }
+    void OnSPRead(int SP_value) { if(m_enabled) TrackSPRead(SP_value); }
+    void OnSPWrite(int new_SP) { if(m_enabled) TrackSPWrite(new_SP); }
+    void OnPush() { if(m_enabled) TrackPush(); }
+    void OnPop() { if(m_enabled) TrackPop(); }
     int GetThreadBySP(int SP) const;  ///< Search threads
 
     int GetCurrentThreadForGDB() const;  ///< Get GDB-style thread ID (the first is 1)
@@ -95,9 +105,18 @@ class HWStack {
         uint32_t stackPointer; //!< current value of stack pointer
         uint32_t lowestStackPointer; //!< marker: lowest stackpointer used by program
         std::multimap<unsigned long, Funktor*> returnPointList; //!< Maps adresses to listeners for return addresses
+        /// Interrupt vector + 1 for every stack address, on which a interrupt handler returns, or 0
+        std::vector<unsigned short> irqReturnPoints;
+        unsigned int irqReturnCount; //!< count of set entries in irqReturnPoints
 
         /// Run functions registered for current stack address and delete them
-        void CheckReturnPoints();
+        void CheckReturnPoints() {
+            if(irqReturnCount != 0 || !returnPointList.empty())
+                RunReturnPoints();
+        }
+        void RunReturnPoints();
+        //! Sets size of irqReturnPoints to count of stack addresses and clears it
+        void InitIrqReturnPoints(unsigned long size);
         
     public:
         ThreadList m_ThreadList;  ///< List of known threads created within target.
@@ -120,11 +139,19 @@ class HWStack {
         /*! Attention! SetReturnPoint must get a COPY of a Funktor because it
             self destroy this functor after usage! */
         void SetReturnPoint(unsigned long stackPointer, Funktor *listener);
+        //! Calls HWIrqSystem::IrqHandlerFinished for vector, if stack pointer comes back to stackPointer
+        /*! Same as SetReturnPoint with a IrqFunktor, but without allocation. */
+        void SetIrqReturnPoint(unsigned long stackPointer, unsigned int vector);
         
         //! Sets lowest stack marker back to current stackpointer
         void ResetLowestStackpointer(void) { lowestStackPointer = stackPointer; }
         //! Gets back the lowest stack pointer (for measuring stack usage)
         unsigned long GetLowestStackpointer(void) { return lowestStackPointer; }
+
+        //! Save stack pointer and pending interrupt return points for a snapshot
+        virtual void SaveState(SnapshotWriter &w);
+        //! Restore stack pointer and interrupt return points from a snapshot
+        virtual void RestoreState(SnapshotReader &r);
 };
 
 //! Implements a stack with stack register using RAM as stackarea
@@ -150,6 +177,7 @@ class HWStackSram: public HWStack, public TraceValueRegister {
         virtual unsigned long PopAddr();
 
         virtual void Reset();
+        virtual void RestoreState(SnapshotReader &r);
         
         IOReg<HWStackSram> sph_reg;
         IOReg<HWStackSram> spl_reg;
@@ -171,6 +199,8 @@ class ThreeLevelStack: public HWStack, public TraceValueRegister {
         virtual unsigned long PopAddr();
 
         virtual void Reset();
+        virtual void SaveState(SnapshotWriter &w);
+        virtual void RestoreState(SnapshotReader &r);
 };
 
 #endif
@@ -29,6 +29,7 @@
 #include "hwtimer.h"
 #include "../helper.h"
 #include "systemclock.h"
+#include "snapshot.h"
 
 #include <cstdlib>
 #include <time.h>
@@ -562,6 +563,57 @@ void BasicTimerUnit::Reset() {
     icapNoiseCanceler = false;
 }
 
+void BasicTimerUnit::SaveState(SnapshotWriter &w) {
+    w.WriteInt(cs);
+    w.WriteBool(captureInputState);
+    w.WriteInt(icapNCcounter);
+    w.WriteBool(icapNCstate);
+    w.WriteDWord(vtcnt);
+    w.WriteDWord(vlast_tcnt);
+    w.WriteInt(updown_counting);
+    w.WriteBool(count_down);
+    w.WriteDWord(limit_bottom);
+    w.WriteDWord(limit_top);
+    w.WriteDWord(limit_max);
+    w.WriteDWord(icapRegister);
+    w.WriteBool(icapRisingEdge);
+    w.WriteBool(icapNoiseCanceler);
+    w.WriteInt(wgm);
+    for(int i = 0; i < OCRIDX_maxUnits; i++) {
+        w.WriteDWord(compare[i]);
+        w.WriteDWord(compare_dbl[i]);
+        w.WriteBool(compareEnable[i]);
+        w.WriteInt(com[i]);
+        w.WriteBool(compare_output_state[i]);
+    }
+}
+
+void BasicTimerUnit::RestoreState(SnapshotReader &r) {
+    cs = r.ReadInt();
+    captureInputState = r.ReadBool();
+    icapNCcounter = r.ReadInt();
+    icapNCstate = r.ReadBool();
+    vtcnt = r.ReadDWord();
+    vlast_tcnt = r.ReadDWord();
+    updown_counting = r.ReadInt();
+    count_down = r.ReadBool();
+    limit_bottom = r.ReadDWord();
+    limit_top = r.ReadDWord();
+    limit_max = r.ReadDWord();
+    icapRegister = r.ReadDWord();
+    icapRisingEdge = r.ReadBool();
+    icapNoiseCanceler = r.ReadBool();
+    wgm = (WGMtype)r.ReadInt();
+    for(int i = 0; i < OCRIDX_maxUnits; i++) {
+        compare[i] = r.ReadDWord();
+        compare_dbl[i] = r.ReadDWord();
+        compareEnable[i] = r.ReadBool();
+        com[i] = (COMtype)r.ReadInt();
+        compare_output_state[i] = r.ReadBool();
+    }
+    counterTrace->change(vtcnt);
+}
+
 unsigned int BasicTimerUnit::CpuCycle() {
     if(premx->isClock(cs))
         CountTimer();
@@ -766,6 +818,16 @@ void HWTimer16::Reset(void) {
     accessTempRegister = 0;
 }
 
+void HWTimer16::SaveState(SnapshotWriter &w) {
+    BasicTimerUnit::SaveState(w);
+    w.WriteByte(accessTempRegister);
+}
+
+void HWTimer16::RestoreState(SnapshotReader &r) {
+    BasicTimerUnit::RestoreState(r);
+    accessTempRegister = r.ReadByte();
+}
+
 void HWTimer16::SetCompareRegister(int idx, bool high, unsigned char val) {
     unsigned long temp;
     if(high) {
@@ -932,6 +994,16 @@ void HWTimer8_0C::Reset() {
     tccr_val = 0;
 }
 
+void HWTimer8_0C::SaveState(SnapshotWriter &w) {
+    BasicTimerUnit::SaveState(w);
+    w.WriteByte(tccr_val);
+}
+
+void HWTimer8_0C::RestoreState(SnapshotReader &r) {
+    BasicTimerUnit::RestoreState(r);
+    tccr_val = r.ReadByte();
+}
+
 HWTimer8_1C::HWTimer8_1C(AvrDevice *core,
                          PrescalerMultiplexer *p,
                          int unit,
@@ -967,6 +1039,16 @@ void HWTimer8_1C::Reset() {
     tccr_val = 0;
 }
 
+void HWTimer8_1C::SaveState(SnapshotWriter &w) {
+    BasicTimerUnit::SaveState(w);
+    w.WriteByte(tccr_val);
+}
+
+void HWTimer8_1C::RestoreState(SnapshotReader &r) {
+    BasicTimerUnit::RestoreState(r);
+    tccr_val = r.ReadByte();
+}
+
 HWTimer8_2C::HWTimer8_2C(AvrDevice *core,
                          PrescalerMultiplexer *p,
                          int unit,
@@ -1037,6 +1119,20 @@ void HWTimer8_2C::Reset() {
     wgm_raw = 0;
 }
 
+void HWTimer8_2C::SaveState(SnapshotWriter &w) {
+    BasicTimerUnit::SaveState(w);
+    w.WriteInt(wgm_raw);
+    w.WriteByte(tccra_val);
+    w.WriteByte(tccrb_val);
+}
+
+void HWTimer8_2C::RestoreState(SnapshotReader &r) {
+    BasicTimerUnit::RestoreState(r);
+    wgm_raw = r.ReadInt();
+    tccra_val = r.ReadByte();
+    tccrb_val = r.ReadByte();
+}
+
 HWTimer16_1C::HWTimer16_1C(AvrDevice *core,
                            PrescalerMultiplexer *p,
                            int unit,
@@ -1100,6 +1196,20 @@ void HWTimer16_1C::Reset() {
     wgm_raw = 0;
 }
 
+void HWTimer16_1C::SaveState(SnapshotWriter &w) {
+    HWTimer16::SaveState(w);
+    w.WriteInt(wgm_raw);
+    w.WriteByte(tccra_val);
+    w.WriteByte(tccrb_val);
+}
+
+void HWTimer16_1C::RestoreState(SnapshotReader &r) {
+    HWTimer16::RestoreState(r);
+    wgm_raw = r.ReadInt();
+    tccra_val = r.ReadByte();
+    tccrb_val = r.ReadByte();
+}
+
 HWTimer16_2C2::HWTimer16_2C2(AvrDevice *core,
                              PrescalerMultiplexer *p,
                              int unit,
@@ -1181,6 +1291,20 @@ void HWTimer16_2C2::Reset() {
     wgm_raw = 0;
 }
 
+void HWTimer16_2C2::SaveState(SnapshotWriter &w) {
+    HWTimer16::SaveState(w);
+    w.WriteInt(wgm_raw);
+    w.WriteByte(tccra_val);
+    w.WriteByte(tccrb_val);
+}
+
+void HWTimer16_2C2::RestoreState(SnapshotReader &r) {
+    HWTimer16::RestoreState(r);
+    wgm_raw = r.ReadInt();
+    tccra_val = r.ReadByte();
+    tccrb_val = r.ReadByte();
+}
+
 HWTimer16_2C3::HWTimer16_2C3(AvrDevice *core,
                              PrescalerMultiplexer *p,
                              int unit,
@@ -1241,6 +1365,18 @@ void HWTimer16_2C3::Reset() {
     tccrb_val = 0;
 }
 
+void HWTimer16_2C3::SaveState(SnapshotWriter &w) {
+    HWTimer16::SaveState(w);
+    w.WriteByte(tccra_val);
+    w.WriteByte(tccrb_val);
+}
+
+void HWTimer16_2C3::RestoreState(SnapshotReader &r) {
+    HWTimer16::RestoreState(r);
+    tccra_val = r.ReadByte();
+    tccrb_val = r.ReadByte();
+}
+
 HWTimer16_3C::HWTimer16_3C(AvrDevice *core,
                            PrescalerMultiplexer *p,
                            int unit,
@@ -1307,6 +1443,18 @@ void HWTimer16_3C::Reset() {
     tccrb_val = 0;
 }
 
+void HWTimer16_3C::SaveState(SnapshotWriter &w) {
+    HWTimer16::SaveState(w);
+    w.WriteByte(tccra_val);
+    w.WriteByte(tccrb_val);
+}
+
+void HWTimer16_3C::RestoreState(SnapshotReader &r) {
+    HWTimer16::RestoreState(r);
+    tccra_val = r.ReadByte();
+    tccrb_val = r.ReadByte();
+}
+
 //! Step time in ns for async clock by pll
 /*! Because system clock steps are counted in ns, we have to calculate so many steps to get
  * over all steps a time in ns without fraction. For 64MHz, e.g. 15,625 ns period, this step
@@ -1412,6 +1560,108 @@ void HWTimerTinyX5::Reset() {
     SetPrescalerClock(false); // reset prescaler to sync. clock mode, if necessary!
 }
 
+void HWTimerTinyX5::SaveState(SnapshotWriter &w) {
+    w.WriteDWord(counter);
+    w.WriteDWord(prescaler);
+    w.WriteByte(dtprescaler);
+
+    tccr_inout_val.SaveState(w);
+    ocra_inout_val.SaveState(w);
+    ocrb_inout_val.SaveState(w);
+    ocrc_inout_val.SaveState(w);
+    gtccr_in_val.SaveState(w);
+    w.WriteByte(dtps1_inout_val);
+    dt1a_inout_val.SaveState(w);
+    dt1b_inout_val.SaveState(w);
+
+    w.WriteByte(tcnt_out_val);
+    w.WriteByte(tcnt_out_async_tmp);
+    w.WriteByte(tcnt_in_val);
+    w.WriteBool(tcnt_set_flag);
+    w.WriteBool(tov_internal_flag);
+    w.WriteBool(tocra_internal_flag);
+    w.WriteBool(tocrb_internal_flag);
+
+    w.WriteByte(ocra_internal_val);
+    w.WriteDWord(ocra_compare);
+    ocra_unit.SaveState(w);
+    w.WriteByte(ocrb_internal_val);
+    w.WriteDWord(ocrb_compare);
+    ocrb_unit.SaveState(w);
+    w.WriteInt(cfg_prescaler);
+    w.WriteInt(cfg_dtprescaler);
+    w.WriteInt(cfg_mode);
+    w.WriteBool(cfg_ctc);
+    w.WriteInt(cfg_com_a);
+    w.WriteInt(cfg_com_b);
+
+    w.WriteInt(asyncClock_step);
+    w.WriteBool(asyncClock_async);
+    w.WriteBool(asyncClock_lsm);
+    w.WriteBool(asyncClock_pll);
+    w.WriteBool(asyncClock_plllock);
+    w.WriteTime(asyncClock_locktime);
+
+    // in async mode the timer is a simulation member, store time to next step
+    SystemClock &clk = SystemClock::Instance();
+    SystemClockOffset next = clk.GetNextTime(this);
+    w.WriteTime((next >= 0) ? next - clk.GetCurrentTime() : -1);
+}
+
+void HWTimerTinyX5::RestoreState(SnapshotReader &r) {
+    counter = r.ReadDWord();
+    prescaler = r.ReadDWord();
+    dtprescaler = r.ReadByte();
+
+    tccr_inout_val.RestoreState(r);
+    ocra_inout_val.RestoreState(r);
+    ocrb_inout_val.RestoreState(r);
+    ocrc_inout_val.RestoreState(r);
+    gtccr_in_val.RestoreState(r);
+    dtps1_inout_val = r.ReadByte();
+    dt1a_inout_val.RestoreState(r);
+    dt1b_inout_val.RestoreState(r);
+
+    tcnt_out_val = r.ReadByte();
+    tcnt_out_async_tmp = r.ReadByte();
+    tcnt_in_val = r.ReadByte();
+    tcnt_set_flag = r.ReadBool();
+    tov_internal_flag = r.ReadBool();
+    tocra_internal_flag = r.ReadBool();
+    tocrb_internal_flag = r.ReadBool();
+
+    ocra_internal_val = r.ReadByte();
+    ocra_compare = r.ReadDWord();
+    ocra_unit.RestoreState(r);
+    ocrb_internal_val = r.ReadByte();
+    ocrb_compare = r.ReadDWord();
+    ocrb_unit.RestoreState(r);
+    cfg_prescaler = r.ReadInt();
+    cfg_dtprescaler = r.ReadInt();
+    cfg_mode = r.ReadInt();
+    cfg_ctc = r.ReadBool();
+    cfg_com_a = r.ReadInt();
+    cfg_com_b = r.ReadInt();
+
+    asyncClock_step = r.ReadInt();
+    asyncClock_async = r.ReadBool();
+    asyncClock_lsm = r.ReadBool();
+    asyncClock_pll = r.ReadBool();
+    asyncClock_plllock = r.ReadBool();
+    asyncClock_locktime = r.ReadTime();
+
+    // schedule async clock again, RestoreSnapshot moves it with simulation time
+    SystemClockOffset next = r.ReadTime();
+    SystemClock &clk = SystemClock::Instance();
+    clk.Remove(this);
+    if(next >= 0)
+        clk.AddDelayed(this, next);
+
+    counterTrace->change(counter);
+    prescalerTrace->change(prescaler);
+    dTPrescalerTrace->change(dtprescaler);
+}
+
 int HWTimerTinyX5::Step(bool &untilCoreStepFinished, SystemClockOffset *nextStepIn_ns) {
     if(asyncClock_async) {
         *nextStepIn_ns = HWTimerTinyX5_nextdelay[asyncClock_step];
@@ -1762,6 +2012,34 @@ void TimerTinyX5_OCR::Reset() {
     dtCounter = 0;
 }
 
+void TimerTinyX5_OCR::SaveState(SnapshotWriter &w) {
+    w.WriteInt(ocrComMode);
+    w.WriteBool(ocrPWM);
+    w.WriteBool(ocrOut);
+    w.WriteInt(dtHigh);
+    w.WriteInt(dtLow);
+    w.WriteInt(dtCounter);
+}
+
+void TimerTinyX5_OCR::RestoreState(SnapshotReader &r) {
+    ocrComMode = r.ReadInt();
+    ocrPWM = r.ReadBool();
+    ocrOut = r.ReadBool();
+    dtHigh = r.ReadInt();
+    dtLow = r.ReadInt();
+    dtCounter = r.ReadInt();
+}
+
+void HWTimerTinyX5_SyncReg::SaveState(SnapshotWriter &w) {
+    w.WriteByte(inValue);
+    w.WriteByte(regValue);
+}
+
+void HWTimerTinyX5_SyncReg::RestoreState(SnapshotReader &r) {
+    inValue = r.ReadByte();
+    regValue = r.ReadByte();
+}
+
 void TimerTinyX5_OCR::DTClockCycle() {
     if(dtCounter > 0) {
         dtCounter--;
@@ -174,6 +174,10 @@ class BasicTimerUnit: public Hardware, public TraceValueRegister {
         ~BasicTimerUnit();
         //! Perform a reset of this unit
         void Reset();
+        //! Save timer state for a snapshot
+        void SaveState(SnapshotWriter &w);
+        //! Restore timer state from a snapshot
+        void RestoreState(SnapshotReader &r);
         
         //! Process timer/counter unit operations by CPU cycle
         virtual unsigned int CpuCycle();
@@ -319,6 +323,10 @@ class HWTimer16: public BasicTimerUnit {
                   ICaptureSource* icapsrc);
         //! Perform a reset of this unit
         void Reset(void);
+        //! Save timer state for a snapshot
+        void SaveState(SnapshotWriter &w);
+        //! Restore timer state from a snapshot
+        void RestoreState(SnapshotReader &r);
 };
 
 //! Timer unit with 8Bit counter and no output compare unit
@@ -350,6 +358,10 @@ class HWTimer8_0C: public HWTimer8 {
                     IRQLine* tov);
         //! Perform a reset of this unit
         void Reset(void);
+        //! Save timer state for a snapshot
+        void SaveState(SnapshotWriter &w);
+        //! Restore timer state from a snapshot
+        void RestoreState(SnapshotReader &r);
 };
 
 //! Timer unit with 8Bit counter and one output compare unit
@@ -382,6 +394,10 @@ class HWTimer8_1C: public HWTimer8 {
                     PinAtPort* outA);
         //! Perform a reset of this unit
         void Reset(void);
+        //! Save timer state for a snapshot
+        void SaveState(SnapshotWriter &w);
+        //! Restore timer state from a snapshot
+        void RestoreState(SnapshotReader &r);
 };
 
 //! Timer unit with 8Bit counter and 2 output compare unit
@@ -436,6 +452,10 @@ class HWTimer8_2C: public HWTimer8 {
                     PinAtPort* outB);
         //! Perform a reset of this unit
         void Reset(void);
+        //! Save timer state for a snapshot
+        void SaveState(SnapshotWriter &w);
+        //! Restore timer state from a snapshot
+        void RestoreState(SnapshotReader &r);
 };
 
 //! Timer unit with 16Bit counter and one output compare unit
@@ -490,6 +510,10 @@ class HWTimer16_1C: public HWTimer16 {
                      ICaptureSource* icapsrc);
         //! Perform a reset of this unit
         void Reset(void);
+        //! Save timer state for a snapshot
+        void SaveState(SnapshotWriter &w);
+        //! Restore timer state from a snapshot
+        void RestoreState(SnapshotReader &r);
 };
 
 //! Timer unit with 16Bit counter and 2 output compare units and 2 config registers
@@ -552,6 +576,10 @@ class HWTimer16_2C2: public HWTimer16 {
                       bool is_at8515);
         //! Perform a reset of this unit
         void Reset(void);
+        //! Save timer state for a snapshot
+        void SaveState(SnapshotWriter &w);
+        //! Restore timer state from a snapshot
+        void RestoreState(SnapshotReader &r);
 };
 
 //! Timer unit with 16Bit counter and 2 output compare units, but 3 config registers
@@ -615,6 +643,10 @@ class HWTimer16_2C3: public HWTimer16 {
                       ICaptureSource* icapsrc);
         //! Perform a reset of this unit
         void Reset(void);
+        //! Save timer state for a snapshot
+        void SaveState(SnapshotWriter &w);
+        //! Restore timer state from a snapshot
+        void RestoreState(SnapshotReader &r);
 };
 
 //! Timer unit with 16Bit counter and 3 output compare units
@@ -680,6 +712,10 @@ class HWTimer16_3C: public HWTimer16 {
                      ICaptureSource* icapsrc);
         //! Perform a reset of this unit
         void Reset(void);
+        //! Save timer state for a snapshot
+        void SaveState(SnapshotWriter &w);
+        //! Restore timer state from a snapshot
+        void RestoreState(SnapshotReader &r);
 };
 
 //! PWM output unit for timer 1 on ATtiny25/45/85
@@ -722,6 +758,11 @@ class TimerTinyX5_OCR {
         //! Configure dead time counter
         void SetDeadTime(int highTime, int lowTime) { dtHigh = highTime; dtLow = lowTime; }
 
+        //! Save OCR unit state for a snapshot
+        void SaveState(SnapshotWriter &w);
+        //! Restore OCR unit state from a snapshot
+        void RestoreState(SnapshotReader &r);
+
         //! Configure OCR mode
         void SetOCRMode(bool isPWM, int comMode);
 };
@@ -755,6 +796,11 @@ class HWTimerTinyX5_SyncReg {
 
         //! Mask out a value inside sync area and do not force a change event
         void MaskOutSync(unsigned char mask) { inValue &= ~mask; regValue = inValue; }
+
+        //! Save both register values for a snapshot
+        void SaveState(SnapshotWriter &w);
+        //! Restore both register values from a snapshot
+        void RestoreState(SnapshotReader &r);
 };
 
 //! timer unit for timer 1 on ATtiny25/45/85
@@ -922,6 +968,10 @@ class HWTimerTinyX5: public Hardware,
         int Step(bool &untilCoreStepFinished, SystemClockOffset *nextStepIn_ns);
         //! Perform a reset of this unit
         void Reset();
+        //! Save timer state for a snapshot, including async clock
+        void SaveState(SnapshotWriter &w);
+        //! Restore timer state from a snapshot
+        void RestoreState(SnapshotReader &r);
         //! Process timer/counter unit operations by CPU cycle
         unsigned int CpuCycle();
 };
@@ -25,6 +25,7 @@
 
 #include "timerprescaler.h"
 #include "traceval.h"
+#include "snapshot.h"
 
 HWPrescaler::HWPrescaler(AvrDevice *core, const std::string &tracename):
     Hardware(core),
@@ -90,6 +91,16 @@ unsigned char HWPrescaler::set_from_reg(const IOSpecialReg *reg, unsigned char n
     return nv;  // return value unchanged
 }
 
+void HWPrescaler::SaveState(SnapshotWriter &w) {
+    w.WriteWord(preScaleValue);
+    w.WriteBool(countEnable);
+}
+
+void HWPrescaler::RestoreState(SnapshotReader &r) {
+    preScaleValue = r.ReadWord();
+    countEnable = r.ReadBool();
+}
+
 HWPrescalerAsync::HWPrescalerAsync(AvrDevice *core,
                                    const std::string &tracename,
                                    PinAtPort tosc,
@@ -152,3 +163,15 @@ unsigned char HWPrescalerAsync::set_from_reg(const IOSpecialReg *reg, unsigned c
     return v;
 }
 
+
+void HWPrescalerAsync::SaveState(SnapshotWriter &w) {
+    HWPrescaler::SaveState(w);
+    w.WriteBool(pinstate);
+    w.WriteBool(clockselect);
+}
+
+void HWPrescalerAsync::RestoreState(SnapshotReader &r) {
+    HWPrescaler::RestoreState(r);
+    pinstate = r.ReadBool();
+    clockselect = r.ReadBool();
+}
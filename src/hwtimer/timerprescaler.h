@@ -75,6 +75,10 @@ class HWPrescaler: public Hardware, public IOSpecialRegClient {
         unsigned short GetValue() { return preScaleValue; }
         //! Reset method, sets prescaler counter to 0
         void Reset(){ preScaleValue = 0; }
+        //! Save prescaler state for a snapshot
+        virtual void SaveState(SnapshotWriter &w);
+        //! Restore prescaler state from a snapshot
+        virtual void RestoreState(SnapshotReader &r);
 };
 
 //! Extends HWPrescaler with a external clock oszillator pin
@@ -102,6 +106,10 @@ class HWPrescalerAsync: public HWPrescaler {
                          int resetSyncBit);
         //! Count functionality for prescaler
         virtual unsigned int CpuCycle();
+        //! Save prescaler state for a snapshot
+        virtual void SaveState(SnapshotWriter &w);
+        //! Restore prescaler state from a snapshot
+        virtual void RestoreState(SnapshotReader &r);
         
     protected:
         //! IO register interface set method, see IOSpecialRegClient
@@ -25,6 +25,8 @@
 
 #include "hwuart.h"
 #include "helper.h"
+#include "snapshot.h"
+#include "ui/uartbridge.h"
 
 //usr & ucsra
 #define RXC 0x80
@@ -168,11 +170,15 @@ void HWUart::SetUcr(unsigned char val) {
 }
 
 unsigned int HWUart::CpuCycle() {
-    baudCnt++; // TODO: this isn't implemented right, baud clock prescaler is a down counter!
-    if(baudCnt >= (ubrr + 1)) {
-        baudCnt = 0;
-        CpuCycleRx();
-        CpuCycleTx();
+    if(bridge != NULL)
+        CpuCycleBridge();
+    else {
+        baudCnt++; // TODO: this isn't implemented right, baud clock prescaler is a down counter!
+        if(baudCnt >= (ubrr + 1)) {
+            baudCnt = 0;
+            CpuCycleRx();
+            CpuCycleTx();
+        }
     }
 
     // controling read sequence down counter
@@ -522,6 +528,66 @@ unsigned int HWUart::CpuCycleTx() {
     return 0;
 }
 
+int HWUart::GetFrameCycles() {
+    // start bit, data bits, parity bit and stop bits, every bit takes 16 baud clocks
+    int bits = 1 + (frameLength + 1) + ((ucsrc & UPM1) ? 1 : 0) + ((ucsrc & USBS) ? 2 : 1);
+    return bits * 16 * (ubrr + 1);
+}
+
+unsigned int HWUart::CpuCycleBridge() {
+    unsigned char usr_old = usr;
+
+    if(ucr & TXEN) {
+        if(bridgeTxCnt > 0 && --bridgeTxCnt == 0) {
+            if(!bridge->WriteByte(txDataTmp))
+                bridgeTxCnt = 1; // host is busy, byte stays in shift register
+            else if(usr & UDRE)
+                usr |= TXC; // transmit complete and no new data
+        }
+        if(bridgeTxCnt == 0 && !(usr & UDRE)) {
+            // shift data from udr->transmit shift register
+            txDataTmp = udrWrite;
+            usr |= UDRE;
+            usr &= 0xff - TXC;
+            bridgeTxCnt = GetFrameCycles();
+        }
+    }
+
+    if(ucr & RXEN) {
+        // host is polled only once in a frame time
+        if(bridgeRxCnt == 0 || --bridgeRxCnt == 0) {
+            if(bridgeRxPending) {
+                udrRead = rxDataTmp & 0xff;
+                usr &= 0xff - FE;
+                if(usr & RXC) //RXC is allready set->Overrun Error
+                    usr |= OR;
+                usr |= RXC;
+            }
+            unsigned char c = 0;
+            bridgeRxPending = bridge->ReadByte(c);
+            rxDataTmp = c;
+            bridgeRxCnt = GetFrameCycles();
+        }
+    }
+
+    unsigned char irqold = ucr & usr_old;
+    unsigned char irqnew = ucr & usr;
+    unsigned char changed = irqold ^ irqnew;
+    CheckForNewSetIrq(changed & irqnew);
+    CheckForNewClearIrq(changed & (~irqnew));
+    return 0;
+}
+
+void HWUart::SetBridge(UartBridge *b) {
+    bridge = b;
+    bridgeRxCnt = 0;
+    bridgeTxCnt = 0;
+    bridgeRxPending = false;
+    // transmitter is idle, if switched back to pins
+    txState = TX_FIRST_RUN;
+    rxState = RX_WAIT_FOR_HIGH;
+}
+
 HWUart::HWUart(AvrDevice *core,
                HWIrqSystem *s,
                PinAtPort tx,
@@ -538,6 +604,7 @@ HWUart::HWUart(AvrDevice *core,
     vectorRx(rx_interrupt),
     vectorUdre(udre_interrupt),
     vectorTx(tx_interrupt),
+    bridge(NULL),
     udr_reg(this, "UDR",
             this, &HWUart::GetUdr, &HWUart::SetUdr),
     usr_reg(this, "USR",
@@ -618,9 +685,67 @@ void HWUart::Reset() {
     rxState = RX_WAIT_FOR_LOWEDGE;
     txState = TX_FIRST_RUN;
 
+    bridgeRxCnt = 0;
+    bridgeTxCnt = 0;
+    bridgeRxPending = false;
+
     SetFrameLengthFromRegister(); 
 }
 
+void HWUart::SaveState(SnapshotWriter &w) {
+    w.WriteByte(udrWrite);
+    w.WriteByte(udrRead);
+    w.WriteByte(usr);
+    w.WriteByte(ucr);
+    w.WriteByte(ucsrc);
+    w.WriteWord(ubrr);
+    w.WriteBool(readParity);
+    w.WriteBool(writeParity);
+    w.WriteInt(frameLength);
+    w.WriteByte(regSeq);
+    w.WriteInt(baudCnt);
+    w.WriteInt(rxState);
+    w.WriteInt(txState);
+    w.WriteInt(cntRxSamples);
+    w.WriteInt(rxLowCnt);
+    w.WriteInt(rxHighCnt);
+    w.WriteDWord(rxDataTmp);
+    w.WriteInt(rxBitCnt);
+    w.WriteInt(baudCnt16);
+    w.WriteByte(txDataTmp);
+    w.WriteInt(txBitCnt);
+    w.WriteInt(bridgeRxCnt);
+    w.WriteInt(bridgeTxCnt);
+    w.WriteBool(bridgeRxPending);
+}
+
+void HWUart::RestoreState(SnapshotReader &r) {
+    udrWrite = r.ReadByte();
+    udrRead = r.ReadByte();
+    usr = r.ReadByte();
+    ucr = r.ReadByte();
+    ucsrc = r.ReadByte();
+    ubrr = r.ReadWord();
+    readParity = r.ReadBool();
+    writeParity = r.ReadBool();
+    frameLength = r.ReadInt();
+    regSeq = r.ReadByte();
+    baudCnt = r.ReadInt();
+    rxState = (T_RxState)r.ReadInt();
+    txState = (T_TxState)r.ReadInt();
+    cntRxSamples = r.ReadInt();
+    rxLowCnt = r.ReadInt();
+    rxHighCnt = r.ReadInt();
+    rxDataTmp = r.ReadDWord();
+    rxBitCnt = r.ReadInt();
+    baudCnt16 = r.ReadInt();
+    txDataTmp = r.ReadByte();
+    txBitCnt = r.ReadInt();
+    bridgeRxCnt = r.ReadInt();
+    bridgeTxCnt = r.ReadInt();
+    bridgeRxPending = r.ReadBool();
+}
+
 // implementation of HWUsart
 
 void HWUsart::SetUcsrc(unsigned char val) {
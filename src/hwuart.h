@@ -33,6 +33,8 @@
 #include "rwmem.h"
 #include "traceval.h"
 
+class UartBridge;
+
 //! Implements the I/O hardware necessary to do UART transfers.
 /*! \todo Needs rewrite! Only one async mode implemented! */
 class HWUart: public Hardware, public TraceValueRegister {
@@ -102,6 +104,14 @@ class HWUart: public Hardware, public TraceValueRegister {
         unsigned char txDataTmp;
         int txBitCnt;
 
+        UartBridge *bridge;      //!< byte level host endpoint or NULL, if pins are used
+        int bridgeRxCnt;         //!< cycles till next received byte is complete
+        int bridgeTxCnt;         //!< cycles till transmitted byte is complete
+        bool bridgeRxPending;    //!< a byte from bridge is in receive shift register
+
+        unsigned int CpuCycleBridge();
+        int GetFrameCycles();
+
     public:
         //! Creates a instance of HWUart class
         HWUart(AvrDevice *core,
@@ -116,6 +126,16 @@ class HWUart: public Hardware, public TraceValueRegister {
 
         void Reset();
 
+        //! Connects UART to a byte level host endpoint, NULL switches back to pins
+        /*! With a bridge the bit level state machines are bypassed, whole bytes
+          are exchanged at the simulated frame time (start, data, parity and
+          stop bits at the programmed baudrate). The bridge isn't owned by UART. */
+        void SetBridge(UartBridge *b);
+        UartBridge *GetBridge(void) { return bridge; }
+
+        void SaveState(SnapshotWriter &w);
+        void RestoreState(SnapshotReader &r);
+
         void SetUdr(unsigned char val);  
         void SetUsr(unsigned char val);  
         void SetUcr(unsigned char val);  
@@ -26,6 +26,7 @@
 #include "hwwado.h"
 #include "avrdevice.h"
 #include "systemclock.h"
+#include "snapshot.h"
 
 #define WDTOE 0x10
 #define WDE 0x08
@@ -80,6 +81,18 @@ void HWWado::Reset() {
 	wdtcr=0;
 }
 
+void HWWado::SaveState(SnapshotWriter &w) {
+	w.WriteByte(wdtcr);
+	w.WriteByte(cntWde);
+	w.WriteTime(timeOutAt);
+}
+
+void HWWado::RestoreState(SnapshotReader &r) {
+	wdtcr=r.ReadByte();
+	cntWde=r.ReadByte();
+	timeOutAt=r.ReadTime();
+}
+
 
 void HWWado::Wdr() {
 	SystemClockOffset currentTime= SystemClock::Instance().GetCurrentTime();
@@ -50,6 +50,8 @@ class HWWado: public Hardware, public TraceValueRegister {
 		unsigned char GetWdtcr() { return wdtcr; }
 		virtual void Wdr(); //reset the wado counter
 		virtual void Reset();
+		virtual void SaveState(SnapshotWriter &w);
+		virtual void RestoreState(SnapshotReader &r);
 
         IOReg<HWWado> wdtcr_reg;
 };
@@ -24,6 +24,7 @@
  */
 
 #include "ioregs.h"
+#include "snapshot.h"
 
 AddressExtensionRegister::AddressExtensionRegister(AvrDevice *core,
                                                    const std::string &regname,
@@ -37,4 +38,12 @@ AddressExtensionRegister::AddressExtensionRegister(AvrDevice *core,
     Reset();
 }
 
+void AddressExtensionRegister::SaveState(SnapshotWriter &w) {
+    w.WriteByte(reg_val);
+}
+
+void AddressExtensionRegister::RestoreState(SnapshotReader &r) {
+    reg_val = r.ReadByte();
+}
+
 // EOF
@@ -41,6 +41,8 @@ class AddressExtensionRegister: public Hardware, public TraceValueRegister {
         void Reset() { reg_val = 0; }
         unsigned char GetRegVal() { return reg_val; }
         void SetRegVal(unsigned char val) { reg_val = val & reg_mask; }
+        void SaveState(SnapshotWriter &w);
+        void RestoreState(SnapshotReader &r);
 
         IOReg<AddressExtensionRegister> ext_reg;
 };
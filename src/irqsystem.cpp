@@ -29,12 +29,17 @@
 #include "systemclock.h"
 #include "helper.h"
 #include "avrerror.h"
+#include "snapshot.h"
 
 #include "application.h"
 
 #include <iostream>
+#include <algorithm>
 #include <assert.h>
 #include <typeinfo>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 using namespace std;
 
@@ -188,6 +193,9 @@ HWIrqSystem::HWIrqSystem(AvrDevice* _core, int bytes, int tblsize):
     bytesPerVector(bytes),
     vectorTableSize(tblsize),
     irqTrace(tblsize),
+    irqPartnerList(tblsize, (Hardware*)NULL),
+    pendingBits((tblsize + 31) / 32, 0),
+    pendingCount(0),
     core(_core),
     irqStatistic(_core),
     debugInterruptTable(tblsize, (Hardware*)NULL)
@@ -200,31 +208,45 @@ HWIrqSystem::HWIrqSystem(AvrDevice* _core, int bytes, int tblsize):
     }
 }
 
+//! Returns index of lowest set bit in val, val must not be 0
+static inline unsigned int LowestBit(unsigned int val) {
+#if defined(__GNUC__)
+    return __builtin_ctz(val);
+#elif defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanForward(&idx, val);
+    return idx;
+#else
+    unsigned int idx = 0;
+    for(; (val & 1) == 0; val >>= 1)
+        idx++;
+    return idx;
+#endif
+}
+
 unsigned int HWIrqSystem::GetNewPc(unsigned int &actualVector) {
     unsigned int newPC = 0xffffffff;
-
-    static map<unsigned int, Hardware *>::iterator ii;
-    static map<unsigned int, Hardware *>::iterator end;
-    end = irqPartnerList.end();
-
-    //a map is always sorted, so the priority of the irq vector is known and handled correctly
-    for(ii = irqPartnerList.begin(); ii != end; ii++) {
-        Hardware* second = ii->second;
-        unsigned int index = ii->first;
-        assert(index < vectorTableSize);
-
-        if(second->IsLevelInterrupt(index)) {
-            second->ClearIrqFlag(index);
-            if(second->LevelInterruptPending(index)) {
+    if(pendingCount == 0)
+        return newPC;
+
+    // lowest pending vector has the highest priority
+    for(unsigned int word = 0; word < pendingBits.size(); word++) {
+        for(unsigned int bits = pendingBits[word]; bits != 0; bits &= bits - 1) {
+            unsigned int index = word * 32 + LowestBit(bits);
+            Hardware* second = irqPartnerList[index];
+            assert(index < vectorTableSize);
+
+            if(second->IsLevelInterrupt(index)) {
+                second->ClearIrqFlag(index);
+                if(second->LevelInterruptPending(index)) {
+                    actualVector = index;
+                    return index * (bytesPerVector / 2);
+                }
+            } else {
+                second->ClearIrqFlag(index);
                 actualVector = index;
-                newPC = index * (bytesPerVector / 2);
-                break;
+                return index * (bytesPerVector / 2);
             }
-        } else {
-            second->ClearIrqFlag(index);
-            actualVector = index;
-            newPC = index * (bytesPerVector / 2);
-            break;
         }
     }
 
@@ -233,6 +255,10 @@ unsigned int HWIrqSystem::GetNewPc(unsigned int &actualVector) {
 
 void HWIrqSystem::SetIrqFlag(Hardware *hwp, unsigned int vector) {
     assert(vector < vectorTableSize);
+    if(irqPartnerList[vector] == NULL) {
+        pendingBits[vector / 32] |= 1U << (vector % 32);
+        pendingCount++;
+    }
     irqPartnerList[vector]=hwp;
     if (core->trace_on) {
         traceOut << core->GetFname() << " interrupt on index " << vector << " is pending" << endl;
@@ -244,7 +270,12 @@ void HWIrqSystem::SetIrqFlag(Hardware *hwp, unsigned int vector) {
 }
 
 void HWIrqSystem::ClearIrqFlag(unsigned int vector) {
-    irqPartnerList.erase(vector);
+    assert(vector < vectorTableSize);
+    if(irqPartnerList[vector] != NULL) {
+        pendingBits[vector / 32] &= ~(1U << (vector % 32));
+        pendingCount--;
+        irqPartnerList[vector] = NULL;
+    }
     if (core->trace_on) {
         traceOut << core->GetFname() << " interrupt on index " << vector << "cleared" << endl;
     }
@@ -280,6 +311,37 @@ void HWIrqSystem::IrqHandlerFinished(unsigned int vector) {
     irqStatistic.entries[vector].CheckComplete();
 }
 
+void HWIrqSystem::SaveState(SnapshotWriter &w) {
+    w.WriteDWord(pendingCount);
+    for(unsigned int vec = 0; vec < vectorTableSize; vec++) {
+        if(irqPartnerList[vec] == NULL)
+            continue;
+        vector<Hardware *>::iterator hw = find(core->hwResetList.begin(), core->hwResetList.end(), irqPartnerList[vec]);
+        if(hw == core->hwResetList.end())
+            avr_error("snapshot: interrupt source for vector %d is unknown", vec);
+        w.WriteDWord(vec);
+        w.WriteDWord(hw - core->hwResetList.begin());
+    }
+}
+
+void HWIrqSystem::RestoreState(SnapshotReader &r) {
+    irqPartnerList.assign(vectorTableSize, (Hardware*)NULL);
+    pendingBits.assign(pendingBits.size(), 0);
+    pendingCount = 0;
+    unsigned long cnt = r.ReadDWord();
+    for(unsigned long i = 0; i < cnt; i++) {
+        unsigned int vector = r.ReadDWord();
+        unsigned int idx = r.ReadDWord();
+        if(vector >= vectorTableSize || idx >= core->hwResetList.size())
+            avr_error("snapshot: invalid interrupt vector %d", vector);
+        if(irqPartnerList[vector] == NULL) {
+            pendingBits[vector / 32] |= 1U << (vector % 32);
+            pendingCount++;
+        }
+        irqPartnerList[vector] = core->hwResetList[idx];
+    }
+}
+
 void HWIrqSystem::DebugVerifyInterruptVector(unsigned int vector, const Hardware* source) {
     assert(vector < vectorTableSize);
     const Hardware* existing = debugInterruptTable[vector];
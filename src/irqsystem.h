@@ -123,8 +123,11 @@ class HWIrqSystem: public TraceValueRegister {
         HWSreg *status;
         std::vector<TraceValue*> irqTrace;
         
-        /// priority queue of pending interrupts (i.e. waiting to be processed)
-        std::map<unsigned int, Hardware *> irqPartnerList;
+        /// source of pending interrupts (i.e. waiting to be processed) per vector or NULL
+        std::vector<Hardware *> irqPartnerList;
+        /// pending vectors as bitset, 32 vectors per word, lowest vector has highest priority
+        std::vector<unsigned int> pendingBits;
+        unsigned int pendingCount; ///< count of pending vectors
         AvrDevice *core;
         IrqStatistic irqStatistic;
         std::vector<const Hardware*> debugInterruptTable;
@@ -134,6 +137,8 @@ class HWIrqSystem: public TraceValueRegister {
 
         /// returns a new PC pointer if interrupt occurred, -1 otherwise.
         unsigned int GetNewPc(unsigned int &vector_index);
+        /// returns true, if a interrupt is flagged and not yet started
+        bool IsIrqPending(void) const { return pendingCount != 0; }
         void SetIrqFlag(Hardware *, unsigned int vector_index);
         void ClearIrqFlag(unsigned int vector_index);
         void IrqHandlerStarted(unsigned int vector_index);
@@ -141,6 +146,11 @@ class HWIrqSystem: public TraceValueRegister {
         /// In datasheets RESET vector is index 1 but we use 0! And not a byte address.
         void DebugVerifyInterruptVector(unsigned int vector_index, const Hardware* source);
         void DebugDumpTable();
+
+        /// Save pending interrupts for a snapshot, hardware is identified by position in reset list of core
+        void SaveState(SnapshotWriter &w);
+        /// Restore pending interrupts from a snapshot
+        void RestoreState(SnapshotReader &r);
 };
 
 #ifndef SWIG
@@ -159,6 +169,7 @@ class IrqFunktor: public Funktor {
             vectorNo(_vector) {}
         void operator()() { (irqSystem->*fp)(vectorNo); }
         Funktor* clone() { return new IrqFunktor(*this); }
+        unsigned int GetVector(void) const { return vectorNo; }
 };
 
 #endif // ifndef SWIG
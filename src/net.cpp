@@ -26,9 +26,17 @@
 #include "net.h"
 #include "pin.h"
 
+Net::Net():
+    lastState(Pin::TRISTATE)
+{
+    for(unsigned int i = 0; i <= Pin::ANALOG_SHORTED; i++)
+        counts[i] = 0;
+}
+
 void Net::Add(Pin *p) {
     push_back(p);
     p->RegisterNet(this);
+    p->netIndex = size() - 1;
     CalcNet();
 }
 
@@ -36,7 +44,14 @@ void Net::Delete(Pin *p) {
     iterator ii;
     for(ii = begin(); ii != end(); ii++) {
         if((Pin*)(*ii) == p) {
+            size_t idx = ii - begin();
+            if(states.size() == size()) {
+                counts[states[idx]]--;
+                states.erase(states.begin() + idx);
+            }
             erase(ii);
+            for(size_t i = idx; i < size(); i++)
+                at(i)->netIndex = i;
             break;
         }
     }
@@ -47,16 +62,84 @@ Net::~Net() {
         (*begin())->UnRegisterNet(this);
 }
 
+Pin Net::Resolve(Pin *p) {
+    unsigned int driven = size() - counts[Pin::TRISTATE];
+
+    if(counts[Pin::SHORTED] || (counts[Pin::HIGH] && counts[Pin::LOW]))
+        return Pin(Pin::SHORTED);
+    // a analog value together with any other not tristate pin is a short
+    if(counts[Pin::ANALOG_SHORTED] || (counts[Pin::ANALOG] && driven > 1))
+        return Pin(Pin::ANALOG_SHORTED);
+    if(counts[Pin::ANALOG]) {
+        if(p == NULL || states[p->netIndex] != Pin::ANALOG) {
+            for(size_t i = 0; i < size(); i++) {
+                if(states[i] == Pin::ANALOG) {
+                    p = at(i);
+                    break;
+                }
+            }
+        }
+        return p->GetPin();
+    }
+    if(counts[Pin::HIGH])
+        return Pin(Pin::HIGH);
+    if(counts[Pin::LOW])
+        return Pin(Pin::LOW);
+    if(counts[Pin::PULLUP] && counts[Pin::PULLDOWN])
+        return Pin(Pin::TRISTATE); // any other idea?
+    if(counts[Pin::PULLUP])
+        return Pin(Pin::PULLUP);
+    if(counts[Pin::PULLDOWN])
+        return Pin(Pin::PULLDOWN);
+    return Pin(Pin::TRISTATE);
+}
+
 bool Net::CalcNet() {
-    Pin result(Pin::TRISTATE);
-    iterator ii;
-    for(ii = begin(); ii != end(); ii++)
-        result += ((*ii)->GetPin()); //get state of pin (TRISTATE, HIGH, LOW ....)
+    // get state of all pins (TRISTATE, HIGH, LOW ....)
+    for(unsigned int i = 0; i <= Pin::ANALOG_SHORTED; i++)
+        counts[i] = 0;
+    states.resize(size());
+    for(size_t i = 0; i < size(); i++) {
+        at(i)->netIndex = i;
+        states[i] = at(i)->GetPin().outState;
+        counts[states[i]]++;
+    }
+    Pin result = Resolve(NULL);
 
     //new result is now found, so set all pins in the Net to new state
+    iterator ii;
     for(ii = begin(); ii != end(); ii++)
         (*ii)->SetInState( result); //In-State that means the state of register PIN not the complete pin here
 
+    lastState = result.outState;
+    lastAnalog = result.analogVal;
+    return (bool)result;
+}
+
+bool Net::CalcNet(Pin *p) {
+    size_t idx = p->netIndex;
+    if(states.size() != size() || idx >= size() || at(idx) != p)
+        return CalcNet();
+
+    Pin::T_Pinstate s = p->GetPin().outState;
+    if(s != states[idx]) {
+        counts[states[idx]]--;
+        counts[s]++;
+        states[idx] = s;
+    }
+    Pin result = Resolve(p);
+
+    if(result.outState != lastState ||
+       result.analogVal.getD() != lastAnalog.getD() ||
+       result.analogVal.getRaw() != lastAnalog.getRaw()) {
+        iterator ii;
+        for(ii = begin(); ii != end(); ii++)
+            (*ii)->SetInState(result);
+        lastState = result.outState;
+        lastAnalog = result.analogVal;
+    } else
+        p->SetInState(result); // own output has changed, so notify listeners
+
     return (bool)result;
 }
 
@@ -31,19 +31,34 @@
 #include "pin.h"
 
 //! Connect Pins to each other and transfers a output change from a pin to input values for all pins
+/*! The net keeps the output state of every pin and a count of pins for every
+  output state. So a change on one pin is resolved in constant time by
+  CalcNet(Pin*) and pin inputs are only set, if the resolved state of the net
+  has changed. (the changed pin itself gets always its input value) */
 class Net
 #ifndef SWIG
     : public std::vector <Pin *>
 #endif
 {
     public:
-        //Net() {} //!< Common Constructor, initially it'a a "empty net" and useless!
+        Net(); //!< Common Constructor, initially it'a a "empty net" and useless!
         virtual ~Net(); //!< Destructor, disconnects save all pins, which are connected
         void Add(Pin *p); //!< Add a pin to net, e.g. connect a pin to others
         virtual void Delete(Pin *p); //!< Remove a pin from net
          //! Calculate a "electrical potential" on the net and set all pin inputs with this value
         virtual bool CalcNet();
-        
+        //! Update net after a output change of pin p, other pins keep their last output state
+        virtual bool CalcNet(Pin *p);
+
+    protected:
+        std::vector<Pin::T_Pinstate> states; //!< last known output state of every pin
+        unsigned int counts[Pin::ANALOG_SHORTED + 1]; //!< count of pins for every output state
+        Pin::T_Pinstate lastState;   //!< resolved state on last calculation
+        AnalogValue lastAnalog;      //!< resolved analog value on last calculation
+
+        //! Resolve net state from counts, p is a hint for the pin with ANALOG state
+        Pin Resolve(Pin *p);
+
     private:
         friend void Pin::RegisterNet(Net*);
 };
@@ -24,6 +24,7 @@
  */
 
 #include <limits.h> // for INT_MAX
+#include <algorithm>
 
 #include "pin.h"
 #include "net.h"
@@ -84,13 +85,14 @@ bool Pin::CalcPin(void) {
         SetInState(*this);
         return (bool)*this;
     } else {
-        return connectedTo->CalcNet();
+        return connectedTo->CalcNet(this);
     }
 }
 
 Pin::Pin(T_Pinstate ps) { 
     pinOfPort = 0; 
     connectedTo = NULL;
+    netIndex = 0;
     mask = 0;
     
     outState = ps;
@@ -120,6 +122,7 @@ Pin::Pin(T_Pinstate ps) {
 Pin::Pin() { 
     pinOfPort = 0; 
     connectedTo = NULL;
+    netIndex = 0;
     mask = 0;
     
     outState = TRISTATE;
@@ -134,6 +137,7 @@ Pin::Pin( unsigned char *parentPin, unsigned char _mask) {
     pinOfPort = parentPin;
     mask = _mask;
     connectedTo = NULL;
+    netIndex = 0;
     
     outState = TRISTATE;
 }
@@ -141,6 +145,7 @@ Pin::Pin( unsigned char *parentPin, unsigned char _mask) {
 Pin::Pin(const Pin& p) {
     pinOfPort = 0; // don't take over HWPort connection!
     connectedTo = NULL; // don't take over Net instance!
+    netIndex = 0;
     mask = 0;
     
     outState = p.outState;
@@ -151,6 +156,7 @@ Pin::Pin(float analog) {
     mask = 0;
     pinOfPort = 0;
     connectedTo = NULL;
+    netIndex = 0;
     analogVal.setA(analog);
 
     outState = ANALOG;
@@ -341,4 +347,16 @@ Pin OpenDrain::GetPin() {
 
 OpenDrain::OpenDrain(Pin *p) {
     pin = p;
+    pin->RegisterCallback(this);
+}
+
+OpenDrain::~OpenDrain() {
+    std::vector<HasPinNotifyFunction*>::iterator ii =
+        std::find(pin->notifyList.begin(), pin->notifyList.end(), this);
+    if(ii != pin->notifyList.end())
+        pin->notifyList.erase(ii);
+}
+
+void OpenDrain::PinStateHasChanged(Pin *) {
+    CalcPin();
 }
@@ -101,6 +101,7 @@ class Pin {
         AnalogValue analogVal; //!< "real" analog voltage value
 
         Net *connectedTo; //!< the connection to other pins (NULL, if not connected)
+        size_t netIndex; //!< position of pin in connected Net
 
     public:
 
@@ -155,6 +156,7 @@ class Pin {
 
         bool isPortPin(void) { return pinOfPort != NULL; } //!< True, if it's a port pin
         bool isConnected(void) { return connectedTo != NULL; } //!< True, if it's connected to other pins
+        Net *GetNet(void) { return connectedTo; } //!< Net of the pin or NULL, if not connected
         bool hasListener(void) { return notifyList.size() != 0; } //!< True, if there change listeners
 
         friend class HWPort;
@@ -163,13 +165,17 @@ class Pin {
 };
 
 //! Open drain Pin class, a special pin with open drain behavior
-class OpenDrain: public Pin {
+/*! The output is calculated from the input value of the controlling pin, so
+  it listens on this pin and updates its net on every change. */
+class OpenDrain: public Pin, public HasPinNotifyFunction {
     protected:
         Pin *pin;        // the connected pin, which control input
 
     public:
         OpenDrain(Pin *p);
+        ~OpenDrain();
         virtual Pin GetPin();
+        void PinStateHasChanged(Pin *);
 };
 
 #endif
@@ -1,4 +1,4 @@
-%module(directors="1") pysimulavr
+%module(directors="1", threads="1") pysimulavr
 
 %{
 
@@ -24,6 +24,12 @@
   #include "hwstack.h"
   #include "avrsignature.h"
   #include "specialmem.h"
+  #include "snapshot.h"
+  #include "forkpool.h"
+  #include "fuzzharness.h"
+  #include "coverage.h"
+  #include "stoptrigger.h"
+  #include "stimulus.h"
 
   #include "cmd/dumpargs.h"
   #include "cmd/gdb.h"
@@ -73,6 +79,10 @@ namespace std {
   }
 }
 
+// the GIL is only released for methods, which run the simulation (see
+// SystemClock below), python models (directors) get it back on upcall
+%nothread;
+
 %include "config.h"
 
 %include "systemclocktypes.h"
@@ -103,8 +113,76 @@ namespace std {
   // getRWMem and setRWMem are deprecated, don't use it in new code!
   unsigned char getRWMem(unsigned a) { return $self->GetRWMem(a); }
   bool setRWMem(unsigned a, unsigned char v) { return $self->SetRWMem(a, v); }
+  // get complete device state (and simulation time) as bytes object
+  PyObject *GetSnapshot(void) {
+    std::ostringstream os;
+    SaveSnapshot($self, os);
+    std::string s = os.str();
+    return PyBytes_FromStringAndSize(s.data(), s.size());
+  }
+  // restore device state (and simulation time) from bytes object, see GetSnapshot
+  void SetSnapshot(PyObject *data) {
+    char *buf;
+    Py_ssize_t size;
+    if(PyBytes_AsStringAndSize(data, &buf, &size) < 0)
+      throw "snapshot: bytes object expected";
+    std::istringstream is(std::string(buf, size));
+    RestoreSnapshot($self, is);
+  }
+  // read len bytes from data address space (registers, IO, SRAM) as bytes object
+  PyObject *read_block(unsigned int addr, unsigned int len) {
+    unsigned int total = $self->GetMemTotalSize();
+    if(addr > total || len > total - addr)
+      throw "read_block: address range exceeds data space";
+    PyObject *res = PyBytes_FromStringAndSize(NULL, len);
+    if(res == NULL)
+      return NULL;
+    char *buf = PyBytes_AS_STRING(res);
+    for(unsigned int i = 0; i < len; i++)
+      buf[i] = $self->GetRWMem(addr + i);
+    return res;
+  }
+  // write a bytes like object to data address space (registers, IO, SRAM)
+  void write_block(unsigned int addr, PyObject *data) {
+    Py_buffer view;
+    if(PyObject_GetBuffer(data, &view, PyBUF_SIMPLE) < 0)
+      throw "write_block: bytes like object expected";
+    unsigned int total = $self->GetMemTotalSize();
+    if(addr > total || (size_t)view.len > total - addr) {
+      PyBuffer_Release(&view);
+      throw "write_block: address range exceeds data space";
+    }
+    const unsigned char *buf = (const unsigned char *)view.buf;
+    for(Py_ssize_t i = 0; i < view.len; i++)
+      $self->SetRWMem(addr + i, buf[i]);
+    PyBuffer_Release(&view);
+  }
+%pythoncode %{
+  def read_var(self, name, fmt = "B"):
+    """read variable by symbol name from data space, fmt is a struct format
+    (little endian), returns a single value or a tuple for more values"""
+    import struct
+    fmt = "<" + fmt
+    v = struct.unpack(fmt, self.read_block(self.data.GetAddressAtSymbol(name), struct.calcsize(fmt)))
+    return v[0] if len(v) == 1 else v
+
+  def write_var(self, name, value, fmt = "B"):
+    """write variable by symbol name to data space, see read_var"""
+    import struct
+    if not isinstance(value, (tuple, list)):
+      value = (value,)
+    self.write_block(self.data.GetAddressAtSymbol(name), struct.pack("<" + fmt, *value))
+
+  def get_registers(self):
+    """returns register file r0 .. r31 as bytes object"""
+    return self.read_block(0, 32)
+%}
 }
 
+%thread SystemClock::Step;
+%thread SystemClock::Endless;
+%thread SystemClock::Run;
+%thread SystemClock::RunTimeRange;
 %include "systemclock.h"
 
 %extend SystemClock {
@@ -164,9 +242,79 @@ namespace std {
   void PyWriteMem(char *src, unsigned int offset, unsigned int secSize) {
     $self->WriteMem((const unsigned char *)src, offset, secSize);
   }
+  // memory content as writable memoryview without copy (usable with numpy.frombuffer)
+  PyObject *view(void) {
+    if($self->myMemory == NULL)
+      throw "view: no memory allocated";
+%#if PY_VERSION_HEX >= 0x03030000
+    return PyMemoryView_FromMemory((char *)$self->myMemory, $self->GetSize(), PyBUF_WRITE);
+%#else
+    return PyBuffer_FromReadWriteMemory($self->myMemory, $self->GetSize());
+%#endif
+  }
+  // read len bytes from memory as bytes object
+  PyObject *read_block(unsigned int offset, unsigned int len) {
+    if(offset > $self->GetSize() || len > $self->GetSize() - offset)
+      throw "read_block: address range exceeds memory";
+    return PyBytes_FromStringAndSize((const char *)$self->myMemory + offset, len);
+  }
+  // write a bytes like object to memory, same as PyWriteMem
+  void write_block(unsigned int offset, PyObject *data) {
+    Py_buffer view;
+    if(PyObject_GetBuffer(data, &view, PyBUF_SIMPLE) < 0)
+      throw "write_block: bytes like object expected";
+    if(offset > $self->GetSize() || (size_t)view.len > $self->GetSize() - offset) {
+      PyBuffer_Release(&view);
+      throw "write_block: address range exceeds memory";
+    }
+    $self->WriteMem((const unsigned char *)view.buf, offset, view.len);
+    PyBuffer_Release(&view);
+  }
 }
 
 %include "flash.h"
+
+%extend AvrFlash {
+  // flash content as read only memoryview without copy, words are stored
+  // high byte first, write with write_block, because flash has to be decoded
+  PyObject *view(void) {
+%#if PY_VERSION_HEX >= 0x03030000
+    return PyMemoryView_FromMemory((char *)$self->myMemory, $self->GetSize(), PyBUF_READ);
+%#else
+    return PyBuffer_FromMemory($self->myMemory, $self->GetSize());
+%#endif
+  }
+  // read len bytes from flash as bytes object, in same byte order as in elf file
+  PyObject *read_block(unsigned int offset, unsigned int len) {
+    if(offset > $self->GetSize() || len > $self->GetSize() - offset)
+      throw "read_block: address range exceeds memory";
+    PyObject *res = PyBytes_FromStringAndSize(NULL, len);
+    if(res == NULL)
+      return NULL;
+    char *buf = PyBytes_AS_STRING(res);
+    for(unsigned int i = 0; i < len; i++)
+      buf[i] = $self->myMemory[(offset + i) ^ 1];
+    return res;
+  }
+  // write a bytes like object to flash, in same byte order as in elf file,
+  // only whole words can be written
+  void write_block(unsigned int offset, PyObject *data) {
+    Py_buffer view;
+    if(PyObject_GetBuffer(data, &view, PyBUF_SIMPLE) < 0)
+      throw "write_block: bytes like object expected";
+    if(offset > $self->GetSize() || (size_t)view.len > $self->GetSize() - offset) {
+      PyBuffer_Release(&view);
+      throw "write_block: address range exceeds memory";
+    }
+    if((offset & 1) || (view.len & 1)) {
+      PyBuffer_Release(&view);
+      throw "write_block: flash offset and length have to be even";
+    }
+    $self->WriteMem((const unsigned char *)view.buf, offset, view.len);
+    PyBuffer_Release(&view);
+  }
+}
+
 %include "hweeprom.h"
 
 %extend Breakpoints {
@@ -183,6 +331,34 @@ namespace std {
 
 %include "avrerror.h"
 
+%include "snapshot.h"
+
+%feature("director") ForkVariant;
+%include "forkpool.h"
+
+%include "coverage.h"
+
+%include "stoptrigger.h"
+
+%include "stimulus.h"
+
+%include "fuzzharness.h"
+
+%extend FuzzHarness {
+  // run input from a bytes object, for instance given by atheris (libFuzzer)
+  int PyRunInput(PyObject *data) {
+    char *buf;
+    Py_ssize_t size;
+    if(PyBytes_AsStringAndSize(data, &buf, &size) < 0)
+      throw "fuzz: bytes object expected";
+    return $self->RunInput((const unsigned char *)buf, size);
+  }
+  // get coverage map as bytes object
+  PyObject *PyGetCoverageMap(void) {
+    return PyBytes_FromStringAndSize((const char *)$self->GetCoverageMap(), $self->GetCoverageSize());
+  }
+}
+
 %include "cmd/dumpargs.h"
 %include "cmd/gdb.h"
 
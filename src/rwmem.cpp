@@ -30,12 +30,14 @@
  */
 
 #include <cstdio>
+#include <assert.h>
 
 #include "avrerror.h"
 #include "traceval.h"
 #include "avrdevice.h"
 #include "helper.h"
 #include "rwmem.h"
+#include "snapshot.h"
 
 using namespace std;
 
@@ -91,6 +93,14 @@ RWMemoryMember::~RWMemoryMember() {
         delete tv;
 }
 
+void GPIORegister::SaveState(SnapshotWriter &w) {
+    w.WriteByte(value);
+}
+
+void GPIORegister::RestoreState(SnapshotReader &r) {
+    value = r.ReadByte();
+}
+
 CLKPRRegister::CLKPRRegister(AvrDevice *core,
                              TraceValueRegister *registry):
         RWMemoryMember(registry, "CLKPR"),
@@ -123,6 +133,16 @@ unsigned int CLKPRRegister::CpuCycle(void) {
     return 0;
 }
 
+void CLKPRRegister::SaveState(SnapshotWriter &w) {
+    w.WriteByte(value);
+    w.WriteByte(activate);
+}
+
+void CLKPRRegister::RestoreState(SnapshotReader &r) {
+    value = r.ReadByte();
+    activate = r.ReadByte();
+}
+
 void CLKPRRegister::set(unsigned char v) {
     if(v == 0x80) {
         // set activation period
@@ -165,6 +185,14 @@ void XDIVRegister::set(unsigned char v) {
     }
 }
 
+void XDIVRegister::SaveState(SnapshotWriter &w) {
+    w.WriteByte(value);
+}
+
+void XDIVRegister::RestoreState(SnapshotReader &r) {
+    value = r.ReadByte();
+}
+
 OSCCALRegister::OSCCALRegister(AvrDevice *core,
                              TraceValueRegister *registry,
                              int cal):
@@ -192,29 +220,68 @@ void OSCCALRegister::set(unsigned char v) {
     value = v;
 }
 
-RAM::RAM(TraceValueCoreRegister *_reg, const std::string &name, const size_t number, const size_t maxsize) {
-    corereg = _reg;
+void OSCCALRegister::SaveState(SnapshotWriter &w) {
+    w.WriteByte(value);
+}
+
+void OSCCALRegister::RestoreState(SnapshotReader &r) {
+    value = r.ReadByte();
+}
+
+RAM::RAM(void):
+    RWMemoryMember(NULL)
+{
     value = 0xaa;
-    if(name.size()) {
-        tv = new TraceValue(8, corereg->GetTraceValuePrefix() + name, number);
-        if(!corereg) {
-            avr_error("registry not initialized for RWMemoryMember '%s'.", name.c_str());
-        }
-        corereg->RegisterTraceSetValue(tv, name, maxsize);
-    } else {
-        tv = NULL;
-    }
 }
 
 unsigned char RAM::get() const { return value; }
 
 void RAM::set(unsigned char v) { value=v; }
 
+void RAM::SaveCellState(SnapshotWriter &w) { w.WriteByte(value); }
+
+void RAM::RestoreCellState(SnapshotReader &r) { value = r.ReadByte(); }
+
+RAMArea::RAMArea(TraceValueCoreRegister *_reg, const std::string &name, const size_t _size):
+    registry(_reg),
+    tracename(name),
+    size(_size)
+{
+    cells = new RAM[size];
+    if(size > 0) {
+        if(!registry)
+            avr_error("registry not initialized for RAMArea '%s'.", name.c_str());
+        registry->RegisterTraceSet(this, name);
+    }
+}
+
+RAMArea::~RAMArea() {
+    delete [] cells;
+}
+
+TraceValue* RAMArea::GetTraceSetValue(size_t index) {
+    assert(index < size);
+    RAM &cell = cells[index];
+    if(cell.tv == NULL)
+        cell.tv = new TraceValue(8, registry->GetTraceValuePrefix() + tracename, index);
+    return cell.tv;
+}
+
 InvalidMem::InvalidMem(AvrDevice* _c, int _a):
     RWMemoryMember(),
     core(_c),
     addr(_a) {}
 
+InvalidMem::InvalidMem(void):
+    RWMemoryMember(),
+    core(NULL),
+    addr(0) {}
+
+void InvalidMem::SetAddress(AvrDevice *_c, int _a) {
+    core = _c;
+    addr = _a;
+}
+
 unsigned char InvalidMem::get() const {
     string s = "Invalid read access from IO[0x" + int2hex(addr) + "], PC=0x" + int2hex(core->PC * 2);
     if(core->abortOnInvalidAccess)
@@ -262,4 +329,8 @@ void IOSpecialReg::set(unsigned char val) {
     value = val;
 }
 
+void IOSpecialReg::SaveCellState(SnapshotWriter &w) { w.WriteByte(value); }
+
+void IOSpecialReg::RestoreCellState(SnapshotReader &r) { value = r.ReadByte(); }
+
 // EOF
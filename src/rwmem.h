@@ -66,6 +66,12 @@ class RWMemoryMember {
         virtual ~RWMemoryMember();
         const std::string &GetTraceName(void) { return tracename; }
         bool IsInvalid(void) const { return isInvalid; } 
+        //! Save value for a snapshot, if this memory cell holds the value itself
+        /*! Cells, which are only a interface to hardware (like IOReg) store
+          nothing, this is done by the hardware itself. */
+        virtual void SaveCellState(SnapshotWriter &w) {}
+        //! Restore value from a snapshot, see SaveCellState
+        virtual void RestoreCellState(SnapshotReader &r) {}
 
     protected:
         /*! This function is the function which will
@@ -101,6 +107,8 @@ class GPIORegister: public RWMemoryMember, public Hardware {
         
         // from Hardware
         void Reset(void) { value = 0; }
+        void SaveState(SnapshotWriter &w);
+        void RestoreState(SnapshotReader &r);
         
     protected:
         unsigned char get() const { return value; }
@@ -120,6 +128,8 @@ class CLKPRRegister: public RWMemoryMember, public Hardware {
         // from Hardware
         void Reset(void);
         unsigned int CpuCycle(void);
+        void SaveState(SnapshotWriter &w);
+        void RestoreState(SnapshotReader &r);
 
     protected:
         unsigned char get() const { return value; }
@@ -140,6 +150,8 @@ class XDIVRegister: public RWMemoryMember, public Hardware {
 
         // from Hardware
         void Reset(void) { value = 0; }
+        void SaveState(SnapshotWriter &w);
+        void RestoreState(SnapshotReader &r);
 
     protected:
         unsigned char get() const { return value; }
@@ -166,6 +178,8 @@ class OSCCALRegister: public RWMemoryMember, public Hardware {
 
         // from Hardware
         void Reset(void);
+        void SaveState(SnapshotWriter &w);
+        void RestoreState(SnapshotReader &r);
 
     protected:
         unsigned char get() const { return value; }
@@ -177,22 +191,49 @@ class OSCCALRegister: public RWMemoryMember, public Hardware {
 };
 
 //! One byte in any AVR RAM
-/*! Allows clean read and write accesses and simply has one stored byte. */
+/*! Allows clean read and write accesses and simply has one stored byte.
+  Cells are created by RAMArea, which holds also the trace values. */
 class RAM : public RWMemoryMember {
     
     public:
-        RAM(TraceValueCoreRegister *registry,
-            const std::string &tracename,
-            const size_t number,
-            const size_t maxsize);
+        RAM(void);
+
+        void SaveCellState(SnapshotWriter &w);
+        void RestoreCellState(SnapshotReader &r);
         
     protected:
         unsigned char get() const;
         void set(unsigned char);
         
     private:
+        friend class RAMArea;
+
         unsigned char value;
-        TraceValueCoreRegister *corereg;
+};
+
+//! A contiguous AVR RAM area, like registers, internal or external RAM
+/*! All cells of the area are allocated as one array. A TraceValue for a cell
+  is only created, if a tracer asks for it by name. */
+class RAMArea : public TraceSetSource {
+    
+    public:
+        RAMArea(TraceValueCoreRegister *registry,
+                const std::string &tracename,
+                const size_t size);
+        ~RAMArea();
+
+        //! Returns the memory cell on index
+        RAM* GetCell(size_t index) { return &cells[index]; }
+
+        // from TraceSetSource
+        size_t GetTraceSetSize(void) { return size; }
+        TraceValue* GetTraceSetValue(size_t index);
+        
+    private:
+        TraceValueCoreRegister *registry;
+        const std::string tracename;
+        const size_t size;
+        RAM *cells;
 };
 
 //! Memory on which access should be avoided! :-)
@@ -204,6 +245,10 @@ class InvalidMem : public RWMemoryMember {
         
     public:
         InvalidMem(AvrDevice *core, int addr);
+        //! Create a invalid cell for a array, see SetAddress
+        InvalidMem(void);
+        //! Set core and address of a cell, which was created by InvalidMem(void)
+        void SetAddress(AvrDevice *core, int addr);
         
     protected:
         unsigned char get() const;
@@ -348,6 +393,9 @@ class IOSpecialReg: public RWMemoryMember {
           @param val the new register value
           @param mask the bitmask for val */
         void hardwareChangeMask(unsigned char val, unsigned char mask) { if(tv) tv->change(val, mask); }
+
+        void SaveCellState(SnapshotWriter &w);
+        void RestoreCellState(SnapshotReader &r);
         
     protected:
         std::vector<IOSpecialRegClient*> clients; //!< clients-list with registered clients
@@ -0,0 +1,154 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2001, 2002 - 2012   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#include <fstream>
+
+#include "snapshot.h"
+#include "avrdevice.h"
+#include "systemclock.h"
+#include "avrerror.h"
+
+using namespace std;
+
+//! identifies a snapshot file
+static const char snapshotMagic[8] = { 'S', 'A', 'V', 'R', 'S', 'N', 'A', 'P' };
+//! format version, increment it, if layout of stored data changes
+static const unsigned long snapshotVersion = 3;
+
+void SnapshotWriter::WriteWord(unsigned int v) {
+    WriteByte(v & 0xff);
+    WriteByte((v >> 8) & 0xff);
+}
+
+void SnapshotWriter::WriteDWord(unsigned long v) {
+    WriteWord(v & 0xffff);
+    WriteWord((v >> 16) & 0xffff);
+}
+
+void SnapshotWriter::WriteTime(SystemClockOffset v) {
+    unsigned long long u = (unsigned long long)v;
+    WriteDWord((unsigned long)(u & 0xffffffffULL));
+    WriteDWord((unsigned long)(u >> 32));
+}
+
+void SnapshotWriter::WriteBlock(const unsigned char *data, unsigned int size) {
+    os.write((const char *)data, size);
+}
+
+void SnapshotWriter::WriteString(const string &s) {
+    WriteDWord(s.size());
+    os.write(s.data(), s.size());
+}
+
+void SnapshotReader::UnexpectedEnd(void) {
+    avr_error("snapshot: unexpected end of data");
+}
+
+unsigned int SnapshotReader::ReadWord(void) {
+    unsigned int v = ReadByte();
+    return v | (ReadByte() << 8);
+}
+
+unsigned long SnapshotReader::ReadDWord(void) {
+    unsigned long v = ReadWord();
+    return v | ((unsigned long)ReadWord() << 16);
+}
+
+SystemClockOffset SnapshotReader::ReadTime(void) {
+    unsigned long long u = ReadDWord();
+    u |= (unsigned long long)ReadDWord() << 32;
+    return (SystemClockOffset)u;
+}
+
+void SnapshotReader::ReadBlock(unsigned char *data, unsigned int size) {
+    is.read((char *)data, size);
+    if((unsigned int)is.gcount() != size)
+        UnexpectedEnd();
+}
+
+string SnapshotReader::ReadString(void) {
+    unsigned long size = ReadDWord();
+    string s;
+    for(unsigned long i = 0; i < size; i++)
+        s += (char)ReadByte();
+    return s;
+}
+
+void SaveSnapshot(AvrDevice *core, ostream &os) {
+    SnapshotWriter w(os);
+    SystemClock &clk = SystemClock::Instance();
+
+    w.WriteBlock((const unsigned char *)snapshotMagic, sizeof(snapshotMagic));
+    w.WriteDWord(snapshotVersion);
+    w.WriteString(core->GetDeviceName());
+
+    // simulation time and the time, on which this core will be called next
+    w.WriteTime(clk.GetCurrentTime());
+    w.WriteTime(clk.GetNextTime(core));
+
+    core->SaveState(w);
+    if(!os.good())
+        avr_error("snapshot: write error");
+}
+
+void SaveSnapshot(AvrDevice *core, const string &filename) {
+    ofstream f(filename.c_str(), ios::out | ios::binary);
+    if(!f.is_open())
+        avr_error("snapshot: can't open file '%s' for writing", filename.c_str());
+    SaveSnapshot(core, f);
+}
+
+void RestoreSnapshot(AvrDevice *core, istream &is) {
+    SnapshotReader r(is);
+    char magic[sizeof(snapshotMagic)];
+
+    r.ReadBlock((unsigned char *)magic, sizeof(magic));
+    if(string(magic, sizeof(magic)) != string(snapshotMagic, sizeof(snapshotMagic)))
+        avr_error("snapshot: not a simulavr snapshot");
+    unsigned long version = r.ReadDWord();
+    if(version != snapshotVersion)
+        avr_error("snapshot: unsupported version %lu", version);
+    // device name is only known, if set by application, memory layout is
+    // checked later by AvrDevice::RestoreState
+    string name = r.ReadString();
+    if(name.size() && core->GetDeviceName().size() && name != core->GetDeviceName())
+        avr_error("snapshot: taken from device '%s', but device is '%s'",
+                  name.c_str(), core->GetDeviceName().c_str());
+
+    SystemClockOffset time = r.ReadTime();
+    SystemClockOffset next = r.ReadTime();
+
+    core->RestoreState(r);
+    SystemClock::Instance().RestoreTime(time, core, next);
+}
+
+void RestoreSnapshot(AvrDevice *core, const string &filename) {
+    ifstream f(filename.c_str(), ios::in | ios::binary);
+    if(!f.is_open())
+        avr_error("snapshot: can't open file '%s' for reading", filename.c_str());
+    RestoreSnapshot(core, f);
+}
+
+// EOF
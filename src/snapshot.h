@@ -0,0 +1,100 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2001, 2002 - 2012   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#ifndef SNAPSHOT
+#define SNAPSHOT
+
+#include <string>
+#include <iostream>
+
+#include "systemclocktypes.h"
+
+class AvrDevice;
+
+//! Writes simulation state as compact binary data (little endian)
+/*! Used by AvrDevice::SaveState and Hardware::SaveState to store the complete
+  state of a device. The reader on the other side must read the values in
+  exactly the same order and size. */
+class SnapshotWriter {
+
+    protected:
+        std::ostream &os; //!< stream to write to
+
+    public:
+        SnapshotWriter(std::ostream &_os): os(_os) {}
+
+        void WriteByte(unsigned char v) { os.rdbuf()->sputc((char)v); }
+        void WriteBool(bool v) { WriteByte(v ? 1 : 0); }
+        void WriteWord(unsigned int v);
+        void WriteDWord(unsigned long v);
+        void WriteInt(int v) { WriteDWord((unsigned long)(unsigned int)v); }
+        void WriteTime(SystemClockOffset v);
+        void WriteBlock(const unsigned char *data, unsigned int size);
+        void WriteString(const std::string &s);
+};
+
+//! Reads simulation state written by SnapshotWriter
+/*! All read methods abort with an error, if data ends unexpected. */
+class SnapshotReader {
+
+    protected:
+        std::istream &is; //!< stream to read from
+
+        void UnexpectedEnd(void);
+
+    public:
+        SnapshotReader(std::istream &_is): is(_is) {}
+
+        unsigned char ReadByte(void) {
+            // direct buffer access, RAM and eeprom are read byte by byte
+            int c = is.rdbuf()->sbumpc();
+            if(c == std::char_traits<char>::eof())
+                UnexpectedEnd();
+            return (unsigned char)c;
+        }
+        bool ReadBool(void) { return ReadByte() != 0; }
+        unsigned int ReadWord(void);
+        unsigned long ReadDWord(void);
+        int ReadInt(void) { return (int)(unsigned int)ReadDWord(); }
+        SystemClockOffset ReadTime(void);
+        void ReadBlock(unsigned char *data, unsigned int size);
+        std::string ReadString(void);
+        //! Returns true, if all data is consumed
+        bool AtEnd(void) { return is.peek() == std::char_traits<char>::eof(); }
+};
+
+//! Save complete state of a device and simulation time to a stream
+void SaveSnapshot(AvrDevice *core, std::ostream &os);
+//! Save complete state of a device and simulation time to a file
+void SaveSnapshot(AvrDevice *core, const std::string &filename);
+//! Restore state of a device and simulation time from a stream
+/*! The device must be of the same type as the device, from which the snapshot
+  was taken. Program (flash), eeprom and RAM content are part of the snapshot,
+  so it isn't necessary to load a program before. */
+void RestoreSnapshot(AvrDevice *core, std::istream &is);
+//! Restore state of a device and simulation time from a file
+void RestoreSnapshot(AvrDevice *core, const std::string &filename);
+
+#endif
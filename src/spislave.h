@@ -0,0 +1,52 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2001, 2002 - 2012   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#ifndef SPISLAVE_H_INCLUDED
+#define SPISLAVE_H_INCLUDED
+
+class Pin;
+
+//! Slave model, which exchanges whole bytes with a SPI master
+/*! A slave is attached to HWSpi by HWSpi::AttachSlave. The master calls
+  Transfer once at the end of the simulated transfer time of a byte. If
+  nothing else listens on SCK and MOSI, the master doesn't toggle them for
+  every bit anymore. Bytes are given MSB first, like a slave would shift them
+  in, if master sends with DORD=0. */
+class SpiSlave {
+
+    public:
+        virtual ~SpiSlave() {}
+
+        //! Returns true, if slave is selected by its /SS input
+        virtual bool IsSelected(void) = 0;
+        //! Takes the byte sent by master, returns the byte shifted out to master meanwhile
+        virtual unsigned char Transfer(unsigned char mosi) = 0;
+        //! Returns true, if p is a pin of this slave
+        /*! Such a pin doesn't count as listener on SCK or MOSI nets, because the
+          slave gets the bytes by Transfer. */
+        virtual bool OwnsPin(Pin *p) { return false; }
+};
+
+#endif
@@ -0,0 +1,313 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2001, 2002 - 2012   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+
+#include <algorithm>
+#include <map>
+#include <sstream>
+#include <stdlib.h>
+
+#include "stimulus.h"
+#include "systemclock.h"
+#include "avrerror.h"
+
+using namespace std;
+
+Stimulus::Stimulus(AvrDevice *_core):
+    core(_core),
+    nextEvent(0),
+    sorted(true),
+    checks(0),
+    errors(0)
+{
+    startTime = SystemClock::Instance().GetCurrentTime();
+}
+
+Stimulus::~Stimulus() {
+    for(size_t i = 0; i < recorders.size(); i++) {
+        vector<HasPinNotifyFunction*> &l = recorders[i]->pin->notifyList;
+        vector<HasPinNotifyFunction*>::iterator ii = find(l.begin(), l.end(), recorders[i]);
+        if(ii != l.end())
+            l.erase(ii);
+        delete recorders[i];
+    }
+    for(size_t i = 0; i < signals.size(); i++) {
+        delete signals[i]->net;
+        delete signals[i];
+    }
+}
+
+SystemClockOffset Stimulus::Now(void) {
+    return SystemClock::Instance().GetCurrentTime() - startTime;
+}
+
+//! Finds a device pin by name, "PB0" is accepted for "B0"
+static Pin *FindDevicePin(AvrDevice *core, const string &name) {
+    Pin *p = core->FindPin(name.c_str());
+    if(p == NULL && name.size() > 1 && name[0] == 'P')
+        p = core->FindPin(name.substr(1).c_str());
+    return p;
+}
+
+size_t Stimulus::GetSignal(const string &name) {
+    for(size_t i = 0; i < signals.size(); i++)
+        if(signals[i]->name == name)
+            return i;
+    Pin *p = FindDevicePin(core, name);
+    if(p == NULL)
+        avr_error("stimulus: unknown pin '%s'", name.c_str());
+    Signal *s = new Signal;
+    s->name = name;
+    s->pin = p;
+    s->net = NULL;
+    signals.push_back(s);
+    return signals.size() - 1;
+}
+
+void Stimulus::AddEvent(SystemClockOffset time, const string &pin, const string &value, bool check) {
+    Event e;
+    e.time = time;
+    e.at = check ? time + 1 : time;
+    e.signal = GetSignal(pin);
+    e.value = value.size() ? value[0] : ' ';
+    e.analog = 0.0;
+    e.check = check;
+    if(e.value == 'a' && !check) {
+        char *end;
+        e.analog = strtod(value.c_str() + 1, &end);
+        if(value.size() < 2 || *end != 0)
+            avr_error("stimulus: invalid analog value '%s' for pin %s", value.c_str(), pin.c_str());
+    } else if(value.size() != 1 || string("01zhlx").find(e.value) == string::npos)
+        avr_error("stimulus: invalid value '%s' for pin %s", value.c_str(), pin.c_str());
+
+    Signal *s = signals[e.signal];
+    if(!check && s->net == NULL) {
+        s->net = new Net;
+        s->net->Add(s->pin);
+        s->net->Add(&s->ext);
+    }
+
+    if(events.size() > nextEvent && e.at < events.back().at)
+        sorted = false;
+    events.push_back(e);
+}
+
+//! Parses a time with optional unit, result in ns
+static bool ParseTime(const string &s, SystemClockOffset &t) {
+    char *end;
+    double v = strtod(s.c_str(), &end);
+    string unit(end);
+    if(end == s.c_str())
+        return false;
+    if(unit == "" || unit == "ns")
+        t = (SystemClockOffset)v;
+    else if(unit == "us")
+        t = (SystemClockOffset)(v * 1000);
+    else if(unit == "ms")
+        t = (SystemClockOffset)(v * 1000000);
+    else if(unit == "s")
+        t = (SystemClockOffset)(v * 1000000000);
+    else
+        return false;
+    return true;
+}
+
+//! Removes leading and trailing white space
+static string Trim(const string &s) {
+    size_t b = s.find_first_not_of(" \t\r\n");
+    if(b == string::npos)
+        return "";
+    return s.substr(b, s.find_last_not_of(" \t\r\n") - b + 1);
+}
+
+void Stimulus::LoadCsv(const string &filename) {
+    ifstream f(filename.c_str());
+    if(!f.is_open())
+        avr_error("stimulus: can't open '%s'", filename.c_str());
+    string line;
+    unsigned int lineNo = 0;
+    while(getline(f, line)) {
+        lineNo++;
+        line = Trim(line);
+        if(line.empty() || line[0] == '#')
+            continue;
+        size_t c1 = line.find(','), c2 = line.find(',', c1 + 1);
+        SystemClockOffset t;
+        if(c1 == string::npos || c2 == string::npos || !ParseTime(Trim(line.substr(0, c1)), t))
+            avr_error("stimulus: syntax error in %s:%u", filename.c_str(), lineNo);
+        string pin = Trim(line.substr(c1 + 1, c2 - c1 - 1));
+        bool check = pin.size() && pin[0] == '?';
+        if(check)
+            pin = pin.substr(1);
+        AddEvent(t, pin, Trim(line.substr(c2 + 1)), check);
+    }
+}
+
+void Stimulus::LoadVcd(const string &filename) {
+    ifstream f(filename.c_str());
+    if(!f.is_open())
+        avr_error("stimulus: can't open '%s'", filename.c_str());
+
+    double scale = 1.0; // ns per time unit
+    map<string, string> ids; // VCD identifier to pin name
+    SystemClockOffset t = 0;
+    string tok;
+    while(f >> tok) {
+        if(tok == "$timescale") {
+            string ts;
+            while(f >> tok && tok != "$end")
+                ts += tok;
+            char *end;
+            double v = strtod(ts.c_str(), &end);
+            string unit(end);
+            if(unit == "s") scale = v * 1e9;
+            else if(unit == "ms") scale = v * 1e6;
+            else if(unit == "us") scale = v * 1e3;
+            else if(unit == "ns") scale = v;
+            else if(unit == "ps") scale = v * 1e-3;
+            else if(unit == "fs") scale = v * 1e-6;
+            else
+                avr_error("stimulus: unknown timescale '%s' in %s", ts.c_str(), filename.c_str());
+        } else if(tok == "$var") {
+            string type, size, id, name;
+            f >> type >> size >> id >> name;
+            while(f >> tok && tok != "$end")
+                ;
+            if((size == "1" || type == "real") && FindDevicePin(core, name) != NULL)
+                ids[id] = name;
+        } else if(tok == "$dumpvars" || tok == "$dumpall" || tok == "$dumpon" ||
+                  tok == "$dumpoff" || tok == "$end") {
+            // value changes inside are handled as usual
+        } else if(tok[0] == '$') {
+            while(f >> tok && tok != "$end")
+                ;
+        } else if(tok[0] == '#') {
+            t = (SystemClockOffset)(strtod(tok.c_str() + 1, NULL) * scale);
+        } else {
+            string id, value;
+            char c = tolower(tok[0]);
+            if(c == 'b' || c == 'r') {
+                f >> id;
+                value = (c == 'r') ? "a" + tok.substr(1) : tok.substr(tok.size() - 1);
+            } else {
+                id = tok.substr(1);
+                value = tok.substr(0, 1);
+            }
+            map<string, string>::iterator i = ids.find(id);
+            if(i == ids.end())
+                continue;
+            value[0] = tolower(value[0]);
+            AddEvent(t, i->second, value, false);
+        }
+    }
+}
+
+void Stimulus::Load(const string &filename) {
+    if(filename.size() > 4 && filename.substr(filename.size() - 4) == ".vcd")
+        LoadVcd(filename);
+    else
+        LoadCsv(filename);
+}
+
+char Stimulus::StateChar(Pin::T_Pinstate st) {
+    switch(st) {
+        case Pin::LOW:      return '0';
+        case Pin::HIGH:     return '1';
+        case Pin::PULLUP:   return 'h';
+        case Pin::PULLDOWN: return 'l';
+        case Pin::TRISTATE: return 'z';
+        case Pin::ANALOG:   return 'a';
+        default:            return 'x';
+    }
+}
+
+void Stimulus::Apply(const Event &e) {
+    Signal *s = signals[e.signal];
+    if(e.check) {
+        checks++;
+        char got = StateChar(s->pin->outState);
+        if(got != e.value) {
+            errors++;
+            avr_warning("stimulus: pin %s at %lld ns: expected %c, got %c",
+                        s->name.c_str(), (long long)e.time, e.value, got);
+        }
+        return;
+    }
+    switch(e.value) {
+        case '0': s->ext = 'L'; break;
+        case '1': s->ext = 'H'; break;
+        case 'z': s->ext = 't'; break;
+        case 'h': s->ext = 'h'; break;
+        case 'l': s->ext = 'l'; break;
+        case 'x': s->ext = 't'; break; // unknown value isn't driven
+        case 'a':
+            s->ext.outState = Pin::ANALOG;
+            s->ext.SetAnalogValue(e.analog);
+            break;
+    }
+}
+
+int Stimulus::Step(bool &trueHwStep, SystemClockOffset *timeToNextStepIn_ns) {
+    if(!sorted) {
+        stable_sort(events.begin() + nextEvent, events.end());
+        sorted = true;
+    }
+    SystemClockOffset now = Now();
+    while(nextEvent < events.size() && events[nextEvent].at <= now)
+        Apply(events[nextEvent++]);
+    if(timeToNextStepIn_ns != NULL)
+        *timeToNextStepIn_ns = (nextEvent < events.size()) ? events[nextEvent].at - now : -1;
+    return 0;
+}
+
+void Stimulus::Record(const string &filename, const vector<string> &pins) {
+    recordFile.open(filename.c_str());
+    if(!recordFile.is_open())
+        avr_error("stimulus: can't open record file '%s'", filename.c_str());
+    recordFile << "# time,?pin,state recorded by simulavr" << endl;
+    for(size_t i = 0; i < pins.size(); i++) {
+        Recorder *r = new Recorder;
+        r->stim = this;
+        r->name = pins[i];
+        r->pin = FindDevicePin(core, pins[i]);
+        if(r->pin == NULL) {
+            delete r;
+            avr_error("stimulus: unknown pin '%s'", pins[i].c_str());
+        }
+        r->last = r->pin->outState;
+        recordFile << Now() << ",?" << r->name << "," << StateChar(r->last) << endl;
+        r->pin->RegisterCallback(r);
+        recorders.push_back(r);
+    }
+}
+
+void Stimulus::Recorder::PinStateHasChanged(Pin *) {
+    if(pin->outState == last)
+        return;
+    last = pin->outState;
+    stim->recordFile << stim->Now() << ",?" << name << "," << StateChar(last) << "\n";
+}
+
+// EOF
@@ -0,0 +1,135 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2001, 2002 - 2012   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+
+#ifndef STIMULUS
+#define STIMULUS
+
+#include <string>
+#include <vector>
+#include <fstream>
+
+#include "simulationmember.h"
+#include "avrdevice.h"
+#include "pin.h"
+#include "net.h"
+#include "pinnotify.h"
+
+//! Drives device pins from a timed waveform and checks expected pin states
+/*! Waveforms are loaded from CSV or VCD files. Every signal gets a own pin,
+  which is connected by a net to the device pin, so the device pin can still
+  drive the net. Transitions are scheduled exactly in SystemClock, times are
+  relative to the time, on which Stimulus was added to SystemClock.
+
+  CSV format, one transition per line, '#' starts a comment line:
+
+  <time>[ns|us|ms|s],<pin>,<value>
+
+  value is one of 0, 1, z, h (pull up), l (pull down), x (shorted) or
+  a<volt> for a analog value. If pin is written as ?<pin>, it's a check of
+  the expected output state of device pin (0, 1, z, h, l or x) instead of a
+  transition. Checks are done 1ns after the given time, so they see all
+  changes on this time. Such lines are also written by Record, so a recorded file
+  of a good run can be used to check later runs.
+
+  VCD files are read for scalar and real variables, the variable name is the
+  pin name like "B0" or "PB0", other variables are ignored. */
+class Stimulus: public SimulationMember {
+
+    protected:
+        //! A driven or checked device pin
+        struct Signal {
+            std::string name;   //!< pin name
+            Pin *pin;           //!< device pin
+            Pin ext;            //!< pin, which drives the signal
+            Net *net;           //!< net between pin and ext, created on first transition
+        };
+
+        //! A transition or check on a signal
+        struct Event {
+            SystemClockOffset time;  //!< time relative to start
+            SystemClockOffset at;    //!< time to process, checks are done 1ns later
+            size_t signal;           //!< index in signals
+            char value;              //!< state character, see class description
+            float analog;            //!< value for 'a'
+            bool check;              //!< true for a check of expected state
+            bool operator<(const Event &e) const { return at < e.at; }
+        };
+
+        //! Writes state changes of a device pin for Record
+        class Recorder: public HasPinNotifyFunction {
+            public:
+                Stimulus *stim;
+                Pin *pin;
+                std::string name;
+                Pin::T_Pinstate last;
+
+                void PinStateHasChanged(Pin *);
+        };
+
+        AvrDevice *core;
+        std::vector<Signal *> signals;
+        std::vector<Event> events;
+        size_t nextEvent;             //!< index of next event to process
+        bool started;                 //!< first Step was done
+        bool sorted;                  //!< events are sorted by time
+        SystemClockOffset startTime;  //!< simulation time of first Step
+        unsigned int checks;          //!< count of checks done
+        unsigned int errors;          //!< count of failed checks
+        std::ofstream recordFile;
+        std::vector<Recorder *> recorders;
+
+        size_t GetSignal(const std::string &name);
+        void AddEvent(SystemClockOffset time, const std::string &pin, const std::string &value, bool check);
+        void Apply(const Event &e);
+        SystemClockOffset Now(void);
+
+    public:
+        Stimulus(AvrDevice *core);
+        ~Stimulus();
+
+        //! Loads a CSV waveform
+        void LoadCsv(const std::string &filename);
+        //! Loads a VCD waveform
+        void LoadVcd(const std::string &filename);
+        //! Loads a VCD waveform, if filename ends with ".vcd", otherwise CSV
+        void Load(const std::string &filename);
+        //! Records output state changes of the given device pins to a CSV file with checks
+        void Record(const std::string &filename, const std::vector<std::string> &pins);
+
+        //! Returns state character of output stage of a pin, see class description
+        static char StateChar(Pin::T_Pinstate st);
+
+        //! Returns count of checks done
+        unsigned int GetChecks(void) const { return checks; }
+        //! Returns count of failed checks
+        unsigned int GetErrors(void) const { return errors; }
+        //! True, if all transitions and checks are processed
+        bool IsFinished(void) const { return nextEvent >= events.size(); }
+
+        int Step(bool &trueHwStep, SystemClockOffset *timeToNextStepIn_ns = 0);
+};
+
+#endif
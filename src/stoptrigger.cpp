@@ -0,0 +1,116 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2001, 2002 - 2012   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+
+#include <algorithm>
+
+#include "stoptrigger.h"
+#include "systemclock.h"
+#include "flash.h"
+#include "avrerror.h"
+
+void StopTrigger::Fire(void) {
+    hits++;
+    SystemClock::Instance().Stop();
+}
+
+PinChangeTrigger::PinChangeTrigger(Pin *_pin):
+    pin(_pin)
+{
+    lastLevel = GetLevel();
+    pin->RegisterCallback(this);
+}
+
+PinChangeTrigger::~PinChangeTrigger() {
+    std::vector<HasPinNotifyFunction*>::iterator ii =
+        std::find(pin->notifyList.begin(), pin->notifyList.end(), this);
+    if(ii != pin->notifyList.end())
+        pin->notifyList.erase(ii);
+}
+
+bool PinChangeTrigger::GetLevel(void) {
+    // a pin without net sees its own output stage, otherwise the input value
+    // from net is held as analog value (floating is seen as high)
+    if(!pin->isConnected())
+        return (bool)*pin;
+    return pin->GetAnalogValue(1.0) > 0.5;
+}
+
+void PinChangeTrigger::PinStateHasChanged(Pin *) {
+    bool level = GetLevel();
+    if(level != lastLevel) {
+        lastLevel = level;
+        Fire();
+    }
+}
+
+WriteTrigger::WriteTrigger(AvrDevice *_core, unsigned int _addr, int _value):
+    RWMemoryMember(_core, ""),
+    core(_core),
+    addr(_addr),
+    value(_value)
+{
+    cell = core->GetMemRegisterInstance(addr);
+    if(cell == NULL)
+        avr_error("write trigger: address 0x%x out of data space", addr);
+    core->ReplaceMemRegister(addr, this);
+}
+
+WriteTrigger::~WriteTrigger() {
+    if(core->GetMemRegisterInstance(addr) == this)
+        core->ReplaceMemRegister(addr, cell);
+}
+
+unsigned char WriteTrigger::get() const {
+    return *cell;
+}
+
+void WriteTrigger::set(unsigned char v) {
+    *cell = v;
+    if(value < 0 || value == v)
+        Fire();
+}
+
+PCTrigger::PCTrigger(AvrDevice *_core, const std::string &symbol):
+    core(_core)
+{
+    pc = core->Flash->GetAddressAtSymbol(symbol);
+    next = core->GetPCObserver();
+    core->SetPCObserver(this);
+}
+
+PCTrigger::~PCTrigger() {
+    if(core->GetPCObserver() == this)
+        core->SetPCObserver(next);
+}
+
+void PCTrigger::OnExecute(unsigned int _pc) {
+    if(next != NULL)
+        next->OnExecute(_pc);
+    if(_pc == pc)
+        Fire();
+}
+
+// EOF
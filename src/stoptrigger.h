@@ -0,0 +1,116 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2001, 2002 - 2012   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+
+#ifndef STOPTRIGGER
+#define STOPTRIGGER
+
+#include <string>
+
+#include "avrdevice.h"
+#include "pin.h"
+#include "rwmem.h"
+
+//! Condition, which stops a running simulation
+/*! If the condition is met, SystemClock::Stop is called, so Run, Endless or
+  RunTimeRange return after the current step. This way a script (python, Tcl)
+  can run a long time range at once and is only woken up on a interesting
+  event, instead of polling in small time slices. */
+class StopTrigger {
+
+    protected:
+        unsigned int hits; //!< count of met conditions since last Clear
+
+        void Fire(void);
+
+    public:
+        StopTrigger(): hits(0) {}
+        virtual ~StopTrigger() {}
+
+        //! True, if condition was met since last Clear
+        bool HasFired(void) const { return hits != 0; }
+        //! Returns count of met conditions since last Clear
+        unsigned int GetHits(void) const { return hits; }
+        //! Clears fired state
+        void Clear(void) { hits = 0; }
+};
+
+//! Stops simulation, if input level of a pin changes
+class PinChangeTrigger: public StopTrigger, public HasPinNotifyFunction {
+
+    protected:
+        Pin *pin;
+        bool lastLevel; //!< input level on last notification
+
+        bool GetLevel(void);
+
+    public:
+        PinChangeTrigger(Pin *pin);
+        ~PinChangeTrigger();
+
+        void PinStateHasChanged(Pin *);
+};
+
+//! Stops simulation, if a data address is written
+/*! Replaces the memory cell on address by itself and forwards all accesses to
+  the replaced cell. Only writes by the core and by hardware through the cell
+  are seen. */
+class WriteTrigger: public StopTrigger, public RWMemoryMember {
+
+    protected:
+        AvrDevice *core;
+        unsigned int addr;
+        int value;              //!< fire only on this value or -1 for all values
+        RWMemoryMember *cell;   //!< replaced memory cell
+
+        unsigned char get() const;
+        void set(unsigned char);
+
+    public:
+        //! Fires on write to data address addr, with value >= 0 only, if this value is written
+        WriteTrigger(AvrDevice *core, unsigned int addr, int value = -1);
+        ~WriteTrigger();
+};
+
+//! Stops simulation, if program counter reaches a address
+/*! The instruction on this address is executed, before simulation stops. A
+  other PC observer (like CoverageRecorder) is kept and called before, it has
+  to be created before the trigger and to be removed after it. */
+class PCTrigger: public StopTrigger, public PCObserver {
+
+    protected:
+        AvrDevice *core;
+        unsigned int pc;        //!< word address
+        PCObserver *next;       //!< replaced observer or NULL
+
+    public:
+        //! Fires, if core reaches symbol in flash (or a hex address, like option -T)
+        PCTrigger(AvrDevice *core, const std::string &symbol);
+        ~PCTrigger();
+
+        void OnExecute(unsigned int pc);
+};
+
+#endif
@@ -130,6 +130,20 @@ void SystemClock::Add(SimulationMember *dev) {
     syncMembers.Insert(currentTime, dev);
 }
 
+void SystemClock::AddDelayed(SimulationMember *dev, SystemClockOffset delay) {
+    syncMembers.Insert(currentTime + delay, dev);
+}
+
+void SystemClock::Remove(SimulationMember *sm) {
+    MinHeap<SystemClockOffset, SimulationMember *> old(syncMembers);
+
+    syncMembers.clear();
+    for(unsigned i = 0; i < old.size(); i++) {
+        if(old[i].second != sm)
+            syncMembers.Insert(old[i].first, old[i].second);
+    }
+}
+
 void SystemClock::AddAsyncMember(SimulationMember *dev) {
     asyncMembers.push_back(dev);
 }
@@ -195,6 +209,31 @@ void SystemClock::Reschedule(SimulationMember *sm, SystemClockOffset newTime) {
     syncMembers.Insert(newTime+currentTime+1, sm);
 }
 
+SystemClockOffset SystemClock::GetNextTime(SimulationMember *sm) const {
+    for(unsigned i = 0; i < syncMembers.size(); i++) {
+        if(syncMembers[i].second == sm)
+            return syncMembers[i].first;
+    }
+    return -1;
+}
+
+void SystemClock::RestoreTime(SystemClockOffset time, SimulationMember *sm, SystemClockOffset nextTime) {
+    MinHeap<SystemClockOffset, SimulationMember *> old(syncMembers);
+    SystemClockOffset diff = time - currentTime;
+    bool member = false;
+
+    syncMembers.clear();
+    for(unsigned i = 0; i < old.size(); i++) {
+        if(old[i].second != sm)
+            syncMembers.Insert(old[i].first + diff, old[i].second);
+        else
+            member = true;
+    }
+    if(member)
+        syncMembers.Insert((nextTime >= 0) ? nextTime : time, sm);
+    currentTime = time;
+}
+
 void OnBreak(int s) {
     signal(SIGINT, SIG_DFL);
     signal(SIGTERM, SIG_DFL);
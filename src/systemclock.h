@@ -101,6 +101,10 @@ class SystemClock
         void IncrTime(SystemClockOffset of) { currentTime += of; }
         //! Add a simulation member (normally a device)
         void Add(SimulationMember *dev);
+        //! Add a simulation member, which is called first after delay [ns]
+        void AddDelayed(SimulationMember *dev, SystemClockOffset delay);
+        //! Removes a simulation member from time table, does nothing, if not found
+        void Remove(SimulationMember *sm);
         //! Add a async simulation member, this will be called every simulation step.
         void AddAsyncMember(SimulationMember *dev);
         //! Process one simulation step
@@ -120,6 +124,14 @@ class SystemClock
             
             \todo This method is possibly obsolete! */
         void Reschedule(SimulationMember *sm, SystemClockOffset newTime);
+        //! Returns the time, on which simulation member will be called next, or -1 if not in time table
+        SystemClockOffset GetNextTime(SimulationMember *sm) const;
+        //! Sets simulation time and the next call time for a simulation member (restore of a snapshot)
+        /*! All other members in time table are moved by the same offset like
+            the simulation time, so they keep their distance to current time.
+            If member isn't in time table (for instance if stepped by gdb server),
+            only the simulation time is set. */
+        void RestoreTime(SystemClockOffset time, SimulationMember *sm, SystemClockOffset nextTime);
         //! Switches trace mode for all current found simulation members
         void SetTraceModeForAllMembers(int trace_on);
         //! Stop Run/Endless or Step asynchronously
@@ -40,6 +40,7 @@ TraceValue::TraceValue(size_t bits,
                        const void *_shadow) :
     _name(__name),
     _index(__index),
+    _serial(_serialCount++),
     b(bits),
     shadow(_shadow),
     v(0xaffeaffe),
@@ -47,6 +48,8 @@ TraceValue::TraceValue(size_t bits,
     _written(false),
     _enabled(false) {}
 
+size_t TraceValue::_serialCount = 0;
+
 size_t TraceValue::bits() const { return b; }
 
 std::string TraceValue::name() const {
@@ -166,22 +169,13 @@ char TraceValueOutput::VcdBit(int bitNo) const {
     return 'x';
 }
 
-TraceValueRegister::~TraceValueRegister() {
-    for (valmap_t::iterator i = _tvr_values.begin(); i != _tvr_values.end(); i++)
-        delete i->first;
-    _tvr_values.clear();
-    for (regmap_t::iterator i = _tvr_registers.begin(); i != _tvr_registers.end(); i++)
-        delete i->first;
-    _tvr_registers.clear();
-}
+TraceValueRegister::~TraceValueRegister() {}
 
 void TraceValueRegister::_tvr_registerTraceValues(TraceValueRegister *r) {
     string n = r->GetScopeName();
-    if(GetScopeGroupByName(n) == NULL) {
-        string *s = new string(n);
-        pair<string*, TraceValueRegister*> v(s, r);
-        _tvr_registers.insert(v);
-    } else
+    if(GetScopeGroupByName(n) == NULL)
+        _tvr_registers.insert(pair<string, TraceValueRegister*>(n, r));
+    else
         avr_error("duplicate name '%s', another TraceValueRegister child is already registered", n.c_str());
 }
 
@@ -199,6 +193,15 @@ void TraceValueRegister::_tvr_insertTraceValuesToSet(TraceSet &t) {
         (i->second)->_tvr_insertTraceValuesToSet(t);
 }
 
+void TraceValueRegister::_tvr_insertMatchingValuesToSet(const std::string &pattern, TraceSet &t) {
+    for (valmap_t::iterator i = _tvr_values.begin(); i != _tvr_values.end(); i++) {
+        if(globmatch(pattern, i->second->name()))
+            t.push_back(i->second);
+    }
+    for (regmap_t::iterator i = _tvr_registers.begin(); i != _tvr_registers.end(); i++)
+        (i->second)->_tvr_insertMatchingValuesToSet(pattern, t);
+}
+
 void TraceValueRegister::RegisterTraceValue(TraceValue *t) {
     // check for duplicate names and the right prefix
     string p = t->name();
@@ -211,39 +214,27 @@ void TraceValueRegister::RegisterTraceValue(TraceValue *t) {
         avr_error("add TraceValue denied: wrong name: '%s', scope is '%s'",
                   n.c_str(), _tvr_scopeprefix.c_str());
     // register this TraceValue
-    if(GetTraceValueByName(n) == NULL) {
-        string *s = new string(n);
-        pair<string*, TraceValue*> v(s, t);
-        _tvr_values.insert(v);
-    } else
+    if(GetTraceValueByName(n) == NULL)
+        _tvr_values.insert(pair<string, TraceValue*>(n, t));
+    else
         avr_error("add TraceValue denied: name found: '%s'", n.c_str());
 }
 
 void TraceValueRegister::UnregisterTraceValue(TraceValue *t) {
     size_t idx = _tvr_scopeprefix.length();
-    string n = t->name().substr(idx);
-    for (valmap_t::iterator i = _tvr_values.begin(); i != _tvr_values.end(); i++) {
-        if(n == *(i->first)) {
-            _tvr_values.erase(i);
-            break;
-        }
-    }
+    valmap_t::iterator i = _tvr_values.find(t->name().substr(idx));
+    if(i != _tvr_values.end() && i->second == t)
+        _tvr_values.erase(i);
 }
 
 TraceValueRegister* TraceValueRegister::GetScopeGroupByName(const std::string &name) {
-    for (regmap_t::iterator i = _tvr_registers.begin(); i != _tvr_registers.end(); i++) {
-        if(name == *(i->first))
-            return i->second;
-    }
-    return NULL;
+    regmap_t::iterator i = _tvr_registers.find(name);
+    return (i != _tvr_registers.end()) ? i->second : NULL;
 }
 
 TraceValue* TraceValueRegister::GetTraceValueByName(const std::string &name) {
-    for (valmap_t::iterator i = _tvr_values.begin(); i != _tvr_values.end(); i++) {
-        if(name == *(i->first))
-            return i->second;
-    }
-    return NULL;
+    valmap_t::iterator i = _tvr_values.find(name);
+    return (i != _tvr_values.end()) ? i->second : NULL;
 }
 
 TraceValueRegister* TraceValueRegister::FindScopeGroupByName(const std::string &name) {
@@ -285,27 +276,19 @@ TraceSet* TraceValueRegister::GetAllTraceValuesRecursive(void) {
     return result;
 }
 
+TraceSet* TraceValueRegister::GetMatchingTraceValuesRecursive(const std::string &pattern) {
+    TraceSet* result = new TraceSet;
+    _tvr_insertMatchingValuesToSet(pattern, *result);
+    return result;
+}
+
 TraceValueCoreRegister::TraceValueCoreRegister(TraceValueRegister *parent):
     TraceValueRegister(parent, "CORE") {}
 
-void TraceValueCoreRegister::RegisterTraceSetValue(TraceValue *t, const std::string &name, const size_t size) {
-    // seek TraceSet
-    TraceSet *set = NULL;
-    for(setmap_t::iterator i = _tvr_valset.begin(); i != _tvr_valset.end(); i++) {
-        if(name == *(i->first)) {
-            set = i->second;
-            break;
-        }
-    }
-    // create TraceSet, if not found
-    if(set == NULL) {
-        set = new TraceSet(size, NULL);
-        string *s = new string(name);
-        pair<string*, TraceSet*> v(s, set);
-        _tvr_valset.insert(v);
-    }
-    // set TraceValue to set[idx]
-    (*set)[t->index()] = t;
+void TraceValueCoreRegister::RegisterTraceSet(TraceSetSource *src, const std::string &name) {
+    if(_tvr_valset.find(name) != _tvr_valset.end())
+        avr_error("add TraceValue group denied: name found: '%s'", name.c_str());
+    _tvr_valset.insert(pair<string, TraceSetSource*>(name, src));
 }
 
 TraceValue* TraceValueCoreRegister::GetTraceValueByName(const std::string &name) {
@@ -314,31 +297,24 @@ TraceValue* TraceValueCoreRegister::GetTraceValueByName(const std::string &name)
         size_t idx = _tvr_numberindex(name);
         if(idx != string::npos) {
             // name + number found, check name and index value
-            string n = name.substr(0, idx);
-            int v = atoi(name.substr(idx).c_str());
-            for(setmap_t::iterator i = _tvr_valset.begin(); i != _tvr_valset.end(); i++) {
-                if(n == *(i->first)) {
-                    TraceSet *set = i->second;
-                    if(v < (int)set->size())
-                        res = (*set)[v];
-                    break;
-                }
+            setmap_t::iterator i = _tvr_valset.find(name.substr(0, idx));
+            if(i != _tvr_valset.end()) {
+                int v = atoi(name.substr(idx).c_str());
+                if(v < (int)i->second->GetTraceSetSize())
+                    res = i->second->GetTraceSetValue(v);
             }
         }
     }
     return res;
 }
 
-TraceValueCoreRegister::~TraceValueCoreRegister() {
-    for(setmap_t::iterator i = _tvr_valset.begin(); i != _tvr_valset.end(); i++)
-        delete i->second;
-}
+TraceValueCoreRegister::~TraceValueCoreRegister() {}
 
 size_t TraceValueCoreRegister::_tvr_getValuesCount(void) {
     size_t cnt = TraceValueRegister::_tvr_getValuesCount();
     // now count too values in _tvr_valset
     for(setmap_t::iterator i = _tvr_valset.begin(); i != _tvr_valset.end(); i++)
-        cnt += i->second->size();
+        cnt += i->second->GetTraceSetSize();
     return cnt;
 }
 
@@ -346,9 +322,24 @@ void TraceValueCoreRegister::_tvr_insertTraceValuesToSet(TraceSet &t) {
     TraceValueRegister::_tvr_insertTraceValuesToSet(t);
     // now insert also all values from _tvr_valset
     for(setmap_t::iterator i = _tvr_valset.begin(); i != _tvr_valset.end(); i++) {
-        TraceSet* s = i->second;
-        for(TraceSet::iterator j = s->begin(); j != s->end(); j++)
-            t.push_back(*j);
+        TraceSetSource* s = i->second;
+        size_t size = s->GetTraceSetSize();
+        for(size_t j = 0; j < size; j++)
+            t.push_back(s->GetTraceSetValue(j));
+    }
+}
+
+void TraceValueCoreRegister::_tvr_insertMatchingValuesToSet(const std::string &pattern, TraceSet &t) {
+    TraceValueRegister::_tvr_insertMatchingValuesToSet(pattern, t);
+    // match values from _tvr_valset by name, create only the matching ones
+    for(setmap_t::iterator i = _tvr_valset.begin(); i != _tvr_valset.end(); i++) {
+        TraceSetSource* s = i->second;
+        string base = GetTraceValuePrefix() + i->first;
+        size_t size = s->GetTraceSetSize();
+        for(size_t j = 0; j < size; j++) {
+            if(globmatch(pattern, base + int2str(j)))
+                t.push_back(s->GetTraceSetValue(j));
+        }
     }
 }
 
@@ -421,9 +412,15 @@ void DumpVCD::setActiveSignals(const TraceSet &act) {
     unsigned n=0;
     for (TraceSet::const_iterator i=act.begin();
          i!=act.end(); i++) {
-        if (id2num.find(*i)!=id2num.end())
+        size_t s=(*i)->serial();
+        if (s>=traced.size()) {
+            traced.resize(s+1, false);
+            id2num.resize(s+1);
+        }
+        if (traced[s])
             avr_error("Trace value would be twice in VCD list.");
-        id2num[*i]=n++;
+        traced[s]=true;
+        id2num[s]=n++;
     }
 }
 
@@ -511,29 +508,30 @@ void DumpVCD::stop() {
 void DumpVCD::markRead(const TraceValue *t) {
     if (rs) {
         // mark read cycle
-        osbuffer << "1" << id2num[t]*(1+rs+ws)+1 << "\n";
+        osbuffer << "1" << id2num[t->serial()]*(1+rs+ws)+1 << "\n";
         changesWritten = true;
         // mark to disable @ next cycle
-        marked.push_back(id2num[t]*(1+rs+ws)+1);
+        marked.push_back(id2num[t->serial()]*(1+rs+ws)+1);
     }
 }
 
 void DumpVCD::markWrite(const TraceValue *t) {
     if (ws) {
-        osbuffer << "1" << id2num[t]*(1+rs+ws)+1+rs << "\n";
+        osbuffer << "1" << id2num[t->serial()]*(1+rs+ws)+1+rs << "\n";
         changesWritten = true;
-        marked.push_back(id2num[t]*(1+rs+ws)+1+rs);
+        marked.push_back(id2num[t->serial()]*(1+rs+ws)+1+rs);
     }
 }
 
 void DumpVCD::markChange(const TraceValue *t) {
     valout(t);
-    osbuffer << " " << id2num[t]*(1+rs+ws) << "\n";
+    osbuffer << " " << id2num[t->serial()]*(1+rs+ws) << "\n";
     changesWritten = true;
 }
 
 bool DumpVCD::enabled(const TraceValue *t) const {
-    return id2num.find(t)!=id2num.end();
+    size_t s=t->serial();
+    return s<traced.size() && traced[s];
 }
 
 DumpVCD::~DumpVCD() { delete os; }
@@ -725,7 +723,13 @@ TraceSet DumpManager::load(istream &is) {
         // empty line or to short?
         if(ls.size() < 2) continue;
         
-        if(ls[0] == "+") {
+        if(ls[0] == "+" && ls[1].find_first_of("*?") != string::npos) {
+            // glob pattern, select all matching values
+            TraceSet s = select(ls[1]);
+            if(s.size() == 0)
+                avr_error("TraceValue pattern '%s' matches nothing.", ls[1].c_str());
+            res.insert(res.end(), s.begin(), s.end());
+        } else if(ls[0] == "+") {
             // single value, get name
             string n = ls[1];
             // seek value
@@ -763,6 +767,16 @@ TraceSet DumpManager::load(const string &istr) {
     return load(is);
 }
 
+TraceSet DumpManager::select(const string &pattern) {
+    TraceSet res;
+    for(vector<AvrDevice*>::const_iterator d = devices.begin(); d != devices.end(); d++) {
+        TraceSet* s = (*d)->GetMatchingTraceValuesRecursive(pattern);
+        res.insert(res.end(), s->begin(), s->end());
+        delete s;
+    }
+    return res;
+}
+
 TraceValue* trace_direct(TraceValueRegister *t, const std::string &name, const bool *val) {
     TraceValue *tv=new TraceValue(1, t->GetTraceValuePrefix() + name,
                                   -1, val);
@@ -127,6 +127,10 @@ class TraceValue {
         //! Gives the index of this member in a memory field (or -1)
         int index() const;
 
+        //! Gives a unique number for this value, counted up from 0
+        /*! Dumpers use it as index into a bitset of traced values. */
+        size_t serial() const { return _serial; }
+
         //! Possible access types for a trace value
         enum Atype {
         READ=1, // true if a READ access has been logged
@@ -190,6 +194,11 @@ class TraceValue {
         std::string _name;
     
         int _index;
+
+        //! unique number, see serial()
+        const size_t _serial;
+        //! serial number for next created value
+        static size_t _serialCount;
     
         //! number of bits
         const unsigned b;
@@ -262,9 +271,8 @@ class Dumper {
         virtual ~Dumper() {}
     
         //! Returns true iff tracing a particular value is enabled
-        /*! FIXME: For a lot of values to trace,
-          checking enabled() each time by doing find on a map()
-          could be slow. Here is potential for more optimization! */
+        /*! This is checked for every active value in every cycle, so it
+          should be cheap. Use TraceValue::serial() to index a bitset. */
         virtual bool enabled(const TraceValue *t) const=0;
 };
 
@@ -320,7 +328,10 @@ class DumpVCD : public Dumper {
         
     private:
         TraceSet tv;
-        std::map<const TraceValue*, size_t> id2num;
+        //! bitset of TraceValue::serial() for all values in tv
+        std::vector<bool> traced;
+        //! position in tv for a TraceValue::serial(), if it's set in traced
+        std::vector<size_t> id2num;
         const std::string tscale;
         const bool rs, ws;
         bool changesWritten;
@@ -374,6 +385,9 @@ class DumpManager {
         /*! Process one AVR clock cycle. Must be done after the AVR did all
           processing so that changed values etc. can be collected. */
         void cycle();
+
+        //! Returns true, if there is at least one dumper
+        bool hasDumpers(void) const { return dumps.size() != 0; }
     
         //! Destroys the DumpManager instance and shut down all dumpers
         ~DumpManager() { stopApplication(); }
@@ -394,6 +408,10 @@ class DumpManager {
           @return TraceSet with found TraceValue's */
         TraceSet load(const std::string &istr);
 
+        /*! Gives all tracing values, which names match the glob pattern,
+          like 'CORE.r*' or 'PORTB.*'. Wildcards are '*' and '?'. */
+        TraceSet select(const std::string &pattern);
+
         /*! Gives all available tracers as a set. */
         const TraceSet& all();
         
@@ -442,8 +460,8 @@ class DumpManager {
 class TraceValueRegister {
     
     private:
-        typedef std::map<std::string*, TraceValue*> valmap_t; //!< type of values map
-        typedef std::map<std::string*, TraceValueRegister*> regmap_t; //!< type of subregisters map
+        typedef std::map<std::string, TraceValue*> valmap_t; //!< type of values map, indexed by name
+        typedef std::map<std::string, TraceValueRegister*> regmap_t; //!< type of subregisters map, indexed by name
         
         std::string _tvr_scopename; //!< the scope name itself
         std::string _tvr_scopeprefix; //!< the prefix scope for a TraceValue name
@@ -460,6 +478,9 @@ class TraceValueRegister {
         //! Insert all TraceValues into TraceSet, that registered here and descending
         virtual void _tvr_insertTraceValuesToSet(TraceSet &t);
         
+        //! Insert TraceValues, which names match a glob pattern, registered here and descending
+        virtual void _tvr_insertMatchingValuesToSet(const std::string &pattern, TraceSet &t);
+        
     public:
         //! Create a TraceValueRegister, with a scope prefix built on parent scope + name
         TraceValueRegister(TraceValueRegister *parent, const std::string &name):
@@ -499,15 +520,30 @@ class TraceValueRegister {
         TraceSet* GetAllTraceValues(void);
         //! Get all here registered TraceValue's with descending values
         TraceSet* GetAllTraceValuesRecursive(void);
+        //! Get all TraceValue's with descending values, which names match a glob pattern
+        TraceSet* GetMatchingTraceValuesRecursive(const std::string &pattern);
+};
+
+//! Provider for a indexed group of TraceValue's, like a RAM area
+/*! The values are created on first request only, so a big memory area doesn't
+  need a TraceValue for every cell, if it isn't traced. */
+class TraceSetSource {
+    
+    public:
+        virtual ~TraceSetSource() {}
+        //! Returns count of values in this group
+        virtual size_t GetTraceSetSize(void) = 0;
+        //! Returns TraceValue for index, creates it on first request
+        virtual TraceValue* GetTraceSetValue(size_t index) = 0;
 };
 
 /*! TraceValueRegister for CORE group to hold also RAM groups */
 class TraceValueCoreRegister: public TraceValueRegister {
   
     private:
-        typedef std::map<std::string*, TraceSet*> setmap_t; //!< type of TraceSet map
+        typedef std::map<std::string, TraceSetSource*> setmap_t; //!< type of TraceSet map, indexed by name
         
-        setmap_t _tvr_valset; //!< the registered TraceValue's
+        setmap_t _tvr_valset; //!< the registered groups of TraceValue's
 
         //! helper function to split up into name an number tail
         size_t _tvr_numberindex(const std::string &str);
@@ -518,17 +554,24 @@ class TraceValueCoreRegister: public TraceValueRegister {
         virtual size_t _tvr_getValuesCount(void);
         
         //! Insert all TraceValues into TraceSet, that registered here and descending
-        /*! This includes here also values in _tvr_valset! */
+        /*! This includes here also values in _tvr_valset, so all values
+          of a group are created! */
         virtual void _tvr_insertTraceValuesToSet(TraceSet &t);
         
+        //! Insert TraceValues, which names match a glob pattern, registered here and descending
+        /*! Values in _tvr_valset are matched by name and index, so only the
+          matching values of a group are created. */
+        virtual void _tvr_insertMatchingValuesToSet(const std::string &pattern, TraceSet &t);
+        
     public:
         //! Create a TraceValueCoreRegister instance
         TraceValueCoreRegister(TraceValueRegister *parent);
         
         ~TraceValueCoreRegister();
         
-        //! Registers a TraceValue for this register
-        void RegisterTraceSetValue(TraceValue *t, const std::string &name, const size_t size);
+        //! Registers a group of TraceValue's, addressed by name + index
+        /*! The source isn't owned by the register and must live as long as the register. */
+        void RegisterTraceSet(TraceSetSource *src, const std::string &name);
         //! Get a here registered TraceValue by it's name
         virtual TraceValue* GetTraceValueByName(const std::string &name);
 };
@@ -0,0 +1,214 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2001, 2002 - 2012   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+
+/* for preprocessor symbol HAVE_SYS_MINGW */
+#include "config.h"
+
+#if defined(HAVE_SYS_MINGW) || defined(_MSC_VER)
+#   include <io.h>
+#else
+#   include <unistd.h>
+#   include <termios.h>
+#   include <sys/types.h>
+#   include <sys/socket.h>
+#   include <sys/un.h>
+#endif
+
+#include "uartbridge.h"
+#include "avrerror.h"
+
+using namespace std;
+
+#if defined(HAVE_SYS_MINGW) || defined(_MSC_VER)
+#   define O_NONBLOCK 0
+#   define O_NOCTTY 0
+#endif
+
+FdUartBridge::FdUartBridge(int _inFd, int _outFd, int _holdFd):
+    inFd(_inFd),
+    outFd(_outFd),
+    holdFd(_holdFd),
+    bufferPos(0),
+    bufferLen(0) {}
+
+//! file status flags of stdin before bridge set O_NONBLOCK or -1
+static int stdinFlags = -1;
+
+//! Restores file status flags of stdin, they are shared with the terminal
+static void RestoreStdinFlags(void) {
+#if !(defined(HAVE_SYS_MINGW) || defined(_MSC_VER))
+    if(stdinFlags >= 0) {
+        fcntl(0, F_SETFL, stdinFlags);
+        stdinFlags = -1;
+    }
+#endif
+}
+
+FdUartBridge::~FdUartBridge() {
+    if(inFd == 0)
+        RestoreStdinFlags();
+    // stdin, stdout and stderr stay open
+    if(inFd > 2)
+        close(inFd);
+    if(outFd > 2 && outFd != inFd)
+        close(outFd);
+    if(holdFd >= 0)
+        close(holdFd);
+}
+
+bool FdUartBridge::ReadByte(unsigned char &c) {
+    if(bufferPos >= bufferLen) {
+        if(inFd < 0)
+            return false;
+        int res = read(inFd, buffer, sizeof(buffer));
+        if(res <= 0)
+            return false; // no data available (EAGAIN) or end of file
+        bufferPos = 0;
+        bufferLen = res;
+    }
+    c = buffer[bufferPos++];
+    return true;
+}
+
+bool FdUartBridge::WriteByte(unsigned char c) {
+    if(outFd < 0)
+        return true;
+    int res;
+    while((res = write(outFd, &c, 1)) < 0 && errno == EINTR)
+        ;
+    if(res < 0 && errno == EPIPE) {
+        // host has closed its side, all further output is dropped
+        if(outFd > 2 && outFd != inFd)
+            close(outFd);
+        outFd = -1;
+        return true;
+    }
+    // descriptor is non blocking, try again later, if host is busy
+    // other errors drop the byte
+    return !(res < 0 && (errno == EAGAIN || errno == EWOULDBLOCK));
+}
+
+//! Ignores SIGPIPE, a host, which closes its side, gets EPIPE on write instead of killing simulavr
+static void IgnoreSigPipe(void) {
+#if !(defined(HAVE_SYS_MINGW) || defined(_MSC_VER))
+    signal(SIGPIPE, SIG_IGN);
+#endif
+}
+
+//! Opens one side of a file bridge, "-" is stdin/stdout
+static int OpenBridgeFile(const string &name, bool output) {
+    if(name.empty())
+        return -1;
+    if(name == "-") {
+        int fd = output ? 1 : 0;
+#if !(defined(HAVE_SYS_MINGW) || defined(_MSC_VER))
+        if(!output && stdinFlags < 0) {
+            stdinFlags = fcntl(fd, F_GETFL);
+            fcntl(fd, F_SETFL, stdinFlags | O_NONBLOCK);
+            atexit(RestoreStdinFlags);
+        }
+#endif
+        return fd;
+    }
+    int fd = output ?
+        open(name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644) :
+        open(name.c_str(), O_RDONLY | O_NONBLOCK);
+    if(fd < 0)
+        avr_error("uart bridge: can't open file '%s': %s", name.c_str(), strerror(errno));
+    return fd;
+}
+
+UartBridge *UartBridge::Create(const string &description) {
+    IgnoreSigPipe();
+    if(description.compare(0, 5, "file:") == 0) {
+        string files = description.substr(5);
+        size_t comma = files.find(',');
+        if(comma == string::npos)
+            avr_error("uart bridge: 'file:<infile>,<outfile>' expected, got '%s'", description.c_str());
+        string inName = files.substr(0, comma), outName = files.substr(comma + 1);
+        return new FdUartBridge(OpenBridgeFile(inName, false), OpenBridgeFile(outName, true));
+    }
+
+#if defined(HAVE_SYS_MINGW) || defined(_MSC_VER)
+    avr_error("uart bridge: '%s' isn't available on this platform", description.c_str());
+    return NULL;
+#else
+    if(description == "pty") {
+        int master = posix_openpt(O_RDWR | O_NOCTTY);
+        if(master < 0 || grantpt(master) != 0 || unlockpt(master) != 0)
+            avr_error("uart bridge: can't create pty: %s", strerror(errno));
+        const char *name = ptsname(master);
+        // slave side is kept open, so that master doesn't see a hangup, if client closes
+        int slave = open(name, O_RDWR | O_NOCTTY);
+        if(slave < 0)
+            avr_error("uart bridge: can't open pty '%s': %s", name, strerror(errno));
+        struct termios tio;
+        if(tcgetattr(slave, &tio) == 0) {
+            cfmakeraw(&tio);
+            tcsetattr(slave, TCSANOW, &tio);
+        }
+        fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+        cerr << "UART bridge on pty " << name << endl;
+        return new FdUartBridge(master, master, slave);
+    }
+
+    if(description.compare(0, 5, "unix:") == 0) {
+        string path = description.substr(5);
+        struct sockaddr_un addr;
+        if(path.empty() || path.size() >= sizeof(addr.sun_path))
+            avr_error("uart bridge: invalid socket path '%s'", path.c_str());
+        int srv = socket(AF_UNIX, SOCK_STREAM, 0);
+        if(srv < 0)
+            avr_error("uart bridge: can't create socket: %s", strerror(errno));
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strcpy(addr.sun_path, path.c_str());
+        unlink(path.c_str());
+        if(bind(srv, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(srv, 1) != 0)
+            avr_error("uart bridge: can't listen on '%s': %s", path.c_str(), strerror(errno));
+        cerr << "UART bridge waiting for connection on " << path << endl;
+        int fd;
+        while((fd = accept(srv, NULL, NULL)) < 0 && errno == EINTR)
+            ;
+        close(srv);
+        if(fd < 0)
+            avr_error("uart bridge: accept failed: %s", strerror(errno));
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        return new FdUartBridge(fd, fd);
+    }
+
+    avr_error("uart bridge: unknown bridge '%s'", description.c_str());
+    return NULL;
+#endif
+}
+
+// EOF
@@ -0,0 +1,79 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2001, 2002 - 2012   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#ifndef UARTBRIDGE_H_INCLUDED
+#define UARTBRIDGE_H_INCLUDED
+
+#include <string>
+
+//! Host side endpoint for a UART, which exchanges whole bytes
+/*! A bridge is connected to HWUart by HWUart::SetBridge. Then the UART doesn't
+  sample or drive its pins anymore, but takes and delivers complete bytes at
+  the simulated frame time. ReadByte must not block, it's called on every
+  frame time, while receiver is enabled. */
+class UartBridge {
+
+    public:
+        virtual ~UartBridge() {}
+
+        //! Returns true and a received byte in c, if host has sent data
+        virtual bool ReadByte(unsigned char &c) = 0;
+        //! Sends a byte from UART to host
+        /*! Returns false, if host can't take the byte now. Then the UART
+          holds back transmit complete and tries again on next cycle. */
+        virtual bool WriteByte(unsigned char c) = 0;
+
+        //! Creates a bridge from a description
+        /*! Possible descriptions are:
+          - "pty": create a pseudo terminal, name of slave side is printed out
+          - "unix:<path>": create a unix socket <path> and wait for a connection
+          - "file:<infile>,<outfile>": read from <infile> and write to <outfile>,
+            one of them can be empty, "-" means stdin or stdout */
+        static UartBridge *Create(const std::string &description);
+};
+
+//! UartBridge on file descriptors, reads are buffered and non blocking
+/*! SIGPIPE is ignored, if a bridge is created. If the host closes its side,
+  write gives EPIPE and all further bytes from UART are dropped. */
+class FdUartBridge: public UartBridge {
+
+    protected:
+        int inFd;                   //!< file descriptor for reading or -1
+        int outFd;                  //!< file descriptor for writing or -1
+        int holdFd;                 //!< extra descriptor, which is closed together with bridge or -1
+        unsigned char buffer[256];  //!< read buffer
+        unsigned int bufferPos;     //!< position of next byte in buffer
+        unsigned int bufferLen;     //!< count of bytes in buffer
+
+    public:
+        //! Creates bridge for given descriptors, they will be closed by bridge (except stdin/stdout)
+        FdUartBridge(int inFd, int outFd, int holdFd = -1);
+        ~FdUartBridge();
+
+        bool ReadByte(unsigned char &c);
+        bool WriteByte(unsigned char c);
+};
+
+#endif
@@ -34,10 +34,28 @@
 
 using namespace std;
 
-UserInterface::UserInterface(int port, bool _withUpdateControl): Socket(port), updateOn(1), pollFreq(100000)  {
+//! Returns a monotonic wall clock time in ms
+static unsigned long WallClockMs(void) {
+#if defined(_MSC_VER) || defined(HAVE_SYS_MINGW)
+    return GetTickCount();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000UL + ts.tv_nsec / 1000000;
+#endif
+}
+
+UserInterface::UserInterface(int port, bool _withUpdateControl):
+    Socket(port),
+    updateOn(1),
+    pollFreq(100000),
+    waitOnAckFromTclRequest(0),
+    waitOnAckFromTclDone(0),
+    frameInterval(0),
+    lastFrameTime(0),
+    frameInFlight(false)
+{
     if (_withUpdateControl) {
-        waitOnAckFromTclRequest=0;
-        waitOnAckFromTclDone=0;
         ostringstream os;
         os << "create UpdateControl dummy dummy " << endl; 
         Write(os.str());
@@ -52,12 +70,89 @@ void UserInterface::SwitchUpdateOnOff(bool yesNo) {
     updateOn=yesNo;
 }
 
+void UserInterface::SetFrameInterval(unsigned int ms) {
+    if (frameInterval != 0 && ms == 0) {
+        // flush, what is collected so far
+        frameInFlight = false;
+        SendFrame();
+    }
+    frameInterval = ms;
+    lastFrameTime = WallClockMs();
+}
+
+void UserInterface::ReadFromUi(void) {
+    while (Poll() != 0) {
+        if (Read(dummy) <= 0)
+            break; // connection closed or nothing to read
+    }
+
+    // dummy holds "net value " pairs, a incomplete pair stays for next read
+    string::size_type pos = 0;
+    for (;;) {
+        string::size_type end1 = dummy.find(' ', pos);
+        if (end1 == string::npos)
+            break;
+        string net = dummy.substr(pos, end1 - pos);
+
+        if (net == "exit" )
+            avr_error("Exiting at external UI request");
+
+        string::size_type end2 = dummy.find(' ', end1 + 1);
+        if (end2 == string::npos)
+            break;
+        pos = end2 + 1;
+
+        if (net == "__ack" ) {
+            waitOnAckFromTclDone++;
+            frameInFlight = false;
+        } else {
+            map<string, ExternalType*>::iterator ii = extMembers.find(net);
+            if (ii != extMembers.end() )
+                (ii->second)->SetNewValueFromUi(dummy.substr(end1 + 1, end2 - end1 - 1));
+        }
+    }
+    dummy.erase(0, pos);
+}
+
+void UserInterface::SendFrame(void) {
+    if (frameInFlight || (pendingLines.empty() && pendingStates.empty()))
+        return;
+
+    string payload;
+    payload.swap(pendingLines);
+    for (map<string, char>::iterator ii = pendingStates.begin(); ii != pendingStates.end(); ii++) {
+        payload += "set ";
+        payload += ii->first;
+        payload += ' ';
+        payload += ii->second;
+        payload += '\n';
+    }
+    pendingStates.clear();
+
+    ostringstream os;
+    os << "frame " << payload.size() << "\n" << payload;
+    Socket::Write(os.str());
+    frameInFlight = true;
+}
 
 int UserInterface::Step(bool &dummy1, SystemClockOffset *nextStepIn_ns) {
     if (nextStepIn_ns!=0) {
         *nextStepIn_ns=pollFreq;
     }
 
+    if (frameInterval != 0) {
+        // batched frames: at most one frame per interval and one frame on
+        // the way to gui, simulation doesn't wait on the acknowledge
+        unsigned long now = WallClockMs();
+        if (now - lastFrameTime >= frameInterval) {
+            lastFrameTime = now;
+            ReadFromUi();
+            if (updateOn)
+                SendFrame();
+        }
+        return 0;
+    }
+
     static time_t oldTime=0;
     time_t newTime=time(NULL);
 
@@ -65,53 +160,7 @@ int UserInterface::Step(bool &dummy1, SystemClockOffset *nextStepIn_ns) {
         oldTime=newTime;
 
         do { 
-            if (Poll()!=0) {
-                ssize_t len = 0;
-                len=Read(dummy);
-
-                //string debug=dummy;
-
-                while (len>0) {
-
-                    string::size_type pos;
-
-                    pos=dummy.find(" ");
-
-                    string net=dummy.substr(0, pos);
-                    string rest=dummy.substr(pos+1); //vfrom pos+1 to end
-
-                    if (net == "exit" )
-                        avr_error("Exiting at external UI request");
-
-                    string par;
-                    int pos2=rest.find(" ");
-
-                    if (pos2<=0) break;
-
-                    par= rest.substr(0, pos2);
-                    dummy=rest.substr(pos2+1);
-
-                    // cerr << "UI: net=" << net << "- rest=" << rest << endl;
-                    if (net == "__ack" ) {
-                        waitOnAckFromTclDone++;
-                    } else {
-                        map<string, ExternalType*>::iterator ii;
-                        ii=extMembers.find(net);
-                        if (ii != extMembers.end() ) {
-                            (ii->second)->SetNewValueFromUi(par);
-                        } else {
-                            // cerr << "Netz nicht gefunden:" << net << endl;
-                            // cerr << "Start with string >>" << net << "<<" << endl;
-                        }
-
-                        //if (trace_on!=0) traceOut << "Net: " << net << "changed to " << par << endl;
-
-                    } //__ack
-
-                    len=dummy.size(); //recalc size from rest of string
-
-                } // len > 0
-            } //poll
+            ReadFromUi();
         }while (waitOnAckFromTclRequest > waitOnAckFromTclDone+500); 
 
 
@@ -135,6 +184,13 @@ void UserInterface::SendUiNewState(const string &s, const char &c)  {
     }
     LastState[s]=c;
 
+    if (frameInterval != 0) {
+        // only the last state of a net is sent with next frame
+        if (updateOn)
+            pendingStates[s]=c;
+        return;
+    }
+
     os << "set " << s << " " << c << endl;
     Write(os.str());
 
@@ -151,7 +207,9 @@ void UserInterface::SetNewValueFromUi(const string &value){
 }
 
 void UserInterface::Write(const string &s) {
-    if (updateOn) {
+    if (updateOn && frameInterval != 0) {
+        pendingLines += s;
+    } else if (updateOn) {
 
         for (unsigned int tt = 0; tt< s.length() ; tt++) {
             if (s[tt]=='\n') {
@@ -48,6 +48,17 @@ class UserInterface: public SimulationMember, private Socket, public ExternalTyp
         int waitOnAckFromTclRequest; 
         int waitOnAckFromTclDone;
 
+        unsigned int frameInterval;   //!< wall clock time between frames in ms, 0 = line protocol
+        unsigned long lastFrameTime;  //!< wall clock time of last frame in ms
+        bool frameInFlight;           //!< a frame was sent, but not acknowledged by gui
+        std::string pendingLines;     //!< buffered messages for next frame
+        std::map<std::string, char> pendingStates; //!< latest state per net for next frame
+
+        //! Reads all available input from gui and forwards "net value " pairs
+        void ReadFromUi(void);
+        //! Sends buffered messages as one frame, if gui has acknowledged the last one
+        void SendFrame(void);
+
         //this is mainly for controlling the ui interface itself from the gui
         void SetNewValueFromUi(const std::string &);
     public:
@@ -66,6 +77,15 @@ class UserInterface: public SimulationMember, private Socket, public ExternalTyp
         int Step(bool &, SystemClockOffset *nextStepIn_ns=0);
         void SwitchUpdateOnOff(bool PollFreq);
         void Write(const std::string &s);
+
+        //! Switches to batched frames, which are sent at most every ms milliseconds
+        /*! All messages are collected and sent as one frame "frame <len>\n"
+          followed by len bytes of messages. Only the last state of a net is
+          sent in a frame. Gui acknowledges the whole frame with one "__ack X ",
+          the next frame is sent after this ack, so simulation never waits on
+          the gui. ms = 0 switches back to line protocol, where every line is
+          acknowledged. */
+        void SetFrameInterval(unsigned int ms);
 };
 
 #endif
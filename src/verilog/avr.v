@@ -23,6 +23,14 @@
  FIXME: Output-pullups are not implemented yet - find a good way to do that!
  */
 
+/* If AVR_QUANTUM is defined (e.g. iverilog -DAVR_QUANTUM=10000), the AVR
+ runs in batches: every AVR_QUANTUM time units $avr_run_until runs the AVR
+ ahead for that time and pins are only exchanged on changes by callbacks.
+ Inputs are seen by the AVR with a delay up to AVR_QUANTUM, outputs are
+ scheduled on the time, on which they changed. The clock period is measured
+ on the first two clock edges, later changes of the clock are ignored.
+ */
+
 module avr_pin(conn);
    parameter name="UNSPECIFIED";
    inout conn;
@@ -69,10 +77,17 @@ module avr_pin(conn);
 
    assign out=a2v(val);
 
+`ifdef AVR_QUANTUM
+   initial begin
+      val=4;
+      @(posedge core.clk) $avr_watch_pin(core.handle, name, val, conn);
+   end
+`else
    always @(posedge core.clk) begin
       val<=$avr_get_pin(core.handle, name);
       $avr_set_pin(core.handle, name, v2a(conn));
    end
+`endif
    
 endmodule // avr_pin
 
@@ -105,11 +120,24 @@ module AVRCORE(clk);
       //$avr_reset(handle);
    end
 
+`ifdef AVR_QUANTUM
+   time      firstEdge;
+   initial begin
+      @(posedge clk) firstEdge=$time;
+      @(posedge clk) $avr_set_clock(handle, $time-firstEdge);
+      forever begin
+	 $avr_run_until(handle, $time+`AVR_QUANTUM);
+	 PCw=$avr_get_pc(handle);
+	 #(`AVR_QUANTUM);
+      end
+   end
+`else
    always @(posedge clk) begin
       $avr_set_time($time);
       $avr_tick(handle);      
       PCw=$avr_get_pc(handle);
    end
+`endif
    
 endmodule // AVRCORE
 
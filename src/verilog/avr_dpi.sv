@@ -0,0 +1,38 @@
+/*
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/* DPI-C imports for libavrdpi (see src/dpi.h), e.g. for Verilator.
+ Ports are exchanged as whole bytes, port is given by its letter, e.g. "B".
+ */
+
+package avr_dpi;
+
+   import "DPI-C" function int avr_dpi_create(input string device, input string progname);
+   import "DPI-C" function void avr_dpi_destroy(input int handle);
+   import "DPI-C" function void avr_dpi_reset(input int handle);
+   import "DPI-C" function void avr_dpi_set_clock(input int handle, input longint period);
+   import "DPI-C" function int avr_dpi_step(input int handle, input int cycles);
+   import "DPI-C" function void avr_dpi_get_port(input int handle, input byte port,
+                                                 output byte unsigned value, output byte unsigned oe);
+   import "DPI-C" function void avr_dpi_set_port(input int handle, input byte port,
+                                                 input byte unsigned value, input byte unsigned oe);
+   import "DPI-C" function int avr_dpi_read_mem(input int handle, input int address);
+   import "DPI-C" function void avr_dpi_write_mem(input int handle, input int address, input int value);
+   import "DPI-C" function int avr_dpi_get_pc(input int handle);
+
+endpackage // avr_dpi
@@ -37,9 +37,30 @@
 #include "avrerror.h"
 #include "cmd/dumpargs.h"
 #include "systemclock.h"
+#include "pinnotify.h"
 
 static std::vector<AvrDevice*> devices;
 
+class VpiPinWatch;
+
+//! State of a AVR device, if it's run in batches by $avr_run_until
+struct VpiBatchState {
+    bool started;                       //!< first $avr_run_until was called
+    SystemClockOffset time;             //!< time of next clock cycle of AVR device
+    std::vector<VpiPinWatch*> watches;  //!< pins, which are exchanged by callbacks
+    VpiBatchState(): started(false), time(0) {}
+};
+
+static std::vector<VpiBatchState> batches;
+
+//! Returns current simulation time of verilog simulator
+static SystemClockOffset simTime(void) {
+    s_vpi_time t;
+    t.type = vpiSimTime;
+    vpi_get_time(0, &t);
+    return ((SystemClockOffset)t.high << 32) | t.low;
+}
+
 static bool checkHandle(int h) {
     if (h>=devices.size()) {
     vpi_printf("There has never been an AVR device with the handle %d.", h);
@@ -138,6 +159,102 @@ static bool checkHandle(int h) {
     vpi_register_systf(&tf_data);               \
     }
 
+/*! Connects a AVR pin to verilog without polling on every clock. Output
+  changes of the AVR pin are written to a verilog variable (delayed to the
+  AVR time, on which they happened, if AVR runs ahead), changes on the
+  verilog net are set as input to the AVR pin by a cbValueChange callback. */
+class VpiPinWatch: public HasPinNotifyFunction {
+    protected:
+        int handle;           //!< handle of AVR device
+        Pin *pin;             //!< the AVR pin
+        vpiHandle outVar;     //!< verilog variable, which gets output state
+        vpiHandle cb;         //!< callback on verilog net
+        int lastOut;          //!< last output state written to outVar
+
+    public:
+        VpiPinWatch(int handle, Pin *pin, vpiHandle outVar, vpiHandle net);
+        ~VpiPinWatch();
+
+        void RemoveCallback(void);
+        void SetInput(int scalar);
+        void PinStateHasChanged(Pin *);
+};
+
+static PLI_INT32 avr_pin_changed_cb(p_cb_data data) {
+    ((VpiPinWatch *)data->user_data)->SetInput(data->value->value.scalar);
+    return 0;
+}
+
+VpiPinWatch::VpiPinWatch(int _handle, Pin *_pin, vpiHandle _outVar, vpiHandle net):
+    handle(_handle),
+    pin(_pin),
+    outVar(_outVar),
+    lastOut(-1)
+{
+    s_vpi_value value;
+    value.format = vpiScalarVal;
+    vpi_get_value(net, &value);
+    SetInput(value.value.scalar);
+    PinStateHasChanged(pin);
+    pin->RegisterCallback(this);
+
+    static s_vpi_time time = { vpiSuppressTime };
+    static s_vpi_value cbValue = { vpiScalarVal };
+    s_cb_data data;
+    data.reason = cbValueChange;
+    data.cb_rtn = avr_pin_changed_cb;
+    data.obj = net;
+    data.time = &time;
+    data.value = &cbValue;
+    data.index = 0;
+    data.user_data = (PLI_BYTE8 *)this;
+    cb = vpi_register_cb(&data);
+}
+
+VpiPinWatch::~VpiPinWatch() {
+    RemoveCallback();
+}
+
+void VpiPinWatch::RemoveCallback(void) {
+    if (cb) {
+        vpi_remove_cb(cb);
+        cb = 0;
+    }
+}
+
+void VpiPinWatch::SetInput(int scalar) {
+    Pin::T_Pinstate st;
+    switch (scalar) {
+        case vpi0: st = Pin::LOW; break;
+        case vpi1: st = Pin::HIGH; break;
+        case vpiZ: st = Pin::TRISTATE; break;
+        default:   st = Pin::SHORTED; break; // approximate X as shorted
+    }
+    pin->SetInState(Pin(st));
+}
+
+void VpiPinWatch::PinStateHasChanged(Pin *) {
+    if (pin->outState == lastOut)
+        return;
+    lastOut = pin->outState;
+
+    s_vpi_value value;
+    value.format = vpiIntVal;
+    value.value.integer = lastOut;
+
+    // output changed on AVR time, which can be in future, if AVR runs ahead
+    SystemClockOffset now = simTime();
+    const VpiBatchState &b = batches[handle];
+    if (b.started && b.time > now) {
+        s_vpi_time delay;
+        delay.type = vpiSimTime;
+        delay.high = (PLI_UINT32)((b.time - now) >> 32);
+        delay.low = (PLI_UINT32)(b.time - now);
+        vpi_put_value(outVar, &value, &delay, vpiTransportDelay);
+    } else
+        vpi_put_value(outVar, &value, 0, vpiNoDelay);
+}
+
 /*!
   This function creates a new AVR core and `returns' a handle to it
   Usage from Verilog:
@@ -158,6 +275,7 @@ static PLI_INT32 avr_create_tf(char *xx) {
 
     AvrDevice* dev=AvrFactory::instance().makeDevice(device.c_str());
     devices.push_back(dev);
+    batches.push_back(VpiBatchState());
     
     dev->Load(progname.c_str());
 
@@ -193,10 +311,18 @@ static PLI_INT32 avr_destroy_tf(char *xx) {
     
     AVR_HCHECK();
 
+    std::vector<VpiPinWatch*> &watches = batches[handle].watches;
+    for (size_t i=0; i < watches.size(); i++)
+        watches[i]->RemoveCallback();
+
     /* We may leak a bity of memory for the pointer in the vector,
        but... what the hell! */
     delete devices[handle];
     devices[handle]=0;
+
+    for (size_t i=0; i < watches.size(); i++)
+        delete watches[i];
+    watches.clear();
     return 0;
 }
 
@@ -217,6 +343,95 @@ static PLI_INT32 avr_tick_tf(char *xx) {
     return 0;
 }
 
+/*!
+  Sets the clock period of an AVR in ns, this is needed for $avr_run_until.
+  Usage from Verilog:
+
+  $avr_set_clock(handle, period)
+*/
+static PLI_INT32 avr_set_clock_tf(char *xx) {
+    VPI_BEGIN();
+    VPI_UNPACKI(handle);
+    VPI_UNPACKI(period);
+    VPI_END();
+    AVR_HCHECK();
+
+    if (period <= 0) {
+        vpi_printf("%s: clock period has to be greater than 0.\n", xx);
+        return 0;
+    }
+    devices[handle]->SetClockFreq(period);
+    return 0;
+}
+
+/*!
+  This function runs an AVR for all clock cycles up to the given time (in ns,
+  the unit of simulation time). Instead of one $avr_tick per clock edge, the
+  AVR can run many cycles with one call. The clock period has to be set
+  by $avr_set_clock before. The first call starts the AVR at current
+  simulation time. Pins connected by $avr_watch_pin are exchanged during the
+  run, output changes are scheduled on the AVR time, on which they happened.
+  Usage from Verilog:
+
+  $avr_run_until(handle, time)
+*/
+static PLI_INT32 avr_run_until_tf(char *xx) {
+    VPI_BEGIN();
+    VPI_UNPACKI(handle);
+    VPI_UNPACKT(time);
+    VPI_END();
+    AVR_HCHECK();
+
+    AvrDevice *dev = devices[handle];
+    SystemClockOffset period = dev->GetClockFreq();
+    if (period <= 0) {
+        vpi_printf("%s: clock period not set, use $avr_set_clock before.\n", xx);
+        return 0;
+    }
+    SystemClockOffset until = ((SystemClockOffset)time->high << 32) | time->low;
+
+    VpiBatchState &b = batches[handle];
+    if (!b.started) {
+        b.started = true;
+        b.time = simTime();
+    }
+    SystemClock &clock = SystemClock::Instance();
+    while (b.time < until) {
+        clock.SetCurrentTime(b.time);
+        bool no_hw=false;
+        dev->Step(no_hw);
+        b.time += period;
+    }
+    return 0;
+}
+
+/*!
+  This function connects an AVR pin to verilog by callbacks instead of
+  polling it with $avr_get_pin and $avr_set_pin on every clock. Output
+  state changes of the AVR pin are written to variable val, changes on
+  net conn are given to the AVR pin as input.
+  Usage from Verilog:
+
+  $avr_watch_pin(handle, name, val, conn)
+*/
+static PLI_INT32 avr_watch_pin_tf(char *xx) {
+    VPI_BEGIN();
+    VPI_UNPACKI(handle);
+    VPI_UNPACKS(name);
+    vpiHandle val = vpi_scan(argv);
+    vpiHandle conn = val ? vpi_scan(argv) : 0;
+    if (!conn) {
+        vpi_printf("%s: val or conn parameter missing.\n", xx);
+        return 0;
+    }
+    VPI_END();
+    AVR_HCHECK();
+
+    Pin *pin=devices[handle]->GetPin(name.c_str());
+    batches[handle].watches.push_back(new VpiPinWatch(handle, pin, val, conn));
+    return 0;
+}
+
 /*!
   Set the time in the AVR system, in ns. Used for trace dumps etc.
   $avr_time(handle)
@@ -396,6 +611,9 @@ static void register_tasks() {
     VPI_REGISTER_TASK(avr_reset);
     VPI_REGISTER_TASK(avr_destroy);
     VPI_REGISTER_TASK(avr_tick);
+    VPI_REGISTER_TASK(avr_set_clock);
+    VPI_REGISTER_TASK(avr_run_until);
+    VPI_REGISTER_TASK(avr_watch_pin);
     VPI_REGISTER_TASK(avr_set_time);
     VPI_REGISTER_FUNC(avr_get_pin);
     VPI_REGISTER_TASK(avr_set_pin);
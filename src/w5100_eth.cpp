@@ -28,20 +28,16 @@
 #include "wiz_spi.h"
 #include "w5100_eth.h"
 
-w5100_eth::w5100_eth() {
+w5100_eth::w5100_eth() :
+    state(WAITING), addr(0), cmd(0), isWrite(false)
+{
     model = 5100;
 }
 
 w5100_eth::~w5100_eth()
 {}
 
-enum State {WAITING, ADDR1, ADDR2, CMD, DATA};
-
 void w5100_eth::processSpiTransaction() {
-    static State state = State::WAITING;
-    static unsigned int addr;
-    static unsigned char cmd;
-    static bool isWrite = false;
     unsigned char ch;
 
     // first take care of asynchronous events
@@ -41,6 +41,13 @@ class w5100_eth : public wiz_ethernet
         //virtual void writeBufToMem(unsigned int addr,unsigned char *buffer,unsigned int len);
         //virtual void readBufFromMem(unsigned int addr,unsigned char *buffer,unsigned int len);
     private:
+        enum State {WAITING, ADDR1, ADDR2, CMD, DATA};
+
+        // state of the spi transaction layer
+        State state;
+        unsigned int addr;
+        unsigned char cmd;
+        bool isWrite;
 };
 
 #endif // W5100_ETH_H
@@ -28,14 +28,15 @@
 #include "wiz_spi.h"
 #include "w5500_eth.h"
 
-w5500_eth::w5500_eth() {
+w5500_eth::w5500_eth() :
+    state(WAITING), addr(0), cmd(0), bytesReceived(0), isWrite(false)
+{
     model = 5500;
 }
 
 w5500_eth::~w5500_eth()
 {}
 
-enum State {WAITING,  ADDR1, ADDR2, CMD, DATA};
 #define COMMON_BASE       0x0000
 #define SOCKET0_BASE      0x0400
 #define SOCKET1_BASE      0x0500
@@ -52,13 +53,7 @@ enum State {WAITING,  ADDR1, ADDR2, CMD, DATA};
 #define RESERVED          0x9000
 
 void w5500_eth::processSpiTransaction() {
-    static State state = State::WAITING;
-    static unsigned int addr;
-    static unsigned char cmd;
-    static unsigned char buffer[2048];
-    static unsigned int bytesReceived;
-    static bool isWrite = false;
-    static unsigned int regBase[] = {
+    static const unsigned int regBase[] = {
         COMMON_BASE, SOCKET0_BASE, SOCKET0_TX_BASE, SOCKET0_RX_BASE,
         RESERVED, SOCKET1_BASE, SOCKET1_TX_BASE, SOCKET1_RX_BASE,
         RESERVED, SOCKET2_BASE, SOCKET2_TX_BASE, SOCKET2_RX_BASE,
@@ -110,7 +105,8 @@ void w5500_eth::processSpiTransaction() {
                 spi.setOutputByte(ch);
             }            break;
         case State::DATA:
-            buffer[bytesReceived] = spi.getByte();
+            ch = spi.getByte();
+            if (bytesReceived<sizeof(buffer)) buffer[bytesReceived] = ch;
             if (!isWrite) {
                 // operation is a read - get the first byte and place it
                 // in the SPI output buffer.
@@ -41,6 +41,15 @@ class w5500_eth : public wiz_ethernet
         //virtual void writeBufToMem(unsigned int addr,unsigned char *buffer,unsigned int len);
         //virtual void readBufFromMem(unsigned int addr,unsigned char *buffer,unsigned int len);
     private:
+        enum State {WAITING, ADDR1, ADDR2, CMD, DATA};
+
+        // state of the spi transaction layer
+        State state;
+        unsigned int addr;
+        unsigned char cmd;
+        unsigned char buffer[2048];
+        unsigned int bytesReceived;
+        bool isWrite;
 };
 
 #endif // W5500_ETH_H
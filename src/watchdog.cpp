@@ -27,6 +27,7 @@
 #include "avrdevice.h"
 #include "systemclock.h"
 #include "irqsystem.h"
+#include "snapshot.h"
 
 #define WDCE 0x10
 #define WDRE 0x08
@@ -146,6 +147,31 @@ void WatchDog::Reset() {
 	timeoutCount = 0;
 }
 
+/********************************************************************
+ * SaveState() / RestoreState()
+ * Saves/restores the watchdog state for a snapshot.
+ *
+ * params:
+ *    w / r - snapshot writer / reader
+ *
+ * returns: None
+ */
+void WatchDog::SaveState(SnapshotWriter &w) {
+	HWWado::SaveState(w);
+	w.WriteByte(wdtcsr);
+	w.WriteByte(counter);
+	w.WriteDWord(timeoutCount);
+	w.WriteTime(timeOutAt);
+}
+
+void WatchDog::RestoreState(SnapshotReader &r) {
+	HWWado::RestoreState(r);
+	wdtcsr = r.ReadByte();
+	counter = r.ReadByte();
+	timeoutCount = r.ReadDWord();
+	timeOutAt = r.ReadTime();
+}
+
 /********************************************************************
  * Wdr()
  * Sets the timeout value according to the prescaler values.
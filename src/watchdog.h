@@ -55,6 +55,8 @@ class WatchDog: public HWWado {
 		unsigned char getWdtcsr() { return wdtcsr; }
 		virtual void Wdr(); //reset the wado counter
 		virtual void Reset();
+		virtual void SaveState(SnapshotWriter &w);
+		virtual void RestoreState(SnapshotReader &r);
 
         IOReg<WatchDog> wdtcsr_reg;
 };
@@ -1,10 +1,12 @@
 /* wiz ethernet defines a base class for the W5100 and W5500 ethernet controllers */
 #include <string.h>
 #include "simulationmember.h"
+#include "systemclock.h"
+#include "hwspi.h"
 #include "wiz_ethernet.h"
 
 /// constructor
-wiz_ethernet::wiz_ethernet() : spi(this)
+wiz_ethernet::wiz_ethernet() : spi(this), byteMode(false), nextSocketPoll(0)
 {
 }
 
@@ -33,6 +35,41 @@ Pin * wiz_ethernet::getSckPin()
     return &spickpin;
 }
 
+/// exchange whole bytes with master instead of sampling the spi pins
+void wiz_ethernet::attachSpi(HWSpi *master)
+{
+    master->AttachSlave(this);
+    // in byte mode Step doesn't look at SS, so the end of a transaction comes by callback
+    if (!byteMode) sspin.RegisterCallback(this);
+    byteMode = true;
+}
+
+/// SpiSlave - the chip is selected by a low SS pin
+bool wiz_ethernet::IsSelected(void)
+{
+    return spi.isSsSet();
+}
+
+/// SpiSlave - the spi pins aren't sampled in byte mode, they are no listeners for the master
+bool wiz_ethernet::OwnsPin(Pin *p)
+{
+    return (p==&sspin)||(p==&misopin)||(p==&mosipin)||(p==&spickpin);
+}
+
+/// SpiSlave - take a byte from master and process it in the transaction layer
+unsigned char wiz_ethernet::Transfer(unsigned char mosi)
+{
+    unsigned char miso = spi.transfer(mosi);
+    processSpiTransaction();
+    return miso;
+}
+
+/// a change of SS ends or starts a transaction
+void wiz_ethernet::PinStateHasChanged(Pin *)
+{
+    processSpiTransaction();
+}
+
 /// called by the spi transaction layer to move data to device memory
 void wiz_ethernet::writeBufToMem(unsigned int addr,unsigned char *buffer,unsigned int len)
 {
@@ -65,21 +102,36 @@ void wiz_ethernet::readBufFromMem(unsigned int addr,unsigned char *buffer,unsign
 
 /// step the sockets by one simulation step
 void wiz_ethernet::stepSockets() {
+    // the epoll set is shared by all controllers, check it once per time step
+    static SystemClockOffset lastHostPoll = -1;
+    SystemClockOffset now = SystemClock::Instance().GetCurrentTime();
+    if (now!=lastHostPoll) {
+        lastHostPoll = now;
+        wiz_socket::pollHost();
+    }
     for (unsigned int i=0;i<4;i++) socket[i].step();
 }
 
 /// Inherited from base class - step the the spi interface and spi transaction layer
 int wiz_ethernet::Step(bool &trueHwStep, SystemClockOffset *timeToNextStepIn_ns)
 {
+	if (byteMode) {
+        // bytes and SS changes come by Transfer and PinStateHasChanged,
+        // only the host sockets have to be checked
+        *timeToNextStepIn_ns = SOCKET_POLL_INTERVAL;
+        stepSockets();
+        return 0;
+    }
+
 	// next step in 100 nanoSec
 	*timeToNextStepIn_ns	= 100;	// Once every 100 nanosecond
 
 	spi.step();
 	processSpiTransaction();
-	static unsigned int i = 0;
-	i++; if (i>10000) {
+	SystemClockOffset now = SystemClock::Instance().GetCurrentTime();
+	if (now>=nextSocketPoll) {
         stepSockets();
-        i=0;
+        nextSocketPoll = now + SOCKET_POLL_INTERVAL;
     }
 	return 0;
 }
@@ -1,6 +1,8 @@
 /* wiz_etherenet.h - defines the base class for Wiznet w5100 and W5500 ethernet controllers. */
 #include "simulationmember.h"
 #include "pin.h"
+#include "pinnotify.h"
+#include "spislave.h"
 #include "wiz_socket.h"
 #include "wiz_spi.h"
 
@@ -8,8 +10,9 @@
 #define WIZ_ETHERNET_H
 
 class wiz_socket;
+class HWSpi;
 
-class wiz_ethernet : public SimulationMember
+class wiz_ethernet : public SimulationMember, public SpiSlave, public HasPinNotifyFunction
 {
 private:
 protected:
@@ -29,6 +32,10 @@ protected:
     wiz_socket socket[4];       /// the ethernet controller's socket interfaces
     wiz_spi spi;                /// the ethernet controller's spi interface
 
+    bool byteMode;              /// attached to the master's HWSpi, bytes come by Transfer, the spi pins aren't sampled
+    SystemClockOffset nextSocketPoll;   /// simulation time, when the host sockets are checked next
+    static const SystemClockOffset SOCKET_POLL_INTERVAL = 1000000;  /// check host sockets every 1ms simulation time
+
     void stepSockets();         /// update the state of the ethernet sockets
 
     virtual void processSpiTransaction() = 0;  /// pure virtual function - child classes will implement specific transaction-layer processing
@@ -45,6 +52,16 @@ public:
     Pin *getSckPin();
     virtual ~wiz_ethernet();    /// destructor
 
+    void attachSpi(HWSpi *master);  /// exchange whole bytes with master instead of sampling the spi pins
+
+    // SpiSlave
+    bool IsSelected(void);
+    unsigned char Transfer(unsigned char mosi);
+    bool OwnsPin(Pin *p);
+
+    // HasPinNotifyFunction - finishes a transaction, if SS is released
+    void PinStateHasChanged(Pin *);
+
 };
 
 #endif
@@ -26,6 +26,7 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/ioctl.h>
+#include <sys/epoll.h>
 #include <unistd.h>
 #include <string.h>
 #include <time.h>
@@ -55,8 +56,9 @@ using namespace std;
  * returns: None
  */
 wiz_socket::wiz_socket() :
-        fd(0), tcpfd(0), rx_write_idx(0)
+        fd(0), tcpfd(0), rx_write_idx(0), watchedFd(0), ready(false)
 {
+    socketCount++;
     regs = new unsigned char [REG_SPACE_SIZE];      // memory associated with the socket registers
     txbuf = new unsigned char   [TX_BUFFER_SIZE];   // memory associated with the transmit buffer
     rxbuf = new unsigned char   [RX_BUFFER_SIZE];   // memory associated with the receive buffer
@@ -76,8 +78,73 @@ wiz_socket::~wiz_socket()
     if (regs) delete[] regs;
     if (txbuf) delete[] txbuf;
     if (rxbuf) delete[] rxbuf;
-    if (tcpfd) close(tcpfd);
-    if (fd) close(fd);
+    closeRealSocket();
+    if ((--socketCount==0)&&(epollFd>=0)) {
+        close(epollFd);
+        epollFd = -1;
+    }
+}
+
+int wiz_socket::epollFd = -1;
+int wiz_socket::socketCount = 0;
+
+/********************************************************************
+ * watch()
+ * Registers the descriptor, which is checked by step(), in the epoll
+ * set shared by all sockets.  The previously watched descriptor is
+ * removed from the set.  The set is created with the first watched
+ * descriptor.
+ *
+ * params:
+ *    descriptor (IN) - the descriptor to watch or 0 to watch nothing
+ * returns: None
+ */
+void wiz_socket::watch(int descriptor) {
+    if (descriptor==watchedFd) return;
+    if (watchedFd>0) epoll_ctl(epollFd, EPOLL_CTL_DEL, watchedFd, 0);
+    watchedFd = 0;
+    ready = false;
+    if (descriptor<=0) return;
+
+    if (epollFd<0) epollFd = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN|EPOLLRDHUP;
+    ev.data.ptr = this;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, descriptor, &ev)==0) watchedFd = descriptor;
+}
+
+/********************************************************************
+ * closeRealSocket()
+ * Removes the real socket from the epoll set and closes it together
+ * with an accepted tcp connection.
+ *
+ * params:  None
+ * returns: None
+ */
+void wiz_socket::closeRealSocket() {
+    watch(0);
+    if (tcpfd>0) close(tcpfd);
+    if (fd>0) close(fd);
+    tcpfd = 0;
+    fd = 0;
+}
+
+/********************************************************************
+ * pollHost()
+ * Checks the epoll set once for all sockets without waiting and marks
+ * the sockets with readable descriptors as ready.  Only ready sockets
+ * have to look at their real socket in step().
+ *
+ * params:  None
+ * returns: true, if at least one socket is ready
+ */
+bool wiz_socket::pollHost() {
+    if (epollFd<0) return false;
+    struct epoll_event events[32];
+    int n = epoll_wait(epollFd, events, 32, 0);
+    for (int i=0;i<n;i++) ((wiz_socket *)events[i].data.ptr)->ready = true;
+    return (n>0);
 }
 
 /********************************************************************
@@ -136,8 +203,7 @@ void wiz_socket::processCommand(unsigned char newCommand) {
                     // accept open commands
                     if ((newCommand)==SKT_CR_OPEN) {
                         // open the new socket connection
-                        if (tcpfd>0) close(tcpfd);
-                        if (fd>0) close(fd);
+                        closeRealSocket();
                         fd = socket(AF_INET, SOCK_STREAM, 0);
                         if (fd>0) {
                             optval = 1;
@@ -161,8 +227,7 @@ void wiz_socket::processCommand(unsigned char newCommand) {
                     // close, Listen or Connect commands
                     switch (newCommand) {
                         case SKT_CR_CLOSE:
-                            if (tcpfd) close(tcpfd);
-                            close(fd);
+                            closeRealSocket();
                             regs[SR_OFFSET] = SKT_SR_CLOSED;
                             regs[CR_OFFSET] = 0;
                             break;
@@ -173,6 +238,7 @@ void wiz_socket::processCommand(unsigned char newCommand) {
                             memcpy(&remote_addr.sin_addr, &regs[DIPR_OFFSET],4);
                             remote_addr.sin_port = htons(dportno);
                             if (connect(fd,(struct sockaddr *) &remote_addr,sizeof(remote_addr)) < 0) break;
+                            watch(fd);
                             regs[SR_OFFSET] = SKT_SR_ESTABLISHED;
                             regs[CR_OFFSET] = 0;
                             break;
@@ -188,6 +254,7 @@ void wiz_socket::processCommand(unsigned char newCommand) {
                             local_addr.sin_port = htons(portno);
                             if (bind(fd, (struct sockaddr *) &local_addr,sizeof(local_addr)) < 0) break;
                             listen(fd,5);
+                            watch(fd);
                             regs[SR_OFFSET] = SKT_SR_LISTEN;
                             regs[CR_OFFSET] = 0;
                             break;
@@ -198,8 +265,7 @@ void wiz_socket::processCommand(unsigned char newCommand) {
                     // once the connection is established, go to established.
                     // only close is a valid command here.
                     if ((newCommand)== SKT_CR_CLOSE) {
-                        if (tcpfd) close(tcpfd);
-                        close(fd);
+                        closeRealSocket();
                         regs[SR_OFFSET] = SKT_SR_CLOSED;
                         regs[CR_OFFSET] = 0;
                     }
@@ -210,8 +276,7 @@ void wiz_socket::processCommand(unsigned char newCommand) {
                     switch (newCommand) {
                         case SKT_CR_DISCON:
                         case SKT_CR_CLOSE:
-                            if (tcpfd) close(tcpfd);
-                            close(fd);
+                            closeRealSocket();
                             regs[SR_OFFSET] = SKT_SR_CLOSED;
                             regs[CR_OFFSET] = 0;
                             break;
@@ -270,7 +335,7 @@ void wiz_socket::processCommand(unsigned char newCommand) {
                     // accept open commands
                     if ((newCommand)==SKT_CR_OPEN) {
                         // open the new socket connection
-                        if (fd>0) close(fd);
+                        closeRealSocket();
                         fd = socket(AF_INET, SOCK_DGRAM|SOCK_NONBLOCK, 0);
                         if (fd>0) {
                             optval = 1;
@@ -297,6 +362,7 @@ void wiz_socket::processCommand(unsigned char newCommand) {
                                 break;
                             } else {
                                 // bind succeeded
+                                watch(fd);
                                 regs[SR_OFFSET] = SKT_SR_UDP;
                                 regs[CR_OFFSET] = 0;
                             }
@@ -308,7 +374,7 @@ void wiz_socket::processCommand(unsigned char newCommand) {
                     switch (newCommand) {
                         case SKT_CR_DISCON:
                         case SKT_CR_CLOSE:
-                            close(fd);
+                            closeRealSocket();
                             regs[SR_OFFSET] = SKT_SR_CLOSED;
                             regs[CR_OFFSET] = 0;
                             break;
@@ -388,7 +454,7 @@ void wiz_socket::setRegValue(unsigned int regnum, unsigned char value) {
         case MR_OFFSET:
             // Update the value.  if a connection is open, close the connection
             regs[regnum] = value;
-            if (fd) {close(fd); fd=0;}
+            closeRealSocket();
             break;
         case CR_OFFSET:
             // changes to the command register will invoke changes in the
@@ -553,7 +619,7 @@ void wiz_socket::reset() {
         0x00, 0x00, 0x00, 0x00, 0xff, 0x40, 0x00, 0x00
     };
 
-    if (fd) close(fd);
+    closeRealSocket();
     for (int i=0;i<REG_SPACE_SIZE;i++) regs[i] = POR_VALUES[i];
 }
 
@@ -731,8 +797,13 @@ void wiz_socket::loopbackNtpResponse(unsigned char *buffer,int len) {
 * An open TCP host socket could have received new data
 * An open UDP socket could have new data available
 *
+* All of these events make the watched descriptor readable, so nothing
+* is done until pollHost() has marked the socket as ready.
 */
 void wiz_socket::step() {
+    if (!ready) return;
+    ready = false;
+
     if ((regs[SR_OFFSET]==SKT_SR_LISTEN)&&(isConnectionAvailable())) {
         struct sockaddr_in clientname;
         unsigned int sizesock;
@@ -741,6 +812,7 @@ void wiz_socket::step() {
         if (tcpfd>0) {
             // connection has been established
             regs[SR_OFFSET] = SKT_SR_ESTABLISHED;
+            watch(tcpfd);
 
             // set the destination ip and port
             regs[DIPR_OFFSET]   = ntohl(clientname.sin_addr.s_addr)>>24;
@@ -756,6 +828,7 @@ void wiz_socket::step() {
     if ((regs[SR_OFFSET]==SKT_SR_ESTABLISHED)&&(isDisconnected())) {
         // port has disconnected - set the state in the state register
         regs[SR_OFFSET] = SKT_SR_CLOSED;
+        watch(0);
         return;
     }
     if ((regs[SR_OFFSET]==SKT_SR_ESTABLISHED)&&(isDataReady())) {
@@ -782,38 +855,11 @@ bool wiz_socket::isDisconnected()
 {
     if (!fd) return true;   // socket is closed
 
-    struct timeval tv;
-    fd_set  fdset;
-
-    // use select to see if there the port is ready - a disconnected
-    // port will return true;
-    tv.tv_sec  = 0;
-    tv.tv_usec = 1;
-
-    FD_ZERO(&fdset);
-    if (tcpfd) {
-        FD_SET(tcpfd, &fdset);
-    } else {
-        FD_SET(fd, &fdset);
-    }
-
-    if (select(FD_SETSIZE, &fdset, 0, 0, &tv)==0) return false;
-
-    // now check the IO controller to see if there are any bytes ready
-    // if not, the port is disconnected.
+    // the descriptor is readable (checked by pollHost), if there are no
+    // bytes to read, the port is disconnected.
     long bytes = 0;
-    long bytesTcp = 0;
-    if (tcpfd) {
-        if (ioctl(tcpfd, FIONREAD, &bytesTcp)<0) {
-            return true;
-        }
-    } else {
-        if (ioctl(fd, FIONREAD, &bytes)<0) {
-            return true;
-        }
-    }
-
-    return ((bytes+bytesTcp)==0);
+    if (ioctl((tcpfd>0)?tcpfd:fd, FIONREAD, &bytes)<0) return true;
+    return (bytes==0);
 }
 
 /********************************************************************
@@ -823,26 +869,9 @@ bool wiz_socket::isDisconnected()
 */
 bool wiz_socket::isDataReady()
 {
-    //if (!descriptor) return true;   // socket is closed
     int descriptor = (tcpfd>0)?tcpfd:fd;
     if (descriptor<=0) return false;
 
-    struct timeval tv;
-    fd_set  fdset;
-
-    // use select to see if there the port is ready - a disconnected
-    // port will return true;
-    tv.tv_sec  = 0;
-    tv.tv_usec = 1;
-
-    FD_ZERO(&fdset);
-    FD_SET(fd, &fdset);
-    if (descriptor!=fd) FD_SET(descriptor,&fdset);
-
-    if (select(FD_SETSIZE, &fdset, 0, 0, &tv)==0) return false;
-
-    // now check the IO controller to see if there are any bytes ready
-    // if not, the port is disconnected.
     long bytes = 0;
     if (ioctl(descriptor, FIONREAD, &bytes)<0) return false;
     return (bytes>0);
@@ -855,16 +884,7 @@ bool wiz_socket::isDataReady()
 * on connect.
 */
 bool wiz_socket::isConnectionAvailable() {
-    struct timeval tv;
-    fd_set  fdset;
-
-    // use select to see if there the port is ready - a disconnected
-    // port will return true;
-    tv.tv_sec  = 0;
-    tv.tv_usec = 1;
-
-    FD_ZERO(&fdset);
-    FD_SET(fd, &fdset);
-
-    return (select(FD_SETSIZE, &fdset, 0, 0, &tv)>0);
+    // a listening socket is readable (checked by pollHost), if a
+    // connection is pending
+    return (fd>0)&&(watchedFd==fd);
 }
@@ -129,6 +129,11 @@ private:
     int fd;                 /** file descriptor for the real socket       */
     int tcpfd;              /** file descriptor for accepted tcp connection */
     int rx_write_idx;       /** index into the rx buffer where new data will be placed */
+    int watchedFd;          /** file descriptor registered in the shared epoll set or 0 */
+    bool ready;             /** epoll has reported the watched descriptor as readable */
+
+    static int epollFd;     /** epoll set shared by all sockets of all controllers */
+    static int socketCount; /** number of socket objects, epoll set is closed with the last one */
 
     /*=================
      *  Private Member Functions
@@ -141,6 +146,8 @@ private:
     bool isDisconnected();                         /* return true if the real socket is disconnected */
     bool isDataReady();                            /* return true if the real socket has data available */
     bool isConnectionAvailable();                  /* return true if the real socket has a connection available */
+    void watch(int descriptor);                    /* register descriptor in the epoll set instead of the previous one */
+    void closeRealSocket();                        /* unregister and close the real socket and accepted connection */
 public:
     /*=================
      *  Public Member Functions
@@ -155,6 +162,7 @@ public:
     unsigned char getTxBufferValue(unsigned int);   /* get the value at the specified Tx buffer offset */
     void reset();                                   /* reset the socket to its power-on state */
     void step();                                    /* advance the socket state, checking for received data or new/lost connections */
+    static bool pollHost();                         /* mark all sockets with readable descriptors ready, returns true if there are any */
 };
 
 #endif
@@ -39,6 +39,8 @@ wiz_spi::wiz_spi(wiz_ethernet *chip)
     *(eth->getSsPin()) = 't';
     *(eth->getSckPin()) = 't';
     dataReady = false;
+    dataOut = 0;
+    reset();
 }
 
 /********************************************************************
@@ -87,6 +89,25 @@ void wiz_spi::setOutputByte(unsigned char ch)  {
 void wiz_spi::reset()
 {
     dataReady = false;
+    bitsRead = 0;
+    shiftOut = 0;
+    shiftCount = 0;
+    lastClk = false;
+}
+
+/*******************************************************************
+* transfer()
+* exchange a whole byte with the master without looking at the pins,
+* called, if the controller is attached to the master's HWSpi.  The
+* byte sent to the master is the one set by the transaction layer
+* before the transfer.
+*/
+unsigned char wiz_spi::transfer(unsigned char mosi)
+{
+    unsigned char miso = dataOut;
+    data = mosi;
+    dataReady = true;
+    return miso;
 }
 
 /*******************************************************************
@@ -95,11 +116,6 @@ void wiz_spi::reset()
 */
 void wiz_spi::step()
 {
-    static unsigned int bitsRead = 0;
-    static unsigned int shiftOut = 0;
-    static unsigned int shiftCount = 0;
-    static bool lastClk = false;
-
     if (!isSsSet()) {
         bitsRead = 0;
         shiftCount = 0;
@@ -120,9 +136,9 @@ void wiz_spi::step()
         // clock is low - make sure that the miso bit is being sent
         if (shiftCount==0) shiftOut = dataOut;
         if (shiftOut&0x80) {
-            eth->getMisoPin()->outState = Pin::HIGH;
+            *eth->getMisoPin() = 'H';
         } else {
-            eth->getMisoPin()->outState = Pin::LOW;
+            *eth->getMisoPin() = 'L';
         }
     }
     lastClk = clk;
@@ -37,6 +37,7 @@ class wiz_spi
         void setOutputByte(unsigned char);    /// place a byte in the buffer to send to the master (called by the transaction layer)
 
         void step();                          /// update the state of the spi device (called by from the ethernet step function)
+        unsigned char transfer(unsigned char mosi); /// take a whole byte from the master, return the byte sent to the master
         void reset();                         /// reset the spi interface (as a hardware chip reset would do)
     protected:
 
@@ -45,6 +46,10 @@ class wiz_spi
         unsigned char data;                     /// data byte received from the master
         bool dataReady;                         /// is data ready from the master
         unsigned char dataOut;                  /// data to be sent to the master.  Set by the transaction layer
+        unsigned int bitsRead;                  /// bits shifted in from mosi
+        unsigned int shiftOut;                  /// bits to shift out to miso
+        unsigned int shiftCount;                /// number of bits shifted in the current byte
+        bool lastClk;                           /// state of the clock pin at the last step
 };
 
 